@@ -24,6 +24,18 @@
 #include "ICM_20948.h"
 #include "AHRS.h"
 #include "PID.h"
+#include "Lin_alg_float.h"
+#include "HAL.h"
+#include "quad_main.h"
+#ifdef QUAD_GYRO_FILTER
+#include "Gyro_filter.h"
+#endif
+#ifdef QUAD_DYN_NOTCH
+#ifndef QUAD_GYRO_FILTER
+#error "QUAD_DYN_NOTCH analyzes the FIFO samples that QUAD_GYRO_FILTER reads"
+#endif
+#include "Gyro_notch.h"
+#endif
 
 
 
@@ -32,13 +44,58 @@
  * #DEFINES                                                                    *
  ******************************************************************************/
 #define HEARTBEAT_PERIOD 1000 //1 sec interval for hearbeat update
+#ifndef ANGULAR_RATE_CONTROL_PERIOD // loop periods can be set with -D for SITL runs
 #define ANGULAR_RATE_CONTROL_PERIOD 20 //Period for control loop in msec
+#endif
+#ifndef ANGLE_CONTROL_PERIOD
 #define ANGLE_CONTROL_PERIOD 20 // msec for calculating new angular control output
+#endif
 #define BUFFER_SIZE 1024
 #define RAW 1
 #define SCALED 2
 #define NUM_MOTORS 4
-#define DT 0.02 //integration constant
+#define DT (ANGULAR_RATE_CONTROL_PERIOD * 0.001) //integration constant, the IMU is read once per rate loop
+/* the gyros are integrated on every IMU sample, the accelerometer and
+ * magnetometer corrections run at these lower rates on the sum of the samples
+ * in between, which keeps the noise averaging of a correction every sample */
+#ifndef AHRS_ACC_CORRECTION_PERIOD
+#define AHRS_ACC_CORRECTION_PERIOD 10 // msec
+#endif
+#ifndef AHRS_MAG_CORRECTION_PERIOD
+#define AHRS_MAG_CORRECTION_PERIOD 50 // msec, heading changes slowly
+#endif
+/* -DQUAD_GYRO_FILTER reads every IMU sample from the FIFO and low-passes the
+ * gyros through the Gyro_filter bank, the AHRS then runs on each filtered
+ * sample instead of once per rate loop.  The default cuts at the rate loop's
+ * Nyquist frequency so the loop's own sampling cannot alias vibration, every
+ * stage's delay costs the loop phase margin: in the 2 msec SITL a 250 Hz
+ * cutoff adds 4% to the attitude error and 80 Hz or a half-band makes it
+ * oscillate */
+#ifdef QUAD_GYRO_FILTER
+#define IMU_MODE IMU_SPI_FIFO_MODE
+#define IMU_READ_PERIOD 2 // msec, about one FIFO sample per read
+#ifndef GYRO_FILTER_HALFBANDS
+#define GYRO_FILTER_HALFBANDS 0 // each halves the rate, 8.9 msec of delay at 562.5 Hz
+#endif
+#ifndef GYRO_FILTER_CUTOFF_HZ
+#define GYRO_FILTER_CUTOFF_HZ (500 / ANGULAR_RATE_CONTROL_PERIOD) // Hz, 0 for none
+#endif
+#define AHRS_DT ((1 << GYRO_FILTER_HALFBANDS) / IMU_FIFO_ODR_HZ)
+#else
+/* -DQUAD_IMU_DMA reads each IMU sample by DMA with one interrupt instead of
+ * one per byte, see IMU_SPI_DMA_MODE */
+#ifdef QUAD_IMU_DMA
+#define IMU_MODE IMU_SPI_DMA_MODE
+#else
+#define IMU_MODE IMU_SPI_MODE
+#endif
+#define IMU_READ_PERIOD ANGULAR_RATE_CONTROL_PERIOD
+#define AHRS_DT DT
+#endif
+#define AHRS_SAMPLE_USEC ((uint32_t) (AHRS_DT * 1e6 + 0.5))
+#define AHRS_DECIMATION(period) ((period) * 1000 > AHRS_SAMPLE_USEC ? (period) * 1000 / AHRS_SAMPLE_USEC : 1)
+#define AHRS_ACC_DECIMATION AHRS_DECIMATION(AHRS_ACC_CORRECTION_PERIOD)
+#define AHRS_MAG_DECIMATION AHRS_DECIMATION(AHRS_MAG_CORRECTION_PERIOD)
 #define MSZ 3 //matrix size
 #define QSZ 4 //quaternion size
 
@@ -123,15 +180,37 @@ PID_controller pitch_controller = {
     .u_min = -1000.0
 };
 
-/* container for controller outputs*/
-struct controller_outputs {
-    float phi;
-    float theta;
-    float psi;
-    float phi_dot;
-    float theta_dot;
-    float psi_dot;
-} controller_outputs;
+static struct controller_outputs controller_outputs;
+static struct loop_profile stage_profile[QUAD_NUM_STAGES];
+
+#ifdef QUAD_GYRO_FILTER
+static gyro_filter_t gyro_filter;
+static const gyro_filter_config_t gyro_filter_config = {
+    .odr_hz = IMU_FIFO_ODR_HZ,
+    .halfbands = GYRO_FILTER_HALFBANDS,
+    .cutoff_hz = GYRO_FILTER_CUTOFF_HZ
+};
+#endif
+#ifdef QUAD_DYN_NOTCH
+#ifndef GYRO_NOTCH_MIN_DPS
+#define GYRO_NOTCH_MIN_DPS 2 // smaller peaks are left alone, notching costs phase
+#endif
+/* -DQUAD_DYN_NOTCH notches the two strongest motor vibration peaks out of the
+ * FIFO samples ahead of the gyro filter.  The analysis takes one step per rate
+ * loop, so the notches move every 10 rate loop periods.  In the 2 msec SITL
+ * with -DSITL_VIBRATION_DPS=30 they sit within 2 Hz of the rotors and cut the
+ * frame to frame ESC jitter from 4.7% to 0.6% */
+static gyro_notch_t gyro_notch;
+static const gyro_notch_config_t gyro_notch_config = {
+    .odr_hz = IMU_FIFO_ODR_HZ,
+    .min_hz = 60, // rotors at idle
+    .max_hz = 250,
+    .q = 3,
+    .min_amplitude = GYRO_NOTCH_MIN_DPS,
+    .peaks = 2,
+    .butterflies_per_step = GYRO_NOTCH_FFT_SIZE / 2
+};
+#endif
 
 /*******************************************************************************
  * FUNCTION PROTOTYPES                                                         *
@@ -143,6 +222,16 @@ struct controller_outputs {
  * @author Aaron Hunter
  */
 void check_IMU_events(void);
+
+/**
+ * @function get_IMU_samples(struct IMU_out samples[])
+ * @param samples, room for IMU_FIFO_MAX_BATCH
+ * @return number of samples for the AHRS, the normalized newest sample, or
+ * with QUAD_GYRO_FILTER each output of the gyro filter with the accelerometer
+ * and magnetometer of the FIFO sample that completed it
+ * @author Aaron Hunter
+ */
+uint8_t get_IMU_samples(struct IMU_out samples[]);
 /**
  * @function RC_channels_init(void)
  * @param none
@@ -248,6 +337,15 @@ void set_motor_outputs(void);
  */
 float get_control_output(float ref, float sensor_val, PID_controller * controller);
 
+/**
+ * @Function profile_add(struct loop_profile *profile, HAL_cycles_t start)
+ * @param profile, stage statistics to update
+ * @param start, HAL_get_cycles() value at the start of the stage
+ * @brief accumulates the execution time of one pass through a loop stage
+ * @author Aaron Hunter
+ */
+static void profile_add(struct loop_profile *profile, HAL_cycles_t start);
+
 /*******************************************************************************
  * FUNCTIONS                                                                   *
  ******************************************************************************/
@@ -259,9 +357,48 @@ float get_control_output(float ref, float sensor_val, PID_controller * controlle
  * @author Aaron Hunter
  */
 void check_IMU_events(void) {
+#ifndef QUAD_GYRO_FILTER // get_IMU_samples() takes the whole FIFO batch
     if (IMU_is_data_ready() == TRUE) {
         IMU_get_raw_data(&IMU_raw);
     }
+#endif
+}
+
+/**
+ * @function get_IMU_samples(struct IMU_out samples[])
+ * @param samples, room for IMU_FIFO_MAX_BATCH
+ * @return number of samples for the AHRS
+ * @author Aaron Hunter
+ */
+uint8_t get_IMU_samples(struct IMU_out samples[]) {
+#ifdef QUAD_GYRO_FILTER
+    struct IMU_out batch[IMU_FIFO_MAX_BATCH];
+    float gyro[MSZ];
+    uint8_t num_samples = IMU_get_batch(batch, IMU_FIFO_MAX_BATCH);
+    uint8_t n = 0;
+    uint8_t k;
+
+    IMU_get_batch_raw_data(&IMU_raw); // the counts of the newest sample
+    for (k = 0; k < num_samples; k++) {
+        gyro[0] = batch[k].gyro.x;
+        gyro[1] = batch[k].gyro.y;
+        gyro[2] = batch[k].gyro.z;
+#ifdef QUAD_DYN_NOTCH
+        Gyro_notch_update(&gyro_notch, gyro);
+#endif
+        if (Gyro_filter_update(&gyro_filter, gyro, gyro) == TRUE) {
+            samples[n] = batch[k];
+            samples[n].gyro.x = gyro[0];
+            samples[n].gyro.y = gyro[1];
+            samples[n].gyro.z = gyro[2];
+            n++;
+        }
+    }
+    return n;
+#else
+    IMU_get_norm_data(&samples[0]);
+    return 1;
+#endif
 }
 
 /**
@@ -695,12 +832,68 @@ float get_control_output(float ref, float sensor_val, PID_controller * controlle
     return (setpoint);
 }
 
+/**
+ * @Function profile_add(struct loop_profile *profile, HAL_cycles_t start)
+ * @param profile, stage statistics to update
+ * @param start, HAL_get_cycles() value at the start of the stage
+ * @brief accumulates the execution time of one pass through a loop stage
+ * @author Aaron Hunter
+ */
+static void profile_add(struct loop_profile *profile, HAL_cycles_t start) {
+    HAL_cycles_t elapsed = HAL_get_cycles() - start;
+    profile->calls++;
+    profile->total += elapsed;
+    if (elapsed > profile->max) {
+        profile->max = elapsed;
+    }
+}
+
+/**
+ * @Function quad_get_controller_outputs(struct controller_outputs *outputs)
+ * @param outputs, the latest angle and rate loop outputs
+ * @author Aaron Hunter
+ */
+void quad_get_controller_outputs(struct controller_outputs *outputs) {
+    *outputs = controller_outputs;
+}
+
+/**
+ * @Function quad_get_profile(enum quad_stage stage, struct loop_profile *profile)
+ * @param stage, the loop stage
+ * @param profile, its execution time so far
+ * @return SUCCESS or ERROR for a stage out of range
+ * @author Aaron Hunter
+ */
+int8_t quad_get_profile(enum quad_stage stage, struct loop_profile *profile) {
+    if (stage >= QUAD_NUM_STAGES) {
+        return ERROR;
+    }
+    *profile = stage_profile[stage];
+    return SUCCESS;
+}
+
+#ifdef QUAD_DYN_NOTCH
+/**
+ * @Function quad_get_notch_centers(float center_hz[GYRO_NOTCH_MAX_PEAKS])
+ * @param center_hz, the notch frequencies, 0 until a peak is found
+ * @author Aaron Hunter
+ */
+void quad_get_notch_centers(float center_hz[GYRO_NOTCH_MAX_PEAKS]) {
+    uint8_t i;
+
+    for (i = 0; i < GYRO_NOTCH_MAX_PEAKS; i++) {
+        center_hz[i] = gyro_notch.center_hz[i];
+    }
+}
+#endif
+
 int main(void) {
     uint32_t start_time = 0;
     uint32_t cur_time = 0;
     uint32_t RC_timeout = 1000;
     uint32_t angular_rate_control_start_time = 0;
     uint32_t angle_control_start_time = 0;
+    uint32_t IMU_read_start_time = 0;
     uint32_t heartbeat_start_time = 0;
     uint8_t index;
     int8_t IMU_state = ERROR;
@@ -709,6 +902,14 @@ int main(void) {
     uint8_t error_report = 50;
     uint32_t IMU_update_start;
     uint32_t IMU_update_end;
+    HAL_cycles_t stage_start;
+    uint16_t acc_samples = 0; // IMU samples since the last AHRS corrections
+    uint16_t mag_samples = 0;
+    float acc_sum[MSZ] = {0, 0, 0};
+    float mag_sum[MSZ] = {0, 0, 0};
+    struct IMU_out IMU_samples[IMU_FIFO_MAX_BATCH];
+    uint8_t num_samples;
+    uint8_t sample;
 
     /*test value for IMU update rate*/
     int8_t IMU_updated = TRUE;
@@ -723,7 +924,7 @@ int main(void) {
     float kp_m = 2.5; // magnetometer proportional gain
     float ki_m = 0.05; //magnetometer integral gain
     /*timing and conversion*/
-    const float dt = DT;
+    const float dt = AHRS_DT;
     const float deg2rad = M_PI / 180.0;
     const float rad2deg = 180.0 / M_PI;
     /* Calibration matrices and offset vectors */
@@ -750,6 +951,9 @@ int main(void) {
 
     // Euler angles
     float euler[MSZ] = {0, 0, 0};
+    // attitude quaternion and gyro bias estimates
+    float q[QSZ] = {1, 0, 0, 0};
+    float gyro_bias[MSZ] = {0, 0, 0};
 
     /* data arrays */
     float gyro_cal[MSZ] = {0, 0, 0};
@@ -782,6 +986,7 @@ int main(void) {
             RC_system_online = TRUE;
             break;
         }
+        cur_time = Sys_timer_get_msec();
     }
     if (RC_system_online == FALSE) {
         msg_len = sprintf(message, "RC system failed to connect!\r\n");
@@ -798,12 +1003,23 @@ int main(void) {
     RC_servo_init(ESC_UNIDIRECTIONAL_TYPE, SERVO_PWM_3); // MOTOR 3
     RC_servo_init(ESC_UNIDIRECTIONAL_TYPE, SERVO_PWM_4); // MOTOR 4
     /* initialize the IMU */
-    IMU_state = IMU_init(IMU_SPI_MODE);
+    IMU_state = IMU_init(IMU_MODE);
     if (IMU_state == ERROR && IMU_retry > 0) {
-        IMU_state = IMU_init(IMU_SPI_MODE);
+        IMU_state = IMU_init(IMU_MODE);
         printf("IMU failed init, retrying %d \r\n", IMU_retry);
         IMU_retry--;
     }
+#ifdef QUAD_GYRO_FILTER
+    IMU_set_fifo_watermark(1); // every read takes what has queued
+    if (Gyro_filter_init(&gyro_filter, &gyro_filter_config) == ERROR) {
+        printf("Gyro filter configuration rejected\r\n");
+    }
+#endif
+#ifdef QUAD_DYN_NOTCH
+    if (Gyro_notch_init(&gyro_notch, &gyro_notch_config) == ERROR) {
+        printf("Gyro notch configuration rejected\r\n");
+    }
+#endif
     /*initialize controllers*/
     PID_init(&pitch_rate_controller);
     PID_init(&roll_rate_controller);
@@ -823,6 +1039,7 @@ int main(void) {
     cur_time = Sys_timer_get_msec();
     angular_rate_control_start_time = cur_time;
     angle_control_start_time = cur_time;
+    IMU_read_start_time = cur_time;
     heartbeat_start_time = cur_time;
 
     while (1) {
@@ -835,9 +1052,28 @@ int main(void) {
         if (cur_time - angular_rate_control_start_time >= ANGULAR_RATE_CONTROL_PERIOD) {
             angular_rate_control_start_time = cur_time; //reset control loop timer
 //            set_control_output(gyro_cal, euler); // set actuator outputs
+            stage_start = HAL_get_cycles();
             calc_angle_rate_output(gyro_cal);
             set_motor_outputs();
-            /*start next data acquisition round*/
+            profile_add(&stage_profile[QUAD_STAGE_RATE_LOOP], stage_start);
+#ifdef QUAD_DYN_NOTCH
+            /* a bounded step, after the outputs so it never delays them */
+            stage_start = HAL_get_cycles();
+            Gyro_notch_analyze(&gyro_notch);
+            profile_add(&stage_profile[QUAD_STAGE_NOTCH], stage_start);
+#endif
+            /*publish high speed sensors*/
+            if (pub_RC_signals == TRUE) {
+                publish_RC_signals_raw();
+            }
+            if (pub_IMU == TRUE) {
+                publish_IMU_data(RAW);
+            }
+        }
+        /*start next data acquisition round, once per rate loop or, reading
+         * the FIFO, often enough that each read finds about one sample*/
+        if (cur_time - IMU_read_start_time >= IMU_READ_PERIOD) {
+            IMU_read_start_time = cur_time;
             IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
             if (IMU_updated == TRUE) {
                 IMU_update_start = Sys_timer_get_msec();
@@ -848,43 +1084,56 @@ int main(void) {
                 if (IMU_error % error_report == 0) {
                     printf("IMU error count %d\r\n", IMU_error);
                     //                    IMU_retry = 5;
-                    //                    IMU_state = IMU_init(IMU_SPI_MODE);
+                    //                    IMU_state = IMU_init(IMU_MODE);
                     //                    if (IMU_state == ERROR && IMU_retry > 0) {
-                    //                        IMU_state = IMU_init(IMU_SPI_MODE);
+                    //                        IMU_state = IMU_init(IMU_MODE);
                     //                        printf("IMU failed init, retrying %d \r\n", IMU_retry);
                     //                        IMU_retry--;
                 }
             }
-            /*publish high speed sensors*/
-            if (pub_RC_signals == TRUE) {
-                publish_RC_signals_raw();
-            }
-            if (pub_IMU == TRUE) {
-                publish_IMU_data(RAW);
-            }
         }
         /* update angular control every ANGL_CONTROL_PERIOD*/
         if(cur_time - angle_control_start_time >= ANGLE_CONTROL_PERIOD) {
             angle_control_start_time = cur_time;
+            stage_start = HAL_get_cycles();
             calc_angle_output(euler);
+            profile_add(&stage_profile[QUAD_STAGE_ANGLE_LOOP], stage_start);
         }
         
         if (IMU_is_data_ready() == TRUE) {
             IMU_updated = TRUE;
             IMU_update_end = Sys_timer_get_msec();
-            IMU_get_norm_data(&IMU_scaled);
-
-            acc_cal[0] = (float) IMU_scaled.acc.x;
-            acc_cal[1] = (float) IMU_scaled.acc.y;
-            acc_cal[2] = (float) IMU_scaled.acc.z;
-            mag_cal[0] = (float) IMU_scaled.mag.x;
-            mag_cal[1] = (float) IMU_scaled.mag.y;
-            mag_cal[2] = (float) IMU_scaled.mag.z;
-            /*scale gyro readings into rad/sec */
-            gyro_cal[0] = (float) IMU_scaled.gyro.x * deg2rad;
-            gyro_cal[1] = (float) IMU_scaled.gyro.y * deg2rad;
-            gyro_cal[2] = (float) IMU_scaled.gyro.z * deg2rad;
-            AHRS_update(acc_cal, mag_cal, gyro_cal, dt, euler);
+            stage_start = HAL_get_cycles();
+            num_samples = get_IMU_samples(IMU_samples);
+            for (sample = 0; sample < num_samples; sample++) {
+                IMU_scaled = IMU_samples[sample];
+                acc_cal[0] = (float) IMU_scaled.acc.x;
+                acc_cal[1] = (float) IMU_scaled.acc.y;
+                acc_cal[2] = (float) IMU_scaled.acc.z;
+                mag_cal[0] = (float) IMU_scaled.mag.x;
+                mag_cal[1] = (float) IMU_scaled.mag.y;
+                mag_cal[2] = (float) IMU_scaled.mag.z;
+                /*scale gyro readings into rad/sec */
+                gyro_cal[0] = (float) IMU_scaled.gyro.x * deg2rad;
+                gyro_cal[1] = (float) IMU_scaled.gyro.y * deg2rad;
+                gyro_cal[2] = (float) IMU_scaled.gyro.z * deg2rad;
+                /* AHRS_correct() normalizes, so the sums need no division */
+                lin_alg_v_v_add(acc_sum, acc_cal, acc_sum);
+                lin_alg_v_v_add(mag_sum, mag_cal, mag_sum);
+                if (++acc_samples >= AHRS_ACC_DECIMATION) {
+                    AHRS_correct(acc_sum, NULL, AHRS_ACC_DECIMATION * dt);
+                    acc_samples = 0;
+                    lin_alg_set_v(0, 0, 0, acc_sum);
+                }
+                if (++mag_samples >= AHRS_MAG_DECIMATION) {
+                    AHRS_correct(NULL, mag_sum, AHRS_MAG_DECIMATION * dt);
+                    mag_samples = 0;
+                    lin_alg_set_v(0, 0, 0, mag_sum);
+                }
+                AHRS_propagate(gyro_cal, dt, q, gyro_bias);
+                lin_alg_q2euler_abs(q, &euler[0], &euler[1], &euler[2]);
+            }
+            profile_add(&stage_profile[QUAD_STAGE_AHRS], stage_start);
 
             //            printf("%+3.1f, %+3.1f, %+3.1f, %d \r\n", euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg, IMU_update_end - IMU_update_start);
         }
@@ -0,0 +1,84 @@
+/*
+ * File:   quad_main.h
+ * Author: Aaron Hunter
+ * Brief: The controller state quad_main.c shares with quad_sitl.c, so the
+ * simulator reads it through these getters and never copies the layouts.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef QUAD_MAIN_H // Header guard
+#define	QUAD_MAIN_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "HAL.h"
+#ifdef QUAD_DYN_NOTCH
+#include "Gyro_notch.h"
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+/* container for controller outputs*/
+struct controller_outputs {
+    float phi;
+    float theta;
+    float psi;
+    float phi_dot;
+    float theta_dot;
+    float psi_dot;
+};
+
+/* execution time of each loop stage, in HAL_CYCLE_UNITS */
+struct loop_profile {
+    uint32_t calls;
+    HAL_cycles_t max;
+    uint64_t total;
+};
+
+/* the profiled loop stages */
+enum quad_stage {
+    QUAD_STAGE_RATE_LOOP,
+    QUAD_STAGE_ANGLE_LOOP,
+    QUAD_STAGE_AHRS,
+#ifdef QUAD_DYN_NOTCH
+    QUAD_STAGE_NOTCH, // one step of the vibration analysis
+#endif
+    QUAD_NUM_STAGES
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function quad_get_controller_outputs(struct controller_outputs *outputs)
+ * @param outputs, the latest angle and rate loop outputs
+ * @author Aaron Hunter
+ */
+void quad_get_controller_outputs(struct controller_outputs *outputs);
+
+/**
+ * @Function quad_get_profile(enum quad_stage stage, struct loop_profile *profile)
+ * @param stage, the loop stage
+ * @param profile, its execution time so far
+ * @return SUCCESS or ERROR for a stage out of range
+ * @author Aaron Hunter
+ */
+int8_t quad_get_profile(enum quad_stage stage, struct loop_profile *profile);
+
+#ifdef QUAD_DYN_NOTCH
+/**
+ * @Function quad_get_notch_centers(float center_hz[GYRO_NOTCH_MAX_PEAKS])
+ * @param center_hz, the notch frequencies, 0 until a peak is found
+ * @author Aaron Hunter
+ */
+void quad_get_notch_centers(float center_hz[GYRO_NOTCH_MAX_PEAKS]);
+#endif
+
+#endif	/* QUAD_MAIN_H */ // End of header guard
@@ -0,0 +1,752 @@
+/*
+ * File:   quad_sitl.c
+ * Author: Aaron Hunter
+ * Brief: Software in the loop plant for quad_main.c.  Links against the
+ * quadcopter application, the PID library and the lib/ drivers on the Linux
+ * HAL backend and closes the cascaded angle and rate loops through a 6-DOF
+ * rigid body model of an X frame quad.  The ESCs read the OC2-OC5 pulses once
+ * per PWM frame, quantize them to their throttle resolution and drive first
+ * order motor models, so the controller sees the same actuator delay it has
+ * on the airframe.
+ *
+ * The scripted flight arms the motors, climbs to a hover with a simple
+ * altitude holding pilot, then applies disturbance torques: a torque step and
+ * a short torque kick on each of roll and pitch, followed by turbulence.  The
+ * angle loop reference is level, so these are the step responses the loops
+ * can show.  At the end the step metrics, the RMS tracking error in
+ * turbulence, the control loop period seen on the IMU chip select and the
+ * execution time of each quad_main.c loop stage are written to stderr as CSV.
+ *
+ * Build from the repository root (needs the c_library_v2 submodule):
+ * gcc -O2 -DHAL_SIM -Ilib/HAL.X/linux -Ilib/HAL.X -Ilib/Board.X -Ilib/Serial.X
+ *   -Ilib/Radio_serial.X -Ilib/System_timer.X -Ilib/RC_RX.X -Ilib/RC_servo.X
+ *   -Ilib/ICM-20948.X -Ilib/Lin_alg.X -Ilib/PID.X -Iapps/ahrs_apps/AHRS.X
+ *   -Imodules/c_library_v2
+ *   Quadcopter/Controller/Quad_passthrough.X/quad_main.c
+ *   Quadcopter/Controller/Quad_passthrough.X/quad_sitl.c
+ *   lib/HAL.X/HAL_linux.c lib/HAL.X/HAL_sim_devices.c lib/Board.X/Board.c
+ *   lib/Serial.X/SerialM32.c lib/Radio_serial.X/Radio_serial.c
+ *   lib/System_timer.X/System_timer.c lib/RC_RX.X/RC_RX.c lib/RC_servo.X/RC_servo.c
+ *   lib/ICM-20948.X/ICM_20948.c lib/PID.X/PID.c lib/Lin_alg.X/Lin_alg_float.c
+ *   apps/ahrs_apps/AHRS.X/AHRS.c apps/ahrs_apps/AHRS.X/AHRS_kernel.c -lm -o quad_sitl
+ * ./quad_sitl > /dev/null
+ * Compare loop rates by rebuilding with e.g. -DANGULAR_RATE_CONTROL_PERIOD=2
+ * -DANGLE_CONTROL_PERIOD=2.  -DSITL_ESC_FRAME_USEC=<usec> models a faster
+ * ESC update than the 50 Hz RC_servo frame, -DSITL_SEED=<n> changes the noise.
+ * -DAHRS_FIXED_POINT with lib/Lin_alg.X/Lin_alg_fix.c and
+ * apps/ahrs_apps/AHRS.X/AHRS_fix.c added flies the fixed point AHRS,
+ * -DAHRS_MEKF with apps/ahrs_apps/AHRS.X/AHRS_mekf.c added the error state EKF,
+ * -DQUAD_GYRO_FILTER with -Ilib/Gyro_filter.X and lib/Gyro_filter.X/Gyro_filter.c
+ * added reads the IMU FIFO through the gyro filter bank, -DQUAD_DYN_NOTCH with
+ * lib/Gyro_filter.X/Gyro_notch.c as well adds the dynamic notches.
+ * -DSITL_VIBRATION_DPS=<dps> puts rotor imbalance vibration on the gyros.
+ * -DQUAD_IMU_DMA reads the IMU by DMA instead of the byte interrupt.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifdef HAL_SIM // host only, not part of the MPLAB project
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "Board.h"
+#include "HAL.h"
+#include "HAL_sim.h"
+#include "HAL_sim_devices.h"
+#include "ICM_20948.h"
+#include "RC_RX.h"
+#include "quad_main.h"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#ifndef SITL_SEED
+#define SITL_SEED 1
+#endif
+#ifndef SITL_ESC_FRAME_USEC
+#define SITL_ESC_FRAME_USEC 20000 // RC_servo.c Timer 3 period
+#endif
+#ifndef SITL_VIBRATION_DPS
+#define SITL_VIBRATION_DPS 0 // gyro vibration per rotor at full throttle
+#endif
+#ifndef ANGULAR_RATE_CONTROL_PERIOD // must agree with quad_main.c
+#define ANGULAR_RATE_CONTROL_PERIOD 20
+#endif
+#ifndef ANGLE_CONTROL_PERIOD
+#define ANGLE_CONTROL_PERIOD 20
+#endif
+#define SITL_DURATION 60.0 // seconds, length of the scripted flight
+
+/* airframe, X configuration.  Motor 1 front left, 2 front right, 3 rear
+ * right, 4 rear left, which is the layout the set_motor_outputs() mixer
+ * assumes with body x forward, y left and z up. */
+#define MASS 1.2 // kg
+#define ARM 0.159 // m, motor offset along body x and y
+#define IXX 0.011 // kg m^2
+#define IYY 0.011
+#define IZZ 0.021
+#define THRUST_MAX 7.0 // N per motor at full throttle
+#define TORQUE_COEFF 0.016 // m, rotor drag torque per N of thrust
+#define MOTOR_TAU 0.035 // s, rotor speed time constant
+#define ROTOR_HZ_MAX 200.0 // rotor speed at full throttle, 12000 rpm
+#define LINEAR_DRAG 0.3 // N per m/s
+#define ANGULAR_DRAG 0.002 // N m per rad/s
+#define GRAVITY 9.80665
+
+/* ESCs */
+#define ESC_MIN_PULSE 1000.0 // usec, zero throttle
+#define ESC_RANGE 1000.0 // usec, zero to full throttle
+#define ESC_STEPS 1000 // throttle resolution
+
+/* sensors, ICM-20948 at +/-2 g and +/-500 dps as configured by IMU_init() */
+#define ACC_COUNTS_PER_G 16384.0
+#define GYRO_COUNTS_PER_DPS (32767.0 / 500.0)
+#define MAG_COUNTS_PER_UNIT 316.0 // 47.4 uT at 0.15 uT/LSB
+#define TEMP_COUNTS 1335 // 25 C
+#define ACC_NOISE 0.02 // g rms, includes prop vibration
+#define GYRO_NOISE 0.15 // dps rms
+#define MAG_NOISE 0.01 // fraction of the field, rms
+
+/* scripted flight */
+#define ARM_TIME 1.0 // s
+#define HOVER_ALTITUDE 1.5 // m
+#define CLIMB_RATE 0.5 // m/s
+#define PILOT_KP 0.15 // throttle per m of altitude error
+#define PILOT_KD 0.12 // throttle per m/s of climb rate
+#define TURBULENCE_START 32.0 // s
+#define TURBULENCE_TORQUE 0.03 // N m rms
+#define TURBULENCE_TAU 0.2 // s, correlation time
+#define SETTLE_BAND 0.5 // deg
+#define EVENT_WINDOW 5 // s, response recorded after each disturbance starts
+#define CRASH_ANGLE 60.0 // deg, end the run beyond this
+
+/* rates, nsec of virtual time */
+#define NSEC_PER_SEC 1000000000ull
+#define PLANT_PERIOD 250000ull // 4 kHz model integration
+#define SBUS_PERIOD 14000000ull // receiver frame rate
+#define ICM_BASE_PERIOD (NSEC_PER_SEC / 1125) // IMU output data rate before SMPLRT_DIV
+#define ESC_FRAME_PERIOD (SITL_ESC_FRAME_USEC * 1000ull)
+#define CONTROL_PERIOD (ANGULAR_RATE_CONTROL_PERIOD * 1000000ull)
+#define OVERRUN_LIMIT (CONTROL_PERIOD * 11 / 10) // longer periods count as overruns
+#define TRACE_LENGTH (EVENT_WINDOW * NSEC_PER_SEC / PLANT_PERIOD)
+
+/* each rate loop step starts one IMU read, in FIFO mode the FIFO count read
+ * that the batch read follows */
+#ifdef QUAD_GYRO_FILTER
+#define IMU_READS(icm) ((icm).fifo_count_reads)
+#else
+#define IMU_READS(icm) ((icm).transactions)
+#endif
+
+#define NUM_MOTORS 4
+#define MSZ 3
+#define QSZ 4
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+
+/* true vehicle state, ENU inertial frame, v_i = q v_b q* */
+struct plant {
+    double q[QSZ];
+    double omega[MSZ]; // body rates, rad/s
+    double pos[MSZ];
+    double vel[MSZ];
+    double force[MSZ]; // specific force in the inertial frame, m/s^2
+    double esc[NUM_MOTORS]; // throttle latched by the ESC, 0 - 1
+    double rotor[NUM_MOTORS]; // rotor speed as a fraction of full throttle
+    double rotor_angle[NUM_MOTORS]; // rad
+    double disturbance[MSZ]; // external torque, N m
+    double turbulence[MSZ];
+    int8_t on_ground;
+};
+
+enum event_type {
+    TORQUE_STEP,
+    TORQUE_KICK
+};
+
+/* one scripted disturbance and the attitude trace on its axis */
+struct event {
+    enum event_type type;
+    uint8_t axis; // 0 roll, 1 pitch
+    double start; // s
+    double length; // s the torque is applied
+    double torque; // N m
+    float trace[TRACE_LENGTH]; // deg, one sample per plant step
+    int samples;
+};
+
+/* response metrics computed from an event trace */
+struct step_metrics {
+    double peak; // deg, signed
+    double t_peak; // s after the disturbance starts
+    double final; // deg, steady state under a torque step, level after a kick
+    double rise; // s, 10 to 90 percent of the final value, steps only
+    double overshoot; // percent, past the final value or past level after a kick
+    double settle; // s, last time outside SETTLE_BAND of the final value
+};
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+static HAL_sim_icm_t icm;
+static struct plant quad;
+static const double arm_x[NUM_MOTORS] = {ARM, ARM, -ARM, -ARM};
+static const double arm_y[NUM_MOTORS] = {ARM, -ARM, -ARM, ARM};
+static const double spin[NUM_MOTORS] = {-1.0, 1.0, -1.0, 1.0}; // drag torque sign about z
+static const double gyro_bias_true[MSZ] = {0.20, -0.15, 0.30}; // dps
+static const double m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+static struct event events[] = {
+    {TORQUE_STEP, 0, 8.0, 4.0, 0.05},
+    {TORQUE_STEP, 1, 14.0, 4.0, 0.05},
+    {TORQUE_KICK, 0, 20.0, 0.04, 0.6},
+    {TORQUE_KICK, 1, 26.0, 0.04, 0.6},
+};
+#define NUM_EVENTS (sizeof (events) / sizeof (events[0]))
+
+static uint64_t next_plant;
+static uint64_t next_sbus;
+static uint64_t next_imu_sample;
+static uint64_t next_esc_frame;
+static uint64_t rng_state = SITL_SEED;
+
+/* control loop observations */
+static uint32_t last_reads;
+static uint64_t last_step;
+static uint64_t max_period;
+static uint64_t sum_period;
+static uint32_t steps;
+static uint32_t overruns;
+
+/* tracking in turbulence */
+static double angle_sum_sq[2];
+static double rate_err_sum_sq[2];
+static double angle_max;
+static uint32_t tracking_samples;
+static double esc_step_sum_sq; // throttle change from frame to frame, what the gyro noise reaches
+static uint32_t esc_steps;
+static struct timespec host_start;
+
+/*******************************************************************************
+ * FUNCTION PROTOTYPES                                                         *
+ ******************************************************************************/
+static void sitl_tick(void *ctx, uint64_t now);
+static void plant_step(double t, double dt);
+static void update_sensors(void);
+static void latch_escs(double t);
+static void send_sbus(double t);
+static void observe_control(uint64_t now);
+static void observe_response(double t);
+static void event_metrics(const struct event *e, struct step_metrics *m);
+static void report(double t, const char *outcome);
+static void attitude(double angles[2]);
+static void quat_rotate(const double q[QSZ], const double v[MSZ], double out[MSZ]);
+static void quat_rotate_inverse(const double q[QSZ], const double v[MSZ], double out[MSZ]);
+static double throttle_to_counts(double throttle);
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+/**
+ * @function sitl_init(void)
+ * @brief attaches the device models before quad_main.c's main() runs, the
+ * HAL constructor has already reset the simulator
+ */
+static void __attribute__((constructor)) sitl_init(void) {
+    quad.q[0] = 1.0;
+    quad.on_ground = TRUE;
+    HAL_sim_icm_attach(&icm, 1, 'E', 0);
+    HAL_sim_uart_attach(4, NULL, NULL); // radio text, not needed here
+    update_sensors();
+    HAL_sim_set_tick_hook(sitl_tick, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+}
+
+/**
+ * @function sitl_tick(void *ctx, uint64_t now)
+ * @brief runs the plant, the ESCs and the receiver on their own schedules
+ */
+static void sitl_tick(void *ctx, uint64_t now) {
+    double t = (double) now / NSEC_PER_SEC;
+    double angles[2];
+    if (now >= next_esc_frame) {
+        next_esc_frame += ESC_FRAME_PERIOD;
+        latch_escs(t);
+    }
+    if (now >= next_plant) {
+        next_plant += PLANT_PERIOD;
+        plant_step(t, (double) PLANT_PERIOD / NSEC_PER_SEC);
+        update_sensors();
+        observe_response(t);
+    }
+    if (now >= next_imu_sample) {
+        /* at the rate IMU_init() programmed, queues a FIFO sample in FIFO mode */
+        next_imu_sample += (1 + icm.regs[2][AGB2_REG_GYRO_SMPLRT_DIV]) * ICM_BASE_PERIOD;
+        HAL_sim_icm_sample(&icm);
+    }
+    if (now >= next_sbus) {
+        next_sbus += SBUS_PERIOD;
+        send_sbus(t);
+    }
+    if (IMU_READS(icm) != last_reads) {
+        last_reads = IMU_READS(icm);
+        observe_control(now);
+    }
+    attitude(angles);
+    if (fabs(angles[0]) > CRASH_ANGLE || fabs(angles[1]) > CRASH_ANGLE) {
+        report(t, "lost control");
+        exit(1);
+    }
+    if (t >= SITL_DURATION) {
+        report(t, "completed");
+        exit(0);
+    }
+}
+
+/**
+ * @function plant_step(double t, double dt)
+ * @brief rotor lag, forces and moments, then a semi-implicit Euler step of
+ * the rigid body.  Sitting on the ground the frame stays level until the
+ * rotors lift it.
+ */
+static void plant_step(double t, double dt) {
+    double thrust = 0.0;
+    double torque[MSZ] = {0.0, 0.0, 0.0};
+    double inertia[MSZ] = {IXX, IYY, IZZ};
+    double h[MSZ];
+    double f_body[MSZ];
+    double f_inertial[MSZ];
+    double w[MSZ];
+    double dq[QSZ];
+    double norm;
+    double decay = exp(-dt / TURBULENCE_TAU);
+    double thrust_i;
+    uint8_t i;
+
+    for (i = 0; i < NUM_MOTORS; i++) {
+        quad.rotor[i] += (quad.esc[i] - quad.rotor[i]) * dt / MOTOR_TAU;
+        quad.rotor_angle[i] = fmod(quad.rotor_angle[i] + 2.0 * M_PI * ROTOR_HZ_MAX * quad.rotor[i] * dt,
+                2.0 * M_PI);
+        thrust_i = THRUST_MAX * quad.rotor[i] * quad.rotor[i];
+        thrust += thrust_i;
+        torque[0] += arm_y[i] * thrust_i;
+        torque[1] -= arm_x[i] * thrust_i;
+        torque[2] += spin[i] * TORQUE_COEFF * thrust_i;
+    }
+
+    /* scripted disturbances and first order Gauss-Markov turbulence */
+    quad.disturbance[0] = quad.disturbance[1] = 0.0;
+    for (i = 0; i < NUM_EVENTS; i++) {
+        if (t >= events[i].start && t < events[i].start + events[i].length) {
+            quad.disturbance[events[i].axis] += events[i].torque;
+        }
+    }
+    for (i = 0; i < 2; i++) {
+        quad.turbulence[i] = quad.turbulence[i] * decay
+                + TURBULENCE_TORQUE * sqrt(1.0 - decay * decay) * HAL_sim_gauss(&rng_state);
+        if (t >= TURBULENCE_START) {
+            quad.disturbance[i] += quad.turbulence[i];
+        }
+    }
+    for (i = 0; i < MSZ; i++) {
+        torque[i] += quad.disturbance[i] - ANGULAR_DRAG * quad.omega[i];
+    }
+
+    f_body[0] = f_body[1] = 0.0;
+    f_body[2] = thrust / MASS;
+    quat_rotate(quad.q, f_body, f_inertial);
+    for (i = 0; i < MSZ; i++) {
+        f_inertial[i] -= LINEAR_DRAG / MASS * quad.vel[i];
+        quad.force[i] = f_inertial[i];
+    }
+
+    if (quad.on_ground) {
+        if (f_inertial[2] <= GRAVITY) {
+            memset(quad.omega, 0, sizeof (quad.omega));
+            memset(quad.vel, 0, sizeof (quad.vel));
+            quad.force[0] = quad.force[1] = 0.0;
+            quad.force[2] = GRAVITY;
+            return;
+        }
+        quad.on_ground = FALSE;
+    }
+
+    /* Euler's equations, omega_dot = I^-1 (tau - omega x I omega) */
+    for (i = 0; i < MSZ; i++) {
+        h[i] = inertia[i] * quad.omega[i];
+    }
+    w[0] = (torque[0] - (quad.omega[1] * h[2] - quad.omega[2] * h[1])) / IXX;
+    w[1] = (torque[1] - (quad.omega[2] * h[0] - quad.omega[0] * h[2])) / IYY;
+    w[2] = (torque[2] - (quad.omega[0] * h[1] - quad.omega[1] * h[0])) / IZZ;
+    for (i = 0; i < MSZ; i++) {
+        quad.omega[i] += w[i] * dt;
+    }
+
+    /* q_dot = 1/2 q (0, omega) */
+    dq[0] = -quad.q[1] * quad.omega[0] - quad.q[2] * quad.omega[1] - quad.q[3] * quad.omega[2];
+    dq[1] = quad.q[0] * quad.omega[0] + quad.q[2] * quad.omega[2] - quad.q[3] * quad.omega[1];
+    dq[2] = quad.q[0] * quad.omega[1] - quad.q[1] * quad.omega[2] + quad.q[3] * quad.omega[0];
+    dq[3] = quad.q[0] * quad.omega[2] + quad.q[1] * quad.omega[1] - quad.q[2] * quad.omega[0];
+    norm = 0.0;
+    for (i = 0; i < QSZ; i++) {
+        quad.q[i] += 0.5 * dq[i] * dt;
+        norm += quad.q[i] * quad.q[i];
+    }
+    norm = sqrt(norm);
+    for (i = 0; i < QSZ; i++) {
+        quad.q[i] /= norm;
+    }
+
+    quad.vel[2] -= GRAVITY * dt;
+    for (i = 0; i < MSZ; i++) {
+        quad.vel[i] += f_inertial[i] * dt;
+        quad.pos[i] += quad.vel[i] * dt;
+    }
+    if (quad.pos[2] < 0.0) {
+        quad.pos[2] = 0.0;
+        quad.on_ground = TRUE;
+    }
+}
+
+/**
+ * @function update_sensors(void)
+ * @brief loads the IMU registers for the current state.  The counts are the
+ * inverse of the calibration the firmware loaded, so the calibrated readings
+ * equal the model plus noise and gyro bias.  Each rotor's imbalance shakes
+ * the frame about x and y once a revolution, in proportion to its speed
+ * squared, and the frame is stiff enough that only the gyros see it.
+ */
+static void update_sensors(void) {
+    float A[MSZ][MSZ];
+    float b[MSZ];
+    double acc[MSZ];
+    double mag[MSZ];
+    double gyro[MSZ];
+    double raw[MSZ];
+    int16_t acc_counts[MSZ];
+    int16_t gyro_counts[MSZ];
+    int16_t mag_counts[MSZ];
+    int i;
+
+    /* specific force and field in the body frame, x forward, z up */
+    quat_rotate_inverse(quad.q, quad.force, acc);
+    quat_rotate_inverse(quad.q, m_i, mag);
+    for (i = 0; i < MSZ; i++) {
+        acc[i] = acc[i] / GRAVITY + ACC_NOISE * HAL_sim_gauss(&rng_state);
+        mag[i] += MAG_NOISE * HAL_sim_gauss(&rng_state);
+        gyro[i] = quad.omega[i] * 180.0 / M_PI + gyro_bias_true[i]
+                + GYRO_NOISE * HAL_sim_gauss(&rng_state);
+    }
+    for (i = 0; i < NUM_MOTORS; i++) {
+        gyro[0] += SITL_VIBRATION_DPS * quad.rotor[i] * quad.rotor[i] * sin(quad.rotor_angle[i]);
+        gyro[1] += SITL_VIBRATION_DPS * quad.rotor[i] * quad.rotor[i] * cos(quad.rotor_angle[i]);
+    }
+
+    IMU_get_acc_cal(A, b);
+    HAL_sim_uncalibrate(A, b, acc, ACC_COUNTS_PER_G, raw);
+    for (i = 0; i < MSZ; i++) {
+        acc_counts[i] = HAL_sim_counts(raw[i]);
+        gyro_counts[i] = HAL_sim_counts(gyro[i] * GYRO_COUNTS_PER_DPS);
+    }
+    IMU_get_mag_cal(A, b);
+    HAL_sim_uncalibrate(A, b, mag, MAG_COUNTS_PER_UNIT, raw);
+    /* AK09916 y and z point the other way, the driver negates them */
+    mag_counts[0] = HAL_sim_counts(raw[0]);
+    mag_counts[1] = HAL_sim_counts(-raw[1]);
+    mag_counts[2] = HAL_sim_counts(-raw[2]);
+    HAL_sim_icm_set_data(&icm, acc_counts, gyro_counts, mag_counts, TEMP_COUNTS);
+}
+
+/**
+ * @function latch_escs(double t)
+ * @brief each ESC measures the pulse once per PWM frame and quantizes it to
+ * its throttle resolution, MOTOR_1-4 are on OC2-OC5.  Counts the changes
+ * from frame to frame in turbulence, where the gyro noise shows up.
+ */
+static void latch_escs(double t) {
+    double throttle;
+    uint32_t pulse;
+    uint8_t i;
+    for (i = 0; i < NUM_MOTORS; i++) {
+        pulse = HAL_sim_oc_pulse_nsec(i + 2);
+        throttle = pulse == 0 ? 0.0 : (pulse / 1000.0 - ESC_MIN_PULSE) / ESC_RANGE;
+        throttle = floor(throttle * ESC_STEPS) / ESC_STEPS;
+        throttle = throttle > 1.0 ? 1.0 : (throttle < 0.0 ? 0.0 : throttle);
+        if (t >= TURBULENCE_START) {
+            esc_step_sum_sq += (throttle - quad.esc[i]) * (throttle - quad.esc[i]);
+            esc_steps++;
+        }
+        quad.esc[i] = throttle;
+    }
+}
+
+/**
+ * @function send_sbus(double t)
+ * @brief scripted pilot: arms the motors, then holds altitude with the
+ * throttle stick, the other sticks stay centered
+ */
+static void send_sbus(double t) {
+    enum {
+        SWITCH_D, THR, AIL, ELE, RUD, HASH
+    };
+    uint16_t channels[HAL_SIM_SBUS_CHANNELS];
+    uint8_t frame[HAL_SIM_SBUS_FRAME_LENGTH];
+    double hover = sqrt(MASS * GRAVITY / (NUM_MOTORS * THRUST_MAX));
+    double altitude = (t - ARM_TIME) * CLIMB_RATE;
+    double throttle = 0.0;
+    int i;
+
+    for (i = 0; i < HAL_SIM_SBUS_CHANNELS; i++) {
+        channels[i] = RC_RX_MID_COUNTS;
+    }
+    channels[SWITCH_D] = RC_RX_MIN_COUNTS;
+    if (t >= ARM_TIME) {
+        channels[SWITCH_D] = RC_RX_MAX_COUNTS;
+        altitude = altitude > HOVER_ALTITUDE ? HOVER_ALTITUDE : altitude;
+        throttle = hover + PILOT_KP * (altitude - quad.pos[2]) - PILOT_KD * quad.vel[2];
+    }
+    channels[THR] = (uint16_t) lround(throttle_to_counts(throttle));
+    /* the transmitter script sends a checksum of the stick channels */
+    channels[HASH] = (channels[THR] >> 2) + (channels[AIL] >> 2) + (channels[ELE] >> 2)
+            + (channels[RUD] >> 2);
+    HAL_sim_sbus_frame(frame, channels);
+    HAL_sim_uart_feed(5, frame, sizeof (frame));
+}
+
+/**
+ * @function observe_control(uint64_t now)
+ * @brief an IMU read starts at the end of every rate loop step
+ */
+static void observe_control(uint64_t now) {
+    uint64_t period;
+    if (last_step != 0) {
+        period = now - last_step;
+        sum_period += period;
+        steps++;
+        if (period > max_period) {
+            max_period = period;
+        }
+        if (period > OVERRUN_LIMIT) {
+            overruns++;
+        }
+    }
+    last_step = now;
+}
+
+/**
+ * @function observe_response(double t)
+ * @brief records the attitude after each scripted disturbance and the
+ * tracking error against the level reference in turbulence
+ */
+static void observe_response(double t) {
+    double angles[2];
+    struct controller_outputs outputs;
+    double rate_ref[2];
+    double err;
+    uint8_t i;
+
+    quad_get_controller_outputs(&outputs);
+    rate_ref[0] = outputs.phi;
+    rate_ref[1] = outputs.theta;
+    attitude(angles);
+    for (i = 0; i < NUM_EVENTS; i++) {
+        if (t >= events[i].start && events[i].samples < TRACE_LENGTH) {
+            events[i].trace[events[i].samples++] = angles[events[i].axis];
+        }
+    }
+    if (t >= TURBULENCE_START) {
+        for (i = 0; i < 2; i++) {
+            angle_sum_sq[i] += angles[i] * angles[i];
+            err = (rate_ref[i] - quad.omega[i]) * 180.0 / M_PI;
+            rate_err_sum_sq[i] += err * err;
+            if (fabs(angles[i]) > angle_max) {
+                angle_max = fabs(angles[i]);
+            }
+        }
+        tracking_samples++;
+    }
+}
+
+/**
+ * @function report(double t, const char *outcome)
+ * @brief step response, tracking, loop timing and stage cost tables as CSV
+ */
+static void report(double t, const char *outcome) {
+    static const char *axis_names[] = {"roll", "pitch"};
+    static const char *event_names[] = {"torque_step", "torque_kick"};
+    static const char *stage_names[] = {"rate_loop", "angle_loop", "AHRS", "notch"};
+    struct loop_profile profile;
+#ifdef QUAD_DYN_NOTCH
+    float center_hz[GYRO_NOTCH_MAX_PEAKS];
+#endif
+    struct timespec host_now;
+    double host_sec;
+    double n = tracking_samples > 0 ? tracking_samples : 1;
+    struct step_metrics m;
+    uint8_t i;
+
+    clock_gettime(CLOCK_MONOTONIC, &host_now);
+    host_sec = (host_now.tv_sec - host_start.tv_sec) + (host_now.tv_nsec - host_start.tv_nsec) * 1e-9;
+    fprintf(stderr, "quad SITL: rate loop %d ms, angle loop %d ms, ESC frame %d us, seed %d, "
+            "%s at %.2f s\n", ANGULAR_RATE_CONTROL_PERIOD, ANGLE_CONTROL_PERIOD,
+            SITL_ESC_FRAME_USEC, SITL_SEED, outcome, t);
+
+    fprintf(stderr, "event,axis,torque_Nm,peak_deg,t_peak_s,final_deg,rise_s,overshoot_pct,settle_s\n");
+    for (i = 0; i < NUM_EVENTS; i++) {
+        event_metrics(&events[i], &m);
+        fprintf(stderr, "%s,%s,%.3f,%.2f,%.3f,%.2f,%.3f,%.1f,%.3f\n",
+                event_names[events[i].type], axis_names[events[i].axis], events[i].torque,
+                m.peak, m.t_peak, m.final, m.rise, m.overshoot, m.settle);
+    }
+    fprintf(stderr, "tracking,roll_rms_deg,pitch_rms_deg,max_deg,roll_rate_rms_dps,pitch_rate_rms_dps,"
+            "esc_step_rms_pct\n");
+    fprintf(stderr, "turbulence,%.3f,%.3f,%.2f,%.2f,%.2f,%.2f\n",
+            sqrt(angle_sum_sq[0] / n), sqrt(angle_sum_sq[1] / n), angle_max,
+            sqrt(rate_err_sum_sq[0] / n), sqrt(rate_err_sum_sq[1] / n),
+            100.0 * sqrt(esc_step_sum_sq / (esc_steps > 0 ? esc_steps : 1)));
+    fprintf(stderr, "loop,steps,period_mean_ms,period_max_ms,overruns\n");
+    fprintf(stderr, "rate_loop,%u,%.3f,%.3f,%u\n", steps,
+            steps > 0 ? (double) sum_period / steps / 1e6 : 0.0, (double) max_period / 1e6, overruns);
+    /* stage cost is host time here, the same counters hold CPU cycles on the PIC32 */
+    fprintf(stderr, "stage,calls,mean_%s,max_%s,per_sec_%s\n", HAL_CYCLE_UNITS, HAL_CYCLE_UNITS,
+            HAL_CYCLE_UNITS);
+    for (i = 0; i < QUAD_NUM_STAGES; i++) {
+        quad_get_profile(i, &profile);
+        fprintf(stderr, "%s,%u,%.1f,%u,%.0f\n", stage_names[i], profile.calls,
+                profile.calls > 0 ? (double) profile.total / profile.calls : 0.0,
+                profile.max, profile.total / t);
+    }
+#ifdef QUAD_DYN_NOTCH
+    fprintf(stderr, "notch,center_1_hz,center_2_hz,rotor_1_hz,rotor_2_hz,rotor_3_hz,rotor_4_hz\n");
+    quad_get_notch_centers(center_hz);
+    fprintf(stderr, "notches,%.1f,%.1f", center_hz[0], center_hz[1]);
+    for (i = 0; i < NUM_MOTORS; i++) {
+        fprintf(stderr, ",%.1f", ROTOR_HZ_MAX * quad.rotor[i]);
+    }
+    fprintf(stderr, "\n");
+#endif
+    fprintf(stderr, "quad SITL: %.0f s simulated in %.2f s host time, %.0fx real time\n",
+            t, host_sec, t / host_sec);
+    HAL_sim_print_stats(stderr);
+}
+
+/**
+ * @function event_metrics(const struct event *e, struct step_metrics *m)
+ * @brief a torque step is measured like a reference step onto its steady
+ * state, the mean over the last second of torque.  A kick is an initial rate,
+ * measured by how far past level the return swings and when it stays within
+ * SETTLE_BAND of level.
+ */
+static void event_metrics(const struct event *e, struct step_metrics *m) {
+    const double dt = (double) PLANT_PERIOD / NSEC_PER_SEC;
+    int end = e->samples;
+    int last_second = (int) (1.0 / dt);
+    int rise_10 = -1;
+    int rise_90 = -1;
+    double past = 0.0;
+    double a;
+    int i;
+
+    memset(m, 0, sizeof (*m));
+    if (e->type == TORQUE_STEP) {
+        end = (int) (e->length / dt);
+        if (e->samples < end) {
+            return; // the run ended before the torque was removed
+        }
+        for (i = end - last_second; i < end; i++) {
+            m->final += e->trace[i] / last_second;
+        }
+    }
+    for (i = 0; i < end; i++) {
+        a = e->trace[i];
+        if (fabs(a) > fabs(m->peak)) {
+            m->peak = a;
+            m->t_peak = i * dt;
+        }
+        if (fabs(a - m->final) > SETTLE_BAND) {
+            m->settle = (i + 1) * dt;
+        }
+        if (e->type == TORQUE_STEP) {
+            if (rise_10 < 0 && fabs(a) >= 0.1 * fabs(m->final)) {
+                rise_10 = i;
+            }
+            if (rise_90 < 0 && fabs(a) >= 0.9 * fabs(m->final)) {
+                rise_90 = i;
+            }
+            if (a * m->final > 0.0 && fabs(a) - fabs(m->final) > past) {
+                past = fabs(a) - fabs(m->final);
+            }
+        }
+    }
+    if (e->type == TORQUE_STEP) {
+        m->rise = (rise_10 >= 0 && rise_90 >= 0) ? (rise_90 - rise_10) * dt : 0.0;
+        m->overshoot = m->final != 0.0 ? 100.0 * past / fabs(m->final) : 0.0;
+    } else {
+        for (i = (int) (m->t_peak / dt); i < end; i++) {
+            if (e->trace[i] * m->peak < 0.0 && fabs(e->trace[i]) > past) {
+                past = fabs(e->trace[i]);
+            }
+        }
+        m->overshoot = m->peak != 0.0 ? 100.0 * past / fabs(m->peak) : 0.0;
+    }
+}
+
+/**
+ * @function attitude(double angles[2])
+ * @brief true roll and pitch in degrees, same definition as lin_alg_q2euler_abs()
+ */
+static void attitude(double angles[2]) {
+    const double *q = quad.q;
+    angles[0] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]),
+            q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3]) * 180.0 / M_PI;
+    angles[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3])) * 180.0 / M_PI;
+}
+
+/**
+ * @function quat_rotate(const double q[QSZ], const double v[MSZ], double out[MSZ])
+ * @brief out = q v q*, body to inertial
+ */
+static void quat_rotate(const double q[QSZ], const double v[MSZ], double out[MSZ]) {
+    /* t = 2 (q_v x v), out = v + q0 t + q_v x t */
+    double t[MSZ];
+    t[0] = 2.0 * (q[2] * v[2] - q[3] * v[1]);
+    t[1] = 2.0 * (q[3] * v[0] - q[1] * v[2]);
+    t[2] = 2.0 * (q[1] * v[1] - q[2] * v[0]);
+    out[0] = v[0] + q[0] * t[0] + q[2] * t[2] - q[3] * t[1];
+    out[1] = v[1] + q[0] * t[1] + q[3] * t[0] - q[1] * t[2];
+    out[2] = v[2] + q[0] * t[2] + q[1] * t[1] - q[2] * t[0];
+}
+
+/**
+ * @function quat_rotate_inverse(const double q[QSZ], const double v[MSZ], double out[MSZ])
+ * @brief out = q* v q, inertial to body
+ */
+static void quat_rotate_inverse(const double q[QSZ], const double v[MSZ], double out[MSZ]) {
+    const double q_conj[QSZ] = {q[0], -q[1], -q[2], -q[3]};
+    quat_rotate(q_conj, v, out);
+}
+
+/**
+ * @function throttle_to_counts(double throttle)
+ * @return RC counts that calc_pw() turns into the ESC pulse for a throttle
+ * fraction
+ */
+static double throttle_to_counts(double throttle) {
+    double pulse = ESC_MIN_PULSE + ESC_RANGE * throttle;
+    double counts = RC_RX_MID_COUNTS + (pulse - 1500.0) * (RC_RX_MAX_COUNTS - RC_RX_MIN_COUNTS)
+            / ESC_RANGE;
+    return counts > RC_RX_MAX_COUNTS ? RC_RX_MAX_COUNTS
+            : (counts < RC_RX_MIN_COUNTS ? RC_RX_MIN_COUNTS : counts);
+}
+
+#endif /* HAL_SIM */
@@ -25,12 +25,15 @@
 #include "ICM_20948.h"
 #include "AHRS.h"
 #include "AS5047D.h"
+#include "Latency.h"
+#include "Mag_cal.h"
+#include "Lin_alg_inline.h"
+#include "rover_main.h"
 
 /*******************************************************************************
  * #DEFINES                                                                    *
  ******************************************************************************/
 #define HEARTBEAT_PERIOD 1000 //1 sec interval for hearbeat update
-#define CONTROL_PERIOD 10 //Period for control loop in msec
 #define PUBLISH_PERIOD 50 // Period for publishing data (msec)
 #define GPS_PERIOD 100 //10 Hz update rate
 #define KNOTS_TO_MPS 0.5144444444 //1 meter/second is equal to 1.9438444924406 knots
@@ -40,7 +43,20 @@
 #define SCALED 2
 #define NUM_MOTORS 4
 #define DT 0.01 //integration constant
-#define MSZ 3 //matrix size
+/* the accelerometer corrects the AHRS every control period, the magnetometer
+ * every AHRS_MAG_DECIMATION periods on the sum of the samples in between */
+#define AHRS_MAG_CORRECTION_PERIOD 50 // msec
+#define AHRS_MAG_DECIMATION (AHRS_MAG_CORRECTION_PERIOD / CONTROL_PERIOD)
+/* -DONLINE_MAG_CAL refines the magnetometer calibration in the background from
+ * the averaged samples of each mag correction, see Mag_cal.h.  Not yet run on
+ * the vehicle */
+/* -DROVER_IMU_DMA reads each IMU sample by DMA with one interrupt instead of
+ * one per byte, see IMU_SPI_DMA_MODE */
+#ifdef ROVER_IMU_DMA
+#define IMU_MODE IMU_SPI_DMA_MODE
+#else
+#define IMU_MODE IMU_SPI_MODE
+#endif
 #define QSZ 4 //quaternion size
 
 /*******************************************************************************
@@ -63,6 +79,7 @@ static uint8_t pub_GPS = TRUE;
 static uint8_t pub_encoders = TRUE;
 static uint8_t pub_attitude = TRUE;
 static uint8_t pub_position = TRUE;
+static uint8_t pub_latency = TRUE;
 
 /*conversions*/
 const float knots_to_mps = KNOTS_TO_MPS;
@@ -87,13 +104,13 @@ float A_acc[MSZ][MSZ] = {
     -1.18653342135860e-06, 6.01268083773005e-05, -2.97010157797952e-07,
     -3.19011230800348e-07, -3.62174516629958e-08, 6.04564465269327e-05
 };
-float A_mag[MSZ][MSZ] = {
+static float A_mag[MSZ][MSZ] = {
     0.00351413733554131, -1.74599042407869e-06, -1.62761272908763e-05,
     6.73767225208446e-06, 0.00334531206332366, -1.35302929502152e-05,
     -3.28233797524166e-05, 9.29337701972177e-06, 0.00343350080131375
 };
 float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
-float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
+static float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
 
 // gravity inertial vector
 float a_i[MSZ] = {0, 0, 1.0};
@@ -105,9 +122,9 @@ float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
 /*attitude*/
 float q[QSZ] = {1, 0, 0, 0};
 /*gyro bias*/
-float gyro_bias[MSZ] = {0, 0, 0};
+static float gyro_bias[MSZ] = {0, 0, 0};
 /*euler angles (yaw, pitch, roll) */
-float euler[MSZ] = {0, 0, 0};
+static float euler[MSZ] = {0, 0, 0};
 
 /* IMU data arrays */
 float gyro_cal[MSZ] = {0, 0, 0};
@@ -115,16 +132,7 @@ float acc_cal[MSZ] = {0, 0, 0};
 float mag_cal[MSZ] = {0, 0, 0};
 
 /* Rover state */
-struct state {
-    float x;
-    float y;
-    float psi;
-    float vx;
-    float vy;
-    float v;
-    float delta;
-};
-struct state X_new = {.x = 0.0, .y = 0.0, .psi = 0.0, .vx = 0, .vy = 0, .v = 0.0, .delta = 0.0};
+static struct state X_new = {.x = 0.0, .y = 0.0, .psi = 0.0, .vx = 0, .vy = 0, .v = 0.0, .delta = 0.0};
 struct state X_old = {.x = 0.0, .y = 0.0, .psi = 0.0, .vx = 0, .vy = 0, .v = 0.0, .delta = 0.0};
 /* Encoder structs for motors and servo */
 encoder_t enc[] = {
@@ -165,6 +173,22 @@ enum mav_output_type {
     RADIO
 };
 
+/* control loop stages timed by the latency statistics */
+enum latency_stages {
+    LATENCY_PERIOD, // start to start of consecutive control loop passes
+    LATENCY_AHRS,
+    LATENCY_EULER,
+    LATENCY_ODOMETRY,
+    LATENCY_CONTROL,
+    LATENCY_ACQUISITION, // encoder and IMU acquisition kick-off
+    NUM_LATENCY_STAGES
+};
+/* DEBUG_FLOAT_ARRAY names, fixed length as the message copies all of them */
+static const char latency_names[NUM_LATENCY_STAGES][MAVLINK_MSG_DEBUG_FLOAT_ARRAY_FIELD_NAME_LEN] = {
+    "period", "AHRS", "quat2euler", "odometry", "control", "acq_start"
+};
+static latency_stats_t latency[NUM_LATENCY_STAGES];
+
 /*******************************************************************************
  * FUNCTION PROTOTYPES                                                         *
  ******************************************************************************/
@@ -252,6 +276,13 @@ void publish_attitude(void);
  */
 void publish_position(void);
 
+/**
+ * @function publish_latency(void)
+ * @brief publishes the statistics of each control loop stage as a
+ * DEBUG_FLOAT_ARRAY, array_id is the stage, then starts a new window
+ */
+void publish_latency(void);
+
 /**
  * @Function publish_heartbeat(uint8_t dest)
  * @param dest, either USB or RADIO
@@ -743,6 +774,34 @@ void publish_position(void) {
     mavprint(msg_buffer, msg_length, USB);
 }
 
+/**
+ * @function publish_latency(void)
+ * @brief publishes the statistics of each control loop stage as a
+ * DEBUG_FLOAT_ARRAY, array_id is the stage, then starts a new window
+ * @note data holds the Latency_to_array() layout, MAVLink 2 trims the unused
+ * trailing zeros so each message is about 130 bytes
+ */
+void publish_latency(void) {
+    mavlink_message_t msg_tx;
+    uint16_t msg_length;
+    uint8_t msg_buffer[BUFFER_SIZE];
+    float data[MAVLINK_MSG_DEBUG_FLOAT_ARRAY_FIELD_DATA_LEN] = {0};
+    uint8_t stage;
+    for (stage = 0; stage < NUM_LATENCY_STAGES; stage++) {
+        Latency_to_array(&latency[stage], data);
+        Latency_reset(&latency[stage]);
+        mavlink_msg_debug_float_array_pack(mavlink_system.sysid,
+                mavlink_system.compid,
+                &msg_tx,
+                Sys_timer_get_usec(),
+                latency_names[stage],
+                stage,
+                data);
+        msg_length = mavlink_msg_to_send_buffer(msg_buffer, &msg_tx);
+        mavprint(msg_buffer, msg_length, USB);
+    }
+}
+
 /**
  * @Function publish_heartbeat(mav_output_type dest)
  * @param dest, either USB or RADIO
@@ -903,9 +962,9 @@ void Rover_quat2euler(float q[MSZ], float euler[MSZ]) {
  * 
  */
 void update_odometry(void) {
-    float l = 0.174; // wheelbase in meters
-    float r_w = .032; // wheel radius in meters
-    uint16_t heading_0 = 1805;
+    float l = WHEELBASE; // wheelbase in meters
+    float r_w = WHEEL_RADIUS; // wheel radius in meters
+    uint16_t heading_0 = HEADING_ZERO;
     float R; // radius of vehicle path
     float dPsi; // change in heading angle of rover
     float Psi_new;
@@ -914,7 +973,7 @@ void update_odometry(void) {
     float d_omega; // wheel rotation amount
     float v; // speed
     float delta; // steering angle
-    float delta_scale = 0.675;
+    float delta_scale = DELTA_SCALE;
     const int16_t max_delta = 2730; // ~ 60 degree turn angle max in counts
     const int16_t TWO_PI_INT = 16383; // 2^14 -1
     int16_t delta_int;
@@ -983,13 +1042,60 @@ float low_pass(float x) {
     return (y_new);
 }
 
+/**
+ * @Function rover_get_euler(float euler_out[MSZ])
+ * @param euler_out, the AHRS euler angles in [psi, theta, roll] order, rad
+ * @author Aaron Hunter
+ */
+void rover_get_euler(float euler_out[MSZ]) {
+    memcpy(euler_out, euler, sizeof (euler));
+}
+
+/**
+ * @Function rover_get_gyro_bias(float bias_out[MSZ])
+ * @param bias_out, the AHRS gyro bias estimate, rad/sec
+ * @author Aaron Hunter
+ */
+void rover_get_gyro_bias(float bias_out[MSZ]) {
+    memcpy(bias_out, gyro_bias, sizeof (gyro_bias));
+}
+
+/**
+ * @Function rover_get_odometry(struct state *X)
+ * @param X, the latest odometry state
+ * @author Aaron Hunter
+ */
+void rover_get_odometry(struct state *X) {
+    *X = X_new;
+}
+
+/**
+ * @Function rover_get_boot_mag_cal(float A[MSZ][MSZ], float b[MSZ])
+ * @param A, the magnetometer calibration loaded at boot
+ * @param b, its offset
+ * @author Aaron Hunter
+ */
+void rover_get_boot_mag_cal(float A[MSZ][MSZ], float b[MSZ]) {
+    memcpy(A, A_mag, sizeof (A_mag));
+    memcpy(b, b_mag, sizeof (b_mag));
+}
+
 int main(void) {
     uint32_t start_time = 0;
     uint32_t cur_time = 0;
     uint32_t RC_timeout = 1000;
     uint32_t control_start_time = 0;
-    uint32_t timer_start = 0;
-    int32_t timer_end = 0;
+    HAL_cycles_t stage_start;
+    uint16_t mag_samples = 0; // control periods since the last mag correction
+    float mag_sum[MSZ] = {0, 0, 0};
+#ifdef ONLINE_MAG_CAL
+    float mag_cal_sample[MSZ];
+    uint8_t is_mag_cal_sample = FALSE;
+    float A_mag_online[MSZ][MSZ];
+    float b_mag_online[MSZ];
+#endif
+    HAL_cycles_t last_control_start = 0;
+    uint8_t stage;
     uint32_t publish_start_time = 0;
     uint32_t gps_start_time = 0;
     uint32_t heartbeat_start_time = 0;
@@ -1034,9 +1140,9 @@ int main(void) {
     RC_servo_init(RC_SERVO_TYPE, SERVO_PWM_3); //steering servo
 
     /* initialize the IMU */
-    IMU_state = IMU_init(IMU_SPI_MODE);
+    IMU_state = IMU_init(IMU_MODE);
     if (IMU_state == ERROR && IMU_retry > 0) {
-        IMU_state = IMU_init(IMU_SPI_MODE);
+        IMU_state = IMU_init(IMU_MODE);
         //        printf("IMU failed init, retrying %d \r\n", IMU_retry);
         msg_len = sprintf(message, "IMU failed init, retrying %d \r\n", IMU_retry);
         mavprint(message, msg_len, RADIO);
@@ -1048,16 +1154,24 @@ int main(void) {
     /* load IMU calibrations */
     IMU_set_mag_cal(A_mag, b_mag);
     IMU_set_acc_cal(A_acc, b_acc);
+#ifdef ONLINE_MAG_CAL
+    Mag_cal_init();
+#endif
 
     /* set filter gains and inertial guiding vectors for AHRS*/
     AHRS_set_filter_gains(kp_a, ki_a, kp_m, ki_m);
     AHRS_set_mag_inertial(m_i);
+    /* the first control step needs a sample, so start one before the loop */
+    IMU_state = IMU_start_data_acq();
 
     cur_time = Sys_timer_get_msec();
     control_start_time = cur_time;
     publish_start_time = cur_time;
     heartbeat_start_time = cur_time;
     gps_start_time = cur_time;
+    for (stage = 0; stage < NUM_LATENCY_STAGES; stage++) {
+        Latency_reset(&latency[stage]);
+    }
 
     while (1) {
         //check for all events
@@ -1071,29 +1185,49 @@ int main(void) {
         /* update control loop*/
         if (cur_time - control_start_time >= CONTROL_PERIOD) {
             control_start_time = cur_time; //reset control loop timer
-            timer_start = Sys_timer_get_usec();
-            AHRS_update(acc_cal, mag_cal, gyro_cal, dt, q, gyro_bias);
+            /* time each stage, the end of one is the start of the next */
+            stage_start = HAL_get_cycles();
+            if (last_control_start != 0) {
+                Latency_add(&latency[LATENCY_PERIOD], stage_start - last_control_start);
+            }
+            last_control_start = stage_start;
+            /* AHRS_correct() normalizes, so the sum needs no division */
+            lin_alg_v_v_add_inline(mag_sum, mag_cal, mag_sum);
+            AHRS_correct(acc_cal, NULL, dt);
+            if (++mag_samples >= AHRS_MAG_DECIMATION) {
+#ifdef ONLINE_MAG_CAL
+                lin_alg_s_v_mult(1.0 / AHRS_MAG_DECIMATION, mag_sum, mag_cal_sample);
+                is_mag_cal_sample = TRUE;
+#endif
+                AHRS_correct(NULL, mag_sum, AHRS_MAG_DECIMATION * dt);
+                mag_samples = 0;
+                lin_alg_set_v(0, 0, 0, mag_sum);
+            }
+            AHRS_propagate(gyro_cal, dt, q, gyro_bias);
+            stage_start = Latency_mark(&latency[LATENCY_AHRS], stage_start);
             Rover_quat2euler(q, euler);
+            stage_start = Latency_mark(&latency[LATENCY_EULER], stage_start);
             update_odometry();
+            stage_start = Latency_mark(&latency[LATENCY_ODOMETRY], stage_start);
             set_control_output(); // set actuator outputs
+            stage_start = Latency_mark(&latency[LATENCY_CONTROL], stage_start);
             /*start next data acquisition round*/
             Encoder_start_data_acq(); // start encoder acquisition
             IMU_state = IMU_start_data_acq(); //initiate IMU measurement with SPI
+            Latency_mark(&latency[LATENCY_ACQUISITION], stage_start);
             if (IMU_state == ERROR) {
                 IMU_error++;
                 if (IMU_error % error_report == 0) {
                     msg_len = sprintf(message, "IMU error count %d\r\n", IMU_error);
                     mavprint(message, msg_len, USB);
                     IMU_retry = 5;
-                    IMU_state = IMU_init(IMU_SPI_MODE);
+                    IMU_state = IMU_init(IMU_MODE);
                     if (IMU_state == ERROR && IMU_retry > 0) {
-                        IMU_state = IMU_init(IMU_SPI_MODE);
+                        IMU_state = IMU_init(IMU_MODE);
                         IMU_retry--;
                     }
                 }
             }
-            /* test time duration of control actions*/
-            timer_end = Sys_timer_get_usec() - timer_start;
         }
         /* publish high speed sensors */
         if (cur_time - publish_start_time > PUBLISH_PERIOD) {
@@ -1115,6 +1249,20 @@ int main(void) {
             }
         }        
 
+#ifdef ONLINE_MAG_CAL
+        /* background: one calibration step per mag correction */
+        if (is_mag_cal_sample == TRUE) {
+            is_mag_cal_sample = FALSE;
+            if (Mag_cal_update(mag_cal_sample) == TRUE) {
+                IMU_get_mag_cal(A_mag_online, b_mag_online);
+                Mag_cal_apply(A_mag_online, b_mag_online);
+                IMU_set_mag_cal(A_mag_online, b_mag_online);
+                msg_len = sprintf(message, "Mag calibration updated\r\n");
+                mavprint(message, msg_len, RADIO);
+            }
+        }
+#endif
+
         /* publish GPS */
         if (cur_time - gps_start_time > GPS_PERIOD) {
             gps_start_time = cur_time; //reset GPS timer
@@ -1126,6 +1274,9 @@ int main(void) {
         if (cur_time - heartbeat_start_time >= HEARTBEAT_PERIOD) {
             heartbeat_start_time = cur_time; //reset the timer
             publish_heartbeat(USB);
+            if (pub_latency == TRUE) {
+                publish_latency();
+            }
             //            msg_len = sprintf(message, "%+3.1f, %+3.1f, %+3.1f,%+1.3e, %+1.3e, %+1.3e \r\n",
             //                    euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg,
             //                    gyro_bias[0], gyro_bias[1], gyro_bias[2]);
@@ -1137,8 +1288,6 @@ int main(void) {
             //            mavprint(message, msg_len, RADIO);
             //            msg_len = sprintf(message, "Switch D: %d, switch A: %d \r\n", RC_channels[SWITCH_D], RC_channels[SWITCH_A]);
             //            mavprint(message, msg_len, RADIO);
-            msg_len = sprintf(message, "%d \r\n", timer_end);
-            mavprint(message, msg_len, RADIO);
             //            msg_len = sprintf(message, "RCRX bytes: %d, collisions %d, parse err %d, Uart err %d\r\n",
             //                    RCRX_get_byte_count(), RCRX_get_collision_count(), RCRX_get_err(), RCRX_get_uart_err_count());
             //            mavprint(message, msg_len, RADIO);
@@ -0,0 +1,80 @@
+/*
+ * File:   rover_main.h
+ * Author: Aaron Hunter
+ * Brief: The estimator state rover_main.c shares with rover_sitl.c, so the
+ * simulator reads it through these getters and never copies the layouts.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef ROVER_MAIN_H // Header guard
+#define	ROVER_MAIN_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define CONTROL_PERIOD 10 //Period for control loop in msec
+#define MSZ 3 //matrix size
+
+/* geometry and steering encoder mapping of update_odometry() */
+#define WHEELBASE 0.174 // m
+#define WHEEL_RADIUS 0.032 // m
+#define HEADING_ZERO 1805 // steering encoder counts at delta = 0
+#define DELTA_SCALE 0.675 // steering angle per encoder angle
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+/* Rover state */
+struct state {
+    float x;
+    float y;
+    float psi;
+    float vx;
+    float vy;
+    float v;
+    float delta;
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function rover_get_euler(float euler_out[MSZ])
+ * @param euler_out, the AHRS euler angles in [psi, theta, roll] order, rad
+ * @author Aaron Hunter
+ */
+void rover_get_euler(float euler_out[MSZ]);
+
+/**
+ * @Function rover_get_gyro_bias(float bias_out[MSZ])
+ * @param bias_out, the AHRS gyro bias estimate, rad/sec
+ * @author Aaron Hunter
+ */
+void rover_get_gyro_bias(float bias_out[MSZ]);
+
+/**
+ * @Function rover_get_odometry(struct state *X)
+ * @param X, the latest odometry state
+ * @author Aaron Hunter
+ */
+void rover_get_odometry(struct state *X);
+
+/**
+ * @Function rover_get_boot_mag_cal(float A[MSZ][MSZ], float b[MSZ])
+ * @param A, the magnetometer calibration loaded at boot
+ * @param b, its offset
+ * @brief the tumble calibration, not any online update of it
+ * @author Aaron Hunter
+ */
+void rover_get_boot_mag_cal(float A[MSZ][MSZ], float b[MSZ]);
+
+#endif	/* ROVER_MAIN_H */ // End of header guard
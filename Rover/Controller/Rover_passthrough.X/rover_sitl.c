@@ -0,0 +1,483 @@
+/*
+ * File:   rover_sitl.c
+ * Author: Aaron Hunter
+ * Brief: Software in the loop plant for rover_main.c.  Links against the
+ * unmodified rover application and lib/ drivers on the Linux HAL backend and
+ * closes the loop through a kinematic bicycle model: the drivers read a
+ * simulated ICM-20948, the three AS5047D encoders, a NEO-M8N RMC stream and
+ * SBUS frames from a scripted pilot, and the ESC and steering servo pulses on
+ * OC2-OC4 drive the model.  Virtual time only advances when the firmware
+ * reads Sys_timer, so a run is deterministic for a given SITL_SEED and a
+ * ten minute drive replays in seconds.
+ *
+ * Every SITL_REPORT_PERIOD the estimator drift (AHRS yaw, odometry position
+ * and heading against the model) and the control loop period seen on the IMU
+ * chip select are written to stderr.  stdout carries the USB MAVLink stream.
+ *
+ * The plant turns with the bicycle model of update_odometry(), so the
+ * odometry drift is the firmware's own.  It comes from the low_pass() speed
+ * filter: every stop of the scripted drive falls in a right turn, and the
+ * filtered speed carries on into it for about 0.2 s.  Each 40 s lap loses a
+ * few degrees of heading to it, so odo_psi_rms_deg grows linearly, to about
+ * 84 deg over the 600 s run.  Without the filter the odometry heading
+ * follows the plant to within 1 deg.
+ *
+ * Build from the repository root (needs the c_library_v2 submodule):
+ * gcc -O2 -DHAL_SIM -Ilib/HAL.X/linux -Ilib/HAL.X -Ilib/Board.X -Ilib/Serial.X
+ *   -Ilib/Radio_serial.X -Ilib/System_timer.X -Ilib/NEO_M8N.X -Ilib/RC_RX.X
+ *   -Ilib/RC_servo.X -Ilib/ICM-20948.X -Ilib/AS5047D.X -Ilib/Lin_alg.X
+ *   -Iapps/ahrs_apps/AHRS.X -Ilib/Latency.X -Imodules/c_library_v2
+ *   Rover/Controller/Rover_passthrough.X/rover_main.c
+ *   Rover/Controller/Rover_passthrough.X/rover_sitl.c
+ *   lib/HAL.X/HAL_linux.c lib/HAL.X/HAL_sim_devices.c lib/Board.X/Board.c
+ *   lib/Serial.X/SerialM32.c lib/Radio_serial.X/Radio_serial.c
+ *   lib/System_timer.X/System_timer.c lib/NEO_M8N.X/NEO_M8N.c lib/RC_RX.X/RC_RX.c
+ *   lib/RC_servo.X/RC_servo.c lib/ICM-20948.X/ICM_20948.c lib/ICM-20948.X/Mag_cal.c
+ *   lib/AS5047D.X/AS5047D.c lib/Lin_alg.X/Lin_alg_float.c
+ *   apps/ahrs_apps/AHRS.X/AHRS.c apps/ahrs_apps/AHRS.X/AHRS_kernel.c
+ *   lib/Latency.X/Latency.c -lm -o rover_sitl
+ * ./rover_sitl > rover_sitl.mav
+ * Add -DSITL_DURATION=<sec> or -DSITL_SEED=<n> to change the run.
+ * -DSITL_MAG_HARD_IRON=<x> adds a payload hard iron offset along body x, as a
+ * fraction of the field, that the boot calibration does not know about.
+ * -DROVER_IMU_DMA reads the IMU by DMA instead of the byte interrupt.
+ * -DONLINE_MAG_CAL builds rover_main.c with the online magnetometer
+ * calibration.  The drive only turns about z, so Mag_cal never converges and
+ * the run reports its epochs with 0 updates: the calibration update path is
+ * untested here, the fit itself is tested by the MAG_CAL_TESTING harness.
+ * Created on Oct 16, 2026
+ * Modified on Oct 16, 2026, the magnetometer model no longer follows the
+ * calibration the firmware loads, so online calibration runs against a fixed
+ * sensor
+ */
+
+#ifdef HAL_SIM // host only, not part of the MPLAB project
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "Board.h"
+#include "HAL_sim.h"
+#include "HAL_sim_devices.h"
+#include "ICM_20948.h"
+#include "AS5047D.h"
+#include "RC_RX.h"
+#include "rover_main.h"
+#ifdef ONLINE_MAG_CAL
+#include "Mag_cal.h"
+#endif
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#ifndef SITL_DURATION
+#define SITL_DURATION 600 // seconds of virtual time to drive
+#endif
+#ifndef SITL_SEED
+#define SITL_SEED 1
+#endif
+#define SITL_REPORT_PERIOD 60 // seconds between drift reports
+#ifndef SITL_MAG_HARD_IRON
+#define SITL_MAG_HARD_IRON 0.0
+#endif
+
+/* actuators */
+#define V_MAX 3.0 // m/s at full ESC pulse
+#define ESC_TAU 0.25 // s, motor and vehicle speed response
+#define DELTA_MAX 0.45 // rad at full servo pulse
+#define STEER_RATE 4.0 // rad/s servo slew limit
+#define PULSE_CENTER 1500.0 // usec
+#define PULSE_HALF_RANGE 500.0 // usec
+
+/* sensors, ICM-20948 at +/-2 g and +/-500 dps as configured by IMU_init() */
+#define ACC_COUNTS_PER_G 16384.0
+#define GYRO_COUNTS_PER_DPS (32767.0 / 500.0)
+#define MAG_COUNTS_PER_UNIT 316.0 // 47.4 uT at 0.15 uT/LSB
+#define TEMP_COUNTS 1335 // 25 C
+#define ACC_NOISE 0.0025 // g rms
+#define GYRO_NOISE 0.15 // dps rms
+#define MAG_NOISE 0.01 // fraction of the field, rms
+#define GRAVITY 9.80665
+
+/* GPS */
+#define LAT_ORIGIN 36.9603855 // deg
+#define LON_ORIGIN -122.0329238 // deg
+#define EARTH_RADIUS 6378137.0 // m
+#define MPS_TO_KNOTS 1.9438444924
+#define UTC_START 76800.0 // 21:20:00
+
+/* rates, nsec of virtual time */
+#define NSEC_PER_SEC 1000000000ull
+#define PLANT_PERIOD 1000000ull // 1 kHz model integration
+#define SBUS_PERIOD 14000000ull // receiver frame rate
+#define GPS_PERIOD 100000000ull // 10 Hz fixes
+#define CONTROL_PERIOD_NSEC (CONTROL_PERIOD * 1000000ull)
+#define OVERRUN_LIMIT (CONTROL_PERIOD_NSEC * 11 / 10) // longer periods count as overruns
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+
+/* true vehicle state, local ENU frame with the origin at the start point */
+struct plant {
+    double x;
+    double y;
+    double psi; // heading, counter clockwise from east
+    double v; // rear axle speed
+    double v_dot;
+    double psi_dot;
+    double delta; // front wheel steering angle
+    double wheel; // wheel rotation, rad
+    double distance;
+};
+
+struct drift {
+    double sum_sq;
+    double max;
+};
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+static HAL_sim_icm_t icm;
+static HAL_sim_as5047d_t encoders[NUM_ENCODERS];
+static struct plant rover;
+static const double gyro_bias_true[MSZ] = {0.20, -0.15, 0.30}; // dps
+static const double m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+static uint64_t next_plant;
+static uint64_t next_sbus;
+static uint64_t next_gps;
+static uint64_t next_report;
+static uint64_t rng_state = SITL_SEED;
+
+/* control loop observations */
+static uint32_t last_transactions;
+static uint64_t last_step;
+static uint64_t max_period;
+static uint64_t sum_period;
+static uint32_t steps;
+static uint32_t overruns;
+
+static struct drift yaw_err;
+static struct drift pos_err;
+static struct drift odo_psi_err;
+static uint32_t samples;
+static struct timespec host_start;
+
+/*******************************************************************************
+ * FUNCTION PROTOTYPES                                                         *
+ ******************************************************************************/
+static void sitl_tick(void *ctx, uint64_t now);
+static void plant_step(double dt);
+static void update_sensors(void);
+static void send_sbus(uint64_t now);
+static void send_gps(uint64_t now);
+static void observe_control(uint64_t now);
+static void report(uint64_t now, int8_t final);
+static double pulse_to_unit(uint8_t oc);
+static double wrap_pi(double angle);
+static void drift_add(struct drift *d, double err);
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+/**
+ * @function sitl_init(void)
+ * @brief attaches the device models before rover_main.c's main() runs, the
+ * HAL constructor has already reset the simulator
+ */
+static void __attribute__((constructor)) sitl_init(void) {
+    uint8_t i;
+    HAL_sim_icm_attach(&icm, 1, 'E', 0);
+    for (i = 0; i < NUM_ENCODERS; i++) {
+        HAL_sim_as5047d_attach(&encoders[i], 2, 'E', i + 1);
+    }
+    HAL_sim_uart_attach(4, NULL, NULL); // radio text, not needed here
+    update_sensors();
+    next_report = SITL_REPORT_PERIOD * NSEC_PER_SEC;
+    HAL_sim_set_tick_hook(sitl_tick, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &host_start);
+    fprintf(stderr, "rover SITL: %d s, seed %d\n", SITL_DURATION, SITL_SEED);
+    fprintf(stderr, "time_s,distance_m,yaw_rms_deg,yaw_max_deg,odo_pos_rms_m,odo_pos_max_m,"
+            "odo_psi_rms_deg,bias_z_err_dps,steps,period_mean_ms,period_max_ms,overruns\n");
+}
+
+/**
+ * @function sitl_tick(void *ctx, uint64_t now)
+ * @brief runs the plant and the sensor streams on their own schedules
+ */
+static void sitl_tick(void *ctx, uint64_t now) {
+    if (now >= next_plant) {
+        next_plant += PLANT_PERIOD;
+        plant_step((double) PLANT_PERIOD / NSEC_PER_SEC);
+        update_sensors();
+    }
+    if (now >= next_sbus) {
+        next_sbus += SBUS_PERIOD;
+        send_sbus(now);
+    }
+    if (now >= next_gps) {
+        next_gps += GPS_PERIOD;
+        send_gps(now);
+    }
+    if (icm.transactions != last_transactions) {
+        last_transactions = icm.transactions;
+        observe_control(now);
+    }
+    if (now >= SITL_DURATION * NSEC_PER_SEC) {
+        report(now, TRUE);
+        exit(0);
+    }
+    if (now >= next_report) {
+        next_report += SITL_REPORT_PERIOD * NSEC_PER_SEC;
+        report(now, FALSE);
+    }
+}
+
+/**
+ * @function plant_step(double dt)
+ * @brief the kinematic bicycle model of update_odometry() driven by the
+ * actuators: the vehicle moves along its heading at the wheel speed and turns
+ * on a radius of WHEELBASE / sin(delta)
+ */
+static void plant_step(double dt) {
+    double v_cmd = V_MAX * (pulse_to_unit(2) + pulse_to_unit(3)) * 0.5;
+    double delta_cmd = DELTA_MAX * pulse_to_unit(4);
+    double d_delta = delta_cmd - rover.delta;
+    double v_last = rover.v;
+
+    if (d_delta > STEER_RATE * dt) {
+        d_delta = STEER_RATE * dt;
+    } else if (d_delta < -STEER_RATE * dt) {
+        d_delta = -STEER_RATE * dt;
+    }
+    rover.delta += d_delta;
+    rover.v += (v_cmd - rover.v) * dt / ESC_TAU;
+    rover.v_dot = (rover.v - v_last) / dt;
+    rover.psi_dot = rover.v * sin(rover.delta) / WHEELBASE;
+    rover.x += rover.v * cos(rover.psi) * dt;
+    rover.y += rover.v * sin(rover.psi) * dt;
+    rover.psi = wrap_pi(rover.psi + rover.psi_dot * dt);
+    rover.wheel += rover.v / WHEEL_RADIUS * dt;
+    rover.distance += fabs(rover.v) * dt;
+}
+
+/**
+ * @function update_sensors(void)
+ * @brief loads the encoder angles and IMU registers for the current state.
+ * The accelerometer counts are the inverse of the calibration the firmware
+ * loaded and the magnetometer counts the inverse of its boot calibration, so
+ * the calibrated readings equal the model plus noise, gyro bias and
+ * SITL_MAG_HARD_IRON.
+ */
+static void update_sensors(void) {
+    float A[MSZ][MSZ];
+    float b[MSZ];
+    float A_mag[MSZ][MSZ];
+    float b_mag[MSZ];
+    double acc[MSZ];
+    double mag[MSZ];
+    double gyro[MSZ];
+    double raw[MSZ];
+    int16_t acc_counts[MSZ];
+    int16_t gyro_counts[MSZ];
+    int16_t mag_counts[MSZ];
+    double c = cos(rover.psi);
+    double s = sin(rover.psi);
+    int32_t wheel_counts = (int32_t) lround(rover.wheel * HAL_SIM_AS5047D_COUNTS / (2.0 * M_PI));
+    int32_t steer_counts = HEADING_ZERO
+            - (int32_t) lround(rover.delta / DELTA_SCALE * HAL_SIM_AS5047D_COUNTS / (2.0 * M_PI));
+    int i;
+
+    /* the left encoder is mounted mirrored */
+    encoders[LEFT_MOTOR].angle = (uint16_t) (-wheel_counts) & 0x3FFF;
+    encoders[RIGHT_MOTOR].angle = (uint16_t) wheel_counts & 0x3FFF;
+    encoders[HEADING].angle = (uint16_t) steer_counts & 0x3FFF;
+
+    /* specific force and field in the body frame, x forward, z up */
+    acc[0] = rover.v_dot / GRAVITY + ACC_NOISE * HAL_sim_gauss(&rng_state);
+    acc[1] = rover.v * rover.psi_dot / GRAVITY + ACC_NOISE * HAL_sim_gauss(&rng_state);
+    acc[2] = 1.0 + ACC_NOISE * HAL_sim_gauss(&rng_state);
+    mag[0] = c * m_i[0] + s * m_i[1] + MAG_NOISE * HAL_sim_gauss(&rng_state);
+    mag[1] = -s * m_i[0] + c * m_i[1] + MAG_NOISE * HAL_sim_gauss(&rng_state);
+    mag[2] = m_i[2] + MAG_NOISE * HAL_sim_gauss(&rng_state);
+    mag[0] += SITL_MAG_HARD_IRON;
+
+    IMU_get_acc_cal(A, b);
+    HAL_sim_uncalibrate(A, b, acc, ACC_COUNTS_PER_G, raw);
+    for (i = 0; i < MSZ; i++) {
+        acc_counts[i] = HAL_sim_counts(raw[i]);
+    }
+    rover_get_boot_mag_cal(A_mag, b_mag); // the true sensor
+    HAL_sim_uncalibrate(A_mag, b_mag, mag, MAG_COUNTS_PER_UNIT, raw);
+    /* AK09916 y and z point the other way, the driver negates them */
+    mag_counts[0] = HAL_sim_counts(raw[0]);
+    mag_counts[1] = HAL_sim_counts(-raw[1]);
+    mag_counts[2] = HAL_sim_counts(-raw[2]);
+
+    for (i = 0; i < MSZ; i++) {
+        gyro[i] = gyro_bias_true[i] + GYRO_NOISE * HAL_sim_gauss(&rng_state);
+    }
+    gyro[2] += rover.psi_dot * 180.0 / M_PI;
+    for (i = 0; i < MSZ; i++) {
+        gyro_counts[i] = HAL_sim_counts(gyro[i] * GYRO_COUNTS_PER_DPS);
+    }
+    HAL_sim_icm_set_data(&icm, acc_counts, gyro_counts, mag_counts, TEMP_COUNTS);
+}
+
+/**
+ * @function send_sbus(uint64_t now)
+ * @brief scripted pilot: cruise with a slow steering sweep that traces
+ * figure eights, stopping for five seconds out of every forty
+ */
+static void send_sbus(uint64_t now) {
+    enum {
+        THR, AIL, ELE, RUD, HASH
+    };
+    uint16_t channels[HAL_SIM_SBUS_CHANNELS];
+    uint8_t frame[HAL_SIM_SBUS_FRAME_LENGTH];
+    double t = (double) now / NSEC_PER_SEC;
+    double throttle = fmod(t, 40.0) < 35.0 ? 0.35 : 0.0;
+    double steer = 0.3 * sin(2.0 * M_PI * t / 20.0);
+    const double half_range = RC_RX_MAX_COUNTS - RC_RX_MID_COUNTS;
+    int i;
+
+    for (i = 0; i < HAL_SIM_SBUS_CHANNELS; i++) {
+        channels[i] = RC_RX_MID_COUNTS;
+    }
+    channels[ELE] = (uint16_t) lround(RC_RX_MID_COUNTS + throttle * half_range);
+    channels[RUD] = (uint16_t) lround(RC_RX_MID_COUNTS + steer * half_range);
+    /* the transmitter script sends a checksum of the stick channels */
+    channels[HASH] = (channels[THR] >> 2) + (channels[AIL] >> 2) + (channels[ELE] >> 2)
+            + (channels[RUD] >> 2);
+    HAL_sim_sbus_frame(frame, channels);
+    HAL_sim_uart_feed(5, frame, sizeof (frame));
+}
+
+/**
+ * @function send_gps(uint64_t now)
+ * @brief RMC fix of the true position on a flat earth around the origin
+ */
+static void send_gps(uint64_t now) {
+    char sentence[HAL_SIM_NMEA_MAX_LENGTH];
+    double lat = LAT_ORIGIN + rover.y / EARTH_RADIUS * 180.0 / M_PI;
+    double lon = LON_ORIGIN + rover.x / (EARTH_RADIUS * cos(LAT_ORIGIN * M_PI / 180.0)) * 180.0 / M_PI;
+    double cog = fmod(450.0 - rover.psi * 180.0 / M_PI, 360.0); // clockwise from north
+    int length = HAL_sim_nmea_rmc(sentence, UTC_START + (double) now / NSEC_PER_SEC,
+            lat, lon, fabs(rover.v) * MPS_TO_KNOTS, cog);
+    HAL_sim_uart_feed(2, (uint8_t *) sentence, length);
+}
+
+/**
+ * @function observe_control(uint64_t now)
+ * @brief a burst read starts at the end of every control step, compare the
+ * estimates rover_main.c just computed with the model
+ */
+static void observe_control(uint64_t now) {
+    float euler[MSZ];
+    struct state X;
+    uint64_t period;
+    if (last_step != 0) {
+        period = now - last_step;
+        sum_period += period;
+        steps++;
+        if (period > max_period) {
+            max_period = period;
+        }
+        if (period > OVERRUN_LIMIT) {
+            overruns++;
+        }
+    }
+    last_step = now;
+    rover_get_euler(euler);
+    rover_get_odometry(&X);
+    drift_add(&yaw_err, wrap_pi(euler[0] - rover.psi) * 180.0 / M_PI);
+    drift_add(&pos_err, hypot(X.x - rover.x, X.y - rover.y));
+    drift_add(&odo_psi_err, wrap_pi(X.psi - rover.psi) * 180.0 / M_PI);
+    samples++;
+}
+
+/**
+ * @function report(uint64_t now, int8_t final)
+ * @brief one CSV line of drift and loop timing, plus run totals at the end
+ */
+static void report(uint64_t now, int8_t final) {
+#ifdef ONLINE_MAG_CAL
+    mag_cal_status_t mag_cal;
+#endif
+    float euler[MSZ];
+    float gyro_bias[MSZ];
+    struct state X;
+    struct timespec host_now;
+    double host_sec;
+    double n = samples > 0 ? samples : 1;
+
+    rover_get_euler(euler);
+    rover_get_gyro_bias(gyro_bias);
+    rover_get_odometry(&X);
+    fprintf(stderr, "%.1f,%.1f,%.2f,%.2f,%.3f,%.3f,%.2f,%.4f,%u,%.3f,%.3f,%u\n",
+            (double) now / NSEC_PER_SEC, rover.distance,
+            sqrt(yaw_err.sum_sq / n), yaw_err.max,
+            sqrt(pos_err.sum_sq / n), pos_err.max,
+            sqrt(odo_psi_err.sum_sq / n),
+            gyro_bias[2] * 180.0 / M_PI - gyro_bias_true[2],
+            steps, steps > 0 ? (double) sum_period / steps / 1e6 : 0.0,
+            (double) max_period / 1e6, overruns);
+    if (final) {
+        clock_gettime(CLOCK_MONOTONIC, &host_now);
+        host_sec = (host_now.tv_sec - host_start.tv_sec) + (host_now.tv_nsec - host_start.tv_nsec) * 1e-9;
+        fprintf(stderr, "rover SITL: %.0f s simulated in %.2f s host time, %.0fx real time\n",
+                (double) now / NSEC_PER_SEC, host_sec, (double) now / NSEC_PER_SEC / host_sec);
+        fprintf(stderr, "final pose x %.2f y %.2f psi %.1f, odometry x %.2f y %.2f psi %.1f, AHRS yaw %.1f\n",
+                rover.x, rover.y, rover.psi * 180.0 / M_PI, X.x, X.y,
+                X.psi * 180.0 / M_PI, euler[0] * 180.0 / M_PI);
+#ifdef ONLINE_MAG_CAL
+        Mag_cal_get_status(&mag_cal);
+        fprintf(stderr, "mag calibration: %u epochs, %u updates, last p_max %.2f\n",
+                mag_cal.epochs, mag_cal.fits, mag_cal.p_max);
+#endif
+        HAL_sim_print_stats(stderr);
+    }
+}
+
+/**
+ * @function pulse_to_unit(uint8_t oc)
+ * @return output compare pulse as -1 to 1 about the servo center, 0 while the
+ * output is not running
+ */
+static double pulse_to_unit(uint8_t oc) {
+    uint32_t pulse = HAL_sim_oc_pulse_nsec(oc);
+    double unit;
+    if (pulse == 0) {
+        return 0.0;
+    }
+    unit = (pulse / 1000.0 - PULSE_CENTER) / PULSE_HALF_RANGE;
+    return unit > 1.0 ? 1.0 : (unit < -1.0 ? -1.0 : unit);
+}
+
+static double wrap_pi(double angle) {
+    while (angle > M_PI) {
+        angle -= 2.0 * M_PI;
+    }
+    while (angle < -M_PI) {
+        angle += 2.0 * M_PI;
+    }
+    return angle;
+}
+
+static void drift_add(struct drift *d, double err) {
+    d->sum_sq += err * err;
+    if (fabs(err) > d->max) {
+        d->max = fabs(err);
+    }
+}
+
+#endif /* HAL_SIM */
@@ -109,15 +109,6 @@ enum motors {
  * @return steering angle, delta in degrees
  */
 float get_delta(uint16_t heading_0, encoder_t enc[]);
-
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
 /*******************************************************************************
  * FUNCTIONS                                                                   *
  ******************************************************************************/
@@ -134,40 +125,6 @@ float get_delta(uint16_t heading_0, encoder_t enc[]) {
     return delta;
 }
 
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
-    float q_i[QSZ];
-    float q_temp[QSZ];
-    float q_conj[QSZ];
-    float q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
-}
-
 void scale_IMU_values(void) {
     acc_cal[0] = (float) IMU_scaled.acc.x;
     acc_cal[1] = (float) IMU_scaled.acc.y;
@@ -251,7 +208,7 @@ int main(void) {
             lin_alg_v_v_sub(waypoint, position, heading_vec_i);
             //            printf("Heading vector %3.1f, %3.1f, %3.1f \r\n ", heading_vec_i[0],heading_vec_i[1], heading_vec_i[2]);
             /* rotate vector into body frame */
-            q_rot_v_q(heading_vec_i, q_vehicle, heading_vec_b);
+            lin_alg_q_rot_v_q(heading_vec_i, q_vehicle, heading_vec_b);
             /* compute angle to waypoint */
             heading_meas = atan2f(heading_vec_b[1], heading_vec_b[0]);
             heading_meas = heading_meas * rad2deg; // convert to degrees
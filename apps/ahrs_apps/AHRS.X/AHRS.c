@@ -13,12 +13,22 @@
 #include <math.h>
 #include <xc.h>
 #include "AHRS.h"
+#include "AHRS_kernel.h"
 #include "Board.h"
 #include "ICM_20948.h"  
 #include "ICM_20948_registers.h" 
-#include "lin_alg_float.h"
+#include "Lin_alg_float.h"
 #include "SerialM32.h"
 #include "System_timer.h"
+#if defined(AHRS_FIXED_POINT) && defined(AHRS_MEKF)
+#error "AHRS_FIXED_POINT and AHRS_MEKF select different AHRS_update() backends"
+#endif
+#ifdef AHRS_FIXED_POINT
+#include "AHRS_fix.h"
+#endif
+#ifdef AHRS_MEKF
+#include "AHRS_mekf.h"
+#endif
 
 
 /*******************************************************************************
@@ -29,64 +39,13 @@
 /*******************************************************************************
  * PRIVATE TYPEDEFS                                                            *
  ******************************************************************************/
-// attitude quaternions
-static float q_minus[QSZ] = {1, 0, 0, 0};
-static float q_plus[QSZ] = {1, 0, 0, 0};
-// gyro bias vector
-static float b_minus[MSZ] = {0, 0, 0};
-static float b_plus[MSZ] = {0, 0, 0};
-
-/* data arrays */
-static float gyro_cal[MSZ] = {0, 0, 0};
-static float acc_cal[MSZ] = {0, 0, 0};
-static float mag_cal[MSZ] = {0, 0, 0};
-
-/*filter gains*/
-static float kp_a = 2.5; //accelerometer proportional gain
-static float ki_a = 0.05; // accelerometer integral gain
-static float kp_m = 2.5; // magnetometer proportional gain
-static float ki_m = 0.05; //magnetometer integral gain
-
-/* gravity inertial vector */
-static float a_i[MSZ] = {0, 0, 1.0};
-
-/* Earth's magnetic field inertial vector at 37 N, 122 W, normalized 
- * North 22,680.8 nT	East 5,217.6 nT	Down 41,324.7 nT, value from NOAA
- * converted into ENU format: */
-static float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+/* attitude, bias, held correction rates, gains and reference vectors */
+static AHRS_kernel_f_t ahrs = AHRS_KERNEL_DEFAULTS;
 
 
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-static void quat2euler(float q[MSZ], float euler[MSZ]);
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
-/**
- * @function v_copy()
- * @param v_in the vector to be copied
- * @param v_out vector to receive the copy
- * @return none
- */
-static void v_copy(float v_in[MSZ], float v_out[MSZ]);
-
-/**
- * @function m_norm()
- * @param M A matrix
- * @return The magnitude of the M, m_norm
- */
-static float m_norm(float M[MSZ]);
 
 /*******************************************************************************
  * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
@@ -101,9 +60,9 @@ static float m_norm(float M[MSZ]);
  * @author Aaron Hunter, 08/05/2022
  * @modified */
 void AHRS_get_mag_inertial(float mag_i[MSZ]) {
-    mag_i[0] = m_i[0];
-    mag_i[1] = m_i[1];
-    mag_i[2] = m_i[2];
+    mag_i[0] = ahrs.m_i[0];
+    mag_i[1] = ahrs.m_i[1];
+    mag_i[2] = ahrs.m_i[2];
 }
 
 /**
@@ -115,9 +74,16 @@ void AHRS_get_mag_inertial(float mag_i[MSZ]) {
  * @author Aaron Hunter, 08/05/2022
  * @modified */
 void AHRS_set_mag_inertial(float mag_i[MSZ]) {
-    m_i[0] = mag_i[0];
-    m_i[1] = mag_i[1];
-    m_i[2] = mag_i[2];
+    ahrs.m_i[0] = mag_i[0];
+    ahrs.m_i[1] = mag_i[1];
+    ahrs.m_i[2] = mag_i[2];
+#ifdef AHRS_FIXED_POINT
+    q30_t mag_i_fix[MSZ] = {FLOAT_TO_Q30(mag_i[0]), FLOAT_TO_Q30(mag_i[1]), FLOAT_TO_Q30(mag_i[2])};
+    AHRS_fix_set_mag_inertial(mag_i_fix);
+#endif
+#ifdef AHRS_MEKF
+    AHRS_mekf_set_mag_inertial(mag_i);
+#endif
 }
 
 /**
@@ -129,10 +95,10 @@ void AHRS_set_mag_inertial(float mag_i[MSZ]) {
  * @author Aaron Hunter, 08/05/2022
  * @modified */
 void AHRS_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m_get, float *ki_m_get) {
-    *kp_a_get = kp_a;
-    *ki_a_get = ki_a;
-    *kp_m_get = kp_m;
-    *ki_m_get = ki_m;
+    *kp_a_get = ahrs.kp_a;
+    *ki_a_get = ahrs.ki_a;
+    *kp_m_get = ahrs.kp_m;
+    *ki_m_get = ahrs.ki_m;
 }
 
 /**
@@ -144,10 +110,38 @@ void AHRS_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m_get, fl
  * @author Aaron Hunter, 08/05/2022
  * @modified */
 void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float ki_m_set) {
-    kp_a = kp_a_set;
-    ki_a = ki_a_set;
-    kp_m = kp_m_set;
-    ki_m = ki_m_set;
+    ahrs.kp_a = kp_a_set;
+    ahrs.ki_a = ki_a_set;
+    ahrs.kp_m = kp_m_set;
+    ahrs.ki_m = ki_m_set;
+#ifdef AHRS_FIXED_POINT
+    AHRS_fix_set_filter_gains(FLOAT_TO_Q16(kp_a_set), FLOAT_TO_Q16(ki_a_set),
+            FLOAT_TO_Q16(kp_m_set), FLOAT_TO_Q16(ki_m_set));
+#endif
+}
+
+/**
+ * @Function AHRS_set_integrator(uint8_t integrator)
+ * @param integrator, one of the AHRS_integrator_t of AHRS_kernel.h
+ * @return SUCCESS or ERROR if integrator is out of range
+ * @brief chooses how AHRS_propagate() integrates the attitude
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+int8_t AHRS_set_integrator(uint8_t integrator) {
+    if (integrator >= AHRS_NUM_INTEGRATORS) {
+        return ERROR;
+    }
+    ahrs.integrator = integrator;
+    return SUCCESS;
+}
+
+/**
+ * @Function AHRS_get_integrator(void)
+ * @return the AHRS_integrator_t in use
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+uint8_t AHRS_get_integrator(void) {
+    return ahrs.integrator;
 }
 
 /**
@@ -162,187 +156,124 @@ void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float
  * @note 
  * @author Aaron Hunter, 08/05/2022
  * @modified  11/01/22 to return quaternion attitude and bias values rather
- * than Euler angles*/
+ * than Euler angles
+ * @modified 10/16/26 runs AHRS_fix_update() when built with AHRS_FIXED_POINT
+ * and AHRS_mekf_update() with AHRS_MEKF, split into AHRS_correct() and
+ * AHRS_propagate() */
 void AHRS_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
         float dt, float q[QSZ], float bias[MSZ]) {
+    AHRS_correct(accels, mags, dt);
+    AHRS_propagate(gyros, dt, q, bias);
+}
 
-    float a_b[MSZ]; //estimated gravity vector in body frame
-    float m_b[MSZ]; //estimated magnetic field vector in body frame
-
-    float gyro_cal[MSZ]; // gyros with bias correction
-    float gyro_wfb[MSZ]; // gyro 'rate' after feedback
-    float w_meas_ap[MSZ]; // accelerometer proportion correction rate
-    float w_meas_mp[MSZ]; // magnetometer proportional correction rate
-    float w_meas_ai[MSZ]; // accelerometer integral correction rate
-    float w_meas_mi[MSZ]; // magnetometer integral correction rate
-
-    float gyro_q_wfb[QSZ]; // temporary quaternion to hold feedback term
-    float q_dot[QSZ]; // quaternion derivative
-    float q_norm;
-    float acc_n;
-    float mag_n;
-
-    /* normalize inertial measurements */
-    acc_n = 1.0 / m_norm(accels);
-    accels[0] = accels[0] * acc_n;
-    accels[1] = accels[1] * acc_n;
-    accels[2] = accels[2] * acc_n;
-
-    mag_n = 1.0 / m_norm(mags);
-    mags[0] = mags[0] * mag_n;
-    mags[1] = mags[1] * mag_n;
-    mags[2] = mags[2] * mag_n;
-
-    /*Accelerometer attitude calculations */
-    q_rot_v_q(a_i, q_minus, a_b); //estimate gravity vector in body frame 
-    lin_alg_cross(accels, a_b, w_meas_ap); // calculate the accelerometer rate term
-    v_copy(w_meas_ap, w_meas_ai); // make a copy for the integral term
-    lin_alg_v_scale(kp_a, w_meas_ap); // calculate the accelerometer proportional feedback term 
-    lin_alg_v_scale(ki_a, w_meas_ai); // calculate the accelerometer integral feedback term 
-
-    /*Magnetometer attitude calculations*/
-    q_rot_v_q(m_i, q_minus, m_b); //estimate magnetic field vector in body frame
-    lin_alg_cross(mags, m_b, w_meas_mp); // calculate the magnetometer rate term
-    v_copy(w_meas_mp, w_meas_mi); //make a copy for the integral term
-    lin_alg_v_scale(kp_m, w_meas_mp); // calculate the magnetometer proportional feedback term
-    lin_alg_v_scale(ki_m, w_meas_mi); // calculate the magnetometer integral feedback term
-
-    /*Gyro attitude contributions */
-    lin_alg_v_v_sub(gyros, b_minus, gyro_cal); //correct the gyros with the b_minus vector
-
-    /* calculate total rate term gyro_wfb */
-    lin_alg_v_v_add(w_meas_ap, w_meas_mp, gyro_wfb);
-    lin_alg_v_v_add(gyro_cal, gyro_wfb, gyro_wfb);
-
-    /* convert feedback term to a pure quaternion */
-    gyro_q_wfb[0] = 0;
-    gyro_q_wfb[1] = gyro_wfb[0];
-    gyro_q_wfb[2] = gyro_wfb[1];
-    gyro_q_wfb[3] = gyro_wfb[2];
-
-    /* compute the quaternion derivative q_dot */
-    lin_alg_q_mult(q_minus, gyro_q_wfb, q_dot);
-
-    /* integrate term by term */
-    q_plus[0] = q_minus[0] + 0.5 * q_dot[0] * dt;
-    q_plus[1] = q_minus[1] + 0.5 * q_dot[1] * dt;
-    q_plus[2] = q_minus[2] + 0.5 * q_dot[2] * dt;
-    q_plus[3] = q_minus[3] + 0.5 * q_dot[3] * dt;
-
-    // normalize the quaternion for stability
-    q_norm = lin_alg_q_norm(q_plus);
-    q_plus[0] = q_plus[0] / q_norm;
-    q_plus[1] = q_plus[1] / q_norm;
-    q_plus[2] = q_plus[2] / q_norm;
-    q_plus[3] = q_plus[3] / q_norm;
-
-    // compute the integral of the bias term by term
-    b_plus[0] = b_minus[0] - (w_meas_ai[0] + w_meas_mi[0]) * dt;
-    b_plus[1] = b_minus[1] - (w_meas_ai[1] + w_meas_mi[1]) * dt;
-    b_plus[2] = b_minus[2] - (w_meas_ai[2] + w_meas_mi[2]) * dt;
-
-    /* update b_minus and q_minus */
-    b_minus[0] = b_plus[0];
-    b_minus[1] = b_plus[1];
-    b_minus[2] = b_plus[2];
-    q_minus[0] = q_plus[0];
-    q_minus[1] = q_plus[1];
-    q_minus[2] = q_plus[2];
-    q_minus[3] = q_plus[3];
+#ifdef AHRS_FIXED_POINT
 
-    /* set external attitude and bias*/
-    bias[0] = b_plus[0];
-    bias[1] = b_plus[1];
-    bias[2] = b_plus[2];
-    q[0] = q_plus[0];
-    q[1] = q_plus[1];
-    q[2] = q_plus[2];
-    q[3] = q_plus[3];
+/**
+ * @Function AHRS_correct(float accels[MSZ], float mags[MSZ], float dt)
+ * @brief converts to fixed point and runs AHRS_fix_correct()
+ * @author Aaron Hunter */
+void AHRS_correct(float accels[MSZ], float mags[MSZ], float dt) {
+    q16_t acc_fix[MSZ];
+    q16_t mag_fix[MSZ];
+    int8_t row;
+
+    for (row = 0; row < MSZ; row++) {
+        if (accels != NULL) {
+            acc_fix[row] = FLOAT_TO_Q16(accels[row]);
+        }
+        if (mags != NULL) {
+            mag_fix[row] = FLOAT_TO_Q16(mags[row]);
+        }
+    }
+    AHRS_fix_correct(accels != NULL ? acc_fix : NULL, mags != NULL ? mag_fix : NULL,
+            FLOAT_TO_Q30(dt));
 }
 
+/**
+ * @Function AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @brief converts to fixed point and runs AHRS_fix_propagate()
+ * @author Aaron Hunter */
+void AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]) {
+    q16_t gyro_fix[MSZ];
+    q30_t q_fix[QSZ];
+    q16_t bias_fix[MSZ];
+    int8_t row;
 
+    for (row = 0; row < MSZ; row++) {
+        gyro_fix[row] = FLOAT_TO_Q16(gyros[row]);
+    }
+    AHRS_fix_propagate(gyro_fix, FLOAT_TO_Q30(dt), q_fix, bias_fix);
+    for (row = 0; row < MSZ; row++) {
+        bias[row] = Q16_TO_FLOAT(bias_fix[row]);
+    }
+    for (row = 0; row < QSZ; row++) {
+        q[row] = Q30_TO_FLOAT(q_fix[row]);
+    }
+}
 
-/*******************************************************************************
- * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
- ******************************************************************************/
+#elif defined(AHRS_MEKF)
 
 /**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-static void quat2euler(float q[MSZ], float euler[MSZ]) {
-    float q00 = q[0] * q[0];
-    float q11 = q[1] * q[1];
-    float q22 = q[2] * q[2];
-    float q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
+ * @Function AHRS_correct(float accels[MSZ], float mags[MSZ], float dt)
+ * @brief runs AHRS_mekf_correct(), the Kalman gain does not need dt
+ * @author Aaron Hunter */
+void AHRS_correct(float accels[MSZ], float mags[MSZ], float dt) {
+    AHRS_mekf_correct(accels, mags);
 }
 
 /**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-static void q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
-    float q_i[QSZ];
-    float q_temp[QSZ];
-    float q_conj[QSZ];
-    float q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
+ * @Function AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @brief runs AHRS_mekf_propagate()
+ * @author Aaron Hunter */
+void AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]) {
+    AHRS_mekf_propagate(gyros, dt, q, bias);
 }
 
+#else
+
 /**
- * @function v_copy()
- * @param v_in the vector to be copied
- * @param v_out vector to receive the copy
- * @return none
- */
-static void v_copy(float v_in[MSZ], float v_out[MSZ]) {
-    int row;
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = v_in[row];
-    }
+ * @Function AHRS_correct(float accels[MSZ], float mags[MSZ], float dt)
+ * @param accels, mags, calibrated accelerometer and magnetometer vectors,
+ * either may be NULL to skip that sensor
+ * @param dt, time since the previous correction from these sensors in seconds
+ * @brief computes the proportional correction rates from the measured and
+ * estimated reference vectors and integrates the gyro bias
+ * @note the correction rate of each sensor is held by AHRS_propagate() until
+ * its next correction
+ * @author Aaron Hunter
+ * @modified 10/16/26 runs the float AHRS_kernel */
+void AHRS_correct(float accels[MSZ], float mags[MSZ], float dt) {
+    AHRS_kernel_correct_f(&ahrs, accels, mags, dt);
 }
 
 /**
- * @function m_norm()
- * @param M A matrix
- * @return The magnitude of the M, m_norm
- */
-static float m_norm(float M[MSZ]) {
-    return ((float) sqrt(M[0] * M[0] + M[1] * M[1] + M[2] * M[2]));
+ * @Function AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @param gyros, gyro rates in rad/sec
+ * @param dt, the integration time in seconds
+ * @return attitude quaternion and gyro biases vector (x,y,z)
+ * @brief integrates the bias corrected gyro rates plus the held correction
+ * rates, cheap enough to run on every IMU sample
+ * @author Aaron Hunter
+ * @modified 10/16/26 runs the float AHRS_kernel */
+void AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]) {
+    AHRS_kernel_propagate_f(&ahrs, gyros, dt);
+
+    /* set external attitude and bias*/
+    bias[0] = ahrs.bias[0];
+    bias[1] = ahrs.bias[1];
+    bias[2] = ahrs.bias[2];
+    q[0] = ahrs.q[0];
+    q[1] = ahrs.q[1];
+    q[2] = ahrs.q[2];
+    q[3] = ahrs.q[3];
 }
+#endif //AHRS_FIXED_POINT, AHRS_MEKF
 
 
 
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
 
 #ifdef AHRS_TESTING
 
@@ -363,6 +294,10 @@ int main(void) {
     float bias_test[MSZ] = {0, 0, 0};
     /*euler angles (yaw, pitch, roll) */
     float euler_test[MSZ] = {0, 0, 0};
+    /* data arrays */
+    float gyro_cal[MSZ] = {0, 0, 0};
+    float acc_cal[MSZ] = {0, 0, 0};
+    float mag_cal[MSZ] = {0, 0, 0};
 
     /*filter gains for testing */
     float kpa = 4.0; //accelerometer proportional gain
@@ -483,7 +418,7 @@ int main(void) {
             update_start = Sys_timer_get_usec();
             AHRS_update(acc_cal, mag_cal, gyro_cal, dt, q_test, bias_test);
             update_end = Sys_timer_get_usec();
-            quat2euler(q_test, euler_test);
+            AHRS_kernel_q_to_euler_f(q_test, euler_test);
             printf("%+3.1f, %+3.1f, %+3.1f, ", euler_test[0] * rad2deg, euler_test[1] * rad2deg, euler_test[2] * rad2deg);
             printf("%+1.3e, %+1.3e, %+1.3e, ", bias_test[0], bias_test[1], bias_test[2]);
             printf("%d\r\n", update_end - update_start);
@@ -16,7 +16,7 @@
  ******************************************************************************/
 
 #include <stdint.h>
-#include "lin_alg_float.h"
+#include "Lin_alg_float.h"
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
@@ -73,6 +73,26 @@ void AHRS_get_filter_gains(float *kp_a_get, float *ki_a_get, float *kp_m, float
  * @modified */
 void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float ki_m_set);
 
+/**
+ * @Function AHRS_set_integrator(uint8_t integrator)
+ * @param integrator, one of the AHRS_integrator_t of AHRS_kernel.h
+ * @return SUCCESS or ERROR if integrator is out of range
+ * @brief chooses how AHRS_propagate() integrates the attitude.  The
+ * exponential map integrators hold their accuracy at longer steps, so the
+ * filter can run at a lower rate, see the integrator table of
+ * AHRS_benchmark.c.  The default is AHRS_INTEGRATOR.
+ * @note the fixed point and MEKF backends keep their own integrators
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+int8_t AHRS_set_integrator(uint8_t integrator);
+
+/**
+ * @Function AHRS_get_integrator(void)
+ * @return the AHRS_integrator_t in use
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+uint8_t AHRS_get_integrator(void);
+
 /**
  * @Function AHRS_update
  * @param IMU data in the form of three axis
@@ -85,10 +105,37 @@ void AHRS_set_filter_gains(float kp_a_set, float ki_a_set, float kp_m_set, float
  * @note 
  * @author Aaron Hunter, 08/05/2022
  * @modified  11/01/22 to return quaternion attitude and bias values rather
- * than Euler angles*/
+ * than Euler angles
+ * @modified 10/16/26 same as AHRS_correct() followed by AHRS_propagate() */
 void AHRS_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ], 
         float dt, float q[QSZ], float bias[MSZ]);
 
+/**
+ * @Function AHRS_correct
+ * @param accels, mags, calibrated accelerometer and magnetometer vectors,
+ * either may be NULL to skip that sensor, normalized in place
+ * @param dt, time since the previous correction from these sensors in seconds
+ * @return none
+ * @brief computes the accelerometer and magnetometer correction rates and
+ * integrates the gyro bias
+ * @note run at a lower rate than AHRS_propagate(), e.g. the accelerometer at
+ * 100 Hz and the magnetometer at 10 Hz.  Each correction rate is held by
+ * AHRS_propagate() until the next correction from that sensor.
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_correct(float accels[MSZ], float mags[MSZ], float dt);
+
+/**
+ * @Function AHRS_propagate
+ * @param gyros, gyro rates in rad/sec
+ * @param dt, the integration time in seconds
+ * @return attitude quaternion and gyro biases vector (x,y,z)
+ * @brief integrates the bias corrected gyros and the held correction rates
+ * @note one quaternion product and a normalization, meant for every IMU sample
+ * @author Aaron Hunter, 10/16/2026
+ * @modified */
+void AHRS_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]);
+
 #endif /* AHRS_H */
 
 /* *****************************************************************************
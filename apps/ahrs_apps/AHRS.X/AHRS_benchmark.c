@@ -0,0 +1,359 @@
+/*
+ * File:   AHRS_benchmark.c
+ * Author: Aaron Hunter
+ * Brief: Execution time of one AHRS_update(), AHRS_fix_update() and
+ * AHRS_mekf_update() step and of their propagate and correct halves, and of
+ * the double precision AHRS_kernel_update_d(), in ns on the host and CPU cycles
+ * on the PIC32, as the CSV described in Benchmark.h.  Build with AHRS_BENCHMARK defined.  On the host:
+ *     gcc -O2 -DHAL_SIM -DAHRS_BENCHMARK -Ilib/HAL.X/linux -Ilib/HAL.X
+ *         -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X -Ilib/ICM-20948.X
+ *         -Ilib/Lin_alg.X -Ilib/Benchmark.X -Iapps/ahrs_apps/AHRS.X
+ *         apps/ahrs_apps/AHRS.X/AHRS.c apps/ahrs_apps/AHRS.X/AHRS_kernel.c
+ *         apps/ahrs_apps/AHRS.X/AHRS_fix.c
+ *         apps/ahrs_apps/AHRS.X/AHRS_mekf.c
+ *         apps/ahrs_apps/AHRS.X/AHRS_benchmark.c lib/Lin_alg.X/Lin_alg_float.c
+ *         lib/Lin_alg.X/Lin_alg_fix.c lib/Benchmark.X/Benchmark.c
+ *         lib/HAL.X/HAL_linux.c lib/Board.X/Board.c lib/Serial.X/SerialM32.c
+ *         lib/System_timer.X/System_timer.c -lm
+ * With AHRS_FIXED_POINT defined AHRS_update() includes the float conversions
+ * around AHRS_fix_update().  AHRS_fix.c and AHRS_mekf.c call the
+ * Lin_alg_inline.h kernels; building with LIN_ALG_NO_INLINE defined as well
+ * turns them back into calls, the before and after of inlining.
+ * The integrator table then weighs the cost of each AHRS_integrator_t against
+ * its accuracy at 10, 20 and 50 ms steps: the float kernel integrates a 20 s
+ * tumble of up to 4 rad/sec per axis, with the rates held over each 50 ms so
+ * the double precision product of exact exponential maps is the true attitude
+ * and the error is the integrator's alone.  per_second is per_call / dt, the
+ * cost of running the filter at that step.
+ * Created on Oct 16, 2026
+ * Modified on Oct 16, 2026 to add the integrator table
+ */
+
+#ifdef AHRS_BENCHMARK
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "AHRS.h"
+#include "AHRS_fix.h"
+#include "AHRS_kernel.h"
+#include "AHRS_mekf.h"
+#include "Benchmark.h"
+#include "Board.h"
+#include "SerialM32.h"
+#include <math.h>
+#include <stdio.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define SUITE "ahrs"
+#define DT 0.01
+#define TUMBLE_SECONDS 20.0
+#define TUMBLE_HOLD 0.05 // rates are constant over each hold, a multiple of every step
+#define TUMBLE_RATE 4.0 // rad/sec amplitude per axis
+#define NUM_STEPS 3
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float q[QSZ];
+    float bias[MSZ];
+    q16_t acc_fix[MSZ];
+    q16_t mag_fix[MSZ];
+    q16_t gyro_fix[MSZ];
+    q30_t q_fix[QSZ];
+    q16_t bias_fix[MSZ];
+    double acc_d[MSZ];
+    double mag_d[MSZ];
+    double gyro_d[MSZ];
+    AHRS_kernel_d_t kernel_d;
+    AHRS_kernel_f_t integrators[AHRS_NUM_INTEGRATORS];
+} operands_t;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void bench_update(void *ctx);
+static void bench_fix_update(void *ctx);
+static void bench_propagate(void *ctx);
+static void bench_correct_acc(void *ctx);
+static void bench_correct_mag(void *ctx);
+static void bench_fix_propagate(void *ctx);
+static void bench_fix_correct_acc(void *ctx);
+static void bench_kernel_update_d(void *ctx);
+static void bench_mekf_update(void *ctx);
+static void bench_mekf_propagate(void *ctx);
+static void bench_mekf_correct_acc(void *ctx);
+static void bench_mekf_correct_mag(void *ctx);
+static void bench_propagate_euler(void *ctx);
+static void bench_propagate_exp2(void *ctx);
+static void bench_propagate_exp4(void *ctx);
+static void bench_propagate_exact(void *ctx);
+static void tumble_rates(double t, float gyros[MSZ]);
+static void integrator_error(uint8_t integrator, float dt, float *rms_deg, float *max_deg);
+static void integrator_table(operands_t *o);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static const benchmark_t kernels[] = {
+    {"AHRS_update", bench_update},
+    {"AHRS_fix_update", bench_fix_update},
+    {"AHRS_propagate", bench_propagate},
+    {"AHRS_correct_acc", bench_correct_acc},
+    {"AHRS_correct_mag", bench_correct_mag},
+    {"AHRS_fix_propagate", bench_fix_propagate},
+    {"AHRS_fix_correct_acc", bench_fix_correct_acc},
+    {"AHRS_kernel_update_d", bench_kernel_update_d},
+    {"AHRS_mekf_update", bench_mekf_update},
+    {"AHRS_mekf_propagate", bench_mekf_propagate},
+    {"AHRS_mekf_correct_acc", bench_mekf_correct_acc},
+    {"AHRS_mekf_correct_mag", bench_mekf_correct_mag},
+};
+
+/* one per AHRS_integrator_t, in order */
+static const benchmark_t integrator_kernels[AHRS_NUM_INTEGRATORS] = {
+    {"AHRS_kernel_propagate_euler", bench_propagate_euler},
+    {"AHRS_kernel_propagate_exp2", bench_propagate_exp2},
+    {"AHRS_kernel_propagate_exp4", bench_propagate_exp4},
+    {"AHRS_kernel_propagate_exact", bench_propagate_exact},
+};
+static const char *integrator_names[AHRS_NUM_INTEGRATORS] = {"euler", "exp2", "exp4", "exact"};
+static const float steps[NUM_STEPS] = {0.01, 0.02, 0.05};
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+static void bench_update(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_update(o->acc, o->mag, o->gyro, DT, o->q, o->bias);
+}
+
+static void bench_fix_update(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_fix_update(o->acc_fix, o->mag_fix, o->gyro_fix, FLOAT_TO_Q30(DT),
+            o->q_fix, o->bias_fix);
+}
+
+static void bench_propagate(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_propagate(o->gyro, DT, o->q, o->bias);
+}
+
+static void bench_correct_acc(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_correct(o->acc, NULL, DT);
+}
+
+static void bench_correct_mag(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_correct(NULL, o->mag, DT);
+}
+
+static void bench_fix_propagate(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_fix_propagate(o->gyro_fix, FLOAT_TO_Q30(DT), o->q_fix, o->bias_fix);
+}
+
+static void bench_fix_correct_acc(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_fix_correct(o->acc_fix, NULL, FLOAT_TO_Q30(DT));
+}
+
+static void bench_kernel_update_d(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_kernel_update_d(&o->kernel_d, o->acc_d, o->mag_d, o->gyro_d, DT);
+}
+
+static void bench_mekf_update(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_mekf_update(o->acc, o->mag, o->gyro, DT, o->q, o->bias);
+}
+
+static void bench_mekf_propagate(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_mekf_propagate(o->gyro, DT, o->q, o->bias);
+}
+
+static void bench_mekf_correct_acc(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_mekf_correct(o->acc, NULL);
+}
+
+static void bench_mekf_correct_mag(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_mekf_correct(NULL, o->mag);
+}
+
+static void bench_propagate_euler(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_kernel_propagate_f(&o->integrators[AHRS_INTEGRATE_EULER], o->gyro, DT);
+}
+
+static void bench_propagate_exp2(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_kernel_propagate_f(&o->integrators[AHRS_INTEGRATE_EXP2], o->gyro, DT);
+}
+
+static void bench_propagate_exp4(void *ctx) {
+    operands_t *o = ctx;
+    AHRS_kernel_propagate_f(&o->integrators[AHRS_INTEGRATE_EXP4], o->gyro, DT);
+}
+
+/* the rates of the benchmark operands are small enough to take the series,
+ * so this one tumbles to time the cos() and sin() */
+static void bench_propagate_exact(void *ctx) {
+    operands_t *o = ctx;
+    float gyros[MSZ] = {TUMBLE_RATE, -TUMBLE_RATE, TUMBLE_RATE};
+    AHRS_kernel_propagate_f(&o->integrators[AHRS_INTEGRATE_EXACT], gyros, DT);
+}
+
+/**
+ * @Function tumble_rates(double t, float gyros[MSZ])
+ * @brief body rates of the tumble, each axis a sinusoid of a different
+ * frequency sampled at the start of the TUMBLE_HOLD containing t
+ * @author Aaron Hunter */
+static void tumble_rates(double t, float gyros[MSZ]) {
+    const double freq[MSZ] = {0.5, 0.8, 1.1};
+    double t_hold = floor(t / TUMBLE_HOLD + 1e-9) * TUMBLE_HOLD;
+    uint8_t i;
+
+    for (i = 0; i < MSZ; i++) {
+        gyros[i] = TUMBLE_RATE * sin(2.0 * M_PI * freq[i] * t_hold + i);
+    }
+}
+
+/**
+ * @Function integrator_error(uint8_t integrator, float dt, float *rms_deg, float *max_deg)
+ * @brief integrates the tumble at steps of dt with the float kernel and with
+ * exact exponential maps in double, and returns the attitude error
+ * @author Aaron Hunter */
+static void integrator_error(uint8_t integrator, float dt, float *rms_deg, float *max_deg) {
+    AHRS_kernel_f_t k = AHRS_KERNEL_DEFAULTS;
+    double truth[QSZ] = {1, 0, 0, 0};
+    double step[QSZ];
+    double next[QSZ];
+    double conj[QSZ];
+    double q_est[QSZ];
+    double v[MSZ];
+    double a, s, e;
+    double sum_sq = 0;
+    double e_max = 0;
+    float gyros[MSZ];
+    uint32_t n_steps = (uint32_t) (TUMBLE_SECONDS / dt + 0.5);
+    uint32_t n;
+    uint8_t i;
+
+    k.integrator = integrator;
+    for (n = 0; n < n_steps; n++) {
+        tumble_rates(n * (double) dt, gyros);
+        AHRS_kernel_propagate_f(&k, gyros, dt);
+
+        /* truth = truth exp([0, w dt / 2]) */
+        for (i = 0; i < MSZ; i++) {
+            v[i] = 0.5 * gyros[i] * (double) dt;
+        }
+        a = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        s = a > 0 ? sin(a) / a : 1.0;
+        step[0] = cos(a);
+        for (i = 0; i < MSZ; i++) {
+            step[i + 1] = s * v[i];
+        }
+        AHRS_kernel_q_mult_d(truth, step, next);
+        for (i = 0; i < QSZ; i++) {
+            truth[i] = next[i];
+        }
+
+        /* angle of truth* q */
+        for (i = 0; i < QSZ; i++) {
+            conj[i] = i == 0 ? truth[0] : -truth[i];
+            q_est[i] = k.q[i];
+        }
+        AHRS_kernel_q_mult_d(conj, q_est, next);
+        e = 2.0 * atan2(sqrt(next[1] * next[1] + next[2] * next[2] + next[3] * next[3]),
+                fabs(next[0])) * 180.0 / M_PI;
+        sum_sq += e * e;
+        if (e > e_max) {
+            e_max = e;
+        }
+    }
+    *rms_deg = sqrt(sum_sq / n_steps);
+    *max_deg = e_max;
+}
+
+/**
+ * @Function integrator_table(operands_t *o)
+ * @brief times the propagation of each integrator and prints its accuracy and
+ * cost per second at each step
+ * @author Aaron Hunter */
+static void integrator_table(operands_t *o) {
+    float per_call[AHRS_NUM_INTEGRATORS];
+    float rms_deg, max_deg;
+    uint8_t integrator;
+    uint8_t j;
+
+    for (integrator = 0; integrator < AHRS_NUM_INTEGRATORS; integrator++) {
+        per_call[integrator] = Benchmark_run(SUITE, integrator_kernels[integrator].name,
+                integrator_kernels[integrator].fn, o);
+    }
+    printf("# integrators, %.0f s tumble of %.1f rad/sec held over %.0f ms\r\n",
+            TUMBLE_SECONDS, TUMBLE_RATE, TUMBLE_HOLD * 1000.0);
+    printf("integrator,dt_ms,rms_deg,max_deg,per_call,per_second,units\r\n");
+    for (j = 0; j < NUM_STEPS; j++) {
+        for (integrator = 0; integrator < AHRS_NUM_INTEGRATORS; integrator++) {
+            integrator_error(integrator, steps[j], &rms_deg, &max_deg);
+            printf("%s,%.0f,%.6f,%.6f,%.1f,%.0f,%s\r\n", integrator_names[integrator],
+                    steps[j] * 1000.0, rms_deg, max_deg, per_call[integrator],
+                    per_call[integrator] / steps[j], HAL_CYCLE_UNITS);
+        }
+    }
+}
+
+/*******************************************************************************
+ * BENCHMARK MAIN                                                              *
+ ******************************************************************************/
+
+int main(void) {
+    /* level and pointing north with a small rate on every axis */
+    operands_t operands = {
+        .acc = {0.02, -0.01, 0.98},
+        .mag = {0.11, 0.48, -0.87},
+        .gyro = {0.01, -0.02, 0.03},
+        .q = {1, 0, 0, 0},
+        .bias = {0, 0, 0},
+        .kernel_d = AHRS_KERNEL_DEFAULTS
+    };
+    uint8_t i;
+
+    for (i = 0; i < AHRS_NUM_INTEGRATORS; i++) {
+        AHRS_kernel_init_f(&operands.integrators[i]);
+        operands.integrators[i].integrator = i;
+    }
+
+    for (i = 0; i < MSZ; i++) {
+        operands.acc_fix[i] = FLOAT_TO_Q16(operands.acc[i]);
+        operands.mag_fix[i] = FLOAT_TO_Q16(operands.mag[i]);
+        operands.gyro_fix[i] = FLOAT_TO_Q16(operands.gyro[i]);
+        operands.acc_d[i] = operands.acc[i];
+        operands.mag_d[i] = operands.mag[i];
+        operands.gyro_d[i] = operands.gyro[i];
+    }
+
+    Board_init();
+    Serial_init();
+    printf("# AHRS benchmark %s, %s\r\n", __DATE__, __TIME__);
+    Benchmark_header();
+    Benchmark_run_table(SUITE, kernels, sizeof (kernels) / sizeof (kernels[0]), &operands);
+    integrator_table(&operands);
+    printf("# done\r\n");
+    return 0;
+}
+
+#endif //AHRS_BENCHMARK
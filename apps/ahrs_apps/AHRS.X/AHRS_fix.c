@@ -0,0 +1,312 @@
+/** Attitude Heading Reference System, fixed point
+ * File:   AHRS_fix.c
+ * Author: Aaron Hunter
+ * Brief: Mahoney complementary filter in Q2.30 and Q16.16 arithmetic
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include "AHRS_fix.h"
+#include "AHRS_kernel.h"
+#include "Lin_alg_inline.h"
+#include "Board.h"
+#include <stddef.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define Q30_MAX ((int64_t) INT32_MAX)
+#define Q30_MIN ((int64_t) INT32_MIN)
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void correct_sensor(q16_t meas[MSZ], q30_t v_b[MSZ], q16_t kp, q16_t ki,
+        q30_t dt, q16_t w_corr[MSZ]);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+// attitude quaternion
+static q30_t q_minus[QSZ] = {Q30_ONE, 0, 0, 0};
+/* gyro bias in rad/sec kept as Q2.30, the integral term adds ~1e-6 rad/sec per
+ * step which is below the Q16.16 resolution */
+static q30_t b_minus[MSZ] = {0, 0, 0};
+// proportional correction rates, held between corrections
+static q16_t w_corr_a[MSZ] = {0, 0, 0};
+static q16_t w_corr_m[MSZ] = {0, 0, 0};
+
+/*filter gains, the AHRS_kernel.h defaults*/
+static q16_t kp_a = FLOAT_TO_Q16(AHRS_KP_A);
+static q16_t ki_a = FLOAT_TO_Q16(AHRS_KI_A);
+static q16_t kp_m = FLOAT_TO_Q16(AHRS_KP_M);
+static q16_t ki_m = FLOAT_TO_Q16(AHRS_KI_M);
+
+/* gravity and magnetic field inertial vectors, AHRS_MAG_INERTIAL in AHRS_kernel.h */
+static q30_t a_i[MSZ] = {0, 0, Q30_ONE};
+static q30_t m_i[MSZ] = {
+    FLOAT_TO_Q30(0.110011998753301),
+    FLOAT_TO_Q30(0.478219898291142),
+    FLOAT_TO_Q30(-0.871322609031072)
+};
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_fix_set_mag_inertial(q30_t mag_i[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_fix_set_mag_inertial(q30_t mag_i[MSZ]) {
+    m_i[0] = mag_i[0];
+    m_i[1] = mag_i[1];
+    m_i[2] = mag_i[2];
+}
+
+/**
+ * @Function AHRS_fix_set_filter_gains(q16_t kp_a_set, q16_t ki_a_set, q16_t kp_m_set, q16_t ki_m_set)
+ * @author Aaron Hunter
+ */
+void AHRS_fix_set_filter_gains(q16_t kp_a_set, q16_t ki_a_set, q16_t kp_m_set, q16_t ki_m_set) {
+    kp_a = kp_a_set;
+    ki_a = ki_a_set;
+    kp_m = kp_m_set;
+    ki_m = ki_m_set;
+}
+
+/**
+ * @Function AHRS_fix_update(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_fix_update(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ],
+        q30_t dt, q30_t q[QSZ], q16_t bias[MSZ]) {
+    AHRS_fix_correct(accels, mags, dt);
+    AHRS_fix_propagate(gyros, dt, q, bias);
+}
+
+/**
+ * @Function AHRS_fix_correct(q16_t accels[MSZ], q16_t mags[MSZ], q30_t dt)
+ * @brief same steps as AHRS_correct(), products round to nearest so the
+ * truncation does not integrate into a drift
+ * @author Aaron Hunter
+ */
+void AHRS_fix_correct(q16_t accels[MSZ], q16_t mags[MSZ], q30_t dt) {
+    q30_t a_b[MSZ]; //estimated gravity vector in body frame
+    q30_t m_b[MSZ]; //estimated magnetic field vector in body frame
+
+    /* estimate gravity and magnetic field vectors in body frame */
+    lin_alg_fix_q_rot_v_q_pair(a_i, m_i, q_minus, a_b, m_b);
+    if (accels != NULL) {
+        correct_sensor(accels, a_b, kp_a, ki_a, dt, w_corr_a);
+    }
+    if (mags != NULL) {
+        correct_sensor(mags, m_b, kp_m, ki_m, dt, w_corr_m);
+    }
+}
+
+/**
+ * @Function AHRS_fix_propagate(q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_fix_propagate(q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ]) {
+    q30_t gyro_q_wfb[QSZ]; // half the rotation over dt as a pure quaternion
+    q30_t q_dot[QSZ];
+    q16_t gyro_wfb;
+    int8_t row;
+
+    gyro_q_wfb[0] = 0;
+    for (row = 0; row < MSZ; row++) {
+        gyro_wfb = gyros[row] - (q16_t) ((b_minus[row] + (1 << 13)) >> 14)
+                + w_corr_a[row] + w_corr_m[row];
+        /* rate * dt / 2, Q16.16 by Q2.30 to Q2.30 */
+        gyro_q_wfb[row + 1] = (q30_t) (((int64_t) gyro_wfb * dt + (1 << 16)) >> 17);
+    }
+
+    /* integrate q + q (x) (0, w dt / 2) and normalize for stability */
+    lin_alg_fix_q_mult_inline(q_minus, gyro_q_wfb, q_dot);
+    for (row = 0; row < QSZ; row++) {
+        q_minus[row] += q_dot[row];
+    }
+    lin_alg_fix_v_normalize(q_minus, QSZ, q_minus);
+
+    /* set external attitude and bias*/
+    for (row = 0; row < MSZ; row++) {
+        bias[row] = (q16_t) ((b_minus[row] + (1 << 13)) >> 14);
+    }
+    for (row = 0; row < QSZ; row++) {
+        q[row] = q_minus[row];
+    }
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function correct_sensor(q16_t meas[MSZ], q30_t v_b[MSZ], q16_t kp, q16_t ki, q30_t dt, q16_t w_corr[MSZ])
+ * @param meas, the measured vector, any length, a zero vector gives no correction
+ * @param v_b, the estimated reference vector in the body frame
+ * @param kp, ki, the filter gains for this sensor
+ * @param dt, the time since the last correction
+ * @param w_corr, returns the proportional correction rate in Q16.16
+ * @brief also integrates the bias
+ */
+static void correct_sensor(q16_t meas[MSZ], q30_t v_b[MSZ], q16_t kp, q16_t ki,
+        q30_t dt, q16_t w_corr[MSZ]) {
+    q30_t meas_n[MSZ] = {0, 0, 0}; // normalized measurement
+    q30_t w_meas[MSZ]; // correction rate
+    int64_t b_plus;
+    int64_t rate;
+    int8_t row;
+
+    lin_alg_fix_v_normalize(meas, MSZ, meas_n);
+    lin_alg_fix_cross_inline(meas_n, v_b, w_meas);
+    for (row = 0; row < MSZ; row++) {
+        /* proportional feedback, Q16.16 gain by Q2.30 rate to Q16.16 */
+        w_corr[row] = (q16_t) (((int64_t) kp * w_meas[row] + (1 << 29)) >> 30);
+
+        /* integral feedback into the bias, Q16.16 gain by Q2.30 rate to Q2.30 */
+        rate = ((int64_t) ki * w_meas[row] + (1 << 15)) >> 16;
+        b_plus = b_minus[row] - ((rate * dt + (1 << 29)) >> 30);
+        if (b_plus > Q30_MAX) {
+            b_plus = Q30_MAX;
+        } else if (b_plus < Q30_MIN) {
+            b_plus = Q30_MIN;
+        }
+        b_minus[row] = (q30_t) b_plus;
+    }
+}
+
+#ifdef AHRS_FIX_TESTING
+/* Accuracy of the fixed point filter against AHRS_update() in float on the
+ * same synthetic flight: the body turns on all three axes with a gyro bias, the
+ * accelerometer and magnetometer see the rotated reference vectors plus noise.
+ * Build AHRS.c without AHRS_FIXED_POINT alongside this file, AHRS_kernel.c,
+ * Lin_alg_fix.c and Lin_alg_float.c. */
+#include <math.h>
+#include <stdio.h>
+#include "AHRS.h"
+#include "SerialM32.h"
+
+#define TEST_DT 0.01
+#define TEST_STEPS 12000 // two minutes
+#define SETTLE_STEPS 3000 // bias convergence excluded from the statistics
+#define TOL_DEG 0.05 // fixed against float
+#define NOISE 0.01
+
+static uint32_t lcg_state = 12345;
+
+static float test_noise(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return NOISE * ((int32_t) lcg_state / 2147483648.0f);
+}
+
+/* angle of the rotation between two attitudes in degrees */
+static float q_angle_deg(float p[QSZ], float q[QSZ]) {
+    float p_conj[QSZ];
+    float d[QSZ];
+    float s;
+    lin_alg_q_inv(p, p_conj);
+    lin_alg_q_mult(p_conj, q, d);
+    s = sqrt(d[1] * d[1] + d[2] * d[2] + d[3] * d[3]);
+    return 2.0 * asin(s < 1.0 ? s : 1.0) * 180.0 / M_PI;
+}
+
+int main(void) {
+    float a_ref[MSZ] = {0, 0, 1.0};
+    float m_ref[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+    const float bias_true[MSZ] = {0.02, -0.01, 0.015};
+    float q_true[QSZ] = {1, 0, 0, 0};
+    float q_float[QSZ];
+    float bias_float[MSZ];
+    float q_fixf[QSZ];
+    float w[QSZ];
+    float q_dot[QSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    q16_t acc_fix[MSZ];
+    q16_t mag_fix[MSZ];
+    q16_t gyro_fix[MSZ];
+    q30_t q_fix[QSZ];
+    q16_t bias_fix[MSZ];
+    const q30_t dt_fix = FLOAT_TO_Q30(TEST_DT);
+    double sq_float = 0;
+    double sq_fix = 0;
+    double sq_diff = 0;
+    float max_diff = 0;
+    float max_bias_diff = 0;
+    float e;
+    float norm;
+    float t;
+    int step;
+    int i;
+
+    Board_init();
+    Serial_init();
+    printf("AHRS fixed point test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    for (step = 0; step < TEST_STEPS; step++) {
+        t = step * TEST_DT;
+        /* body rates and the true attitude, integrated finely */
+        w[0] = 0;
+        w[1] = 0.6 * sin(0.7 * t);
+        w[2] = 0.4 * sin(1.1 * t + 1.0);
+        w[3] = 0.3 * cos(0.5 * t);
+        for (i = 0; i < 10; i++) {
+            lin_alg_q_mult(q_true, w, q_dot);
+            lin_alg_scale_q(0.05 * TEST_DT, q_dot);
+            q_true[0] += q_dot[0];
+            q_true[1] += q_dot[1];
+            q_true[2] += q_dot[2];
+            q_true[3] += q_dot[3];
+            lin_alg_scale_q(1.0 / lin_alg_q_norm(q_true), q_true);
+        }
+        lin_alg_q_rot_v_q_pair(a_ref, m_ref, q_true, acc, mag);
+        for (i = 0; i < MSZ; i++) {
+            acc[i] += test_noise();
+            mag[i] += test_noise();
+            gyro[i] = w[i + 1] + bias_true[i] + test_noise();
+            acc_fix[i] = FLOAT_TO_Q16(acc[i]);
+            mag_fix[i] = FLOAT_TO_Q16(mag[i]);
+            gyro_fix[i] = FLOAT_TO_Q16(gyro[i]);
+        }
+
+        AHRS_update(acc, mag, gyro, TEST_DT, q_float, bias_float);
+        AHRS_fix_update(acc_fix, mag_fix, gyro_fix, dt_fix, q_fix, bias_fix);
+        for (i = 0; i < QSZ; i++) {
+            q_fixf[i] = Q30_TO_FLOAT(q_fix[i]);
+        }
+        if (step < SETTLE_STEPS) {
+            continue;
+        }
+        e = q_angle_deg(q_true, q_float);
+        sq_float += e * e;
+        e = q_angle_deg(q_true, q_fixf);
+        sq_fix += e * e;
+        e = q_angle_deg(q_float, q_fixf);
+        sq_diff += e * e;
+        if (e > max_diff) {
+            max_diff = e;
+        }
+        for (i = 0; i < MSZ; i++) {
+            e = fabs(Q16_TO_FLOAT(bias_fix[i]) - bias_float[i]);
+            if (e > max_bias_diff) {
+                max_bias_diff = e;
+            }
+        }
+    }
+    norm = 1.0 / (TEST_STEPS - SETTLE_STEPS);
+    printf("attitude error RMS, float %.4f deg, fixed %.4f deg\r\n",
+            sqrt(sq_float * norm), sqrt(sq_fix * norm));
+    printf("fixed against float RMS %.5f deg, max %.5f deg\r\n", sqrt(sq_diff * norm), max_diff);
+    printf("bias, fixed against float max %.2e rad/sec, float %+.4f %+.4f %+.4f\r\n",
+            max_bias_diff, bias_float[0], bias_float[1], bias_float[2]);
+    printf("%s\r\n", max_diff < TOL_DEG ? "AHRS fixed point tests passed" : "AHRS fixed point tests FAILED");
+    return 0;
+}
+#endif //AHRS_FIX_TESTING
@@ -0,0 +1,83 @@
+/* ************************************************************************** */
+/** Attitude Heading Reference System, fixed point
+ * File:   AHRS_fix.h
+ * Author: Aaron Hunter
+ * Brief: The Mahoney complementary filter of AHRS.c in Q2.30 and Q16.16
+ * integer arithmetic, see Lin_alg_fix.h.  The attitude and unit vectors are
+ * Q2.30, rates, gains and the calibrated sensor vectors Q16.16, so the
+ * output of IMU_get_norm_data_fix() feeds AHRS_fix_update() without a float
+ * operation.  Building AHRS.c with AHRS_FIXED_POINT defined runs
+ * AHRS_update() on this filter for applications that keep the float API.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+/* ************************************************************************** */
+
+#ifndef AHRS_FIX_H    /* Guard against multiple inclusion */
+#define AHRS_FIX_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Lin_alg_fix.h"
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_fix_set_mag_inertial(q30_t mag_i[MSZ])
+ * @param mag_i, normalized local magnetic field (ENU), Q2.30
+ * @author Aaron Hunter
+ */
+void AHRS_fix_set_mag_inertial(q30_t mag_i[MSZ]);
+
+/**
+ * @Function AHRS_fix_set_filter_gains(q16_t kp_a_set, q16_t ki_a_set, q16_t kp_m_set, q16_t ki_m_set)
+ * @param kp_a_set, ki_a_set, kp_m_set, ki_m_set, filter gains in Q16.16
+ * @author Aaron Hunter
+ */
+void AHRS_fix_set_filter_gains(q16_t kp_a_set, q16_t ki_a_set, q16_t kp_m_set, q16_t ki_m_set);
+
+/**
+ * @Function AHRS_fix_update(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ])
+ * @param accels, mags, calibrated accelerometer and magnetometer vectors in
+ * Q16.16, any length
+ * @param gyros, gyro rates in rad/sec, Q16.16
+ * @param dt, the integration time in seconds, Q2.30
+ * @param q, returns the attitude quaternion, Q2.30
+ * @param bias, returns the gyro bias estimate in rad/sec, Q16.16
+ * @brief complementary filter update step, AHRS_fix_correct() followed by
+ * AHRS_fix_propagate()
+ * @author Aaron Hunter
+ */
+void AHRS_fix_update(q16_t accels[MSZ], q16_t mags[MSZ], q16_t gyros[MSZ],
+        q30_t dt, q30_t q[QSZ], q16_t bias[MSZ]);
+
+/**
+ * @Function AHRS_fix_correct(q16_t accels[MSZ], q16_t mags[MSZ], q30_t dt)
+ * @param accels, mags, calibrated sensor vectors in Q16.16, either may be NULL
+ * @param dt, time since the previous correction from these sensors, Q2.30
+ * @brief same as AHRS_correct()
+ * @author Aaron Hunter
+ */
+void AHRS_fix_correct(q16_t accels[MSZ], q16_t mags[MSZ], q30_t dt);
+
+/**
+ * @Function AHRS_fix_propagate(q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ])
+ * @param gyros, gyro rates in rad/sec, Q16.16
+ * @param dt, the integration time in seconds, Q2.30
+ * @param q, returns the attitude quaternion, Q2.30
+ * @param bias, returns the gyro bias estimate in rad/sec, Q16.16
+ * @brief same as AHRS_propagate()
+ * @author Aaron Hunter
+ */
+void AHRS_fix_propagate(q16_t gyros[MSZ], q30_t dt, q30_t q[QSZ], q16_t bias[MSZ]);
+
+#endif /* AHRS_FIX_H */
+
+/* *****************************************************************************
+ End of File
+ */
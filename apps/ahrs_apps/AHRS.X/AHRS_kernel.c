@@ -0,0 +1,57 @@
+/*
+ * File:   AHRS_kernel.c
+ * Author: Aaron Hunter
+ * Brief: Instantiates the precision generic AHRS kernel of AHRS_kernel_impl.h
+ * in float and double, see AHRS_kernel.h.  Building with
+ * AHRS_KERNEL_DOUBLE_ONLY or AHRS_KERNEL_FLOAT_ONLY leaves the other type out
+ * of the image.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <math.h>
+#include <stddef.h>
+#include "AHRS_kernel.h"
+
+/*******************************************************************************
+ * INSTANTIATIONS                                                              *
+ ******************************************************************************/
+
+#ifndef AHRS_KERNEL_DOUBLE_ONLY
+#define AHRS_REAL float
+#define AHRS_SFX f
+#define AHRS_SQRT sqrtf
+#define AHRS_ATAN2 atan2f
+#define AHRS_ASIN asinf
+#define AHRS_COS cosf
+#define AHRS_SIN sinf
+#include "AHRS_kernel_impl.h"
+#undef AHRS_REAL
+#undef AHRS_SFX
+#undef AHRS_SQRT
+#undef AHRS_ATAN2
+#undef AHRS_ASIN
+#undef AHRS_COS
+#undef AHRS_SIN
+#endif
+
+#ifndef AHRS_KERNEL_FLOAT_ONLY
+#define AHRS_REAL double
+#define AHRS_SFX d
+#define AHRS_SQRT sqrt
+#define AHRS_ATAN2 atan2
+#define AHRS_ASIN asin
+#define AHRS_COS cos
+#define AHRS_SIN sin
+#include "AHRS_kernel_impl.h"
+#undef AHRS_REAL
+#undef AHRS_SFX
+#undef AHRS_SQRT
+#undef AHRS_ATAN2
+#undef AHRS_ASIN
+#undef AHRS_COS
+#undef AHRS_SIN
+#endif
@@ -0,0 +1,174 @@
+/* ************************************************************************** */
+/** Attitude Heading Reference System, precision generic kernel
+ * File:   AHRS_kernel.h
+ * Author: Aaron Hunter
+ * Brief: The complementary filter described by Mahoney 2008 and the quaternion
+ * helpers it needs, written once in AHRS_kernel_impl.h for any floating point
+ * type.  AHRS_kernel.c instantiates it in float, suffix _f, used by AHRS.c and
+ * q_ahrs.X, and in double, suffix _d, used by q_ahrs_dbl.X.  The attitude, the
+ * bias, the held correction rates, the gains and the reference vectors of one
+ * filter live in its AHRS_kernel_<sfx>_t, so several filters can run side by
+ * side.  The fixed point filter in AHRS_fix.c and the MATLAB generated
+ * ahrs_q_update() are separate implementations of the same filter, and
+ * ahrs_replay.c cross validates all of them on a log.
+ * Created on Oct 16, 2026
+ * Modified on Oct 16, 2026 to choose the attitude integrator, the first order
+ * Euler step or the exponential map, see AHRS_integrator_t
+ */
+/* ************************************************************************** */
+
+#ifndef AHRS_KERNEL_H    /* Guard against multiple inclusion */
+#define AHRS_KERNEL_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+#define QSZ 4
+
+/* default filter gains */
+#define AHRS_KP_A 2.5 //accelerometer proportional gain
+#define AHRS_KI_A 0.05 // accelerometer integral gain
+#define AHRS_KP_M 2.5 // magnetometer proportional gain
+#define AHRS_KI_M 0.05 //magnetometer integral gain
+
+/* Earth's magnetic field inertial vector at 37 N, 122 W, normalized
+ * North 22,680.8 nT	East 5,217.6 nT	Down 41,324.7 nT, value from NOAA
+ * converted into ENU format: */
+#define AHRS_MAG_INERTIAL {0.110011998753301, 0.478219898291142, -0.871322609031072}
+
+/* attitude integrator of AHRS_KERNEL_DEFAULTS, one of AHRS_integrator_t */
+#ifndef AHRS_INTEGRATOR
+#define AHRS_INTEGRATOR AHRS_INTEGRATE_EULER
+#endif
+
+/* series of the exponential map exp([0, v]) = [cos(a), sin(a)/a v], a = |v|,
+ * in powers of a^2, evaluated by Horner's rule */
+#define AHRS_EXP_C2 (1.0 / 2.0)
+#define AHRS_EXP_C4 (1.0 / 24.0)
+#define AHRS_EXP_S2 (1.0 / 6.0)
+#define AHRS_EXP_S4 (1.0 / 120.0)
+/* below this a^2 the exact map uses the 4th order series, the truncation error
+ * is under a^6 / 720 */
+#define AHRS_EXP_SMALL_ANGLE_SQ 1.0e-4
+
+/* static initializer for an AHRS_kernel_<sfx>_t, same as AHRS_kernel_init_<sfx>() */
+#define AHRS_KERNEL_DEFAULTS { \
+    .q = {1, 0, 0, 0}, \
+    .kp_a = AHRS_KP_A, .ki_a = AHRS_KI_A, .kp_m = AHRS_KP_M, .ki_m = AHRS_KI_M, \
+    .a_i = {0, 0, 1.0}, \
+    .m_i = AHRS_MAG_INERTIAL, \
+    .integrator = AHRS_INTEGRATOR \
+}
+
+/* AHRS_KERNEL_FN(update, f) is AHRS_kernel_update_f */
+#define AHRS_KERNEL_GLUE(name, sfx) AHRS_kernel_ ## name ## _ ## sfx
+#define AHRS_KERNEL_FN(name, sfx) AHRS_KERNEL_GLUE(name, sfx)
+/* AHRS_KERNEL_T(f) is AHRS_kernel_f_t */
+#define AHRS_KERNEL_T(sfx) AHRS_KERNEL_GLUE(sfx, t)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS AND FUNCTION PROTOTYPES                                     *
+ ******************************************************************************/
+
+/* How AHRS_kernel_propagate_<sfx>() turns the rate w over dt into an attitude
+ * step.  The Euler step is q + 1/2 q [0, w] dt, which grows the norm by
+ * (|w| dt / 2)^2 and needs a full normalization.  The exponential map steps
+ * q [cos(a), sin(a)/a v] with v = w dt / 2, a = |v|, exact for a rate held over
+ * dt.  EXP2 and EXP4 truncate the series of cos(a) and sin(a)/a after the a^2
+ * and a^4 terms, so after normalization their angle error per step is O(a^5)
+ * and O(a^7) against O(a^3) for Euler.  They leave the norm within a^4 / 12
+ * and a^6 / 360 of one, so the exponential forms renormalize with one Newton
+ * step of the inverse square root, (3 - |q|^2) / 2, instead of a square root
+ * and a divide.  EXACT calls the cos and sin of the type. */
+typedef enum {
+    AHRS_INTEGRATE_EULER = 0,
+    AHRS_INTEGRATE_EXP2,
+    AHRS_INTEGRATE_EXP4,
+    AHRS_INTEGRATE_EXACT,
+    AHRS_NUM_INTEGRATORS
+} AHRS_integrator_t;
+
+/* The declarations for one type, see AHRS_kernel_impl.h for the definitions.
+ *
+ * AHRS_kernel_<sfx>_t
+ *     q, attitude quaternion, v_b = q* v_i q
+ *     bias, gyro bias estimate in rad/sec
+ *     w_corr_a, w_corr_m, proportional correction rates held between
+ *         corrections
+ *     kp_a, ki_a, kp_m, ki_m, filter gains
+ *     a_i, m_i, normalized inertial gravity and magnetic field (ENU)
+ *     integrator, the AHRS_integrator_t of propagate
+ *
+ * void AHRS_kernel_init_<sfx>(AHRS_kernel_<sfx>_t *k)
+ *     identity attitude, zero bias, default gains and reference vectors
+ *
+ * void AHRS_kernel_correct_<sfx>(AHRS_kernel_<sfx>_t *k, real accels[MSZ],
+ *         real mags[MSZ], real dt)
+ *     computes the correction rates from calibrated accelerometer and
+ *     magnetometer vectors, either may be NULL to skip that sensor, and
+ *     integrates the bias over dt, the time since the previous correction.
+ *     The vectors are normalized in place.
+ *
+ * void AHRS_kernel_propagate_<sfx>(AHRS_kernel_<sfx>_t *k, real gyros[MSZ], real dt)
+ *     integrates the bias corrected gyros in rad/sec plus the held correction
+ *     rates over dt with k->integrator
+ *
+ * void AHRS_kernel_update_<sfx>(AHRS_kernel_<sfx>_t *k, real accels[MSZ],
+ *         real mags[MSZ], real gyros[MSZ], real dt)
+ *     correct then propagate, the single rate filter
+ *
+ * void AHRS_kernel_q_mult_<sfx>(real q[QSZ], real p[QSZ], real r[QSZ])
+ *     r = q p, Hamilton product
+ *
+ * void AHRS_kernel_q_rot_v_q_pair_<sfx>(real v1_i[MSZ], real v2_i[MSZ],
+ *         real q[QSZ], real v1_b[MSZ], real v2_b[MSZ])
+ *     rotates two inertial vectors into the body frame through one DCM
+ *
+ * void AHRS_kernel_cross_<sfx>(real u[MSZ], real v[MSZ], real w[MSZ])
+ *     w = u x v
+ *
+ * void AHRS_kernel_q_to_euler_<sfx>(real q[QSZ], real euler[MSZ])
+ *     euler angles in [psi, theta, phi] order in radians
+ */
+#define AHRS_KERNEL_DECLARE(real, sfx) \
+    typedef struct { \
+        real q[QSZ]; \
+        real bias[MSZ]; \
+        real w_corr_a[MSZ]; \
+        real w_corr_m[MSZ]; \
+        real kp_a; \
+        real ki_a; \
+        real kp_m; \
+        real ki_m; \
+        real a_i[MSZ]; \
+        real m_i[MSZ]; \
+        uint8_t integrator; \
+    } AHRS_KERNEL_T(sfx); \
+    void AHRS_KERNEL_FN(init, sfx)(AHRS_KERNEL_T(sfx) *k); \
+    void AHRS_KERNEL_FN(correct, sfx)(AHRS_KERNEL_T(sfx) *k, real accels[MSZ], \
+            real mags[MSZ], real dt); \
+    void AHRS_KERNEL_FN(propagate, sfx)(AHRS_KERNEL_T(sfx) *k, real gyros[MSZ], \
+            real dt); \
+    void AHRS_KERNEL_FN(update, sfx)(AHRS_KERNEL_T(sfx) *k, real accels[MSZ], \
+            real mags[MSZ], real gyros[MSZ], real dt); \
+    void AHRS_KERNEL_FN(q_mult, sfx)(real q[QSZ], real p[QSZ], real r[QSZ]); \
+    void AHRS_KERNEL_FN(q_rot_v_q_pair, sfx)(real v1_i[MSZ], real v2_i[MSZ], \
+            real q[QSZ], real v1_b[MSZ], real v2_b[MSZ]); \
+    void AHRS_KERNEL_FN(cross, sfx)(real u[MSZ], real v[MSZ], real w[MSZ]); \
+    void AHRS_KERNEL_FN(q_to_euler, sfx)(real q[QSZ], real euler[MSZ])
+
+AHRS_KERNEL_DECLARE(float, f);
+AHRS_KERNEL_DECLARE(double, d);
+
+#endif /* AHRS_KERNEL_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,238 @@
+/*
+ * File:   AHRS_kernel_impl.h
+ * Author: Aaron Hunter
+ * Brief: Body of the precision generic AHRS kernel declared in AHRS_kernel.h.
+ * AHRS_kernel.c includes it once per type with AHRS_REAL (the type), AHRS_SFX
+ * (the name suffix) and AHRS_SQRT, AHRS_ATAN2, AHRS_ASIN, AHRS_COS, AHRS_SIN
+ * (the math functions of that type) defined, so there is deliberately no
+ * include guard.  Constants are cast to AHRS_REAL so the float build never
+ * promotes to double.
+ * Created on Oct 16, 2026
+ * Modified on Oct 16, 2026 to add the exponential map integrators
+ */
+
+#define KERNEL_T AHRS_KERNEL_T(AHRS_SFX)
+#define KERNEL_FN(name) AHRS_KERNEL_FN(name, AHRS_SFX)
+#define K(x) ((AHRS_REAL) (x))
+
+/**
+ * @Function AHRS_kernel_init_<sfx>(AHRS_kernel_<sfx>_t *k)
+ * @brief identity attitude, zero bias, default gains and reference vectors
+ * @author Aaron Hunter */
+void KERNEL_FN(init)(KERNEL_T *k) {
+    const KERNEL_T defaults = AHRS_KERNEL_DEFAULTS;
+    *k = defaults;
+}
+
+/**
+ * @Function AHRS_kernel_correct_<sfx>(AHRS_kernel_<sfx>_t *k, real accels[MSZ], real mags[MSZ], real dt)
+ * @param accels, mags, calibrated accelerometer and magnetometer vectors,
+ * either may be NULL to skip that sensor
+ * @param dt, time since the previous correction from these sensors in seconds
+ * @brief computes the proportional correction rates from the measured and
+ * estimated reference vectors and integrates the gyro bias
+ * @note the correction rate of each sensor is held by
+ * AHRS_kernel_propagate_<sfx>() until its next correction
+ * @author Aaron Hunter */
+void KERNEL_FN(correct)(KERNEL_T *k, AHRS_REAL accels[MSZ], AHRS_REAL mags[MSZ],
+        AHRS_REAL dt) {
+    AHRS_REAL a_b[MSZ]; //estimated gravity vector in body frame
+    AHRS_REAL m_b[MSZ]; //estimated magnetic field vector in body frame
+    AHRS_REAL w_meas[MSZ]; // correction rate
+    AHRS_REAL n;
+    int row;
+
+    /* estimate gravity and magnetic field vectors in body frame */
+    KERNEL_FN(q_rot_v_q_pair)(k->a_i, k->m_i, k->q, a_b, m_b);
+
+    if (accels != NULL) {
+        /* normalize inertial measurements */
+        n = K(1.0) / AHRS_SQRT(accels[0] * accels[0] + accels[1] * accels[1]
+                + accels[2] * accels[2]);
+        for (row = 0; row < MSZ; row++) {
+            accels[row] *= n;
+        }
+        /*Accelerometer attitude calculations */
+        KERNEL_FN(cross)(accels, a_b, w_meas);
+        for (row = 0; row < MSZ; row++) {
+            k->w_corr_a[row] = k->kp_a * w_meas[row];
+            k->bias[row] -= k->ki_a * w_meas[row] * dt;
+        }
+    }
+
+    if (mags != NULL) {
+        n = K(1.0) / AHRS_SQRT(mags[0] * mags[0] + mags[1] * mags[1]
+                + mags[2] * mags[2]);
+        for (row = 0; row < MSZ; row++) {
+            mags[row] *= n;
+        }
+        /*Magnetometer attitude calculations*/
+        KERNEL_FN(cross)(mags, m_b, w_meas);
+        for (row = 0; row < MSZ; row++) {
+            k->w_corr_m[row] = k->kp_m * w_meas[row];
+            k->bias[row] -= k->ki_m * w_meas[row] * dt;
+        }
+    }
+}
+
+/**
+ * @Function AHRS_kernel_propagate_<sfx>(AHRS_kernel_<sfx>_t *k, real gyros[MSZ], real dt)
+ * @param gyros, gyro rates in rad/sec
+ * @param dt, the integration time in seconds
+ * @brief integrates the bias corrected gyro rates plus the held correction
+ * rates with k->integrator and normalizes the attitude
+ * @author Aaron Hunter
+ * @modified 10/16/26 exponential map integrators, see AHRS_integrator_t */
+void KERNEL_FN(propagate)(KERNEL_T *k, AHRS_REAL gyros[MSZ], AHRS_REAL dt) {
+    AHRS_REAL gyro_q_wfb[QSZ]; // gyro 'rate' after feedback as a pure quaternion
+    AHRS_REAL q_dot[QSZ]; // quaternion derivative
+    AHRS_REAL dq[QSZ]; // attitude step, exp([0, w dt / 2])
+    AHRS_REAL q_plus[QSZ];
+    AHRS_REAL half_dt = K(0.5) * dt;
+    AHRS_REAL a2; // squared half angle of the step
+    AHRS_REAL a;
+    AHRS_REAL s; // sin(a) / a
+    AHRS_REAL n;
+    int row;
+
+    gyro_q_wfb[0] = 0;
+    for (row = 0; row < MSZ; row++) {
+        gyro_q_wfb[row + 1] = gyros[row] - k->bias[row] + k->w_corr_a[row]
+                + k->w_corr_m[row];
+    }
+
+    if (k->integrator == AHRS_INTEGRATE_EULER) {
+        /* integrate the quaternion derivative and normalize for stability */
+        KERNEL_FN(q_mult)(k->q, gyro_q_wfb, q_dot);
+        for (row = 0; row < QSZ; row++) {
+            k->q[row] += q_dot[row] * half_dt;
+        }
+        n = K(1.0) / AHRS_SQRT(k->q[0] * k->q[0] + k->q[1] * k->q[1]
+                + k->q[2] * k->q[2] + k->q[3] * k->q[3]);
+        for (row = 0; row < QSZ; row++) {
+            k->q[row] *= n;
+        }
+        return;
+    }
+
+    /* rotation vector of half the step */
+    for (row = 1; row < QSZ; row++) {
+        gyro_q_wfb[row] *= half_dt;
+    }
+    a2 = gyro_q_wfb[1] * gyro_q_wfb[1] + gyro_q_wfb[2] * gyro_q_wfb[2]
+            + gyro_q_wfb[3] * gyro_q_wfb[3];
+    if (k->integrator == AHRS_INTEGRATE_EXP2) {
+        dq[0] = K(1.0) - a2 * K(AHRS_EXP_C2);
+        s = K(1.0) - a2 * K(AHRS_EXP_S2);
+    } else if ((k->integrator == AHRS_INTEGRATE_EXACT)
+            && (a2 > K(AHRS_EXP_SMALL_ANGLE_SQ))) {
+        a = AHRS_SQRT(a2);
+        dq[0] = AHRS_COS(a);
+        s = AHRS_SIN(a) / a;
+    } else {
+        dq[0] = K(1.0) - a2 * (K(AHRS_EXP_C2) - a2 * K(AHRS_EXP_C4));
+        s = K(1.0) - a2 * (K(AHRS_EXP_S2) - a2 * K(AHRS_EXP_S4));
+    }
+    for (row = 1; row < QSZ; row++) {
+        dq[row] = s * gyro_q_wfb[row];
+    }
+    KERNEL_FN(q_mult)(k->q, dq, q_plus);
+
+    /* |q_plus|^2 is within a^4 / 12 of one, one Newton step of 1 / sqrt() */
+    n = K(0.5) * (K(3.0) - (q_plus[0] * q_plus[0] + q_plus[1] * q_plus[1]
+            + q_plus[2] * q_plus[2] + q_plus[3] * q_plus[3]));
+    for (row = 0; row < QSZ; row++) {
+        k->q[row] = q_plus[row] * n;
+    }
+}
+
+/**
+ * @Function AHRS_kernel_update_<sfx>(AHRS_kernel_<sfx>_t *k, real accels[MSZ], real mags[MSZ], real gyros[MSZ], real dt)
+ * @brief one correction and one propagation step over dt
+ * @author Aaron Hunter */
+void KERNEL_FN(update)(KERNEL_T *k, AHRS_REAL accels[MSZ], AHRS_REAL mags[MSZ],
+        AHRS_REAL gyros[MSZ], AHRS_REAL dt) {
+    KERNEL_FN(correct)(k, accels, mags, dt);
+    KERNEL_FN(propagate)(k, gyros, dt);
+}
+
+/**
+ * @Function AHRS_kernel_q_mult_<sfx>(real q[QSZ], real p[QSZ], real r[QSZ])
+ * @brief r = q p, the Hamilton product
+ * @author Aaron Hunter */
+void KERNEL_FN(q_mult)(AHRS_REAL q[QSZ], AHRS_REAL p[QSZ], AHRS_REAL r[QSZ]) {
+    r[0] = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
+    r[1] = p[1] * q[0] + p[0] * q[1] + p[3] * q[2] - p[2] * q[3];
+    r[2] = p[2] * q[0] - p[3] * q[1] + p[0] * q[2] + p[1] * q[3];
+    r[3] = p[3] * q[0] + p[2] * q[1] - p[1] * q[2] + p[0] * q[3];
+}
+
+/**
+ * @Function AHRS_kernel_q_rot_v_q_pair_<sfx>(real v1_i[MSZ], real v2_i[MSZ], real q[QSZ], real v1_b[MSZ], real v2_b[MSZ])
+ * @brief rotates two vectors from the inertial to the body frame, v_b = q* v_i q,
+ * through the DCM of the unit quaternion q, 27 multiplies
+ * @author Aaron Hunter */
+void KERNEL_FN(q_rot_v_q_pair)(AHRS_REAL v1_i[MSZ], AHRS_REAL v2_i[MSZ],
+        AHRS_REAL q[QSZ], AHRS_REAL v1_b[MSZ], AHRS_REAL v2_b[MSZ]) {
+    AHRS_REAL x2 = q[1] + q[1];
+    AHRS_REAL y2 = q[2] + q[2];
+    AHRS_REAL z2 = q[3] + q[3];
+    AHRS_REAL xx = q[1] * x2;
+    AHRS_REAL yy = q[2] * y2;
+    AHRS_REAL zz = q[3] * z2;
+    AHRS_REAL xy = q[1] * y2;
+    AHRS_REAL xz = q[1] * z2;
+    AHRS_REAL yz = q[2] * z2;
+    AHRS_REAL wx = q[0] * x2;
+    AHRS_REAL wy = q[0] * y2;
+    AHRS_REAL wz = q[0] * z2;
+    AHRS_REAL dcm[MSZ][MSZ];
+    int row;
+
+    dcm[0][0] = 1 - yy - zz;
+    dcm[0][1] = xy + wz;
+    dcm[0][2] = xz - wy;
+    dcm[1][0] = xy - wz;
+    dcm[1][1] = 1 - xx - zz;
+    dcm[1][2] = yz + wx;
+    dcm[2][0] = xz + wy;
+    dcm[2][1] = yz - wx;
+    dcm[2][2] = 1 - xx - yy;
+
+    for (row = 0; row < MSZ; row++) {
+        v1_b[row] = dcm[row][0] * v1_i[0] + dcm[row][1] * v1_i[1] + dcm[row][2] * v1_i[2];
+        v2_b[row] = dcm[row][0] * v2_i[0] + dcm[row][1] * v2_i[1] + dcm[row][2] * v2_i[2];
+    }
+}
+
+/**
+ * @Function AHRS_kernel_cross_<sfx>(real u[MSZ], real v[MSZ], real w[MSZ])
+ * @brief w = u x v
+ * @author Aaron Hunter */
+void KERNEL_FN(cross)(AHRS_REAL u[MSZ], AHRS_REAL v[MSZ], AHRS_REAL w[MSZ]) {
+    w[0] = u[1] * v[2] - u[2] * v[1];
+    w[1] = u[2] * v[0] - u[0] * v[2];
+    w[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/**
+ * @Function AHRS_kernel_q_to_euler_<sfx>(real q[QSZ], real euler[MSZ])
+ * @param euler, returns the euler angles in [psi, theta, phi] order
+ * @author Aaron Hunter */
+void KERNEL_FN(q_to_euler)(AHRS_REAL q[QSZ], AHRS_REAL euler[MSZ]) {
+    AHRS_REAL q00 = q[0] * q[0];
+    AHRS_REAL q11 = q[1] * q[1];
+    AHRS_REAL q22 = q[2] * q[2];
+    AHRS_REAL q33 = q[3] * q[3];
+
+    // psi
+    euler[0] = AHRS_ATAN2(K(2.0) * (q[1] * q[2] + q[0] * q[3]), q00 + q11 - q22 - q33);
+    // theta
+    euler[1] = AHRS_ASIN(K(2.0) * (q[0] * q[2] - q[1] * q[3]));
+    // phi
+    euler[2] = AHRS_ATAN2(K(2.0) * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
+}
+
+#undef KERNEL_T
+#undef KERNEL_FN
+#undef K
@@ -0,0 +1,357 @@
+/** Attitude Heading Reference System, multiplicative EKF
+ * File:   AHRS_mekf.c
+ * Author: Aaron Hunter
+ * Brief: 6 state error state Kalman filter for attitude and gyro bias
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include "AHRS_mekf.h"
+#include "Lin_alg_inline.h"
+#include "Board.h"
+#include <math.h>
+#include <stddef.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+/* default tuning, see AHRS_mekf_set_noise() */
+#define GYRO_NOISE 0.01 // rad/sec/sqrt(Hz), includes vibration and model error
+#define BIAS_NOISE 0.0005 // rad/sec^2/sqrt(Hz)
+#define ACC_NOISE 0.05 // normalized units
+#define MAG_NOISE 0.05
+/* the accelerometer only measures gravity when its magnitude is ~1 g, the
+ * variance grows with the square of the magnitude error over ACC_NORM_TOL */
+#define ACC_NORM_TOL 0.05
+/* initial standard deviations */
+#define ATTITUDE_INIT 0.5 // rad
+#define BIAS_INIT 0.05 // rad/sec
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void rot_small(float phi[MSZ], float v[MSZ], float v_out[MSZ]);
+static void vector_update(float z[MSZ], float h[MSZ], float r, float x[2 * MSZ]);
+static void symmetrize(float P[MSZ][MSZ]);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+// nominal attitude quaternion and gyro bias
+static float q_nom[QSZ] = {1, 0, 0, 0};
+static float b_nom[MSZ] = {0, 0, 0};
+
+/* covariance blocks of the error state [dtheta, db], P_ba is P_ab transposed */
+static float P_aa[MSZ][MSZ];
+static float P_ab[MSZ][MSZ];
+static float P_bb[MSZ][MSZ];
+
+/* noise, as variances */
+static float q_gyro = GYRO_NOISE * GYRO_NOISE;
+static float q_bias = BIAS_NOISE * BIAS_NOISE;
+static float r_acc = ACC_NOISE * ACC_NOISE;
+static float r_mag = MAG_NOISE * MAG_NOISE;
+
+/* gravity and magnetic field inertial vectors, see AHRS.c */
+static float a_i[MSZ] = {0, 0, 1.0};
+static float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+static uint8_t is_initialized = FALSE;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_mekf_init(void)
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_init(void) {
+    int8_t row;
+    int8_t col;
+
+    lin_alg_set_q(0, 0, 0, q_nom);
+    for (row = 0; row < MSZ; row++) {
+        b_nom[row] = 0;
+        for (col = 0; col < MSZ; col++) {
+            P_aa[row][col] = 0;
+            P_ab[row][col] = 0;
+            P_bb[row][col] = 0;
+        }
+        P_aa[row][row] = ATTITUDE_INIT * ATTITUDE_INIT;
+        P_bb[row][row] = BIAS_INIT * BIAS_INIT;
+    }
+    is_initialized = TRUE;
+}
+
+/**
+ * @Function AHRS_mekf_set_mag_inertial(float mag_i[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_set_mag_inertial(float mag_i[MSZ]) {
+    m_i[0] = mag_i[0];
+    m_i[1] = mag_i[1];
+    m_i[2] = mag_i[2];
+}
+
+/**
+ * @Function AHRS_mekf_set_noise(float gyro_noise, float bias_noise, float acc_noise, float mag_noise)
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_set_noise(float gyro_noise, float bias_noise, float acc_noise, float mag_noise) {
+    q_gyro = gyro_noise * gyro_noise;
+    q_bias = bias_noise * bias_noise;
+    r_acc = acc_noise * acc_noise;
+    r_mag = mag_noise * mag_noise;
+}
+
+/**
+ * @Function AHRS_mekf_get_covariance(float P_aa_get[MSZ][MSZ], float P_bb_get[MSZ][MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_get_covariance(float P_aa_get[MSZ][MSZ], float P_bb_get[MSZ][MSZ]) {
+    int8_t row;
+    int8_t col;
+
+    if (is_initialized == FALSE) {
+        AHRS_mekf_init();
+    }
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            P_aa_get[row][col] = P_aa[row][col];
+            P_bb_get[row][col] = P_bb[row][col];
+        }
+    }
+}
+
+/**
+ * @Function AHRS_mekf_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @brief with phi = (gyros - bias) dt the error transition is
+ *     [R  -dt I]    R = I - [phi x]
+ *     [0     I ]
+ * so P_bb only gains the bias noise and the other two blocks are
+ *     P_ab = R P_ab - dt P_bb
+ *     P_aa = R P_aa R' - dt (R P_ab + (R P_ab)') + dt^2 P_bb + gyro noise
+ * R v is v - phi x v, 6 multiplies, so the whole step is ~90 multiplies
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]) {
+    float w[QSZ]; // bias corrected rate as a pure quaternion
+    float q_dot[QSZ];
+    float phi[MSZ];
+    float A[MSZ][MSZ]; // R P_aa, then R P_aa R'
+    float M[MSZ][MSZ]; // R P_ab
+    float col_in[MSZ];
+    float col_out[MSZ];
+    float q_norm;
+    float dt2 = dt * dt;
+    int8_t row;
+    int8_t col;
+
+    if (is_initialized == FALSE) {
+        AHRS_mekf_init();
+    }
+
+    /* nominal attitude, same integration as AHRS_propagate() */
+    w[0] = 0;
+    for (row = 0; row < MSZ; row++) {
+        w[row + 1] = gyros[row] - b_nom[row];
+        phi[row] = w[row + 1] * dt;
+    }
+    lin_alg_q_mult_inline(q_nom, w, q_dot);
+    for (row = 0; row < QSZ; row++) {
+        q_nom[row] = q_nom[row] + 0.5 * q_dot[row] * dt;
+    }
+    q_norm = 1.0 / lin_alg_q_norm_inline(q_nom);
+    lin_alg_scale_q_inline(q_norm, q_nom);
+
+    /* R P_aa and R P_ab column by column */
+    for (col = 0; col < MSZ; col++) {
+        for (row = 0; row < MSZ; row++) {
+            col_in[row] = P_aa[row][col];
+        }
+        rot_small(phi, col_in, col_out);
+        for (row = 0; row < MSZ; row++) {
+            A[row][col] = col_out[row];
+            col_in[row] = P_ab[row][col];
+        }
+        rot_small(phi, col_in, col_out);
+        for (row = 0; row < MSZ; row++) {
+            M[row][col] = col_out[row];
+        }
+    }
+    /* (R P_aa) R' row by row, the rows of a symmetric result are its columns */
+    for (row = 0; row < MSZ; row++) {
+        rot_small(phi, A[row], A[row]);
+    }
+
+    for (row = 0; row < MSZ; row++) {
+        for (col = row; col < MSZ; col++) {
+            P_aa[row][col] = A[row][col] - dt * (M[row][col] + M[col][row])
+                    + dt2 * P_bb[row][col];
+        }
+        for (col = 0; col < MSZ; col++) {
+            P_ab[row][col] = M[row][col] - dt * P_bb[row][col];
+        }
+    }
+    symmetrize(P_aa);
+    for (row = 0; row < MSZ; row++) {
+        P_aa[row][row] += q_gyro * dt;
+        P_bb[row][row] += q_bias * dt;
+    }
+
+    /* set external attitude and bias*/
+    for (row = 0; row < MSZ; row++) {
+        bias[row] = b_nom[row];
+    }
+    for (row = 0; row < QSZ; row++) {
+        q[row] = q_nom[row];
+    }
+}
+
+/**
+ * @Function AHRS_mekf_correct(float accels[MSZ], float mags[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_correct(float accels[MSZ], float mags[MSZ]) {
+    float a_b[MSZ]; //estimated gravity vector in body frame
+    float m_b[MSZ]; //estimated magnetic field vector in body frame
+    float x[2 * MSZ] = {0, 0, 0, 0, 0, 0}; // error state estimate
+    float dq[QSZ];
+    float q_temp[QSZ];
+    float norm;
+    float q_norm;
+    float r;
+    int8_t row;
+
+    if (is_initialized == FALSE) {
+        AHRS_mekf_init();
+    }
+    lin_alg_q_rot_v_q_pair(a_i, m_i, q_nom, a_b, m_b);
+
+    if (accels != NULL) {
+        norm = lin_alg_v_norm_inline(accels);
+        if (norm > 0) {
+            lin_alg_v_scale_inline(1.0 / norm, accels);
+            r = (norm - 1.0) / ACC_NORM_TOL;
+            vector_update(accels, a_b, r_acc * (1.0 + r * r), x);
+        }
+    }
+    if (mags != NULL) {
+        norm = lin_alg_v_norm_inline(mags);
+        if (norm > 0) {
+            lin_alg_v_scale_inline(1.0 / norm, mags);
+            vector_update(mags, m_b, r_mag, x);
+        }
+    }
+
+    /* reset: fold the error into the nominal state */
+    dq[0] = 1.0;
+    dq[1] = 0.5 * x[0];
+    dq[2] = 0.5 * x[1];
+    dq[3] = 0.5 * x[2];
+    lin_alg_q_mult_inline(q_nom, dq, q_temp);
+    q_norm = 1.0 / lin_alg_q_norm_inline(q_temp);
+    for (row = 0; row < QSZ; row++) {
+        q_nom[row] = q_temp[row] * q_norm;
+    }
+    for (row = 0; row < MSZ; row++) {
+        b_nom[row] += x[row + MSZ];
+    }
+}
+
+/**
+ * @Function AHRS_mekf_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    AHRS_mekf_correct(accels, mags);
+    AHRS_mekf_propagate(gyros, dt, q, bias);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function rot_small(float phi[MSZ], float v[MSZ], float v_out[MSZ])
+ * @param phi, a small rotation vector
+ * @param v, the vector to rotate
+ * @param v_out, (I - [phi x]) v, may be v
+ */
+static void rot_small(float phi[MSZ], float v[MSZ], float v_out[MSZ]) {
+    float v0 = v[0];
+    float v1 = v[1];
+    float v2 = v[2];
+    v_out[0] = v0 - (phi[1] * v2 - phi[2] * v1);
+    v_out[1] = v1 - (phi[2] * v0 - phi[0] * v2);
+    v_out[2] = v2 - (phi[0] * v1 - phi[1] * v0);
+}
+
+/**
+ * @Function vector_update(float z[MSZ], float h[MSZ], float r, float x[2 * MSZ])
+ * @param z, the measured unit vector in the body frame
+ * @param h, the same vector predicted from the nominal attitude
+ * @param r, variance of each component of z
+ * @param x, the error state, updated
+ * @brief z = h + [h x] dtheta, processed one component at a time so the
+ * innovation variance is a scalar.  The rows of [h x] have one zero, each
+ * component is ~40 multiplies and one divide.
+ */
+static void vector_update(float z[MSZ], float h[MSZ], float r, float x[2 * MSZ]) {
+    float H[MSZ][MSZ] = {
+        {0, -h[2], h[1]},
+        {h[2], 0, -h[0]},
+        {-h[1], h[0], 0}
+    };
+    float Pa_h[MSZ]; // P_aa H'
+    float Pb_h[MSZ]; // P_ab' H'
+    float K_a[MSZ];
+    float K_b[MSZ];
+    float innovation;
+    float s_inv;
+    int8_t i;
+    int8_t row;
+    int8_t col;
+
+    for (i = 0; i < MSZ; i++) {
+        for (row = 0; row < MSZ; row++) {
+            Pa_h[row] = P_aa[row][0] * H[i][0] + P_aa[row][1] * H[i][1] + P_aa[row][2] * H[i][2];
+            Pb_h[row] = P_ab[0][row] * H[i][0] + P_ab[1][row] * H[i][1] + P_ab[2][row] * H[i][2];
+        }
+        s_inv = 1.0 / (H[i][0] * Pa_h[0] + H[i][1] * Pa_h[1] + H[i][2] * Pa_h[2] + r);
+        innovation = z[i] - h[i] - (H[i][0] * x[0] + H[i][1] * x[1] + H[i][2] * x[2]);
+        for (row = 0; row < MSZ; row++) {
+            K_a[row] = Pa_h[row] * s_inv;
+            K_b[row] = Pb_h[row] * s_inv;
+            x[row] += K_a[row] * innovation;
+            x[row + MSZ] += K_b[row] * innovation;
+        }
+        /* P = P - K H P, block by block */
+        for (row = 0; row < MSZ; row++) {
+            for (col = row; col < MSZ; col++) {
+                P_aa[row][col] -= K_a[row] * Pa_h[col];
+                P_bb[row][col] -= K_b[row] * Pb_h[col];
+            }
+            for (col = 0; col < MSZ; col++) {
+                P_ab[row][col] -= K_a[row] * Pb_h[col];
+            }
+        }
+        symmetrize(P_aa);
+        symmetrize(P_bb);
+    }
+}
+
+/**
+ * @Function symmetrize(float P[MSZ][MSZ])
+ * @brief copies the upper triangle to the lower
+ */
+static void symmetrize(float P[MSZ][MSZ]) {
+    P[1][0] = P[0][1];
+    P[2][0] = P[0][2];
+    P[2][1] = P[1][2];
+}
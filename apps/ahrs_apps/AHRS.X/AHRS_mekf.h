@@ -0,0 +1,103 @@
+/* ************************************************************************** */
+/** Attitude Heading Reference System, multiplicative EKF
+ * File:   AHRS_mekf.h
+ * Author: Aaron Hunter
+ * Brief: Error state (multiplicative) extended Kalman filter for attitude and
+ * gyro bias.  The quaternion is kept as the nominal state and the filter
+ * estimates the 6 element error x = [dtheta, db], a small body frame rotation
+ * q_true = q (x) [1, dtheta / 2] and a bias correction, which is folded back
+ * into q and b after every measurement.  The 6x6 covariance is held as its
+ * three distinct 3x3 blocks P_aa, P_ab and P_bb, and the bias block has no
+ * dynamics, so one propagation costs a fixed ~90 multiplies and each
+ * measurement vector three scalar updates without a matrix inverse.
+ * Building AHRS.c with AHRS_MEKF defined runs AHRS_update() on this filter.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+/* ************************************************************************** */
+
+#ifndef AHRS_MEKF_H    /* Guard against multiple inclusion */
+#define AHRS_MEKF_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Lin_alg_float.h"
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function AHRS_mekf_init(void)
+ * @brief resets the attitude to identity, the bias to zero and the covariance
+ * to its initial value
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_init(void);
+
+/**
+ * @Function AHRS_mekf_set_mag_inertial(float mag_i[MSZ])
+ * @param mag_i, normalized local magnetic field (ENU)
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_set_mag_inertial(float mag_i[MSZ]);
+
+/**
+ * @Function AHRS_mekf_set_noise(float gyro_noise, float bias_noise, float acc_noise, float mag_noise)
+ * @param gyro_noise, gyro noise density in rad/sec/sqrt(Hz)
+ * @param bias_noise, gyro bias random walk in rad/sec^2/sqrt(Hz)
+ * @param acc_noise, standard deviation of a normalized accelerometer component
+ * @param mag_noise, standard deviation of a normalized magnetometer component
+ * @brief the tuning of the filter, defaults in AHRS_mekf.c
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_set_noise(float gyro_noise, float bias_noise, float acc_noise, float mag_noise);
+
+/**
+ * @Function AHRS_mekf_get_covariance(float P_aa[MSZ][MSZ], float P_bb[MSZ][MSZ])
+ * @param P_aa, returns the attitude error covariance in rad^2
+ * @param P_bb, returns the bias covariance in (rad/sec)^2
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_get_covariance(float P_aa[MSZ][MSZ], float P_bb[MSZ][MSZ]);
+
+/**
+ * @Function AHRS_mekf_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @param gyros, gyro rates in rad/sec
+ * @param dt, the integration time in seconds
+ * @param q, returns the attitude quaternion
+ * @param bias, returns the gyro bias estimate in rad/sec
+ * @brief integrates the bias corrected gyros and propagates the covariance
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_propagate(float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ]);
+
+/**
+ * @Function AHRS_mekf_correct(float accels[MSZ], float mags[MSZ])
+ * @param accels, mags, calibrated accelerometer and magnetometer vectors,
+ * either may be NULL to skip that sensor, normalized in place
+ * @brief Kalman update with the measured directions of gravity and the
+ * magnetic field, then resets the error state into the attitude and bias
+ * @note the gain comes from the covariance, so unlike AHRS_correct() no time
+ * since the previous correction is needed
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_correct(float accels[MSZ], float mags[MSZ]);
+
+/**
+ * @Function AHRS_mekf_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ], float dt, float q[QSZ], float bias[MSZ])
+ * @brief AHRS_mekf_correct() followed by AHRS_mekf_propagate(), same
+ * arguments as AHRS_update()
+ * @author Aaron Hunter
+ */
+void AHRS_mekf_update(float accels[MSZ], float mags[MSZ], float gyros[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+
+#endif /* AHRS_MEKF_H */
+
+/* *****************************************************************************
+ End of File
+ */
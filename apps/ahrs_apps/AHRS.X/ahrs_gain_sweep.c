@@ -0,0 +1,896 @@
+/*
+ * File:   ahrs_gain_sweep.c
+ * Author: Aaron Hunter
+ * Brief: Host tool that replays one IMU log through the AHRS for every
+ * combination of a grid of kp_a, ki_a, kp_m and ki_m and ranks them, so the
+ * gains can be tuned on a workstation instead of by reflashing and driving.
+ *
+ * AHRS_update() keeps its filter in the statics of AHRS.c, so the sweep runs
+ * its own copy of AHRS_kernel_update_f() that updates SWEEP_LANES gain sets at
+ * once, each step a loop over the lanes that the compiler turns into SIMD.
+ * The measurements are normalized once per sample for all lanes.  Before the
+ * sweep, lane 0 with the default gains is checked against
+ * AHRS_kernel_update_f() itself.  Blocks of SWEEP_LANES gain sets are handed
+ * out to a pool of worker threads, one per core by default.
+ *
+ * Logs, the format is detected from the first line:
+ *   python/mavcsv_logging.py csv with RAW_IMU rows, calibrated with the rover
+ *   IMU calibration as in ahrs_replay.c, or HIGHRES_IMU rows, already scaled
+ *   with the gyros in deg/sec.  ATTITUDE_QUATERNION rows, if any, are the
+ *   reference attitude, held until the next one.
+ *   tumble_main.c NORM_DATA_OUT output, acc, mag, gyro in deg/sec per line at
+ *   its 20 msec period.
+ * Without a reference attitude the score is the innovation: the angle between
+ * each measured gravity and magnetic field vector and the filter's prediction
+ * of it from the previous sample, over the samples where the accelerometer
+ * reads 1 g.  Unlike the residual after the correction it does not reward
+ * gains high enough to follow the sensor noise.  Without a log a synthetic
+ * flight with a known attitude is generated and scored against it.  The first
+ * -s seconds, the bias convergence, are not scored.  Errors are accumulated
+ * as sines of the angles, exact to 1% below 14 degrees.
+ *
+ * Build from the repository root:
+ * gcc -O3 -march=native -fno-math-errno -pthread -DHAL_SIM -Ilib/HAL.X/linux
+ *   -Ilib/HAL.X -Ilib/Board.X -Ilib/Lin_alg.X -Iapps/ahrs_apps/AHRS.X
+ *   apps/ahrs_apps/AHRS.X/ahrs_gain_sweep.c apps/ahrs_apps/AHRS.X/AHRS_kernel.c
+ *   -lm -o ahrs_gain_sweep
+ * ./ahrs_gain_sweep [options] [log.csv]
+ *   -kp_a lo:hi:n, -ki_a, -kp_m, -ki_m  grid of a gain, n points, log spaced
+ *       unless lo is 0, default a factor of 10 around the AHRS_kernel.h gain
+ *   -t threads, -n combinations printed, -s settle seconds, -i euler|exp2|exp4,
+ *   -nomag
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifdef HAL_SIM // host only, not part of the MPLAB project
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "AHRS_kernel.h"
+#include "Board.h"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#define SWEEP_LANES 8 // gain sets per kernel call, 8 floats fill an AVX register
+#define NUM_GAINS 4
+#define GRID_POINTS 9 // default points per gain, odd so the default gain is one
+#define GRID_SPAN 10.0 // default grid runs from gain / span to gain * span
+#define MAX_THREADS 64
+#define LINE_LENGTH 4096
+#define MAX_FIELDS 64
+#define TUMBLE_DT 0.02 // tumble_main.c period
+#define GYRO_SCALE (500.0 / 32767.0 * M_PI / 180.0) // RAW_IMU counts to rad/sec
+#define DEG2RAD (M_PI / 180.0)
+#define RAD2DEG (180.0 / M_PI)
+#define MAX_DT 0.5 // longer gaps in a log are skipped
+#define STATIC_TOL 0.05 // fraction of 1 g, samples scored without a reference
+#define DIP_SAMPLES 50 // samples averaged for the magnetic dip of a log
+#define SETTLE_TIME 10.0 // seconds not scored by default
+#define KERNEL_CHECK_TOL 0.01 // deg, lane kernel against AHRS_kernel_update_f
+
+/* synthetic flight, as ahrs_replay.c */
+#define SYNTH_DT 0.01
+#define SYNTH_STEPS 12000
+#define SYNTH_NOISE 0.01
+#define SYNTH_GYRO_NOISE 0.005 // rad/sec
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+typedef struct {
+    float acc[MSZ]; // normalized
+    float mag[MSZ]; // normalized
+    float gyro[MSZ]; // rad/sec
+    float dt;
+    float q_ref[QSZ]; // reference attitude if the log has one
+    uint8_t is_scored;
+} sample_t;
+
+typedef struct {
+    const char *name;
+    double lo;
+    double hi;
+    int n;
+} gain_axis_t;
+
+/* SWEEP_LANES filters, one per gain set, lane index last so every step is a
+ * unit stride loop */
+typedef struct {
+    float q[QSZ][SWEEP_LANES];
+    float bias[MSZ][SWEEP_LANES];
+    float kp_a[SWEEP_LANES];
+    float ki_a[SWEEP_LANES];
+    float kp_m[SWEEP_LANES];
+    float ki_m[SWEEP_LANES];
+    double sq_err[SWEEP_LANES];
+} lanes_t;
+
+typedef struct {
+    float gains[NUM_GAINS];
+    double rms_deg;
+} result_t;
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+/* rover IMU calibration, see rover_main.c */
+static float A_acc[MSZ][MSZ] = {
+    {6.01180201773358e-05, -6.28352073406424e-07, -3.91326747595870e-07},
+    {-1.18653342135860e-06, 6.01268083773005e-05, -2.97010157797952e-07},
+    {-3.19011230800348e-07, -3.62174516629958e-08, 6.04564465269327e-05}
+};
+static float A_mag[MSZ][MSZ] = {
+    {0.00351413733554131, -1.74599042407869e-06, -1.62761272908763e-05},
+    {6.73767225208446e-06, 0.00334531206332366, -1.35302929502152e-05},
+    {-3.28233797524166e-05, 9.29337701972177e-06, 0.00343350080131375}
+};
+static float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
+static float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
+
+static float a_i[MSZ] = {0, 0, 1.0};
+static float m_i[MSZ] = AHRS_MAG_INERTIAL;
+
+static gain_axis_t grid[NUM_GAINS] = {
+    {"kp_a", AHRS_KP_A / GRID_SPAN, AHRS_KP_A * GRID_SPAN, GRID_POINTS},
+    {"ki_a", AHRS_KI_A / GRID_SPAN, AHRS_KI_A * GRID_SPAN, GRID_POINTS},
+    {"kp_m", AHRS_KP_M / GRID_SPAN, AHRS_KP_M * GRID_SPAN, GRID_POINTS},
+    {"ki_m", AHRS_KI_M / GRID_SPAN, AHRS_KI_M * GRID_SPAN, GRID_POINTS},
+};
+
+static sample_t *samples;
+static uint32_t num_samples;
+static uint32_t num_scored;
+static uint8_t has_reference = FALSE;
+static uint8_t is_synthetic = FALSE;
+static uint8_t use_mag = TRUE;
+static uint8_t integrator = AHRS_INTEGRATOR;
+static double settle_time = SETTLE_TIME;
+
+static result_t *results;
+static uint32_t num_combinations;
+static uint32_t num_blocks;
+static uint32_t next_block; // taken by the workers with an atomic add
+static uint32_t lcg_state = 12345;
+
+/*******************************************************************************
+ * FUNCTION PROTOTYPES                                                         *
+ ******************************************************************************/
+static int parse_args(int argc, char **argv, int *threads, int *top, const char **path);
+static int load_log(const char *path);
+static int load_mavlink(FILE *log, char *header);
+static int load_tumble(FILE *log, char *first);
+static void add_sample(float acc[MSZ], float mag[MSZ], float gyro[MSZ], float dt,
+        float q_ref[QSZ]);
+static void prepare_samples(void);
+static void make_synthetic(void);
+static double grid_value(const gain_axis_t *axis, int i);
+static void combination_gains(uint32_t c, float gains[NUM_GAINS]);
+static void lanes_run(lanes_t *l);
+static void *worker(void *arg);
+static double check_kernel(void);
+static int compare_results(const void *a, const void *b);
+static int split_csv(char *line, char *fields[], int max);
+static float synth_noise(float sigma);
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    pthread_t pool[MAX_THREADS];
+    struct timespec start;
+    struct timespec end;
+    const char *path = NULL;
+    double seconds;
+    double check;
+    float defaults[NUM_GAINS] = {AHRS_KP_A, AHRS_KI_A, AHRS_KP_M, AHRS_KI_M};
+    int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int top = 20;
+    uint32_t c;
+    uint32_t default_rank = 0;
+    int i;
+
+    printf("# AHRS gain sweep %s, %s\n", __DATE__, __TIME__);
+    if (parse_args(argc, argv, &threads, &top, &path) != SUCCESS) {
+        return 1;
+    }
+    if (path != NULL) {
+        if (load_log(path) != SUCCESS) {
+            return 1;
+        }
+    } else {
+        make_synthetic();
+    }
+    prepare_samples();
+    if (num_scored == 0) {
+        fprintf(stderr, "no samples to score, lower -s\n");
+        return 1;
+    }
+    printf("# %u samples, %u scored against %s\n", num_samples, num_scored,
+            has_reference == TRUE ? "the reference attitude" : "the measured vectors");
+
+    check = check_kernel();
+    printf("# lane kernel vs AHRS_kernel_update_f: %.6f deg max\n", check);
+    if (check > KERNEL_CHECK_TOL) {
+        fprintf(stderr, "lane kernel does not match AHRS_kernel_update_f\n");
+        return 1;
+    }
+
+    num_combinations = 1;
+    for (i = 0; i < NUM_GAINS; i++) {
+        num_combinations *= grid[i].n;
+    }
+    num_blocks = (num_combinations + SWEEP_LANES - 1) / SWEEP_LANES;
+    results = calloc(num_blocks * SWEEP_LANES, sizeof (result_t));
+    threads = threads < 1 ? 1 : (threads > MAX_THREADS ? MAX_THREADS : threads);
+    next_block = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < threads; i++) {
+        pthread_create(&pool[i], NULL, worker, NULL);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(pool[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + 1e-9 * (end.tv_nsec - start.tv_nsec);
+    printf("# %u combinations on %d threads in %.2f sec, %.1f M filter updates/sec\n",
+            num_combinations, threads, seconds,
+            (double) num_combinations * num_samples / seconds * 1e-6);
+
+    qsort(results, num_combinations, sizeof (result_t), compare_results);
+    for (c = 0; c < num_combinations; c++) {
+        for (i = 0; i < NUM_GAINS; i++) {
+            if (fabsf(results[c].gains[i] - defaults[i]) > 1e-5f * defaults[i]) {
+                break;
+            }
+        }
+        if (i == NUM_GAINS) {
+            default_rank = c + 1;
+        }
+    }
+    printf("rank,kp_a,ki_a,kp_m,ki_m,rms_deg\n");
+    for (c = 0; c < num_combinations && c < (uint32_t) top; c++) {
+        printf("%u,%.4g,%.4g,%.4g,%.4g,%.4f\n", c + 1, results[c].gains[0],
+                results[c].gains[1], results[c].gains[2], results[c].gains[3],
+                results[c].rms_deg);
+    }
+    for (i = 0; i < NUM_GAINS; i++) {
+        if ((grid[i].n > 1) && ((results[0].gains[i] <= (float) grid_value(&grid[i], 0))
+                || (results[0].gains[i] >= (float) grid_value(&grid[i], grid[i].n - 1)))) {
+            printf("# best %s is at the edge of its grid, widen -%s\n", grid[i].name,
+                    grid[i].name);
+        }
+    }
+    if (default_rank > 0) {
+        printf("# AHRS_kernel.h gains rank %u, %.4f deg\n", default_rank,
+                results[default_rank - 1].rms_deg);
+    }
+    free(results);
+    free(samples);
+    return 0;
+}
+
+/**
+ * @function parse_args()
+ * @return SUCCESS or ERROR with a usage message
+ */
+static int parse_args(int argc, char **argv, int *threads, int *top, const char **path) {
+    int a;
+    int g;
+
+    for (a = 1; a < argc; a++) {
+        for (g = 0; g < NUM_GAINS; g++) {
+            if (argv[a][0] == '-' && strcmp(argv[a] + 1, grid[g].name) == 0) {
+                break;
+            }
+        }
+        if (g < NUM_GAINS && a + 1 < argc) {
+            if (sscanf(argv[++a], "%lf:%lf:%d", &grid[g].lo, &grid[g].hi, &grid[g].n) != 3
+                    || grid[g].n < 1 || grid[g].lo < 0 || grid[g].hi < grid[g].lo) {
+                fprintf(stderr, "bad grid %s, use lo:hi:n\n", argv[a]);
+                return ERROR;
+            }
+        } else if (strcmp(argv[a], "-t") == 0 && a + 1 < argc) {
+            *threads = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-n") == 0 && a + 1 < argc) {
+            *top = atoi(argv[++a]);
+        } else if (strcmp(argv[a], "-s") == 0 && a + 1 < argc) {
+            settle_time = atof(argv[++a]);
+        } else if (strcmp(argv[a], "-i") == 0 && a + 1 < argc) {
+            a++;
+            if (strcmp(argv[a], "euler") == 0) {
+                integrator = AHRS_INTEGRATE_EULER;
+            } else if (strcmp(argv[a], "exp2") == 0) {
+                integrator = AHRS_INTEGRATE_EXP2;
+            } else if (strcmp(argv[a], "exp4") == 0) {
+                integrator = AHRS_INTEGRATE_EXP4;
+            } else {
+                fprintf(stderr, "integrator %s is not euler, exp2 or exp4\n", argv[a]);
+                return ERROR;
+            }
+        } else if (strcmp(argv[a], "-nomag") == 0) {
+            use_mag = FALSE;
+        } else if (argv[a][0] != '-' && *path == NULL) {
+            *path = argv[a];
+        } else {
+            fprintf(stderr, "usage: %s [-kp_a|-ki_a|-kp_m|-ki_m lo:hi:n] [-t threads] "
+                    "[-n top] [-s settle_sec] [-i euler|exp2|exp4] [-nomag] [log.csv]\n",
+                    argv[0]);
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function load_log()
+ * @brief reads a mavcsv_logging.py or tumble_main.c log into samples
+ * @return SUCCESS or ERROR
+ */
+static int load_log(const char *path) {
+    FILE *log = fopen(path, "r");
+    char line[LINE_LENGTH];
+    int status;
+
+    if (log == NULL || fgets(line, sizeof (line), log) == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return ERROR;
+    }
+    if (strncmp(line, "mavpackettype", 13) == 0) {
+        status = load_mavlink(log, line);
+    } else {
+        status = load_tumble(log, line);
+    }
+    fclose(log);
+    if (status == SUCCESS && num_samples == 0) {
+        fprintf(stderr, "%s has no IMU samples\n", path);
+        return ERROR;
+    }
+    return status;
+}
+
+/**
+ * @function load_mavlink()
+ * @param header, the first line, naming the columns of every message type
+ * @return SUCCESS or ERROR if a column is missing
+ */
+static int load_mavlink(FILE *log, char *header) {
+    const char *names[] = {"time_usec", "xacc", "yacc", "zacc", "xgyro", "ygyro",
+        "zgyro", "xmag", "ymag", "zmag", "q1", "q2", "q3", "q4"};
+    char line[LINE_LENGTH];
+    char *fields[MAX_FIELDS];
+    int columns[14];
+    int num_fields;
+    int is_raw;
+    int i;
+    float raw[MSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float q_ref[QSZ] = {1, 0, 0, 0};
+    double t_prev = -1;
+    double t;
+    double dt;
+
+    num_fields = split_csv(header, fields, MAX_FIELDS);
+    for (i = 0; i < 14; i++) {
+        for (columns[i] = num_fields - 1; columns[i] >= 0; columns[i]--) {
+            if (strcmp(fields[columns[i]], names[i]) == 0) {
+                break;
+            }
+        }
+        if (columns[i] < 0 && i < 10) {
+            fprintf(stderr, "log has no %s column\n", names[i]);
+            return ERROR;
+        }
+    }
+
+    while (fgets(line, sizeof (line), log) != NULL) {
+        num_fields = split_csv(line, fields, MAX_FIELDS);
+        if (strcmp(fields[0], "ATTITUDE_QUATERNION") == 0 && columns[13] >= 0
+                && columns[13] < num_fields) {
+            for (i = 0; i < QSZ; i++) {
+                q_ref[i] = atof(fields[columns[10 + i]]);
+            }
+            has_reference = TRUE;
+            continue;
+        }
+        is_raw = strcmp(fields[0], "RAW_IMU") == 0;
+        if ((is_raw == FALSE && strcmp(fields[0], "HIGHRES_IMU") != 0)
+                || columns[9] >= num_fields) {
+            continue;
+        }
+        t = atof(fields[columns[0]]) * 1e-6;
+        dt = t - t_prev;
+        t_prev = t;
+        if (dt <= 0 || dt > MAX_DT) {
+            continue;
+        }
+        for (i = 0; i < MSZ; i++) {
+            acc[i] = atof(fields[columns[1 + i]]);
+            gyro[i] = atof(fields[columns[4 + i]]) * (is_raw ? GYRO_SCALE : DEG2RAD);
+            mag[i] = atof(fields[columns[7 + i]]);
+        }
+        if (acc[0] == 0 && acc[1] == 0 && acc[2] == 0) {
+            continue; // IMU not running yet
+        }
+        if (is_raw) {
+            memcpy(raw, acc, sizeof (raw));
+            for (i = 0; i < MSZ; i++) {
+                acc[i] = A_acc[i][0] * raw[0] + A_acc[i][1] * raw[1] + A_acc[i][2] * raw[2]
+                        + b_acc[i];
+            }
+            memcpy(raw, mag, sizeof (raw));
+            for (i = 0; i < MSZ; i++) {
+                mag[i] = A_mag[i][0] * raw[0] + A_mag[i][1] * raw[1] + A_mag[i][2] * raw[2]
+                        + b_mag[i];
+            }
+        }
+        add_sample(acc, mag, gyro, dt, q_ref);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function load_tumble()
+ * @param first, the first line, the tumble_main.c banner or data
+ * @return SUCCESS or ERROR if the lines are not NORM_DATA_OUT
+ */
+static int load_tumble(FILE *log, char *first) {
+    char line[LINE_LENGTH];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float q_ref[QSZ] = {1, 0, 0, 0};
+    int i;
+
+    strncpy(line, first, sizeof (line));
+    do {
+        if (sscanf(line, "%f, %f, %f, %f, %f, %f, %f, %f, %f", &acc[0], &acc[1], &acc[2],
+                &mag[0], &mag[1], &mag[2], &gyro[0], &gyro[1], &gyro[2]) != 9) {
+            if (num_samples == 0 && strncmp(line, "IMU tumble", 10) == 0) {
+                continue;
+            }
+            if (num_samples == 0) {
+                fprintf(stderr, "not a mavcsv_logging.py log or tumble_main NORM_DATA_OUT\n");
+                return ERROR;
+            }
+            continue;
+        }
+        for (i = 0; i < MSZ; i++) {
+            gyro[i] *= DEG2RAD;
+        }
+        add_sample(acc, mag, gyro, TUMBLE_DT, q_ref);
+    } while (fgets(line, sizeof (line), log) != NULL);
+    return SUCCESS;
+}
+
+/**
+ * @function add_sample()
+ * @brief appends a sample with the measurements as read, growing the array
+ */
+static void add_sample(float acc[MSZ], float mag[MSZ], float gyro[MSZ], float dt,
+        float q_ref[QSZ]) {
+    static uint32_t capacity = 0;
+    sample_t *s;
+
+    if (num_samples == capacity) {
+        capacity = capacity == 0 ? 4096 : 2 * capacity;
+        samples = realloc(samples, capacity * sizeof (sample_t));
+    }
+    s = &samples[num_samples++];
+    memcpy(s->acc, acc, sizeof (s->acc));
+    memcpy(s->mag, mag, sizeof (s->mag));
+    memcpy(s->gyro, gyro, sizeof (s->gyro));
+    memcpy(s->q_ref, q_ref, sizeof (s->q_ref));
+    s->dt = dt;
+    s->is_scored = FALSE;
+}
+
+/**
+ * @function prepare_samples()
+ * @brief finds the local 1 g and, for a log, the magnetic dip from the first
+ * samples, then normalizes the vectors and marks the samples to score
+ */
+static void prepare_samples(void) {
+    double g_sum = 0;
+    double dip_sum = 0;
+    double t = 0;
+    float g;
+    float n_a;
+    float n_m;
+    uint32_t k;
+    uint32_t first = num_samples < DIP_SAMPLES ? num_samples : DIP_SAMPLES;
+    int i;
+    sample_t *s;
+
+    for (k = 0; k < first; k++) {
+        s = &samples[k];
+        n_a = sqrtf(s->acc[0] * s->acc[0] + s->acc[1] * s->acc[1] + s->acc[2] * s->acc[2]);
+        n_m = sqrtf(s->mag[0] * s->mag[0] + s->mag[1] * s->mag[1] + s->mag[2] * s->mag[2]);
+        g_sum += n_a;
+        dip_sum += (s->acc[0] * s->mag[0] + s->acc[1] * s->mag[1] + s->acc[2] * s->mag[2])
+                / (n_a * n_m);
+    }
+    g = g_sum / first;
+    if (is_synthetic == FALSE) {
+        /* logs were recorded in different places */
+        m_i[0] = 0;
+        m_i[2] = dip_sum / first;
+        m_i[1] = sqrtf(1.0f - m_i[2] * m_i[2]);
+        printf("# inertial magnetic field %.3f, %.3f, %.3f\n", m_i[0], m_i[1], m_i[2]);
+    }
+
+    num_scored = 0;
+    for (k = 0; k < num_samples; k++) {
+        s = &samples[k];
+        t += s->dt;
+        n_a = sqrtf(s->acc[0] * s->acc[0] + s->acc[1] * s->acc[1] + s->acc[2] * s->acc[2]);
+        n_m = sqrtf(s->mag[0] * s->mag[0] + s->mag[1] * s->mag[1] + s->mag[2] * s->mag[2]);
+        for (i = 0; i < MSZ; i++) {
+            s->acc[i] /= n_a;
+            s->mag[i] /= n_m;
+        }
+        s->is_scored = (t >= settle_time)
+                && (has_reference == TRUE || fabsf(n_a / g - 1.0f) < STATIC_TOL);
+        num_scored += s->is_scored;
+    }
+}
+
+/**
+ * @function make_synthetic()
+ * @brief the ahrs_replay.c flight: turns on all three axes with a gyro bias,
+ * the truth is the reference attitude
+ */
+static void make_synthetic(void) {
+    const float bias_true[MSZ] = {0.02, -0.01, 0.015};
+    float q_true[QSZ] = {1, 0, 0, 0};
+    float w[MSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    AHRS_kernel_f_t truth = AHRS_KERNEL_DEFAULTS;
+    float t;
+    int step;
+    int i;
+
+    truth.kp_a = truth.ki_a = truth.kp_m = truth.ki_m = 0;
+    truth.integrator = AHRS_INTEGRATE_EXP4;
+    lcg_state = 54321;
+    for (step = 0; step < SYNTH_STEPS; step++) {
+        t = step * SYNTH_DT;
+        w[0] = 0.6 * sin(0.7 * t);
+        w[1] = 0.4 * sin(1.1 * t + 1.0);
+        w[2] = 0.3 * cos(0.5 * t);
+        AHRS_kernel_propagate_f(&truth, w, SYNTH_DT);
+        memcpy(q_true, truth.q, sizeof (q_true));
+        AHRS_kernel_q_rot_v_q_pair_f(a_i, m_i, q_true, acc, mag);
+        for (i = 0; i < MSZ; i++) {
+            acc[i] += synth_noise(SYNTH_NOISE);
+            mag[i] += synth_noise(SYNTH_NOISE);
+            gyro[i] = w[i] + bias_true[i] + synth_noise(SYNTH_GYRO_NOISE);
+        }
+        add_sample(acc, mag, gyro, SYNTH_DT, q_true);
+    }
+    has_reference = TRUE;
+    is_synthetic = TRUE;
+}
+
+/**
+ * @function grid_value()
+ * @return point i of a gain axis, log spaced unless it starts at zero
+ */
+static double grid_value(const gain_axis_t *axis, int i) {
+    if (axis->n == 1) {
+        return axis->lo;
+    }
+    if (axis->lo == 0) {
+        return axis->hi * i / (axis->n - 1);
+    }
+    return axis->lo * pow(axis->hi / axis->lo, (double) i / (axis->n - 1));
+}
+
+/**
+ * @function combination_gains()
+ * @brief the gains of combination c of the grid, kp_a varying slowest
+ */
+static void combination_gains(uint32_t c, float gains[NUM_GAINS]) {
+    int g;
+
+    if (c >= num_combinations) {
+        c = num_combinations - 1; // padding lanes of the last block
+    }
+    for (g = NUM_GAINS - 1; g >= 0; g--) {
+        gains[g] = grid_value(&grid[g], c % grid[g].n);
+        c /= grid[g].n;
+    }
+}
+
+/**
+ * @function lanes_run()
+ * @brief AHRS_kernel_update_f() on every sample for SWEEP_LANES gain sets,
+ * scoring each against the reference or the innovation before its correction
+ */
+static void lanes_run(lanes_t *l) {
+    float a_b[MSZ][SWEEP_LANES];
+    float m_b[MSZ][SWEEP_LANES];
+    float w_a[MSZ][SWEEP_LANES];
+    float w_m[MSZ][SWEEP_LANES];
+    float w[MSZ][SWEEP_LANES];
+    float q_dot[QSZ][SWEEP_LANES];
+    float err[SWEEP_LANES];
+    float x2, y2, z2, xx, yy, zz, xy, xz, yz, wx, wy, wz;
+    float a2, c, s, n, dot;
+    float half_dt;
+    /* EXP2 is EXP4 without the a^4 terms */
+    const float c4 = integrator == AHRS_INTEGRATE_EXP2 ? 0 : (float) AHRS_EXP_C4;
+    const float s4 = integrator == AHRS_INTEGRATE_EXP2 ? 0 : (float) AHRS_EXP_S4;
+    uint32_t k;
+    int row;
+    int j;
+    const sample_t *sm;
+
+    for (k = 0; k < num_samples; k++) {
+        sm = &samples[k];
+        half_dt = 0.5f * sm->dt;
+
+        /* estimated gravity and field through the DCM, as q_rot_v_q_pair */
+        for (j = 0; j < SWEEP_LANES; j++) {
+            x2 = l->q[1][j] + l->q[1][j];
+            y2 = l->q[2][j] + l->q[2][j];
+            z2 = l->q[3][j] + l->q[3][j];
+            xx = l->q[1][j] * x2;
+            yy = l->q[2][j] * y2;
+            zz = l->q[3][j] * z2;
+            xy = l->q[1][j] * y2;
+            xz = l->q[1][j] * z2;
+            yz = l->q[2][j] * z2;
+            wx = l->q[0][j] * x2;
+            wy = l->q[0][j] * y2;
+            wz = l->q[0][j] * z2;
+            a_b[0][j] = (1 - yy - zz) * a_i[0] + (xy + wz) * a_i[1] + (xz - wy) * a_i[2];
+            a_b[1][j] = (xy - wz) * a_i[0] + (1 - xx - zz) * a_i[1] + (yz + wx) * a_i[2];
+            a_b[2][j] = (xz + wy) * a_i[0] + (yz - wx) * a_i[1] + (1 - xx - yy) * a_i[2];
+            m_b[0][j] = (1 - yy - zz) * m_i[0] + (xy + wz) * m_i[1] + (xz - wy) * m_i[2];
+            m_b[1][j] = (xy - wz) * m_i[0] + (1 - xx - zz) * m_i[1] + (yz + wx) * m_i[2];
+            m_b[2][j] = (xz + wy) * m_i[0] + (yz - wx) * m_i[1] + (1 - xx - yy) * m_i[2];
+        }
+
+        /* correction rates, u x v */
+        for (j = 0; j < SWEEP_LANES; j++) {
+            w_a[0][j] = sm->acc[1] * a_b[2][j] - sm->acc[2] * a_b[1][j];
+            w_a[1][j] = sm->acc[2] * a_b[0][j] - sm->acc[0] * a_b[2][j];
+            w_a[2][j] = sm->acc[0] * a_b[1][j] - sm->acc[1] * a_b[0][j];
+            w_m[0][j] = sm->mag[1] * m_b[2][j] - sm->mag[2] * m_b[1][j];
+            w_m[1][j] = sm->mag[2] * m_b[0][j] - sm->mag[0] * m_b[2][j];
+            w_m[2][j] = sm->mag[0] * m_b[1][j] - sm->mag[1] * m_b[0][j];
+        }
+        if (use_mag == FALSE) {
+            memset(w_m, 0, sizeof (w_m));
+        }
+
+        /* innovation: sin^2 of the angles between measured and predicted */
+        if (sm->is_scored && has_reference == FALSE) {
+            for (j = 0; j < SWEEP_LANES; j++) {
+                err[j] = w_a[0][j] * w_a[0][j] + w_a[1][j] * w_a[1][j] + w_a[2][j] * w_a[2][j]
+                        + w_m[0][j] * w_m[0][j] + w_m[1][j] * w_m[1][j] + w_m[2][j] * w_m[2][j];
+                l->sq_err[j] += err[j];
+            }
+        }
+
+        /* bias integration and propagation, in the order of the kernel */
+        for (row = 0; row < MSZ; row++) {
+            for (j = 0; j < SWEEP_LANES; j++) {
+                l->bias[row][j] -= l->ki_a[j] * w_a[row][j] * sm->dt;
+                l->bias[row][j] -= l->ki_m[j] * w_m[row][j] * sm->dt;
+                w[row][j] = sm->gyro[row] - l->bias[row][j] + l->kp_a[j] * w_a[row][j]
+                        + l->kp_m[j] * w_m[row][j];
+            }
+        }
+        if (integrator == AHRS_INTEGRATE_EULER) {
+            for (j = 0; j < SWEEP_LANES; j++) {
+                q_dot[0][j] = -w[0][j] * l->q[1][j] - w[1][j] * l->q[2][j] - w[2][j] * l->q[3][j];
+                q_dot[1][j] = w[0][j] * l->q[0][j] + w[2][j] * l->q[2][j] - w[1][j] * l->q[3][j];
+                q_dot[2][j] = w[1][j] * l->q[0][j] - w[2][j] * l->q[1][j] + w[0][j] * l->q[3][j];
+                q_dot[3][j] = w[2][j] * l->q[0][j] + w[1][j] * l->q[1][j] - w[0][j] * l->q[2][j];
+                for (row = 0; row < QSZ; row++) {
+                    l->q[row][j] += q_dot[row][j] * half_dt;
+                }
+                n = 1.0f / sqrtf(l->q[0][j] * l->q[0][j] + l->q[1][j] * l->q[1][j]
+                        + l->q[2][j] * l->q[2][j] + l->q[3][j] * l->q[3][j]);
+                for (row = 0; row < QSZ; row++) {
+                    l->q[row][j] *= n;
+                }
+            }
+        } else {
+            for (j = 0; j < SWEEP_LANES; j++) {
+                for (row = 0; row < MSZ; row++) {
+                    w[row][j] *= half_dt;
+                }
+                a2 = w[0][j] * w[0][j] + w[1][j] * w[1][j] + w[2][j] * w[2][j];
+                c = 1.0f - a2 * ((float) AHRS_EXP_C2 - a2 * c4);
+                s = 1.0f - a2 * ((float) AHRS_EXP_S2 - a2 * s4);
+                for (row = 0; row < MSZ; row++) {
+                    w[row][j] *= s;
+                }
+                /* q [c, w], then one Newton step of 1 / sqrt() */
+                q_dot[0][j] = c * l->q[0][j] - w[0][j] * l->q[1][j] - w[1][j] * l->q[2][j]
+                        - w[2][j] * l->q[3][j];
+                q_dot[1][j] = w[0][j] * l->q[0][j] + c * l->q[1][j] + w[2][j] * l->q[2][j]
+                        - w[1][j] * l->q[3][j];
+                q_dot[2][j] = w[1][j] * l->q[0][j] - w[2][j] * l->q[1][j] + c * l->q[2][j]
+                        + w[0][j] * l->q[3][j];
+                q_dot[3][j] = w[2][j] * l->q[0][j] + w[1][j] * l->q[1][j] - w[0][j] * l->q[2][j]
+                        + c * l->q[3][j];
+                n = 0.5f * (3.0f - (q_dot[0][j] * q_dot[0][j] + q_dot[1][j] * q_dot[1][j]
+                        + q_dot[2][j] * q_dot[2][j] + q_dot[3][j] * q_dot[3][j]));
+                for (row = 0; row < QSZ; row++) {
+                    l->q[row][j] = q_dot[row][j] * n;
+                }
+            }
+        }
+
+        /* reference: sin^2 of the attitude error angle, 4 (1 - (p.q)^2) */
+        if (sm->is_scored && has_reference == TRUE) {
+            for (j = 0; j < SWEEP_LANES; j++) {
+                dot = sm->q_ref[0] * l->q[0][j] + sm->q_ref[1] * l->q[1][j]
+                        + sm->q_ref[2] * l->q[2][j] + sm->q_ref[3] * l->q[3][j];
+                err[j] = 4.0f * (1.0f - dot * dot);
+                l->sq_err[j] += err[j] > 0 ? err[j] : 0;
+            }
+        }
+    }
+}
+
+/**
+ * @function worker()
+ * @brief a thread of the pool, runs blocks until there are none left
+ */
+static void *worker(void *arg) {
+    lanes_t l;
+    uint32_t block;
+    uint32_t c;
+    float gains[NUM_GAINS];
+    int j;
+
+    (void) arg;
+    while ((block = __atomic_fetch_add(&next_block, 1, __ATOMIC_RELAXED)) < num_blocks) {
+        memset(&l, 0, sizeof (l));
+        for (j = 0; j < SWEEP_LANES; j++) {
+            combination_gains(block * SWEEP_LANES + j, gains);
+            l.q[0][j] = 1.0f;
+            l.kp_a[j] = gains[0];
+            l.ki_a[j] = gains[1];
+            l.kp_m[j] = use_mag ? gains[2] : 0;
+            l.ki_m[j] = use_mag ? gains[3] : 0;
+        }
+        lanes_run(&l);
+        for (j = 0; j < SWEEP_LANES; j++) {
+            c = block * SWEEP_LANES + j;
+            combination_gains(c, results[c].gains);
+            /* rms angle from the mean sin^2, both vectors count without a
+             * reference */
+            results[c].rms_deg = sqrt(l.sq_err[j] / num_scored
+                    / (has_reference == FALSE && use_mag ? 2 : 1)) * RAD2DEG;
+            if (isnan(results[c].rms_deg)) {
+                results[c].rms_deg = INFINITY;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @function check_kernel()
+ * @return largest attitude difference in degrees between lane 0 with the
+ * default gains and AHRS_kernel_update_f() over the samples
+ */
+static double check_kernel(void) {
+    AHRS_kernel_f_t k = AHRS_KERNEL_DEFAULTS;
+    lanes_t l;
+    sample_t *all = samples;
+    uint32_t total = num_samples;
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    double w, x, y, z;
+    double err;
+    double err_max = 0;
+    uint32_t i;
+    int j;
+
+    memcpy(k.m_i, m_i, sizeof (k.m_i));
+    k.integrator = integrator;
+    memset(&l, 0, sizeof (l));
+    for (j = 0; j < SWEEP_LANES; j++) {
+        l.q[0][j] = 1.0f;
+        l.kp_a[j] = AHRS_KP_A;
+        l.ki_a[j] = AHRS_KI_A;
+        l.kp_m[j] = use_mag ? AHRS_KP_M : 0;
+        l.ki_m[j] = use_mag ? AHRS_KI_M : 0;
+    }
+    /* one sample at a time through both */
+    for (i = 0; i < total; i++) {
+        memcpy(acc, all[i].acc, sizeof (acc));
+        memcpy(mag, all[i].mag, sizeof (mag));
+        memcpy(gyro, all[i].gyro, sizeof (gyro));
+        AHRS_kernel_update_f(&k, acc, use_mag ? mag : NULL, gyro, all[i].dt);
+        samples = &all[i];
+        num_samples = 1;
+        lanes_run(&l);
+        /* angle from the vector part of k.q* l.q, acos() of float
+         * quaternions is too coarse near zero */
+        w = k.q[0] * (double) l.q[0][0] + k.q[1] * (double) l.q[1][0]
+                + k.q[2] * (double) l.q[2][0] + k.q[3] * (double) l.q[3][0];
+        x = k.q[0] * (double) l.q[1][0] - k.q[1] * (double) l.q[0][0]
+                - k.q[2] * (double) l.q[3][0] + k.q[3] * (double) l.q[2][0];
+        y = k.q[0] * (double) l.q[2][0] + k.q[1] * (double) l.q[3][0]
+                - k.q[2] * (double) l.q[0][0] - k.q[3] * (double) l.q[1][0];
+        z = k.q[0] * (double) l.q[3][0] - k.q[1] * (double) l.q[2][0]
+                + k.q[2] * (double) l.q[1][0] - k.q[3] * (double) l.q[0][0];
+        err = 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(w)) * RAD2DEG;
+        err_max = err > err_max ? err : err_max;
+    }
+    samples = all;
+    num_samples = total;
+    return err_max;
+}
+
+/**
+ * @function compare_results()
+ * @brief qsort order, smallest error first
+ */
+static int compare_results(const void *a, const void *b) {
+    double ea = ((const result_t *) a)->rms_deg;
+    double eb = ((const result_t *) b)->rms_deg;
+    return (ea > eb) - (ea < eb);
+}
+
+/**
+ * @function split_csv()
+ * @brief splits a line in place at the commas outside of double quotes,
+ * mavcsv_logging.py quotes array fields
+ * @return number of fields
+ */
+static int split_csv(char *line, char *fields[], int max) {
+    int n = 0;
+    int is_quoted = FALSE;
+    char *p = line;
+
+    fields[n++] = p;
+    for (; *p != '\0' && n < max; p++) {
+        if (*p == '"') {
+            is_quoted = !is_quoted;
+        } else if (*p == ',' && !is_quoted) {
+            *p = '\0';
+            fields[n++] = p + 1;
+        } else if (*p == '\r' || *p == '\n') {
+            *p = '\0';
+            break;
+        }
+    }
+    return n;
+}
+
+/**
+ * @function synth_noise()
+ * @return uniform noise with the given standard deviation
+ */
+static float synth_noise(float sigma) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return sigma * sqrt(3.0) * ((int32_t) lcg_state / 2147483648.0f);
+}
+
+#endif //HAL_SIM
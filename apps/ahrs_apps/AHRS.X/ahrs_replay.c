@@ -0,0 +1,638 @@
+/*
+ * File:   ahrs_replay.c
+ * Author: Aaron Hunter
+ * Brief: Host harness that runs every AHRS variant side by side on the same
+ * IMU data and prints their accuracy, their divergence from the double
+ * precision kernel and their execution time per update.  The variants are the
+ * complementary filter of AHRS_kernel.h in float (through AHRS_update() in
+ * AHRS.c) and in double, the fixed point AHRS_fix_update(), the MATLAB
+ * generated ahrs_q_update() in double and the multiplicative EKF
+ * AHRS_mekf_update().  Only the filter call is timed, not the conversion of
+ * the measurements into its type.
+ *
+ * With a file argument the data is a RAW_IMU log written by
+ * python/mavcsv_logging.py, e.g. python/logfiles/tumble_030122.csv.  The counts
+ * are calibrated with the rover IMU calibration from rover_main.c and the dip
+ * of the inertial magnetic field is taken from the first second of the log, as
+ * the logs were recorded in different places.  A log has no reference
+ * attitude, so accuracy is the angle between the measured and estimated
+ * gravity and magnetic field directions over the samples where the
+ * accelerometer reads 1 g.  Without an
+ * argument a synthetic flight with a known attitude, gyro bias and sensor
+ * noise is generated and the attitude and bias errors are printed instead.
+ *
+ * Build from the repository root:
+ * gcc -O2 -DHAL_SIM -Ilib/HAL.X/linux -Ilib/HAL.X -Ilib/Board.X -Ilib/Serial.X
+ *   -Ilib/System_timer.X -Ilib/ICM-20948.X -Ilib/Lin_alg.X -Iapps/ahrs_apps/AHRS.X
+ *   -Iapps/ahrs_apps/q_ahrs_codegen
+ *   apps/ahrs_apps/AHRS.X/ahrs_replay.c apps/ahrs_apps/AHRS.X/AHRS.c
+ *   apps/ahrs_apps/AHRS.X/AHRS_kernel.c apps/ahrs_apps/AHRS.X/AHRS_fix.c
+ *   apps/ahrs_apps/AHRS.X/AHRS_mekf.c apps/ahrs_apps/q_ahrs_codegen/ahrs_q_update.c
+ *   lib/Lin_alg.X/Lin_alg_float.c lib/Lin_alg.X/Lin_alg_fix.c
+ *   lib/HAL.X/HAL_linux.c lib/Board.X/Board.c lib/Serial.X/SerialM32.c
+ *   lib/System_timer.X/System_timer.c -lm -o ahrs_replay
+ * ./ahrs_replay [log.csv [nomag]], nomag runs the filters without the
+ * magnetometer for logs whose magnetometer calibration is off
+ * Created on Oct 16, 2026
+ * Modified on 10/16/26 cross validates the AHRS_kernel precisions, the fixed
+ * point and the generated filter
+ */
+
+#ifdef HAL_SIM // host only, not part of the MPLAB project
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "AHRS.h"
+#include "AHRS_fix.h"
+#include "AHRS_kernel.h"
+#include "AHRS_mekf.h"
+#include "ahrs_q_update.h"
+#include "Board.h"
+#include "HAL.h"
+
+/*******************************************************************************
+ * #DEFINES                                                                    *
+ ******************************************************************************/
+#define LINE_LENGTH 4096
+#define NUM_FILTERS 5
+#define REFERENCE 0 // the double kernel, divergence is measured from it
+#define GYRO_SCALE (500.0 / 32767.0 * M_PI / 180.0) // counts to rad/sec
+#define MAX_DT 0.5 // longer gaps in a log restart the timing
+#define STATIC_TOL 0.05 // g, accelerometer samples used for the gravity residual
+#define DIP_SAMPLES 50 // log samples averaged for the magnetic dip
+#define RAD2DEG (180.0 / M_PI)
+
+/* synthetic flight */
+#define SYNTH_DT 0.01
+#define SYNTH_STEPS 12000 // two minutes
+#define SYNTH_SETTLE 3000 // bias convergence excluded from the statistics
+#define SYNTH_NOISE 0.01
+#define SYNTH_GYRO_NOISE 0.005 // rad/sec
+
+/*******************************************************************************
+ * TYPEDEFS                                                                    *
+ ******************************************************************************/
+/* one update on private copies of the measurements, mag may be NULL, returns
+ * the execution time of the filter call */
+typedef HAL_cycles_t(*variant_update_t)(float acc[MSZ], float mag[MSZ],
+        float gyro[MSZ], float dt, float q[QSZ], float bias[MSZ]);
+
+typedef struct {
+    const char *name;
+    variant_update_t update;
+    float q[QSZ];
+    float bias[MSZ];
+    uint32_t samples;
+    HAL_cycles_t cycles_max;
+    double cycles_total;
+    double sq_err; // attitude error against the truth, or gravity residual
+    double sq_mag; // magnetic field residual, logs only
+    uint32_t err_samples;
+    float err_max;
+    double sq_ref; // attitude difference from the reference
+    float ref_max;
+} filter_stats_t;
+
+/*******************************************************************************
+ * VARIABLES                                                                   *
+ ******************************************************************************/
+/* rover IMU calibration, see rover_main.c */
+static float A_acc[MSZ][MSZ] = {
+    {6.01180201773358e-05, -6.28352073406424e-07, -3.91326747595870e-07},
+    {-1.18653342135860e-06, 6.01268083773005e-05, -2.97010157797952e-07},
+    {-3.19011230800348e-07, -3.62174516629958e-08, 6.04564465269327e-05}
+};
+static float A_mag[MSZ][MSZ] = {
+    {0.00351413733554131, -1.74599042407869e-06, -1.62761272908763e-05},
+    {6.73767225208446e-06, 0.00334531206332366, -1.35302929502152e-05},
+    {-3.28233797524166e-05, 9.29337701972177e-06, 0.00343350080131375}
+};
+static float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
+static float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
+
+static float a_i[MSZ] = {0, 0, 1.0};
+static float m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
+
+static AHRS_kernel_d_t kernel_d = AHRS_KERNEL_DEFAULTS;
+static double q_codegen[QSZ] = {1, 0, 0, 0};
+static double b_codegen[MSZ] = {0, 0, 0};
+static q30_t q_fix[QSZ];
+static q16_t bias_fix[MSZ];
+static uint32_t lcg_state = 12345;
+static uint8_t use_mag = TRUE;
+
+/*******************************************************************************
+ * FUNCTION PROTOTYPES                                                         *
+ ******************************************************************************/
+static HAL_cycles_t update_double(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+static HAL_cycles_t update_float(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+static HAL_cycles_t update_fixed(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+static HAL_cycles_t update_codegen(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+static HAL_cycles_t update_mekf(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]);
+static void set_mag_inertial(void);
+static void run_filters(float acc[MSZ], float mag[MSZ], float gyro[MSZ], float dt);
+static void compare_filters(void);
+static int replay_log(const char *path);
+static void run_synthetic(void);
+static float q_angle_deg(float p[QSZ], float q[QSZ]);
+static float v_angle_deg(float u[MSZ], float v[MSZ]);
+static int find_column(char *header, const char *name);
+static float synth_noise(float sigma);
+static void print_results(int is_log, uint32_t compared);
+
+static filter_stats_t filters[NUM_FILTERS] = {
+    {.name = "double", .update = update_double, .q = {1, 0, 0, 0}},
+    {.name = "float", .update = update_float, .q = {1, 0, 0, 0}},
+    {.name = "fixed", .update = update_fixed, .q = {1, 0, 0, 0}},
+    {.name = "codegen", .update = update_codegen, .q = {1, 0, 0, 0}},
+    {.name = "mekf", .update = update_mekf, .q = {1, 0, 0, 0}},
+};
+
+/*******************************************************************************
+ * FUNCTIONS                                                                   *
+ ******************************************************************************/
+
+int main(int argc, char **argv) {
+    printf("# AHRS replay %s, %s\n", __DATE__, __TIME__);
+    AHRS_mekf_init();
+    set_mag_inertial();
+    if (argc > 2 && strcmp(argv[2], "nomag") == 0) {
+        use_mag = FALSE;
+    }
+    if (argc > 1) {
+        return replay_log(argv[1]);
+    }
+    run_synthetic();
+    return 0;
+}
+
+/**
+ * @function update_double()
+ * @brief the AHRS_kernel in double, the reference of the comparison
+ */
+static HAL_cycles_t update_double(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    double acc_d[MSZ];
+    double mag_d[MSZ];
+    double gyro_d[MSZ];
+    HAL_cycles_t start;
+    HAL_cycles_t elapsed;
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        acc_d[i] = acc[i];
+        mag_d[i] = mag != NULL ? mag[i] : 0;
+        gyro_d[i] = gyro[i];
+    }
+    start = HAL_get_cycles();
+    AHRS_kernel_update_d(&kernel_d, acc_d, mag != NULL ? mag_d : NULL, gyro_d, dt);
+    elapsed = HAL_get_cycles() - start;
+    for (i = 0; i < QSZ; i++) {
+        q[i] = kernel_d.q[i];
+    }
+    for (i = 0; i < MSZ; i++) {
+        bias[i] = kernel_d.bias[i];
+    }
+    return elapsed;
+}
+
+/**
+ * @function update_float()
+ * @brief the AHRS_kernel in float through AHRS_update() as the vehicles run it
+ */
+static HAL_cycles_t update_float(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    HAL_cycles_t start = HAL_get_cycles();
+    AHRS_update(acc, mag, gyro, dt, q, bias);
+    return HAL_get_cycles() - start;
+}
+
+/**
+ * @function update_fixed()
+ * @brief AHRS_fix_update() on the Q16.16 measurements
+ */
+static HAL_cycles_t update_fixed(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    q16_t acc_fix[MSZ];
+    q16_t mag_fix[MSZ];
+    q16_t gyro_fix[MSZ];
+    HAL_cycles_t start;
+    HAL_cycles_t elapsed;
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        acc_fix[i] = FLOAT_TO_Q16(acc[i]);
+        mag_fix[i] = mag != NULL ? FLOAT_TO_Q16(mag[i]) : 0;
+        gyro_fix[i] = FLOAT_TO_Q16(gyro[i]);
+    }
+    start = HAL_get_cycles();
+    AHRS_fix_update(acc_fix, mag != NULL ? mag_fix : NULL, gyro_fix, FLOAT_TO_Q30(dt),
+            q_fix, bias_fix);
+    elapsed = HAL_get_cycles() - start;
+    for (i = 0; i < QSZ; i++) {
+        q[i] = Q30_TO_FLOAT(q_fix[i]);
+    }
+    for (i = 0; i < MSZ; i++) {
+        bias[i] = Q16_TO_FLOAT(bias_fix[i]);
+    }
+    return elapsed;
+}
+
+/**
+ * @function update_codegen()
+ * @brief the MATLAB generated ahrs_q_update(), which always takes a
+ * magnetometer vector, so without one the magnetometer gains are zero
+ */
+static HAL_cycles_t update_codegen(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    double acc_d[MSZ];
+    double mag_d[MSZ] = {1.0, 0, 0};
+    double gyro_d[MSZ];
+    double a_i_d[MSZ];
+    double m_i_d[MSZ];
+    double q_plus[QSZ];
+    double b_plus[MSZ];
+    double kp_m = mag != NULL ? AHRS_KP_M : 0;
+    double ki_m = mag != NULL ? AHRS_KI_M : 0;
+    HAL_cycles_t start;
+    HAL_cycles_t elapsed;
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        acc_d[i] = acc[i];
+        if (mag != NULL) {
+            mag_d[i] = mag[i];
+        }
+        gyro_d[i] = gyro[i];
+        a_i_d[i] = a_i[i];
+        m_i_d[i] = m_i[i];
+    }
+    start = HAL_get_cycles();
+    ahrs_q_update(q_codegen, b_codegen, gyro_d, mag_d, acc_d, m_i_d, a_i_d, dt,
+            AHRS_KP_A, AHRS_KI_A, kp_m, ki_m, q_plus, b_plus);
+    elapsed = HAL_get_cycles() - start;
+    for (i = 0; i < QSZ; i++) {
+        q_codegen[i] = q_plus[i];
+        q[i] = q_plus[i];
+    }
+    for (i = 0; i < MSZ; i++) {
+        b_codegen[i] = b_plus[i];
+        bias[i] = b_plus[i];
+    }
+    return elapsed;
+}
+
+/**
+ * @function update_mekf()
+ * @brief AHRS_mekf_update()
+ */
+static HAL_cycles_t update_mekf(float acc[MSZ], float mag[MSZ], float gyro[MSZ],
+        float dt, float q[QSZ], float bias[MSZ]) {
+    HAL_cycles_t start = HAL_get_cycles();
+    AHRS_mekf_update(acc, mag, gyro, dt, q, bias);
+    return HAL_get_cycles() - start;
+}
+
+/**
+ * @function set_mag_inertial()
+ * @brief gives m_i to every variant
+ */
+static void set_mag_inertial(void) {
+    q30_t m_i_fix[MSZ];
+    int i;
+
+    for (i = 0; i < MSZ; i++) {
+        kernel_d.m_i[i] = m_i[i];
+        m_i_fix[i] = FLOAT_TO_Q30(m_i[i]);
+    }
+    AHRS_set_mag_inertial(m_i);
+    AHRS_fix_set_mag_inertial(m_i_fix);
+    AHRS_mekf_set_mag_inertial(m_i);
+}
+
+/**
+ * @function run_filters()
+ * @brief one update of each filter on its own copy of the measurements, the
+ * filters normalize in place
+ * @note mag is not used when use_mag is FALSE
+ */
+static void run_filters(float acc[MSZ], float mag[MSZ], float gyro[MSZ], float dt) {
+    float acc_copy[MSZ];
+    float mag_copy[MSZ];
+    float gyro_copy[MSZ];
+    HAL_cycles_t elapsed;
+    uint8_t f;
+
+    for (f = 0; f < NUM_FILTERS; f++) {
+        memcpy(acc_copy, acc, sizeof (acc_copy));
+        memcpy(mag_copy, mag, sizeof (mag_copy));
+        memcpy(gyro_copy, gyro, sizeof (gyro_copy));
+        elapsed = filters[f].update(acc_copy, use_mag ? mag_copy : NULL, gyro_copy, dt,
+                filters[f].q, filters[f].bias);
+        filters[f].samples++;
+        filters[f].cycles_total += elapsed;
+        if (elapsed > filters[f].cycles_max) {
+            filters[f].cycles_max = elapsed;
+        }
+    }
+}
+
+/**
+ * @function compare_filters()
+ * @brief accumulates the attitude difference of each filter from the reference
+ */
+static void compare_filters(void) {
+    float e;
+    uint8_t f;
+
+    for (f = 0; f < NUM_FILTERS; f++) {
+        e = q_angle_deg(filters[REFERENCE].q, filters[f].q);
+        filters[f].sq_ref += e * e;
+        if (e > filters[f].ref_max) {
+            filters[f].ref_max = e;
+        }
+    }
+}
+
+/**
+ * @function replay_log()
+ * @param path, a csv log with a RAW_IMU message per line
+ * @return 0, or 1 if the file cannot be read
+ */
+static int replay_log(const char *path) {
+    FILE *log = fopen(path, "r");
+    char line[LINE_LENGTH];
+    const char *fields[] = {"time_usec", "xacc", "yacc", "zacc", "xgyro", "ygyro",
+        "zgyro", "xmag", "ymag", "zmag"};
+    int columns[10];
+    double values[10];
+    int16_t acc_raw[MSZ];
+    float raw[MSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float a_b[MSZ];
+    float m_b[MSZ];
+    float e;
+    double t_prev = 0;
+    double dt;
+    double dip_sum = 0;
+    uint32_t dip_samples = 0;
+    uint32_t compared = 0;
+    int type_column;
+    int column;
+    int i;
+    uint8_t f;
+    char *token;
+
+    if (log == NULL || fgets(line, sizeof (line), log) == NULL) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    type_column = find_column(line, "mavpackettype");
+    for (i = 0; i < 10; i++) {
+        columns[i] = find_column(line, fields[i]);
+        if (columns[i] < 0 || type_column < 0) {
+            fprintf(stderr, "%s has no %s column\n", path, columns[i] < 0 ? fields[i] : "mavpackettype");
+            return 1;
+        }
+    }
+
+    while (fgets(line, sizeof (line), log) != NULL) {
+        if (strncmp(line, "RAW_IMU,", 8) != 0 || type_column != 0) {
+            continue;
+        }
+        column = 0;
+        for (token = strtok(line, ","); token != NULL; token = strtok(NULL, ",")) {
+            for (i = 0; i < 10; i++) {
+                if (columns[i] == column) {
+                    values[i] = atof(token);
+                }
+            }
+            column++;
+        }
+        dt = (values[0] - t_prev) * 1e-6;
+        t_prev = values[0];
+        if (dt <= 0 || dt > MAX_DT) {
+            continue;
+        }
+        for (i = 0; i < MSZ; i++) {
+            acc_raw[i] = (int16_t) values[1 + i];
+            gyro[i] = values[4 + i] * GYRO_SCALE;
+        }
+        if (acc_raw[0] == 0 && acc_raw[1] == 0 && acc_raw[2] == 0) {
+            continue; // IMU not running yet
+        }
+        for (i = 0; i < MSZ; i++) {
+            raw[i] = acc_raw[i];
+        }
+        lin_alg_m_v_mult(A_acc, raw, acc);
+        lin_alg_v_v_add(acc, b_acc, acc);
+        for (i = 0; i < MSZ; i++) {
+            raw[i] = values[7 + i];
+        }
+        lin_alg_m_v_mult(A_mag, raw, mag);
+        lin_alg_v_v_add(mag, b_mag, mag);
+
+        /* inertial field from the mean angle between gravity and the field */
+        if (dip_samples < DIP_SAMPLES) {
+            dip_sum += lin_alg_dot(acc, mag) / (lin_alg_v_norm(acc) * lin_alg_v_norm(mag));
+            dip_samples++;
+            if (dip_samples == DIP_SAMPLES) {
+                m_i[0] = 0;
+                m_i[2] = dip_sum / DIP_SAMPLES;
+                m_i[1] = sqrt(1.0 - m_i[2] * m_i[2]);
+                set_mag_inertial();
+                printf("# inertial magnetic field %.3f, %.3f, %.3f\n", m_i[0], m_i[1], m_i[2]);
+            }
+            continue;
+        }
+        run_filters(acc, mag, gyro, dt);
+
+        /* residuals once each filter has had a second to converge */
+        if (filters[0].samples < 1.0 / dt) {
+            continue;
+        }
+        for (f = 0; f < NUM_FILTERS; f++) {
+            if (fabs(lin_alg_v_norm(acc) - 1.0) < STATIC_TOL) {
+                lin_alg_q_rot_v_q_pair(a_i, m_i, filters[f].q, a_b, m_b);
+                e = v_angle_deg(acc, a_b);
+                filters[f].sq_err += e * e;
+                if (e > filters[f].err_max) {
+                    filters[f].err_max = e;
+                }
+                e = use_mag ? v_angle_deg(mag, m_b) : 0;
+                filters[f].sq_mag += e * e;
+                filters[f].err_samples++;
+            }
+        }
+        compare_filters();
+        compared++;
+    }
+    fclose(log);
+    print_results(TRUE, compared);
+    return 0;
+}
+
+/**
+ * @function run_synthetic()
+ * @brief the body turns on all three axes with a constant gyro bias, the
+ * accelerometer and magnetometer see the rotated reference vectors plus noise
+ */
+static void run_synthetic(void) {
+    const float bias_true[MSZ] = {0.02, -0.01, 0.015};
+    float q_true[QSZ] = {1, 0, 0, 0};
+    float w[QSZ];
+    float q_dot[QSZ];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+    float e;
+    float t;
+    int step;
+    int i;
+    uint8_t f;
+
+    for (step = 0; step < SYNTH_STEPS; step++) {
+        t = step * SYNTH_DT;
+        w[0] = 0;
+        w[1] = 0.6 * sin(0.7 * t);
+        w[2] = 0.4 * sin(1.1 * t + 1.0);
+        w[3] = 0.3 * cos(0.5 * t);
+        for (i = 0; i < 10; i++) {
+            lin_alg_q_mult(q_true, w, q_dot);
+            lin_alg_scale_q(0.05 * SYNTH_DT, q_dot);
+            q_true[0] += q_dot[0];
+            q_true[1] += q_dot[1];
+            q_true[2] += q_dot[2];
+            q_true[3] += q_dot[3];
+            lin_alg_scale_q(1.0 / lin_alg_q_norm(q_true), q_true);
+        }
+        lin_alg_q_rot_v_q_pair(a_i, m_i, q_true, acc, mag);
+        for (i = 0; i < MSZ; i++) {
+            acc[i] += synth_noise(SYNTH_NOISE);
+            mag[i] += synth_noise(SYNTH_NOISE);
+            gyro[i] = w[i + 1] + bias_true[i] + synth_noise(SYNTH_GYRO_NOISE);
+        }
+        run_filters(acc, mag, gyro, SYNTH_DT);
+        if (step < SYNTH_SETTLE) {
+            continue;
+        }
+        for (f = 0; f < NUM_FILTERS; f++) {
+            e = q_angle_deg(q_true, filters[f].q);
+            filters[f].sq_err += e * e;
+            if (e > filters[f].err_max) {
+                filters[f].err_max = e;
+            }
+            filters[f].err_samples++;
+        }
+        compare_filters();
+    }
+    for (f = 0; f < NUM_FILTERS; f++) {
+        for (i = 0; i < MSZ; i++) {
+            /* the bias error is kept in sq_mag, which a synthetic run does not use */
+            e = filters[f].bias[i] - bias_true[i];
+            filters[f].sq_mag += e * e;
+        }
+    }
+    print_results(FALSE, SYNTH_STEPS - SYNTH_SETTLE);
+}
+
+/**
+ * @function print_results()
+ * @param compared, number of samples in the comparison with the reference
+ * @brief one csv line per filter
+ */
+static void print_results(int is_log, uint32_t compared) {
+    uint8_t f;
+    filter_stats_t *s;
+    double mean;
+
+    if (is_log) {
+        printf("filter,updates,mean_%s,max_%s,updates_per_sec,static_samples,"
+                "gravity_rms_deg,gravity_max_deg,mag_rms_deg,", HAL_CYCLE_UNITS, HAL_CYCLE_UNITS);
+    } else {
+        printf("filter,updates,mean_%s,max_%s,updates_per_sec,samples,"
+                "attitude_rms_deg,attitude_max_deg,bias_err_rad_per_sec,", HAL_CYCLE_UNITS, HAL_CYCLE_UNITS);
+    }
+    printf("vs_%s_rms_deg,vs_%s_max_deg\n", filters[REFERENCE].name, filters[REFERENCE].name);
+    for (f = 0; f < NUM_FILTERS; f++) {
+        s = &filters[f];
+        mean = s->samples > 0 ? s->cycles_total / s->samples : 0;
+        printf("%s,%u,%.1f,%u,%.0f,%u,%.3f,%.3f,%.4f,%.5f,%.5f\n", s->name, s->samples,
+                mean, s->cycles_max, mean > 0 ? 1e9 / mean : 0,
+                s->err_samples,
+                s->err_samples > 0 ? sqrt(s->sq_err / s->err_samples) : 0, s->err_max,
+                is_log ? (s->err_samples > 0 ? sqrt(s->sq_mag / s->err_samples) : 0) : sqrt(s->sq_mag),
+                compared > 0 ? sqrt(s->sq_ref / compared) : 0, s->ref_max);
+    }
+}
+
+/**
+ * @function q_angle_deg()
+ * @return angle of the rotation between two attitudes in degrees, from the
+ * vector part of p* q so that small differences are not lost in acos()
+ */
+static float q_angle_deg(float p[QSZ], float q[QSZ]) {
+    double w = p[0] * (double) q[0] + p[1] * (double) q[1] + p[2] * (double) q[2]
+            + p[3] * (double) q[3];
+    double x = p[0] * (double) q[1] - p[1] * (double) q[0] - p[2] * (double) q[3]
+            + p[3] * (double) q[2];
+    double y = p[0] * (double) q[2] + p[1] * (double) q[3] - p[2] * (double) q[0]
+            - p[3] * (double) q[1];
+    double z = p[0] * (double) q[3] - p[1] * (double) q[2] + p[2] * (double) q[1]
+            - p[3] * (double) q[0];
+    return 2.0 * atan2(sqrt(x * x + y * y + z * z), fabs(w)) * RAD2DEG;
+}
+
+/**
+ * @function v_angle_deg()
+ * @return angle between two vectors of any length in degrees
+ */
+static float v_angle_deg(float u[MSZ], float v[MSZ]) {
+    float c[MSZ];
+    lin_alg_cross(u, v, c);
+    return atan2(lin_alg_v_norm(c), lin_alg_dot(u, v)) * RAD2DEG;
+}
+
+/**
+ * @function find_column()
+ * @return index of the comma separated name in the header, or -1
+ */
+static int find_column(char *header, const char *name) {
+    char copy[LINE_LENGTH];
+    char *token;
+    int column = 0;
+
+    strncpy(copy, header, sizeof (copy) - 1);
+    copy[sizeof (copy) - 1] = '\0';
+    for (token = strtok(copy, ",\r\n"); token != NULL; token = strtok(NULL, ",\r\n")) {
+        if (strcmp(token, name) == 0) {
+            return column;
+        }
+        column++;
+    }
+    return -1;
+}
+
+/**
+ * @function synth_noise()
+ * @return uniform noise with the given standard deviation
+ */
+static float synth_noise(float sigma) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return sigma * sqrt(3.0) * ((int32_t) lcg_state / 2147483648.0f);
+}
+
+#endif //HAL_SIM
@@ -13,7 +13,11 @@
 #include <sys/attribs.h>  //for ISR definitions
 #include <proc/p32mx795f512l.h>
 #include <xc.h>
+#include "AHRS_kernel.h"
 #include "Board.h"
+#include "EEPROM2.h"
+#include "Gyro_cal.h"
+#include "Gyro_temp.h"
 #include "ICM_20948.h"  
 #include "ICM_20948_registers.h" 
 #include "SerialM32.h"
@@ -21,261 +25,13 @@
 /*******************************************************************************
  * #DEFINES                                                                    *
  ******************************************************************************/
-#define CAL_TIME 5000 //bias calculation time in msec
+#define CAL_TIME 5000 //longest bias calibration in msec, Gyro_cal ends it sooner
+#define GYRO_BIAS_PAGE 0 // EEPROM page of the last calibrated gyro bias, deg/sec
+#define GYRO_TEMP_PAGE 1 // first of the GYRO_TEMP_TABLE_PAGES pages of the bias against temperature
+#define TEMP_KI_SCALE 0.2 // AHRS integral gains with a temperature model, only a residual bias is left
 #define MEAS_PERIOD 20 // measurement period in msec
 #define THREESEC 3000
 #define DT 0.02 
-#define MSZ 3
-#define QSZ 4
-
-/*******************************************************************************
- * FUNCTION PROTOTYPES                                                         *
- ******************************************************************************/
-void quat2euler(double q[MSZ], double euler[MSZ]);
-void lin_alg_q_mult(double q[QSZ], double p[QSZ], double r[QSZ]);
-void q_rot_v_q(double v_i[MSZ], double q[QSZ], double v_b[MSZ]);
-void v_copy(double m_in[MSZ], double m_out[MSZ]);
-void lin_alg_cross(double u[MSZ], double v[MSZ], double w_out[MSZ]);
-void lin_alg_v_scale(double s, double v[MSZ]);
-void lin_alg_v_v_add(double v1[MSZ], double v2[MSZ], double v_out[MSZ]);
-void lin_alg_v_v_sub(double v1[MSZ], double v2[MSZ], double v_out[MSZ]);
-double lin_alg_q_norm(double q[QSZ]);
-
-/*******************************************************************************
- * FUNCTIONS                                                                    *
- ******************************************************************************/
-
-/**
- * @function quat2euler()
- * @param q A quaternion
- * @param euler a vector of euler angles in [psi, theta, roll] order
- */
-void quat2euler(double q[MSZ], double euler[MSZ]) {
-    double q00 = q[0] * q[0];
-    double q11 = q[1] * q[1];
-    double q22 = q[2] * q[2];
-    double q33 = q[3] * q[3];
-
-    // psi
-    euler[0] = atan2(2.0 * (q[1] * q[2] + q[0] * q[3]), ((q00 + q11 - q22 - q33)));
-    // theta
-    euler[1] = asin(2.0 * (q[0] * q[2] - q[1] * q[3]));
-    // phi
-    euler[2] = atan2(2.0 * (q[2] * q[3] + q[0] * q[1]), q00 - q11 - q22 + q33);
-}
-
-/**
- * @function lin_alg_q_mult()
- * Multiply two quaternions together
- * @param p A quaternion
- * @param q A quaternion
- * @param r The resulting quaternion
- */
-void lin_alg_q_mult(double q[QSZ], double p[QSZ], double r[QSZ]) {
-    r[0] = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
-    r[1] = p[1] * q[0] + p[0] * q[1] + p[3] * q[2] - p[2] * q[3];
-    r[2] = p[2] * q[0] - p[3] * q[1] + p[0] * q[2] + p[1] * q[3];
-    r[3] = p[3] * q[0] + p[2] * q[1] - p[1] * q[2] + p[0] * q[3];
-}
-
-/**
- * @function q_rot_v_q()
- * Rotate a vector from the inertial frame to the body frame
- * @param v_i, a 3space vector in the inertial frame
- * @param q an attitude quaternion
- * sets v_b to the rotated inertial vector in the body frame
- */
-void q_rot_v_q(double v_i[MSZ], double q[QSZ], double v_b[MSZ]) {
-    double q_i[QSZ];
-    double q_temp[QSZ];
-    double q_conj[QSZ];
-    double q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
-}
-
-void v_copy(double m_in[MSZ], double m_out[MSZ]) {
-    int row;
-    for (row = 0; row < MSZ; row++) {
-        m_out[row] = m_in[row];
-    }
-}
-
-/**
- * @function lin_alg_cross()
- * @param u A vector
- * @param v A vector
- * @return The cross product (sometimes called the outter product) of u and v
- */
-void lin_alg_cross(double u[MSZ], double v[MSZ], double w_out[MSZ]) {
-    w_out[0] = u[1] * v[2] - u[2] * v[1];
-    w_out[1] = u[2] * v[0] - u[0] * v[2];
-    w_out[2] = u[0] * v[1] - u[1] * v[0];
-}
-
-/**
- * @function lin_alg_v_scale()
- * Scales vector
- * @param s Scalar to scale vector with
- * @param v Vector to be scaled
- */
-void lin_alg_v_scale(double s, double v[MSZ]) {
-    int row;
-    for (row = 0; row < MSZ; row++) {
-        v[row] *= s;
-    }
-}
-
-/**
- * @function lin_alg_v_v_add()
- * Add a vector value to a vector
- * @param v1 Vector to add to another vector
- * @param v2 Vector to have a vector added to it
- * @param v_out Vector as sum of two vectors
- */
-void lin_alg_v_v_add(double v1[MSZ], double v2[MSZ], double v_out[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = v1[row] + v2[row];
-    }
-}
-
-/**
- * @function lin_alg_v_v_sub()
- * Add a vector value to a vector
- * @param v1 Vector to subtract to another vector
- * @param v2 Vector to have a vector subtracted to it
- * @param v_out Vector as difference of two vectors
- */
-void lin_alg_v_v_sub(double v1[MSZ], double v2[MSZ], double v_out[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = v1[row] - v2[row];
-    }
-}
-
-/**
- * @function lin_alg_q_norm()
- * @param q A quaternion
- * @return The magnitude of the quaternion, q
- */
-double lin_alg_q_norm(double q[QSZ]) {
-    return ((double) sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]));
-}
-
-/**
- * @function m_norm()
- * @param M A matrix
- * @return The magnitude of the M, m_norm
- */
-double m_norm(double M[MSZ]) {
-    return ((double) sqrt(M[0] * M[0] + M[1] * M[1] + M[2] * M[2]));
-}
-
-
-//            ahrs_update(q_minus, b_minus, gyro_cal, mag_cal, acc_cal, m_i,
-//                    a_i, dt, kp_a, ki_a, kp_m, ki_m, q_plus, b_plus);
-void ahrs_update(double q_minus[QSZ], double bias_minus[MSZ], double gyros[MSZ],
-        double mags[MSZ], double accels[MSZ], double mag_i[MSZ], double acc_i[MSZ],
-        double dt, double kp_a, double ki_a, double kp_m, double ki_m,
-        double q_plus[QSZ], double bias_plus[MSZ]) {
-
-    double acc_b[MSZ]; //estimated gravity vector in body frame
-    double mag_b[MSZ]; //estimated magnetic field vector in body frame
-
-    double gyro_cal[MSZ]; // gyros with bias correction
-    double gyro_wfb[MSZ]; // gyro 'rate' after feedback
-    double w_meas_ap[MSZ]; // accelerometer proportion correction rate
-    double w_meas_mp[MSZ]; // magnetometer proportional correction rate
-    double w_meas_ai[MSZ]; // accelerometer integral correction rate
-    double w_meas_mi[MSZ]; // magnetometer integral correction rate
-
-    double gyro_q_wfb[QSZ]; // temporary quaternion to hold feedback term
-    double q_dot[QSZ]; // quaternion derivative
-    double b_dot[MSZ]; // bias vector derivative
-    double q_norm;
-    double acc_n;
-    double mag_n;
-
-    /* normalize inertial measurements */
-    acc_n = m_norm(accels);
-    accels[0] = accels[0] / acc_n;
-    accels[1] = accels[1] / acc_n;
-    accels[2] = accels[2] / acc_n;
-
-    mag_n = m_norm(mags);
-    mags[0] = mags[0] / mag_n;
-    mags[1] = mags[1] / mag_n;
-    mags[2] = mags[2] / mag_n;
-
-    /*Accelerometer attitude calculations */
-    q_rot_v_q(acc_i, q_minus, acc_b); //estimate gravity vector in body frame 
-    lin_alg_cross(accels, acc_b, w_meas_ap); // calculate the accelerometer rate term
-    v_copy(w_meas_ap, w_meas_ai); // make a copy for the integral term
-    lin_alg_v_scale(kp_a, w_meas_ap); // calculate the accelerometer proportional feedback term 
-    lin_alg_v_scale(ki_a, w_meas_ai); // calculate the accelerometer integral feedback term 
-
-    /*Magnetometer attitude calculations*/
-    q_rot_v_q(mag_i, q_minus, mag_b); //estimate magnetic field vector in body frame
-    lin_alg_cross(mags, mag_b, w_meas_mp); // calculate the magnetometer rate term
-    v_copy(w_meas_mp, w_meas_mi); //make a copy for the integral term
-    lin_alg_v_scale(kp_m, w_meas_mp); // calculate the magnetometer proportional feedback term
-    lin_alg_v_scale(ki_m, w_meas_mi); // calculate the magnetometer integral feedback term
-
-    /*Gyro attitude contributions */
-    lin_alg_v_v_sub(gyros, bias_minus, gyro_cal); //correct the gyros with the b_minus vector
-
-    /* calculate total rate term gyro_wfb */
-    lin_alg_v_v_add(w_meas_ap, w_meas_mp, gyro_wfb);
-    lin_alg_v_v_add(gyro_cal, gyro_wfb, gyro_wfb);
-
-    /* convert feedback term to a pure quaternion */
-    gyro_q_wfb[0] = 0;
-    gyro_q_wfb[1] = gyro_wfb[0];
-    gyro_q_wfb[2] = gyro_wfb[1];
-    gyro_q_wfb[3] = gyro_wfb[2];
-
-    /* compute the quaternion derivative q_dot */
-    lin_alg_q_mult(q_minus, gyro_q_wfb, q_dot);
-
-    /* integrate term by term */
-    q_plus[0] = q_minus[0] + 0.5 * q_dot[0] * dt;
-    q_plus[1] = q_minus[1] + 0.5 * q_dot[1] * dt;
-    q_plus[2] = q_minus[2] + 0.5 * q_dot[2] * dt;
-    q_plus[3] = q_minus[3] + 0.5 * q_dot[3] * dt;
-
-    // normalize the quaternion for stability
-    q_norm = lin_alg_q_norm(q_plus);
-    q_plus[0] = q_plus[0] / q_norm;
-    q_plus[1] = q_plus[1] / q_norm;
-    q_plus[2] = q_plus[2] / q_norm;
-    q_plus[3] = q_plus[3] / q_norm;
-
-    // compute the integral of the bias term by term
-    bias_plus[0] = bias_minus[0] - (w_meas_ai[0] + w_meas_mi[0]) * dt;
-    bias_plus[1] = bias_minus[1] - (w_meas_ai[1] + w_meas_mi[1]) * dt;
-    bias_plus[2] = bias_minus[2] - (w_meas_ai[2] + w_meas_mi[2]) * dt;
-}
 
 int main(void) {
     uint32_t start_time = 0;
@@ -284,11 +40,8 @@ int main(void) {
     uint32_t current_time = 0;
     uint32_t update_start = 0;
     uint32_t update_end = 0;
-    /*filter gains*/
-    double kp_a = 2.5; //accelerometer proportional gain
-    double ki_a = 0.05; // accelerometer integral gain
-    double kp_m = 2.5; // magnetometer proportional gain
-    double ki_m = 0.05; //magnetometer integral gain
+    uint32_t cal_start = 0;
+    int8_t is_cal_done = FALSE;
     /*timing and conversion*/
     const double dt = DT;
     const double deg2rad = M_PI / 180.0;
@@ -311,26 +64,33 @@ int main(void) {
     };
     float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
     float b_mag[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
-    // gravity inertial vector
-    double a_i[MSZ] = {0, 0, 1.0};
-    // Earth's magnetic field inertial vector, normalized 
-    // North 22,680.8 nT	East 5,217.6 nT	Down 41,324.7 nT, value from NOAA
-    // converted into ENU format and normalized:
-    double m_i[MSZ] = {0.110011998753301, 0.478219898291142, -0.871322609031072};
 
     // Euler angles
     double euler[MSZ] = {0, 0, 0};
 
-    // attitude quaternions
-    double q_minus[QSZ] = {1, 0, 0, 0};
-    double q_plus[QSZ] = {1, 0, 0, 0};
-    // gyro bias vector
-    double b_minus[MSZ] = {0, 0, 0};
-    double b_plus[MSZ] = {0, 0, 0};
+    /* attitude, gyro bias, default gains, gravity and the magnetic field at
+     * Santa Cruz as the reference vectors */
+    AHRS_kernel_d_t ahrs = AHRS_KERNEL_DEFAULTS;
+
     /* data arrays */
     double gyro_cal[MSZ] = {0, 0, 0};
     double acc_cal[MSZ] = {0, 0, 0};
     double mag_cal[MSZ] = {0, 0, 0};
+    float gyro_f[MSZ];
+    float acc_f[MSZ];
+    float gyro_bias[MSZ];
+    gyro_cal_status_t gyro_cal_status;
+    /* gyro bias against temperature */
+    float temp_table[GYRO_TEMP_TABLE_SIZE];
+    float temp_bias[MSZ] = {0, 0, 0}; // taken off the gyro by the driver, deg/sec
+    float temp_bias_new[MSZ];
+    float temp_c;
+    IMU_gyro_temp_model_t temp_model;
+    gyro_temp_status_t temp_status;
+    int8_t is_temp_model = FALSE;
+    uint8_t saved_bins = 0;
+    uint8_t page;
+    uint8_t i;
     /* gryo, accelerometer, magnetometer data struct */
     struct IMU_out IMU_data = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 
@@ -351,6 +111,81 @@ int main(void) {
     IMU_set_mag_cal(A_mag, b_mag);
     IMU_set_acc_cal(A_acc, b_acc);
 
+    /* gyro bias: seeded from the last calibration when there is one, ends as
+     * soon as the bias is known, the AHRS keeps estimating it in flight */
+    EEPROM_init();
+    /* the bias against temperature learned over earlier runs, the driver takes
+     * it off the samples so Gyro_cal and the AHRS only see what it misses */
+    Gyro_temp_init();
+    for (page = 0; page < GYRO_TEMP_TABLE_PAGES; page++) {
+        EEPROM_read_float_array(&temp_table[page * GYRO_TEMP_PAGE_FLOATS], GYRO_TEMP_PAGE_FLOATS,
+                GYRO_TEMP_PAGE + page, 0);
+    }
+    if ((Gyro_temp_set_table(temp_table) == SUCCESS) && (Gyro_temp_fit(&temp_model) == SUCCESS)
+            && (IMU_set_gyro_temp_model(&temp_model) == SUCCESS)) {
+        is_temp_model = TRUE;
+        Gyro_temp_get_status(&temp_status);
+        saved_bins = temp_status.bins;
+        printf("Gyro temperature model, degree %d, %1.1f to %1.1f C, rms %1.4f dps\r\n",
+                temp_status.degree, temp_status.min_c, temp_status.max_c, temp_status.rms);
+    }
+    Gyro_cal_init();
+    if (is_temp_model == TRUE) {
+        /* the model leaves a bias near zero */
+        for (i = 0; i < MSZ; i++) {
+            gyro_bias[i] = 0;
+        }
+        Gyro_cal_seed(gyro_bias);
+    } else if (EEPROM_read_float_array(gyro_bias, MSZ, GYRO_BIAS_PAGE, 0) == SUCCESS) {
+        Gyro_cal_seed(gyro_bias);
+    }
+    cal_start = Sys_timer_get_msec();
+    start_time = cal_start;
+    while ((is_cal_done == FALSE) && (Sys_timer_get_msec() - cal_start < CAL_TIME)) {
+        current_time = Sys_timer_get_msec();
+        if ((current_time - start_time) >= MEAS_PERIOD) {
+            IMU_start_data_acq();
+            start_time = current_time;
+        }
+        if (IMU_is_data_ready() == TRUE) {
+            IMU_get_norm_data(&IMU_data);
+            gyro_f[0] = IMU_data.gyro.x;
+            gyro_f[1] = IMU_data.gyro.y;
+            gyro_f[2] = IMU_data.gyro.z;
+            acc_f[0] = IMU_data.acc.x;
+            acc_f[1] = IMU_data.acc.y;
+            acc_f[2] = IMU_data.acc.z;
+            is_cal_done = Gyro_cal_update(gyro_f, acc_f);
+            IMU_get_gyro_temp_bias(temp_bias);
+            for (i = 0; i < MSZ; i++) {
+                gyro_f[i] += temp_bias[i];
+            }
+            Gyro_temp_update(gyro_f, acc_f, IMU_data.temp / IMU_TEMP_SENSE + IMU_TEMP_OFFSET_C);
+        }
+    }
+    Gyro_cal_get_status(&gyro_cal_status);
+    if (Gyro_cal_get_bias(gyro_bias) == SUCCESS) {
+        /* stored without the model so it seeds a run without one */
+        IMU_get_gyro_temp_bias(temp_bias);
+        for (i = 0; i < MSZ; i++) {
+            temp_bias_new[i] = gyro_bias[i] + temp_bias[i];
+        }
+        EEPROM_write_float_array(temp_bias_new, MSZ, GYRO_BIAS_PAGE, 0);
+        printf("Gyro bias %+1.3f, %+1.3f, %+1.3f dps in %d msec, %s\r\n",
+                gyro_bias[0], gyro_bias[1], gyro_bias[2], Sys_timer_get_msec() - cal_start,
+                gyro_cal_status.is_seeded == TRUE ? "seeded" : "cold");
+    } else {
+        printf("Gyro bias not converged, %d restarts, using %+1.3f, %+1.3f, %+1.3f dps\r\n",
+                gyro_cal_status.restarts, gyro_bias[0], gyro_bias[1], gyro_bias[2]);
+    }
+    ahrs.bias[0] = gyro_bias[0] * deg2rad;
+    ahrs.bias[1] = gyro_bias[1] * deg2rad;
+    ahrs.bias[2] = gyro_bias[2] * deg2rad;
+    if (is_temp_model == TRUE) {
+        ahrs.ki_a *= TEMP_KI_SCALE;
+        ahrs.ki_m *= TEMP_KI_SCALE;
+    }
+
     start_time = Sys_timer_get_msec();
     while (1) {
         current_time = Sys_timer_get_msec();
@@ -373,23 +208,43 @@ int main(void) {
             gyro_cal[0] = (double) IMU_data.gyro.x * deg2rad;
             gyro_cal[1] = (double) IMU_data.gyro.y * deg2rad;
             gyro_cal[2] = (double) IMU_data.gyro.z * deg2rad;
+
+            /* keep learning while the board sits still, a refit moves the
+             * bias the driver takes off, the AHRS bias moves the other way */
+            IMU_get_gyro_temp_bias(temp_bias);
+            gyro_f[0] = IMU_data.gyro.x + temp_bias[0];
+            gyro_f[1] = IMU_data.gyro.y + temp_bias[1];
+            gyro_f[2] = IMU_data.gyro.z + temp_bias[2];
+            acc_f[0] = IMU_data.acc.x;
+            acc_f[1] = IMU_data.acc.y;
+            acc_f[2] = IMU_data.acc.z;
+            temp_c = IMU_data.temp / IMU_TEMP_SENSE + IMU_TEMP_OFFSET_C;
+            if ((Gyro_temp_update(gyro_f, acc_f, temp_c) == TRUE)
+                    && (Gyro_temp_fit(&temp_model) == SUCCESS)
+                    && (IMU_set_gyro_temp_model(&temp_model) == SUCCESS)) {
+                IMU_get_gyro_temp_bias(temp_bias_new);
+                for (i = 0; i < MSZ; i++) {
+                    ahrs.bias[i] -= (temp_bias_new[i] - temp_bias[i]) * deg2rad;
+                }
+                /* the EEPROM writes block, only save when a bin is added */
+                Gyro_temp_get_status(&temp_status);
+                if (temp_status.bins > saved_bins) {
+                    saved_bins = temp_status.bins;
+                    Gyro_temp_get_table(temp_table);
+                    for (page = 0; page < GYRO_TEMP_TABLE_PAGES; page++) {
+                        EEPROM_write_float_array(&temp_table[page * GYRO_TEMP_PAGE_FLOATS],
+                                GYRO_TEMP_PAGE_FLOATS, GYRO_TEMP_PAGE + page, 0);
+                    }
+                }
+            }
             update_start = Sys_timer_get_usec();
-            ahrs_update(q_minus, b_minus, gyro_cal, mag_cal, acc_cal, m_i,
-                    a_i, dt, kp_a, ki_a, kp_m, ki_m, q_plus, b_plus);
+            AHRS_kernel_update_d(&ahrs, acc_cal, mag_cal, gyro_cal, dt);
             update_end = Sys_timer_get_usec();
-            quat2euler(q_plus, euler);
+            AHRS_kernel_q_to_euler_d(ahrs.q, euler);
 
             printf("%+3.1f, %+3.1f, %+3.1f, ", euler[0] * rad2deg, euler[1] * rad2deg, euler[2] * rad2deg);
-            printf("%+1.3e, %+1.3e, %+1.3e, ", b_plus[0], b_plus[1], b_plus[2]);
+            printf("%+1.3e, %+1.3e, %+1.3e, ", ahrs.bias[0], ahrs.bias[1], ahrs.bias[2]);
             printf("%d\r\n", update_end - update_start);
-            // update b_minus and q_minus
-            b_minus[0] = b_plus[0];
-            b_minus[1] = b_plus[1];
-            b_minus[2] = b_plus[2];
-            q_minus[0] = q_plus[0];
-            q_minus[1] = q_plus[1];
-            q_minus[2] = q_plus[2];
-            q_minus[3] = q_plus[3];
         }
     }
     return 0;
@@ -86,30 +86,18 @@ void lin_alg_q_mult(double q[QSZ], double p[QSZ], double r[QSZ]) {
  * sets v_b to the rotated inertial vector in the body frame
  */
 void q_rot_v_q(double v_i[MSZ], double q[QSZ], double v_b[MSZ]) {
-    double q_i[QSZ];
-    double q_temp[QSZ];
-    double q_conj[QSZ];
-    double q_b[QSZ]; // container for inertial vector in body frame as pure quaternion
-
-    // calculate conjugate of q 
-    q_conj[0] = q[0];
-    q_conj[1] = -q[1];
-    q_conj[2] = -q[2];
-    q_conj[3] = -q[3];
-
-    //   convert v_i to a pure quaternion --> q_i
-    q_i[0] = 0;
-    q_i[1] = v_i[0];
-    q_i[2] = v_i[1];
-    q_i[3] = v_i[2];
-    //   first quaternion product q_i by q --> q_temp
-    lin_alg_q_mult(q_i, q, q_temp);
-    //   second quaternion product q_conj by q_temp -->q_b
-    lin_alg_q_mult(q_conj, q_temp, q_b);
-    //    set v_b to imaginary part of q_b
-    v_b[0] = q_b[1];
-    v_b[1] = q_b[2];
-    v_b[2] = q_b[3];
+    double v0 = v_i[0];
+    double v1 = v_i[1];
+    double v2 = v_i[2];
+    // t = 2 v_i x u, u the vector part of q
+    double t0 = 2.0 * (v1 * q[3] - v2 * q[2]);
+    double t1 = 2.0 * (v2 * q[1] - v0 * q[3]);
+    double t2 = 2.0 * (v0 * q[2] - v1 * q[1]);
+
+    // v_b = q* v_i q = v_i + q0 t + t x u
+    v_b[0] = v0 + q[0] * t0 + t1 * q[3] - t2 * q[2];
+    v_b[1] = v1 + q[0] * t1 + t2 * q[1] - t0 * q[3];
+    v_b[2] = v2 + q[0] * t2 + t0 * q[2] - t1 * q[1];
 }
 
 void v_copy(double m_in[MSZ], double m_out[MSZ]) {
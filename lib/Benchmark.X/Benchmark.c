@@ -0,0 +1,98 @@
+/*
+ * File:   Benchmark.c
+ * Author: Aaron Hunter
+ * Brief: Micro-benchmark runner for library kernels
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Benchmark.h" // The header file for this source file.
+#include <stdio.h>
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static HAL_cycles_t best_batch(benchmark_fn_t fn, void *ctx);
+static void empty_call(void *ctx);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* the pointer is volatile so the compiler can neither inline nor drop calls */
+static volatile benchmark_fn_t call_fn;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Benchmark_header(void)
+ * @author Aaron Hunter
+ */
+void Benchmark_header(void) {
+    printf("suite,kernel,iterations,per_call,units\r\n");
+}
+
+/**
+ * @Function Benchmark_run(const char *suite, const char *name, benchmark_fn_t fn, void *ctx)
+ * @author Aaron Hunter
+ */
+float Benchmark_run(const char *suite, const char *name, benchmark_fn_t fn, void *ctx) {
+    HAL_cycles_t overhead = best_batch(empty_call, ctx);
+    HAL_cycles_t elapsed = best_batch(fn, ctx);
+    float per_call;
+
+    elapsed = elapsed > overhead ? elapsed - overhead : 0;
+    per_call = (float) elapsed / BENCHMARK_ITERATIONS;
+    printf("%s,%s,%d,%.2f,%s\r\n", suite, name, BENCHMARK_ITERATIONS, per_call, HAL_CYCLE_UNITS);
+    return per_call;
+}
+
+/**
+ * @Function Benchmark_run_table(const char *suite, const benchmark_t *table, uint8_t length, void *ctx)
+ * @author Aaron Hunter
+ */
+void Benchmark_run_table(const char *suite, const benchmark_t *table, uint8_t length, void *ctx) {
+    uint8_t i;
+    for (i = 0; i < length; i++) {
+        Benchmark_run(suite, table[i].name, table[i].fn, ctx);
+    }
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function best_batch(benchmark_fn_t fn, void *ctx)
+ * @return shortest time of BENCHMARK_BATCHES batches, the first call warms
+ * the cache before any batch is timed
+ */
+static HAL_cycles_t best_batch(benchmark_fn_t fn, void *ctx) {
+    HAL_cycles_t best = 0xFFFFFFFFu;
+    HAL_cycles_t start;
+    HAL_cycles_t elapsed;
+    uint32_t i;
+    uint8_t batch;
+
+    call_fn = fn;
+    call_fn(ctx);
+    for (batch = 0; batch < BENCHMARK_BATCHES; batch++) {
+        start = HAL_get_cycles();
+        for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+            call_fn(ctx);
+        }
+        elapsed = HAL_get_cycles() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static void empty_call(void *ctx) {
+}
@@ -0,0 +1,80 @@
+/*
+ * File:   Benchmark.h
+ * Author: Aaron Hunter
+ * Brief: Micro-benchmark runner for library kernels.  Each kernel is called
+ * through a function pointer in batches timed with HAL_get_cycles(), the cost
+ * of an empty call is subtracted and the best batch is kept so interrupts and
+ * host scheduling only ever make a result pessimistic.  Results are printed
+ * as CSV lines, one per kernel:
+ *     suite,kernel,iterations,per_call,units
+ * with units ns on the Linux backend and cycles on the PIC32, so the output of
+ * successive builds can be diffed or loaded into a spreadsheet directly.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef BENCHMARK_H // Header guard
+#define	BENCHMARK_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "HAL.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#ifndef BENCHMARK_ITERATIONS
+#define BENCHMARK_ITERATIONS 1000 // calls per batch, keep a batch well under a counter wrap
+#endif
+#ifndef BENCHMARK_BATCHES
+#define BENCHMARK_BATCHES 7 // the fastest batch is reported
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef void (*benchmark_fn_t)(void *ctx);
+
+typedef struct {
+    const char *name;
+    benchmark_fn_t fn;
+} benchmark_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Benchmark_header(void)
+ * @brief prints the CSV column names
+ * @author Aaron Hunter
+ */
+void Benchmark_header(void);
+
+/**
+ * @Function Benchmark_run(const char *suite, const char *name, benchmark_fn_t fn, void *ctx)
+ * @param suite, first CSV column, the module under test
+ * @param name, second CSV column, the kernel
+ * @param fn, calls the kernel once with its operands in ctx
+ * @param ctx, operands and results, passed through to fn
+ * @return time per call in HAL_CYCLE_UNITS with the call overhead removed
+ * @brief times BENCHMARK_BATCHES batches of BENCHMARK_ITERATIONS calls and
+ * prints the best as one CSV line
+ * @author Aaron Hunter
+ */
+float Benchmark_run(const char *suite, const char *name, benchmark_fn_t fn, void *ctx);
+
+/**
+ * @Function Benchmark_run_table(const char *suite, const benchmark_t *table, uint8_t length, void *ctx)
+ * @param suite, first CSV column
+ * @param table, kernels sharing one operand structure
+ * @param length, number of entries in table
+ * @param ctx, operands and results
+ * @author Aaron Hunter
+ */
+void Benchmark_run_table(const char *suite, const benchmark_t *table, uint8_t length, void *ctx);
+
+#endif	/* BENCHMARK_H */ // End of header guard
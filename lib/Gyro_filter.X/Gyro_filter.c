@@ -0,0 +1,648 @@
+/*
+ * File:   Gyro_filter.c
+ * Author: Aaron Hunter
+ * Brief: Anti-aliasing and decimation filters between the IMU and the AHRS
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Gyro_filter.h" // The header file for this source file.
+#include "Board.h"
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+/* half-band taps in 1/512, h[5 -/+ j] for j = 1, 3, 5 and the center h[5] */
+#define HB_TAP_1 150
+#define HB_TAP_3 -25
+#define HB_TAP_5 3
+#define HB_CENTER 256
+#define HB_SHIFT 9
+#define HB_SCALE (1.0f / (1 << HB_SHIFT))
+#define BUTTERWORTH_Q 0.70710678118654752
+#define Q30_FRAC_MASK ((1L << 30) - 1)
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static int8_t biquad_design(float fs_hz, float cutoff_hz, double c[5]);
+static int8_t check_config(const gyro_filter_config_t *config);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_filter_init(gyro_filter_t *filter, const gyro_filter_config_t *config)
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_init(gyro_filter_t *filter, const gyro_filter_config_t *config) {
+    if (config->cic_order != 0 || check_config(config) == ERROR) {
+        return ERROR;
+    }
+    memset(filter, 0, sizeof (*filter));
+    filter->halfbands = config->halfbands;
+    if (config->cutoff_hz > 0) {
+        filter->use_lpf = TRUE;
+        Gyro_filter_biquad_init(&filter->lpf, config->odr_hz / Gyro_filter_decimation(config),
+                config->cutoff_hz);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_filter_update(gyro_filter_t *filter, const float in[MSZ], float out[MSZ])
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_update(gyro_filter_t *filter, const float in[MSZ], float out[MSZ]) {
+    float v[MSZ] = {in[0], in[1], in[2]};
+    uint8_t i;
+
+    for (i = 0; i < filter->halfbands; i++) {
+        if (Gyro_filter_halfband(&filter->halfband[i], v, v) == FALSE) {
+            return FALSE;
+        }
+    }
+    if (filter->use_lpf) {
+        Gyro_filter_biquad(&filter->lpf, v);
+    }
+    out[0] = v[0];
+    out[1] = v[1];
+    out[2] = v[2];
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_filter_fix_init(gyro_filter_fix_t *filter, const gyro_filter_config_t *config)
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_fix_init(gyro_filter_fix_t *filter, const gyro_filter_config_t *config) {
+    if (check_config(config) == ERROR) {
+        return ERROR;
+    }
+    memset(filter, 0, sizeof (*filter));
+    if (config->cic_order != 0) {
+        Gyro_filter_cic_init(&filter->cic, config->cic_order, config->cic_log2_ratio);
+    }
+    filter->halfbands = config->halfbands;
+    if (config->cutoff_hz > 0) {
+        filter->use_lpf = TRUE;
+        Gyro_filter_biquad_fix_init(&filter->lpf, config->odr_hz / Gyro_filter_decimation(config),
+                config->cutoff_hz);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_filter_fix_update(gyro_filter_fix_t *filter, const q16_t in[MSZ], q16_t out[MSZ])
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_fix_update(gyro_filter_fix_t *filter, const q16_t in[MSZ], q16_t out[MSZ]) {
+    q16_t v[MSZ] = {in[0], in[1], in[2]};
+    uint8_t i;
+
+    if (filter->cic.order != 0 && Gyro_filter_cic(&filter->cic, v, v) == FALSE) {
+        return FALSE;
+    }
+    for (i = 0; i < filter->halfbands; i++) {
+        if (Gyro_filter_halfband_fix(&filter->halfband[i], v, v) == FALSE) {
+            return FALSE;
+        }
+    }
+    if (filter->use_lpf) {
+        Gyro_filter_biquad_fix(&filter->lpf, v);
+    }
+    out[0] = v[0];
+    out[1] = v[1];
+    out[2] = v[2];
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_filter_decimation(const gyro_filter_config_t *config)
+ * @author Aaron Hunter
+ */
+uint16_t Gyro_filter_decimation(const gyro_filter_config_t *config) {
+    uint8_t log2_ratio = config->halfbands;
+    if (config->cic_order != 0) {
+        log2_ratio += config->cic_log2_ratio;
+    }
+    return (uint16_t) 1 << log2_ratio;
+}
+
+/**
+ * @Function Gyro_filter_biquad_init(gyro_biquad_t *biquad, float fs_hz, float cutoff_hz)
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_biquad_init(gyro_biquad_t *biquad, float fs_hz, float cutoff_hz) {
+    double c[5];
+    if (biquad_design(fs_hz, cutoff_hz, c) == ERROR) {
+        return ERROR;
+    }
+    memset(biquad, 0, sizeof (*biquad));
+    biquad->b0 = (float) c[0];
+    biquad->b1 = (float) c[1];
+    biquad->b2 = (float) c[2];
+    biquad->a1 = (float) c[3];
+    biquad->a2 = (float) c[4];
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_filter_biquad(gyro_biquad_t *biquad, float v[MSZ])
+ * @author Aaron Hunter
+ */
+void Gyro_filter_biquad(gyro_biquad_t *biquad, float v[MSZ]) {
+    float x;
+    float y;
+    uint8_t i;
+
+    for (i = 0; i < MSZ; i++) {
+        x = v[i];
+        y = biquad->b0 * x + biquad->z1[i];
+        biquad->z1[i] = biquad->b1 * x - biquad->a1 * y + biquad->z2[i];
+        biquad->z2[i] = biquad->b2 * x - biquad->a2 * y;
+        v[i] = y;
+    }
+}
+
+/**
+ * @Function Gyro_filter_biquad_fix_init(gyro_biquad_fix_t *biquad, float fs_hz, float cutoff_hz)
+ * @note a1 is above -2 for any cutoff in range, so all five fit Q2.30
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_biquad_fix_init(gyro_biquad_fix_t *biquad, float fs_hz, float cutoff_hz) {
+    double c[5];
+    if (biquad_design(fs_hz, cutoff_hz, c) == ERROR) {
+        return ERROR;
+    }
+    memset(biquad, 0, sizeof (*biquad));
+    biquad->b0 = (q30_t) lround(c[0] * Q30_ONE);
+    biquad->b1 = (q30_t) lround(c[1] * Q30_ONE);
+    biquad->b2 = (q30_t) lround(c[2] * Q30_ONE);
+    biquad->a1 = (q30_t) lround(c[3] * Q30_ONE);
+    biquad->a2 = (q30_t) lround(c[4] * Q30_ONE);
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_filter_biquad_fix(gyro_biquad_fix_t *biquad, q16_t v[MSZ])
+ * @note the fraction the shift drops is added to the next output, which
+ * moves the truncation noise away from DC.  Without it a low cutoff
+ * amplifies the truncation by 1 / (1 + a1 + a2) into a rate offset.
+ * @author Aaron Hunter
+ */
+void Gyro_filter_biquad_fix(gyro_biquad_fix_t *biquad, q16_t v[MSZ]) {
+    int64_t acc;
+    q16_t x;
+    q16_t y;
+    uint8_t i;
+
+    for (i = 0; i < MSZ; i++) {
+        x = v[i];
+        acc = (int64_t) biquad->b0 * x + (int64_t) biquad->b1 * biquad->x1[i]
+                + (int64_t) biquad->b2 * biquad->x2[i] - (int64_t) biquad->a1 * biquad->y1[i]
+                - (int64_t) biquad->a2 * biquad->y2[i] + biquad->frac[i];
+        y = (q16_t) (acc >> 30);
+        biquad->frac[i] = (q30_t) (acc & Q30_FRAC_MASK);
+        biquad->x2[i] = biquad->x1[i];
+        biquad->x1[i] = x;
+        biquad->y2[i] = biquad->y1[i];
+        biquad->y1[i] = y;
+        v[i] = y;
+    }
+}
+
+/**
+ * @Function Gyro_filter_halfband(gyro_halfband_t *halfband, const float in[MSZ], float out[MSZ])
+ * @note the odd delay line feeds only the center tap, the even line the
+ * symmetric pairs, so each output needs one pass over the newest 11 inputs
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_halfband(gyro_halfband_t *halfband, const float in[MSZ], float out[MSZ]) {
+    float (*e)[MSZ] = halfband->even;
+    uint8_t i;
+
+    if (halfband->phase == 0) {
+        halfband->phase = 1;
+        memmove(halfband->odd[1], halfband->odd[0], (GYRO_FILTER_HB_ODD - 1) * sizeof (halfband->odd[0]));
+        memcpy(halfband->odd[0], in, sizeof (halfband->odd[0]));
+        return FALSE;
+    }
+    halfband->phase = 0;
+    memmove(e[1], e[0], (GYRO_FILTER_HB_EVEN - 1) * sizeof (e[0]));
+    memcpy(e[0], in, sizeof (e[0]));
+    for (i = 0; i < MSZ; i++) {
+        out[i] = (HB_TAP_5 * (e[0][i] + e[5][i]) + HB_TAP_3 * (e[1][i] + e[4][i])
+                + HB_TAP_1 * (e[2][i] + e[3][i]) + HB_CENTER * halfband->odd[2][i]) * HB_SCALE;
+    }
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_filter_halfband_fix(gyro_halfband_fix_t *halfband, const q16_t in[MSZ], q16_t out[MSZ])
+ * @note the sum is formed in 64 bits, 612 times a Q16.16 input can exceed
+ * 32, and rounded to nearest, the taps sum to exactly one
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_halfband_fix(gyro_halfband_fix_t *halfband, const q16_t in[MSZ], q16_t out[MSZ]) {
+    q16_t (*e)[MSZ] = halfband->even;
+    int64_t sum;
+    uint8_t i;
+
+    if (halfband->phase == 0) {
+        halfband->phase = 1;
+        memmove(halfband->odd[1], halfband->odd[0], (GYRO_FILTER_HB_ODD - 1) * sizeof (halfband->odd[0]));
+        memcpy(halfband->odd[0], in, sizeof (halfband->odd[0]));
+        return FALSE;
+    }
+    halfband->phase = 0;
+    memmove(e[1], e[0], (GYRO_FILTER_HB_EVEN - 1) * sizeof (e[0]));
+    memcpy(e[0], in, sizeof (e[0]));
+    for (i = 0; i < MSZ; i++) {
+        sum = HB_TAP_5 * ((int64_t) e[0][i] + e[5][i]) + HB_TAP_3 * ((int64_t) e[1][i] + e[4][i])
+                + HB_TAP_1 * ((int64_t) e[2][i] + e[3][i]) + HB_CENTER * (int64_t) halfband->odd[2][i];
+        out[i] = (q16_t) ((sum + (1 << (HB_SHIFT - 1))) >> HB_SHIFT);
+    }
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_filter_cic_init(gyro_cic_t *cic, uint8_t order, uint8_t log2_ratio)
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_cic_init(gyro_cic_t *cic, uint8_t order, uint8_t log2_ratio) {
+    if (order < 1 || order > GYRO_FILTER_CIC_MAX_ORDER || log2_ratio < 1
+            || order * log2_ratio > GYRO_FILTER_CIC_MAX_GROWTH) {
+        return ERROR;
+    }
+    memset(cic, 0, sizeof (*cic));
+    cic->order = order;
+    cic->log2_ratio = log2_ratio;
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_filter_cic(gyro_cic_t *cic, const q16_t in[MSZ], q16_t out[MSZ])
+ * @note the R^N gain is a shift, rounded to nearest
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_cic(gyro_cic_t *cic, const q16_t in[MSZ], q16_t out[MSZ]) {
+    uint8_t growth = cic->order * cic->log2_ratio;
+    uint32_t y;
+    uint32_t previous;
+    uint8_t i;
+    uint8_t s;
+
+    for (i = 0; i < MSZ; i++) {
+        y = (uint32_t) in[i];
+        for (s = 0; s < cic->order; s++) {
+            cic->integrator[s][i] += y;
+            y = cic->integrator[s][i];
+        }
+    }
+    if (++cic->count < (1 << cic->log2_ratio)) {
+        return FALSE;
+    }
+    cic->count = 0;
+    for (i = 0; i < MSZ; i++) {
+        y = cic->integrator[cic->order - 1][i];
+        for (s = 0; s < cic->order; s++) {
+            previous = cic->comb[s][i];
+            cic->comb[s][i] = y;
+            y -= previous;
+        }
+        out[i] = (q16_t) ((int32_t) (y + (1u << (growth - 1))) >> growth);
+    }
+    return TRUE;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function biquad_design(float fs_hz, float cutoff_hz, double c[5])
+ * @param c, b0, b1, b2, a1, a2 of the bilinear transform Butterworth, whose
+ * frequency warping puts the -3 dB point exactly at cutoff_hz
+ * @return SUCCESS or ERROR for a cutoff out of range
+ * @author Aaron Hunter
+ */
+static int8_t biquad_design(float fs_hz, float cutoff_hz, double c[5]) {
+    double w0;
+    double alpha;
+    double cos_w0;
+    double a0;
+    if (cutoff_hz <= 0 || cutoff_hz >= 0.5f * fs_hz) {
+        return ERROR;
+    }
+    w0 = 2.0 * M_PI * cutoff_hz / fs_hz;
+    alpha = sin(w0) / (2.0 * BUTTERWORTH_Q);
+    cos_w0 = cos(w0);
+    a0 = 1.0 + alpha;
+    c[0] = 0.5 * (1.0 - cos_w0) / a0;
+    c[1] = 2.0 * c[0];
+    c[2] = c[0];
+    c[3] = -2.0 * cos_w0 / a0;
+    c[4] = (1.0 - alpha) / a0;
+    return SUCCESS;
+}
+
+/**
+ * @Function check_config(const gyro_filter_config_t *config)
+ * @return SUCCESS or ERROR for any stage out of range, checked before a bank
+ * is touched so a rejected configuration leaves it as it was
+ * @author Aaron Hunter
+ */
+static int8_t check_config(const gyro_filter_config_t *config) {
+    uint8_t order = config->cic_order;
+    if (config->odr_hz <= 0 || config->halfbands > GYRO_FILTER_MAX_HALFBANDS || config->cutoff_hz < 0
+            || config->cutoff_hz >= 0.5f * config->odr_hz / Gyro_filter_decimation(config)) {
+        return ERROR;
+    }
+    if (order != 0 && (order > GYRO_FILTER_CIC_MAX_ORDER || config->cic_log2_ratio < 1
+            || order * config->cic_log2_ratio > GYRO_FILTER_CIC_MAX_GROWTH)) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+#ifdef GYRO_FILTER_TESTING
+#include <stdio.h>
+#include <stdlib.h>
+#include "SerialM32.h"
+
+#define TEST_SAMPLES 4000
+#define TEST_SETTLE 2000
+
+/* output amplitude on axis 0 of a unit tone after the transients, from the
+ * RMS since the samples miss the peaks */
+static float tone_float(gyro_filter_t *filter, float odr_hz, float tone_hz) {
+    float in[MSZ];
+    float out[MSZ];
+    double power = 0;
+    int outputs = 0;
+    int n;
+    for (n = 0; n < TEST_SAMPLES; n++) {
+        in[0] = sinf(2 * M_PI * tone_hz * n / odr_hz + 0.3f);
+        in[1] = in[0];
+        in[2] = in[0];
+        if (Gyro_filter_update(filter, in, out) && n > TEST_SETTLE) {
+            power += out[0] * out[0];
+            outputs++;
+        }
+    }
+    return sqrt(2 * power / outputs);
+}
+
+static float tone_fix(gyro_filter_fix_t *filter, float odr_hz, float tone_hz) {
+    q16_t in[MSZ];
+    q16_t out[MSZ];
+    double power = 0;
+    int outputs = 0;
+    int n;
+    for (n = 0; n < TEST_SAMPLES; n++) {
+        in[0] = FLOAT_TO_Q16(sinf(2 * M_PI * tone_hz * n / odr_hz + 0.3f));
+        in[1] = in[0];
+        in[2] = in[0];
+        if (Gyro_filter_fix_update(filter, in, out) && n > TEST_SETTLE) {
+            power += Q16_TO_FLOAT(out[0]) * Q16_TO_FLOAT(out[0]);
+            outputs++;
+        }
+    }
+    return sqrt(2 * power / outputs);
+}
+
+static uint8_t check(const char *name, float value, float low, float high) {
+    uint8_t pass = (value >= low && value <= high);
+    printf("%s: %g, expected %g to %g, %s\r\n", name, (double) value, (double) low, (double) high,
+            pass ? "pass" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int main(void) {
+    gyro_filter_config_t halfband = {1000, 0, 0, 1, 0};
+    gyro_filter_config_t lpf = {1000, 0, 0, 0, 100};
+    gyro_filter_config_t bank = {1000, 0, 0, 2, 50};
+    gyro_filter_config_t cic = {1000, 2, 2, 0, 0};
+    gyro_filter_config_t cic_bank = {1000, 2, 2, 1, 20};
+    gyro_filter_config_t quad = {562.5, 0, 0, 1, 80};
+    gyro_filter_config_t bad;
+    static gyro_filter_t filter;
+    static gyro_filter_fix_t filter_fix;
+    float in[MSZ];
+    float out[MSZ];
+    q16_t in_fix[MSZ];
+    q16_t out_fix[MSZ];
+    float diff = 0;
+    uint8_t failures = 0;
+    int n;
+    int i;
+
+    Board_init();
+    Serial_init();
+    printf("Gyro_filter test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    /* half-band: flat below a quarter of the input rate, an alias at 0.4 of
+     * it (folding to 0.1 of the output rate) is down 42 dB */
+    Gyro_filter_init(&filter, &halfband);
+    failures += check("half-band at 0.05 fs", tone_float(&filter, 1000, 50), 0.998, 1.001);
+    Gyro_filter_init(&filter, &halfband);
+    failures += check("half-band at 0.4 fs", tone_float(&filter, 1000, 400), 0, 0.01);
+    Gyro_filter_fix_init(&filter_fix, &halfband);
+    failures += check("fixed half-band at 0.4 fs", tone_fix(&filter_fix, 1000, 400), 0, 0.01);
+
+    /* biquad: -3 dB at the cutoff */
+    Gyro_filter_init(&filter, &lpf);
+    failures += check("biquad at cutoff", tone_float(&filter, 1000, 100), 0.702, 0.712);
+    Gyro_filter_fix_init(&filter_fix, &lpf);
+    failures += check("fixed biquad at cutoff", tone_fix(&filter_fix, 1000, 100), 0.702, 0.712);
+
+    /* CIC: the nulls at multiples of the output rate take out what would
+     * alias to DC */
+    Gyro_filter_fix_init(&filter_fix, &cic);
+    failures += check("CIC at fs / R", tone_fix(&filter_fix, 1000, 250), 0, 1e-4);
+
+    /* whole banks: unity gain at DC, the fixed point bank to the LSB */
+    Gyro_filter_init(&filter, &bank);
+    for (n = 0; n < TEST_SAMPLES; n++) {
+        in[0] = 1.5;
+        in[1] = -2.0;
+        in[2] = 0.25;
+        Gyro_filter_update(&filter, in, out);
+    }
+    for (i = 0; i < MSZ; i++) {
+        diff = fmaxf(diff, fabsf(out[i] - in[i]));
+    }
+    failures += check("float bank DC error", diff, 0, 1e-5);
+    Gyro_filter_fix_init(&filter_fix, &cic_bank);
+    for (n = 0; n < TEST_SAMPLES; n++) {
+        in_fix[0] = FLOAT_TO_Q16(1.5);
+        in_fix[1] = FLOAT_TO_Q16(-2.0);
+        in_fix[2] = FLOAT_TO_Q16(0.2501);
+        Gyro_filter_fix_update(&filter_fix, in_fix, out_fix);
+    }
+    diff = 0;
+    for (i = 0; i < MSZ; i++) {
+        diff = fmaxf(diff, abs(out_fix[i] - in_fix[i]));
+    }
+    failures += check("fixed bank DC error, LSB", diff, 0, 1);
+
+    /* the fixed point bank follows the float one on noise */
+    Gyro_filter_init(&filter, &quad);
+    Gyro_filter_fix_init(&filter_fix, &quad);
+    diff = 0;
+    srand(1);
+    for (n = 0; n < TEST_SAMPLES; n++) {
+        for (i = 0; i < MSZ; i++) {
+            in[i] = 10.0f * rand() / RAND_MAX - 5.0f;
+            in_fix[i] = FLOAT_TO_Q16(in[i]);
+        }
+        if (Gyro_filter_update(&filter, in, out) != Gyro_filter_fix_update(&filter_fix, in_fix, out_fix)) {
+            diff = 1;
+            break;
+        }
+        for (i = 0; i < MSZ; i++) {
+            diff = fmaxf(diff, fabsf(out[i] - Q16_TO_FLOAT(out_fix[i])));
+        }
+    }
+    failures += check("fixed against float bank on noise", diff, 0, 2e-4);
+
+    /* configurations that do not fit */
+    bad = cic;
+    failures += check("float bank with a CIC", Gyro_filter_init(&filter, &bad), ERROR, ERROR);
+    bad = bank;
+    bad.cutoff_hz = 125;
+    failures += check("cutoff at the output Nyquist", Gyro_filter_init(&filter, &bad), ERROR, ERROR);
+    bad = cic;
+    bad.cic_order = 3;
+    bad.cic_log2_ratio = 3;
+    Gyro_filter_fix_init(&filter_fix, &cic);
+    failures += check("CIC growth of 9 bits", Gyro_filter_fix_init(&filter_fix, &bad), ERROR, ERROR);
+    failures += check("rejected bank left as it was", filter_fix.cic.order, 2, 2);
+    failures += check("decimation", Gyro_filter_decimation(&cic_bank), 8, 8);
+
+    printf("%s\r\n", failures == 0 ? "Gyro_filter tests passed" : "Gyro_filter tests FAILED");
+    return 0;
+}
+#endif //GYRO_FILTER_TESTING
+
+#ifdef GYRO_FILTER_BENCHMARK
+/*
+ * Time per input sample of each stage and of the two banks configured for
+ * the quad, the FIFO at 562.5 Hz decimated by 2 with an 80 Hz low-pass,
+ * and the full rate 1125 Hz decimated by 8 with a CIC.  CSV as in
+ * Benchmark.h, "#" lines are comments.  On the host:
+ *     gcc -O2 -DHAL_SIM -DGYRO_FILTER_BENCHMARK -Ilib/HAL.X/linux -Ilib/HAL.X
+ *         -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X -Ilib/Lin_alg.X
+ *         -Ilib/Benchmark.X lib/Gyro_filter.X/Gyro_filter.c
+ *         lib/Benchmark.X/Benchmark.c lib/HAL.X/HAL_linux.c lib/Board.X/Board.c
+ *         lib/Serial.X/SerialM32.c lib/System_timer.X/System_timer.c -lm
+ * On the target add Benchmark.c and HAL_pic32.c to the project, the cycles
+ * per input times the input rate is the CPU load.
+ */
+#include <stdio.h>
+#include "Benchmark.h"
+#include "SerialM32.h"
+
+#define BENCH_SUITE "gyro_filter"
+
+typedef struct {
+    float in[MSZ];
+    float out[MSZ];
+    q16_t in_fix[MSZ];
+    q16_t out_fix[MSZ];
+    gyro_biquad_t biquad;
+    gyro_biquad_fix_t biquad_fix;
+    gyro_halfband_t halfband;
+    gyro_halfband_fix_t halfband_fix;
+    gyro_cic_t cic;
+    gyro_filter_t bank;
+    gyro_filter_fix_t bank_fix;
+    gyro_filter_fix_t bank_cic;
+} bench_operands_t;
+
+static void bench_biquad(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_biquad(&o->biquad, o->in);
+}
+
+static void bench_biquad_fix(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_biquad_fix(&o->biquad_fix, o->in_fix);
+}
+
+static void bench_halfband(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_halfband(&o->halfband, o->in, o->out);
+}
+
+static void bench_halfband_fix(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_halfband_fix(&o->halfband_fix, o->in_fix, o->out_fix);
+}
+
+static void bench_cic(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_cic(&o->cic, o->in_fix, o->out_fix);
+}
+
+static void bench_bank(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_update(&o->bank, o->in, o->out);
+}
+
+static void bench_bank_fix(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_fix_update(&o->bank_fix, o->in_fix, o->out_fix);
+}
+
+static void bench_bank_cic(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_filter_fix_update(&o->bank_cic, o->in_fix, o->out_fix);
+}
+
+/* per input sample, the decimators only compute on some of the calls */
+static const benchmark_t kernels[] = {
+    {"biquad", bench_biquad},
+    {"biquad_fix", bench_biquad_fix},
+    {"halfband", bench_halfband},
+    {"halfband_fix", bench_halfband_fix},
+    {"cic_2_4_fix", bench_cic},
+    {"bank_562_hb_lpf", bench_bank},
+    {"bank_562_hb_lpf_fix", bench_bank_fix},
+    {"bank_1125_cic_hb_lpf_fix", bench_bank_cic},
+};
+
+int main(void) {
+    static bench_operands_t operands;
+    gyro_filter_config_t quad = {562.5, 0, 0, 1, 80};
+    gyro_filter_config_t full_rate = {1125, 2, 2, 1, 40};
+    uint8_t i;
+
+    Board_init();
+    Serial_init();
+    printf("# Gyro_filter benchmark %s, %s\r\n", __DATE__, __TIME__);
+    for (i = 0; i < MSZ; i++) {
+        operands.in[i] = 0.1f * (i + 1);
+        operands.in_fix[i] = FLOAT_TO_Q16(operands.in[i]);
+    }
+    Gyro_filter_biquad_init(&operands.biquad, 562.5, 80);
+    Gyro_filter_biquad_fix_init(&operands.biquad_fix, 562.5, 80);
+    Gyro_filter_cic_init(&operands.cic, 2, 2);
+    Gyro_filter_init(&operands.bank, &quad);
+    Gyro_filter_fix_init(&operands.bank_fix, &quad);
+    Gyro_filter_fix_init(&operands.bank_cic, &full_rate);
+
+    Benchmark_header();
+    Benchmark_run_table(BENCH_SUITE, kernels, sizeof (kernels) / sizeof (kernels[0]), &operands);
+    printf("# done\r\n");
+    return 0;
+}
+#endif //GYRO_FILTER_BENCHMARK
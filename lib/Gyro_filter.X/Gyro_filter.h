@@ -0,0 +1,253 @@
+/*
+ * File:   Gyro_filter.h
+ * Author: Aaron Hunter
+ * Brief: Anti-aliasing and decimation filters between the IMU and the AHRS.
+ * With the ICM-20948 read at its full output rate (up to 1125 Hz, the FIFO
+ * runs at 562.5 Hz) the rate loop should see the band limited average of the
+ * samples since its last step, not whichever sample is newest, or vibration
+ * above the loop's Nyquist frequency aliases into the rate estimate.
+ *
+ * A filter bank is a chain of up to three stages, each optional:
+ *     CIC decimator, fixed point only: order N integrator and comb sections,
+ *         decimation R = 2^k, a few integer adds per sample and axis
+ *     half-band decimators, decimation by 2 each: 11 tap linear phase FIR,
+ *         4 multiplies per output and axis, the taps are multiples of 1/512
+ *     biquad low-pass at the output rate: second order Butterworth
+ * Samples go in one at a time at the input rate and an output comes out every
+ * R * 2^halfbands inputs.  The float bank takes any units; the fixed point
+ * bank takes Q16.16, e.g. the rad/sec of IMU_get_fix_data().
+ *
+ * Cost per input sample and 3 axis vector, see GYRO_FILTER_BENCHMARK for
+ * measured times:
+ *     CIC          3 N adds, plus 3 N subtracts and a shift per output
+ *     half-band    12 multiplies, 18 adds per output, so half that per input
+ *     biquad       15 multiplies, 12 adds per output
+ * The PIC32MX795 has no FPU, so each float operation is a library call of
+ * roughly 50 to 100 cycles while the fixed point multiplies are single
+ * 32 x 32 -> 64 bit MULT instructions.  Use the fixed point bank for inputs
+ * at 1 kHz and above.
+ *
+ * Group delay at low frequencies: (N (R - 1)) / 2 input samples for the CIC,
+ * 5 samples at the input rate of each half-band, and 0.225 / cutoff_hz
+ * seconds for the Butterworth biquad.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef GYRO_FILTER_H // Header guard
+#define	GYRO_FILTER_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Lin_alg_fix.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+#define GYRO_FILTER_MAX_HALFBANDS 3 // decimation by up to 8 in half-bands
+#define GYRO_FILTER_HB_EVEN 6 // half-band taps on every other input
+#define GYRO_FILTER_HB_ODD 3 // inputs kept for the center tap
+#define GYRO_FILTER_CIC_MAX_ORDER 4
+/* bits the CIC adds to its input, N k, limited so an input of up to +/-128.0
+ * in Q16.16 (7300 deg/sec as rad/sec) scaled by R^N stays inside 32 bits */
+#define GYRO_FILTER_CIC_MAX_GROWTH 8
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    float odr_hz; // input sample rate
+    uint8_t cic_order; // N, 0 for no CIC stage, fixed point bank only
+    uint8_t cic_log2_ratio; // k, the CIC decimates by 2^k
+    uint8_t halfbands; // decimation by 2 each, up to GYRO_FILTER_MAX_HALFBANDS
+    float cutoff_hz; // biquad -3 dB frequency, 0 for none
+} gyro_filter_config_t;
+
+/* second order section, a0 = 1, transposed direct form II state */
+typedef struct {
+    float b0, b1, b2, a1, a2;
+    float z1[MSZ];
+    float z2[MSZ];
+} gyro_biquad_t;
+
+/* Q2.30 coefficients, direct form I state in the data format */
+typedef struct {
+    q30_t b0, b1, b2, a1, a2;
+    q16_t x1[MSZ], x2[MSZ];
+    q16_t y1[MSZ], y2[MSZ];
+    q30_t frac[MSZ]; // truncated fraction carried to the next output
+} gyro_biquad_fix_t;
+
+/* polyphase delay lines, newest first */
+typedef struct {
+    float even[GYRO_FILTER_HB_EVEN][MSZ];
+    float odd[GYRO_FILTER_HB_ODD][MSZ];
+    uint8_t phase;
+} gyro_halfband_t;
+
+typedef struct {
+    q16_t even[GYRO_FILTER_HB_EVEN][MSZ];
+    q16_t odd[GYRO_FILTER_HB_ODD][MSZ];
+    uint8_t phase;
+} gyro_halfband_fix_t;
+
+/* the integrators wrap modulo 2^32, the combs take the wrap back out */
+typedef struct {
+    uint32_t integrator[GYRO_FILTER_CIC_MAX_ORDER][MSZ];
+    uint32_t comb[GYRO_FILTER_CIC_MAX_ORDER][MSZ]; // previous comb inputs
+    uint8_t order;
+    uint8_t log2_ratio;
+    uint8_t count;
+} gyro_cic_t;
+
+typedef struct {
+    gyro_halfband_t halfband[GYRO_FILTER_MAX_HALFBANDS];
+    gyro_biquad_t lpf;
+    uint8_t halfbands;
+    uint8_t use_lpf;
+} gyro_filter_t;
+
+typedef struct {
+    gyro_cic_t cic;
+    gyro_halfband_fix_t halfband[GYRO_FILTER_MAX_HALFBANDS];
+    gyro_biquad_fix_t lpf;
+    uint8_t halfbands;
+    uint8_t use_lpf;
+} gyro_filter_fix_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_filter_init(gyro_filter_t *filter, const gyro_filter_config_t *config)
+ * @param filter, the float bank, cleared
+ * @param config, the stages, cic_order must be 0
+ * @return SUCCESS or ERROR for a stage the float bank does not have or a
+ * cutoff at or above the Nyquist frequency of the output
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_init(gyro_filter_t *filter, const gyro_filter_config_t *config);
+
+/**
+ * @Function Gyro_filter_update(gyro_filter_t *filter, const float in[MSZ], float out[MSZ])
+ * @param filter, the float bank
+ * @param in, the newest input sample
+ * @param out, written when an output is due
+ * @return TRUE when out holds a new output, FALSE otherwise
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_update(gyro_filter_t *filter, const float in[MSZ], float out[MSZ]);
+
+/**
+ * @Function Gyro_filter_fix_init(gyro_filter_fix_t *filter, const gyro_filter_config_t *config)
+ * @param filter, the fixed point bank, cleared
+ * @param config, the stages
+ * @return SUCCESS or ERROR for a CIC order over GYRO_FILTER_CIC_MAX_ORDER,
+ * a CIC growth over GYRO_FILTER_CIC_MAX_GROWTH or a cutoff at or above the
+ * Nyquist frequency of the output
+ * @note the coefficients are designed in floating point, call it at start up
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_fix_init(gyro_filter_fix_t *filter, const gyro_filter_config_t *config);
+
+/**
+ * @Function Gyro_filter_fix_update(gyro_filter_fix_t *filter, const q16_t in[MSZ], q16_t out[MSZ])
+ * @param filter, the fixed point bank
+ * @param in, the newest input sample in Q16.16
+ * @param out, written when an output is due
+ * @return TRUE when out holds a new output, FALSE otherwise
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_fix_update(gyro_filter_fix_t *filter, const q16_t in[MSZ], q16_t out[MSZ]);
+
+/**
+ * @Function Gyro_filter_decimation(const gyro_filter_config_t *config)
+ * @param config, the stages
+ * @return input samples per output sample
+ * @author Aaron Hunter
+ */
+uint16_t Gyro_filter_decimation(const gyro_filter_config_t *config);
+
+/**
+ * @Function Gyro_filter_biquad_init(gyro_biquad_t *biquad, float fs_hz, float cutoff_hz)
+ * @param biquad, designed as a Butterworth low-pass and cleared
+ * @param fs_hz, its sample rate
+ * @param cutoff_hz, -3 dB frequency, above 0 and below fs_hz / 2
+ * @return SUCCESS or ERROR for a cutoff out of range
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_biquad_init(gyro_biquad_t *biquad, float fs_hz, float cutoff_hz);
+
+/**
+ * @Function Gyro_filter_biquad(gyro_biquad_t *biquad, float v[MSZ])
+ * @param biquad, the section
+ * @param v, the input, replaced by the output
+ * @author Aaron Hunter
+ */
+void Gyro_filter_biquad(gyro_biquad_t *biquad, float v[MSZ]);
+
+/**
+ * @Function Gyro_filter_biquad_fix_init(gyro_biquad_fix_t *biquad, float fs_hz, float cutoff_hz)
+ * @param biquad, designed as a Butterworth low-pass and cleared
+ * @param fs_hz, its sample rate
+ * @param cutoff_hz, -3 dB frequency, above 0 and below fs_hz / 2
+ * @return SUCCESS or ERROR for a cutoff out of range
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_biquad_fix_init(gyro_biquad_fix_t *biquad, float fs_hz, float cutoff_hz);
+
+/**
+ * @Function Gyro_filter_biquad_fix(gyro_biquad_fix_t *biquad, q16_t v[MSZ])
+ * @param biquad, the section
+ * @param v, the input, replaced by the output
+ * @author Aaron Hunter
+ */
+void Gyro_filter_biquad_fix(gyro_biquad_fix_t *biquad, q16_t v[MSZ]);
+
+/**
+ * @Function Gyro_filter_halfband(gyro_halfband_t *halfband, const float in[MSZ], float out[MSZ])
+ * @param halfband, the stage
+ * @param in, the newest input
+ * @param out, written on every second input
+ * @return TRUE when out holds a new output, FALSE otherwise
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_halfband(gyro_halfband_t *halfband, const float in[MSZ], float out[MSZ]);
+
+/**
+ * @Function Gyro_filter_halfband_fix(gyro_halfband_fix_t *halfband, const q16_t in[MSZ], q16_t out[MSZ])
+ * @param halfband, the stage
+ * @param in, the newest input
+ * @param out, written on every second input
+ * @return TRUE when out holds a new output, FALSE otherwise
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_halfband_fix(gyro_halfband_fix_t *halfband, const q16_t in[MSZ], q16_t out[MSZ]);
+
+/**
+ * @Function Gyro_filter_cic_init(gyro_cic_t *cic, uint8_t order, uint8_t log2_ratio)
+ * @param cic, the stage, cleared
+ * @param order, N, 1 to GYRO_FILTER_CIC_MAX_ORDER
+ * @param log2_ratio, k, decimation by 2^k, N k at most GYRO_FILTER_CIC_MAX_GROWTH
+ * @return SUCCESS or ERROR for an order or growth out of range
+ * @author Aaron Hunter
+ */
+int8_t Gyro_filter_cic_init(gyro_cic_t *cic, uint8_t order, uint8_t log2_ratio);
+
+/**
+ * @Function Gyro_filter_cic(gyro_cic_t *cic, const q16_t in[MSZ], q16_t out[MSZ])
+ * @param cic, the stage
+ * @param in, the newest input in Q16.16
+ * @param out, written on every 2^k th input, unity gain at DC
+ * @return TRUE when out holds a new output, FALSE otherwise
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_filter_cic(gyro_cic_t *cic, const q16_t in[MSZ], q16_t out[MSZ]);
+
+#endif	/* GYRO_FILTER_H */ // End of header guard
@@ -0,0 +1,604 @@
+/*
+ * File:   Gyro_notch.c
+ * Author: Aaron Hunter
+ * Brief: Dynamic notch filters placed on the motor vibration peaks by an FFT
+ * of the gyro data, analyzed a bounded step at a time
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Gyro_notch.h" // The header file for this source file.
+#include "Board.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define N GYRO_NOTCH_FFT_SIZE
+#define N_MASK (N - 1)
+#define STEP_CAPTURE 0
+#define STEP_FFT 1 // steps 1 to GYRO_NOTCH_FFT_LOG2 are the FFT stages
+#define STEP_SPECTRUM (GYRO_NOTCH_FFT_LOG2 + 1)
+#define STEP_DESIGN (GYRO_NOTCH_FFT_LOG2 + 2)
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* shared by every instance, they only depend on N */
+static float window[N]; // periodic Hann
+static float twiddle_re[N / 2]; // e^(-2 pi i k / N)
+static float twiddle_im[N / 2];
+static uint8_t bit_reverse[N];
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void capture(gyro_notch_t *notch);
+static void fft_butterflies(gyro_notch_t *notch);
+static void find_peaks(gyro_notch_t *notch);
+static uint8_t move_notches(gyro_notch_t *notch);
+static void notch_design(gyro_biquad_t *biquad, float fs_hz, float center_hz, float q);
+static int8_t check_config(const gyro_notch_config_t *config);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_notch_init(gyro_notch_t *notch, const gyro_notch_config_t *config)
+ * @author Aaron Hunter
+ */
+int8_t Gyro_notch_init(gyro_notch_t *notch, const gyro_notch_config_t *config) {
+    uint16_t n;
+    uint16_t r;
+    uint8_t bit;
+
+    if (check_config(config) == ERROR) {
+        return ERROR;
+    }
+    memset(notch, 0, sizeof (*notch));
+    notch->config = *config;
+    for (n = 0; n < N; n++) {
+        window[n] = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * n / N);
+        r = 0;
+        for (bit = 0; bit < GYRO_NOTCH_FFT_LOG2; bit++) {
+            r |= ((n >> bit) & 1) << (GYRO_NOTCH_FFT_LOG2 - 1 - bit);
+        }
+        bit_reverse[n] = (uint8_t) r;
+    }
+    for (n = 0; n < N / 2; n++) {
+        twiddle_re[n] = cosf(2.0f * (float) M_PI * n / N);
+        twiddle_im[n] = -sinf(2.0f * (float) M_PI * n / N);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_notch_update(gyro_notch_t *notch, float v[MSZ])
+ * @author Aaron Hunter
+ */
+void Gyro_notch_update(gyro_notch_t *notch, float v[MSZ]) {
+    uint8_t p;
+
+    notch->ring[notch->head][0] = v[0];
+    notch->ring[notch->head][1] = v[1];
+    notch->head = (notch->head + 1) & N_MASK;
+    if (notch->fill < N) {
+        notch->fill++;
+    }
+    for (p = 0; p < notch->config.peaks; p++) {
+        if (notch->center_hz[p] > 0) {
+            Gyro_filter_biquad(&notch->notch[p], v);
+        }
+    }
+}
+
+/**
+ * @Function Gyro_notch_analyze(gyro_notch_t *notch)
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_notch_analyze(gyro_notch_t *notch) {
+    if (notch->step == STEP_CAPTURE) {
+        if (notch->fill == N) {
+            capture(notch);
+            notch->step = STEP_FFT;
+            notch->butterfly = 0;
+        }
+    } else if (notch->step < STEP_SPECTRUM) {
+        fft_butterflies(notch);
+    } else if (notch->step == STEP_SPECTRUM) {
+        find_peaks(notch);
+        notch->step = STEP_DESIGN;
+    } else {
+        notch->step = STEP_CAPTURE;
+        return move_notches(notch);
+    }
+    return FALSE;
+}
+
+/**
+ * @Function Gyro_notch_steps(const gyro_notch_config_t *config)
+ * @author Aaron Hunter
+ */
+uint16_t Gyro_notch_steps(const gyro_notch_config_t *config) {
+    uint16_t per_stage = (N / 2 + config->butterflies_per_step - 1) / config->butterflies_per_step;
+    return 1 + GYRO_NOTCH_FFT_LOG2 * per_stage + 2;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function capture(gyro_notch_t *notch)
+ * @brief windows the ring, oldest sample first, into bit reversed order so the
+ * butterflies run in place
+ * @author Aaron Hunter
+ */
+static void capture(gyro_notch_t *notch) {
+    uint16_t n;
+    uint16_t slot = notch->head; // the oldest sample once the ring is full
+    uint8_t r;
+
+    for (n = 0; n < N; n++) {
+        r = bit_reverse[n];
+        notch->re[r] = window[n] * notch->ring[slot][0];
+        notch->im[r] = window[n] * notch->ring[slot][1];
+        slot = (slot + 1) & N_MASK;
+    }
+}
+
+/**
+ * @Function fft_butterflies(gyro_notch_t *notch)
+ * @brief the next butterflies_per_step butterflies of the current decimation
+ * in time stage, stage s pairs samples 2^s apart
+ * @author Aaron Hunter
+ */
+static void fft_butterflies(gyro_notch_t *notch) {
+    uint8_t stage = notch->step - STEP_FFT;
+    uint16_t half = 1 << stage;
+    uint8_t stride = GYRO_NOTCH_FFT_LOG2 - 1 - stage; // log2 of the twiddle index step
+    uint16_t b = notch->butterfly;
+    uint16_t end = b + notch->config.butterflies_per_step;
+    uint16_t top;
+    uint16_t bottom;
+    uint16_t k;
+    float t_re;
+    float t_im;
+
+    if (end > N / 2) {
+        end = N / 2;
+    }
+    for (; b < end; b++) {
+        k = b & (half - 1);
+        top = ((b >> stage) << (stage + 1)) + k;
+        bottom = top + half;
+        k <<= stride;
+        t_re = twiddle_re[k] * notch->re[bottom] - twiddle_im[k] * notch->im[bottom];
+        t_im = twiddle_re[k] * notch->im[bottom] + twiddle_im[k] * notch->re[bottom];
+        notch->re[bottom] = notch->re[top] - t_re;
+        notch->im[bottom] = notch->im[top] - t_im;
+        notch->re[top] += t_re;
+        notch->im[top] += t_im;
+    }
+    if (end == N / 2) {
+        notch->step++;
+        notch->butterfly = 0;
+    } else {
+        notch->butterfly = end;
+    }
+}
+
+/**
+ * @Function find_peaks(gyro_notch_t *notch)
+ * @brief the strongest local maxima of the band that stand GYRO_NOTCH_PEAK_SNR
+ * above its noise floor and are at least min_amplitude, located between bins on a parabola through the log power,
+ * which is exact for a Gaussian and within a few hundredths of a bin for the
+ * Hann window's main lobe.  peak_hz is left in ascending order.
+ * @author Aaron Hunter
+ */
+static void find_peaks(gyro_notch_t *notch) {
+    const gyro_notch_config_t *config = &notch->config;
+    float *power = notch->re; // bin k of the spectrum replaces re[k], k <= N / 2
+    uint16_t k_min = (uint16_t) ceilf(config->min_hz * N / config->odr_hz);
+    uint16_t k_max = (uint16_t) (config->max_hz * N / config->odr_hz);
+    uint16_t best[GYRO_NOTCH_MAX_PEAKS];
+    uint8_t found = 0;
+    float mean = 0;
+    float floor = 0;
+    float threshold;
+    uint8_t below = 0;
+    float left;
+    float center;
+    float right;
+    float hz;
+    uint16_t k;
+    uint16_t mirror;
+    uint8_t p;
+    uint8_t j;
+
+    /* |Z[k]|^2 + |Z[N - k]|^2 reads only bins above N / 2 */
+    for (k = k_min - 1; k <= k_max + 1; k++) {
+        mirror = (N - k) & N_MASK;
+        power[k] = notch->re[k] * notch->re[k] + notch->im[k] * notch->im[k]
+                + notch->re[mirror] * notch->re[mirror] + notch->im[mirror] * notch->im[mirror];
+    }
+    for (k = k_min; k <= k_max; k++) {
+        mean += power[k];
+    }
+    mean /= (k_max - k_min + 1);
+    /* the bins under the mean are the noise floor, strong peaks raise the
+     * mean but not the floor */
+    for (k = k_min; k <= k_max; k++) {
+        if (power[k] <= mean) {
+            floor += power[k];
+            below++;
+        }
+    }
+    floor = GYRO_NOTCH_PEAK_SNR * floor / below;
+    /* sines of amplitudes A on roll and B on pitch peak at 2 (A^2 + B^2) (N / 4)^2
+     * through the Hann window, less up to 1.4 dB between bins */
+    threshold = 0.25f * config->min_amplitude * N;
+    threshold *= 1.4f * threshold;
+    if (threshold > floor) {
+        floor = threshold;
+    }
+
+    /* insertion into the strongest few, strongest first */
+    for (k = k_min; k <= k_max; k++) {
+        if (power[k] <= power[k - 1] || power[k] < power[k + 1] || power[k] < floor) {
+            continue;
+        }
+        for (p = found; p > 0 && power[best[p - 1]] < power[k]; p--) {
+            if (p < config->peaks) {
+                best[p] = best[p - 1];
+            }
+        }
+        if (p < config->peaks) {
+            best[p] = k;
+            if (found < config->peaks) {
+                found++;
+            }
+        }
+    }
+
+    for (p = 0; p < found; p++) {
+        k = best[p];
+        left = logf(power[k - 1] + FLT_MIN);
+        center = logf(power[k]);
+        right = logf(power[k + 1] + FLT_MIN);
+        hz = (k + 0.5f * (left - right) / (left - 2.0f * center + right)) * config->odr_hz / N;
+        for (j = p; j > 0 && notch->peak_hz[j - 1] > hz; j--) {
+            notch->peak_hz[j] = notch->peak_hz[j - 1];
+        }
+        notch->peak_hz[j] = hz;
+    }
+    notch->found = found;
+}
+
+/**
+ * @Function move_notches(gyro_notch_t *notch)
+ * @return TRUE if any notch moved
+ * @brief with a peak for every notch they pair in order of frequency,
+ * otherwise each peak takes the nearest notch, an unused notch counting as
+ * being at 0 Hz.  A new notch starts on its peak, an active one moves
+ * GYRO_NOTCH_SMOOTHING of the way so a one window outlier cannot throw it,
+ * and the filter state is kept so moving does not restart it.
+ * @author Aaron Hunter
+ */
+static uint8_t move_notches(gyro_notch_t *notch) {
+    const gyro_notch_config_t *config = &notch->config;
+    gyro_biquad_t swap;
+    float swap_hz;
+    float hz;
+    uint8_t target;
+    uint8_t p;
+    uint8_t q;
+
+    for (p = 0; p < notch->found; p++) {
+        hz = notch->peak_hz[p];
+        target = p;
+        if (notch->found < config->peaks) {
+            for (q = 0; q < config->peaks; q++) {
+                if (fabsf(notch->center_hz[q] - hz) < fabsf(notch->center_hz[target] - hz)) {
+                    target = q;
+                }
+            }
+        }
+        if (notch->center_hz[target] > 0) {
+            hz = notch->center_hz[target] + GYRO_NOTCH_SMOOTHING * (hz - notch->center_hz[target]);
+        }
+        notch->center_hz[target] = hz;
+        notch_design(&notch->notch[target], config->odr_hz, hz, config->q);
+    }
+    /* keep the active notches in ascending order for the next pairing */
+    for (p = 1; p < config->peaks; p++) {
+        for (q = p; q > 0 && notch->center_hz[q - 1] > notch->center_hz[q]; q--) {
+            swap = notch->notch[q];
+            notch->notch[q] = notch->notch[q - 1];
+            notch->notch[q - 1] = swap;
+            swap_hz = notch->center_hz[q];
+            notch->center_hz[q] = notch->center_hz[q - 1];
+            notch->center_hz[q - 1] = swap_hz;
+        }
+    }
+    return notch->found > 0 ? TRUE : FALSE;
+}
+
+/**
+ * @Function notch_design(gyro_biquad_t *biquad, float fs_hz, float center_hz, float q)
+ * @brief bilinear transform notch, unity gain away from center_hz, only the
+ * coefficients change
+ * @author Aaron Hunter
+ */
+static void notch_design(gyro_biquad_t *biquad, float fs_hz, float center_hz, float q) {
+    float w0 = 2.0f * (float) M_PI * center_hz / fs_hz;
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0_inv = 1.0f / (1.0f + alpha);
+    biquad->b0 = a0_inv;
+    biquad->b1 = -2.0f * cosf(w0) * a0_inv;
+    biquad->b2 = a0_inv;
+    biquad->a1 = biquad->b1;
+    biquad->a2 = (1.0f - alpha) * a0_inv;
+}
+
+/**
+ * @Function check_config(const gyro_notch_config_t *config)
+ * @return SUCCESS or ERROR for a band outside 0 to the Nyquist frequency, a
+ * notch width, amplitude, number of notches or step size out of range
+ * @author Aaron Hunter
+ */
+static int8_t check_config(const gyro_notch_config_t *config) {
+    if (config->odr_hz <= 0 || config->min_hz <= 0 || config->max_hz <= config->min_hz
+            || config->max_hz >= 0.5f * config->odr_hz || config->q <= 0 || config->min_amplitude < 0
+            || config->peaks < 1 || config->peaks > GYRO_NOTCH_MAX_PEAKS
+            || config->butterflies_per_step < 1 || config->butterflies_per_step > N / 2) {
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+#ifdef GYRO_NOTCH_TESTING
+#include <stdio.h>
+#include <stdlib.h>
+#include "SerialM32.h"
+
+#define TEST_ODR 562.5f
+
+static float test_noise = 0.5f; // uniform on every axis
+
+/* one sample of up to two tones, the roll and pitch axes see different
+ * amplitudes and phases of the same vibration */
+static void tone_sample(float v[MSZ], float hz_1, float amp_1, float hz_2, float amp_2) {
+    static float phase_1;
+    static float phase_2;
+    uint8_t i;
+    phase_1 += 2.0f * (float) M_PI * hz_1 / TEST_ODR;
+    phase_2 += 2.0f * (float) M_PI * hz_2 / TEST_ODR;
+    v[0] = amp_1 * sinf(phase_1) + amp_2 * sinf(phase_2 + 1.0f);
+    v[1] = 0.7f * amp_1 * sinf(phase_1 + 2.0f) + 0.5f * amp_2 * sinf(phase_2);
+    v[2] = 0.3f * amp_1 * sinf(phase_1 + 0.5f);
+    for (i = 0; i < MSZ; i++) {
+        v[i] += test_noise * (2.0f * rand() / RAND_MAX - 1.0f);
+    }
+}
+
+/* a sample and an analysis step at a time as in a control loop, until an
+ * analysis finishes */
+static uint8_t run_analysis(gyro_notch_t *notch, float hz_1, float amp_1, float hz_2, float amp_2,
+        uint16_t *calls) {
+    float v[MSZ];
+    uint8_t last;
+    uint8_t moved;
+    *calls = 0;
+    do {
+        tone_sample(v, hz_1, amp_1, hz_2, amp_2);
+        Gyro_notch_update(notch, v);
+        last = (notch->step == STEP_DESIGN);
+        moved = Gyro_notch_analyze(notch);
+        (*calls)++;
+    } while (!last);
+    return moved;
+}
+
+/* gain on axis 0 for a noise free unit tone, from the RMS after the
+ * transient, the notches held still */
+static float notch_gain(gyro_notch_t *notch, float hz) {
+    float v[MSZ];
+    double power = 0;
+    int samples = 0;
+    int n;
+    test_noise = 0;
+    for (n = 0; n < TEST_ODR; n++) {
+        tone_sample(v, hz, 1.0f, 0, 0);
+        Gyro_notch_update(notch, v);
+        if (n > TEST_ODR / 4) {
+            power += v[0] * v[0];
+            samples++;
+        }
+    }
+    test_noise = 0.5f;
+    return sqrt(2 * power / samples);
+}
+
+static uint8_t check(const char *name, float value, float low, float high) {
+    uint8_t pass = (value >= low && value <= high);
+    printf("%s: %g, expected %g to %g, %s\r\n", name, (double) value, (double) low, (double) high,
+            pass ? "pass" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int main(void) {
+    gyro_notch_config_t one = {TEST_ODR, 60, 250, 3, 1.0f, 1, N / 2};
+    gyro_notch_config_t two = {TEST_ODR, 60, 250, 3, 1.0f, 2, 16};
+    gyro_notch_config_t bad;
+    static gyro_notch_t notch;
+    float v[MSZ];
+    uint16_t calls;
+    uint8_t failures = 0;
+    int n;
+
+    Board_init();
+    Serial_init();
+    printf("Gyro_notch test harness %s, %s\r\n", __DATE__, __TIME__);
+    srand(1);
+
+    /* one tone between bins, found to a fraction of the 4.4 Hz bin */
+    Gyro_notch_init(&notch, &one);
+    for (n = 0; n < N; n++) {
+        tone_sample(v, 137.3f, 10.0f, 0, 0);
+        Gyro_notch_update(&notch, v);
+    }
+    failures += check("analysis moved the notch", run_analysis(&notch, 137.3f, 10.0f, 0, 0, &calls),
+            TRUE, TRUE);
+    failures += check("calls per analysis", calls, Gyro_notch_steps(&one), Gyro_notch_steps(&one));
+    failures += check("peak at 137.3 Hz", notch.peak_hz[0], 137.0f, 137.6f);
+    failures += check("notch at the peak", notch.center_hz[0], 137.0f, 137.6f);
+
+    /* the tone is gone and 40 Hz passes */
+    failures += check("gain at the peak", notch_gain(&notch, 137.3f), 0, 0.03f);
+    failures += check("gain at 40 Hz", notch_gain(&notch, 40.0f), 0.98f, 1.01f);
+
+    /* a sweeping peak is followed, a window and the smoothing behind */
+    for (n = 0; n < 2 * TEST_ODR; n++) {
+        tone_sample(v, 137.3f - 20.0f * n / (2 * TEST_ODR), 10.0f, 0, 0);
+        Gyro_notch_update(&notch, v);
+        Gyro_notch_analyze(&notch);
+    }
+    for (n = 0; n < 20; n++) {
+        run_analysis(&notch, 117.3f, 10.0f, 0, 0, &calls);
+    }
+    failures += check("notch followed to 117.3 Hz", notch.center_hz[0], 116.3f, 118.3f);
+
+    /* two motor pairs at different speeds, two notches, smaller steps */
+    Gyro_notch_init(&notch, &two);
+    for (n = 0; n < N; n++) {
+        tone_sample(v, 110.0f, 6.0f, 180.0f, 4.0f);
+        Gyro_notch_update(&notch, v);
+    }
+    run_analysis(&notch, 110.0f, 6.0f, 180.0f, 4.0f, &calls);
+    failures += check("calls per analysis, 16 butterflies each", calls, 31, 31);
+    failures += check("peaks found", notch.found, 2, 2);
+    failures += check("lower notch", notch.center_hz[0], 109.5f, 110.5f);
+    failures += check("upper notch", notch.center_hz[1], 179.5f, 180.5f);
+
+    /* noise alone moves nothing */
+    Gyro_notch_init(&notch, &two);
+    for (n = 0; n < N; n++) {
+        tone_sample(v, 0, 0, 0, 0);
+        Gyro_notch_update(&notch, v);
+    }
+    failures += check("noise only, peaks found", run_analysis(&notch, 0, 0, 0, 0, &calls), FALSE, FALSE);
+    for (n = 0; n < N; n++) {
+        tone_sample(v, 150.0f, 0.6f, 0, 0);
+        Gyro_notch_update(&notch, v);
+    }
+    failures += check("tone under min_amplitude", run_analysis(&notch, 150.0f, 0.6f, 0, 0, &calls),
+            FALSE, FALSE);
+
+    /* configurations that do not fit */
+    bad = one;
+    bad.max_hz = TEST_ODR / 2;
+    failures += check("band up to Nyquist", Gyro_notch_init(&notch, &bad), ERROR, ERROR);
+    bad = one;
+    bad.peaks = GYRO_NOTCH_MAX_PEAKS + 1;
+    failures += check("too many notches", Gyro_notch_init(&notch, &bad), ERROR, ERROR);
+    bad = one;
+    bad.butterflies_per_step = N / 2 + 1;
+    failures += check("step over a stage", Gyro_notch_init(&notch, &bad), ERROR, ERROR);
+
+    printf("%s\r\n", failures == 0 ? "Gyro_notch tests passed" : "Gyro_notch tests FAILED");
+    return 0;
+}
+#endif //GYRO_NOTCH_TESTING
+
+#ifdef GYRO_NOTCH_BENCHMARK
+/*
+ * Time per gyro sample with two notches active and per whole analysis, every
+ * step of it back to back, for the quad's 562.5 Hz FIFO.  CSV as in
+ * Benchmark.h, "#" lines are comments.  On the host:
+ *     gcc -O2 -DHAL_SIM -DGYRO_NOTCH_BENCHMARK -Ilib/HAL.X/linux -Ilib/HAL.X
+ *         -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X -Ilib/Lin_alg.X
+ *         -Ilib/Benchmark.X -Ilib/Gyro_filter.X lib/Gyro_filter.X/Gyro_notch.c
+ *         lib/Gyro_filter.X/Gyro_filter.c lib/Benchmark.X/Benchmark.c
+ *         lib/HAL.X/HAL_linux.c lib/Board.X/Board.c lib/Serial.X/SerialM32.c
+ *         lib/System_timer.X/System_timer.c -lm
+ * An analysis divided by its steps is the mean cost of a Gyro_notch_analyze()
+ * call; the largest single step is in the quad's notch stage profile.
+ */
+#include <stdio.h>
+#include "Benchmark.h"
+#include "SerialM32.h"
+
+#define BENCH_SUITE "gyro_notch"
+
+typedef struct {
+    float v[MSZ];
+    gyro_notch_t notch;
+    gyro_notch_t notch_16;
+} bench_operands_t;
+
+static void bench_update(void *ctx) {
+    bench_operands_t *o = ctx;
+    Gyro_notch_update(&o->notch, o->v);
+}
+
+static void bench_analysis(void *ctx) {
+    bench_operands_t *o = ctx;
+    do {
+        Gyro_notch_analyze(&o->notch);
+    } while (o->notch.step != STEP_CAPTURE);
+}
+
+static void bench_analysis_16(void *ctx) {
+    bench_operands_t *o = ctx;
+    do {
+        Gyro_notch_analyze(&o->notch_16);
+    } while (o->notch_16.step != STEP_CAPTURE);
+}
+
+static const benchmark_t kernels[] = {
+    {"update_2_notches", bench_update},
+    {"analysis_64_per_step", bench_analysis},
+    {"analysis_16_per_step", bench_analysis_16},
+};
+
+int main(void) {
+    static bench_operands_t operands;
+    gyro_notch_config_t quad = {562.5, 60, 250, 3, 0.5f, 2, N / 2};
+    gyro_notch_config_t quad_16 = {562.5, 60, 250, 3, 0.5f, 2, 16};
+    float hz[GYRO_NOTCH_MAX_PEAKS] = {110, 180};
+    uint16_t n;
+    uint8_t i;
+    uint8_t p;
+
+    Board_init();
+    Serial_init();
+    printf("# Gyro_notch benchmark %s, %s\r\n", __DATE__, __TIME__);
+    Gyro_notch_init(&operands.notch, &quad);
+    Gyro_notch_init(&operands.notch_16, &quad_16);
+    /* two tones, so the analyses find, interpolate and design two notches */
+    for (n = 0; n < N; n++) {
+        for (i = 0; i < MSZ; i++) {
+            operands.v[i] = 0;
+            for (p = 0; p < GYRO_NOTCH_MAX_PEAKS; p++) {
+                operands.v[i] += sinf(2.0f * (float) M_PI * hz[p] * n / quad.odr_hz + i);
+            }
+        }
+        Gyro_notch_update(&operands.notch, operands.v);
+        Gyro_notch_update(&operands.notch_16, operands.v);
+    }
+    printf("# %u and %u steps per analysis\r\n", Gyro_notch_steps(&quad), Gyro_notch_steps(&quad_16));
+
+    Benchmark_header();
+    Benchmark_run_table(BENCH_SUITE, kernels, sizeof (kernels) / sizeof (kernels[0]), &operands);
+    printf("# done\r\n");
+    return 0;
+}
+#endif //GYRO_NOTCH_BENCHMARK
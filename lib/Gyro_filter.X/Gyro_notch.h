@@ -0,0 +1,123 @@
+/*
+ * File:   Gyro_notch.h
+ * Author: Aaron Hunter
+ * Brief: Dynamic notch filters that follow the motor vibration peaks in the
+ * gyro data.  Every sample goes into a ring before the notches; an FFT of the
+ * ring finds the strongest peaks between min_hz and max_hz and moves a notch
+ * biquad onto each.
+ *
+ * The analysis never runs in one piece.  Each Gyro_notch_analyze() call does
+ * one bounded step and returns, so the caller spreads an analysis over as many
+ * control loop iterations as it takes:
+ *     capture   Hann window the ring into the FFT buffer in bit reversed
+ *               order, 2 N multiplies
+ *     FFT       log2(N) radix-2 stages of N / 2 butterflies, at most
+ *               butterflies_per_step of them per call, 4 multiplies and 6 adds
+ *               each
+ *     spectrum  power and peak search of the bins in the band
+ *     design    interpolate the peaks, smooth the centers and recompute the
+ *               notch coefficients, a sinf() and cosf() per notch
+ * With N = 128 at 562.5 Hz the window is 228 msec and a bin 4.4 Hz.
+ *
+ * Roll and pitch are packed as the real and imaginary parts of one complex
+ * FFT, the power of both at bin k is |Z[k]|^2 + |Z[N - k]|^2 with no split
+ * step.  Motor vibration shows on all axes at the same frequencies, so the
+ * notches found on roll and pitch filter yaw too.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef GYRO_NOTCH_H // Header guard
+#define	GYRO_NOTCH_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "Gyro_filter.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define GYRO_NOTCH_FFT_LOG2 7
+#define GYRO_NOTCH_FFT_SIZE (1 << GYRO_NOTCH_FFT_LOG2) // N, samples per analysis window
+#define GYRO_NOTCH_MAX_PEAKS 2
+#define GYRO_NOTCH_PEAK_SNR 16.0f // peak power over the noise floor, white noise alone reaches 13
+#define GYRO_NOTCH_SMOOTHING 0.5f // fraction of the way a center moves to a new peak
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    float odr_hz; // gyro sample rate
+    float min_hz; // band searched for peaks
+    float max_hz; // below odr_hz / 2
+    float q; // notch center over -3 dB bandwidth
+    float min_amplitude; // smallest peak worth a notch, sqrt(roll^2 + pitch^2) amplitude
+    uint8_t peaks; // notches, 1 to GYRO_NOTCH_MAX_PEAKS
+    uint8_t butterflies_per_step; // FFT work per call, 1 to N / 2
+} gyro_notch_config_t;
+
+typedef struct {
+    gyro_notch_config_t config;
+    float ring[GYRO_NOTCH_FFT_SIZE][2]; // roll and pitch before the notches
+    float re[GYRO_NOTCH_FFT_SIZE]; // FFT buffer, then the power spectrum
+    float im[GYRO_NOTCH_FFT_SIZE];
+    gyro_biquad_t notch[GYRO_NOTCH_MAX_PEAKS];
+    float center_hz[GYRO_NOTCH_MAX_PEAKS]; // notch frequencies, 0 until a peak is found
+    float peak_hz[GYRO_NOTCH_MAX_PEAKS]; // peaks of the last analysis, ascending
+    uint8_t found; // number of peak_hz
+    uint16_t head; // next ring slot
+    uint16_t fill; // samples in the ring
+    uint8_t step; // analysis state
+    uint16_t butterfly; // next butterfly of the current FFT stage
+} gyro_notch_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_notch_init(gyro_notch_t *notch, const gyro_notch_config_t *config)
+ * @param notch, cleared with no notch active
+ * @param config, the band, notch width and analysis step size
+ * @return SUCCESS or ERROR for a configuration out of range, which leaves
+ * notch as it was
+ * @note builds the window and twiddle tables with the float library, call it
+ * at start up
+ * @author Aaron Hunter
+ */
+int8_t Gyro_notch_init(gyro_notch_t *notch, const gyro_notch_config_t *config);
+
+/**
+ * @Function Gyro_notch_update(gyro_notch_t *notch, float v[MSZ])
+ * @param notch, the filter
+ * @param v, the newest gyro sample, roll, pitch and yaw rates, replaced by the
+ * notched sample
+ * @brief call at odr_hz, costs a ring store and one biquad per active notch
+ * @author Aaron Hunter
+ */
+void Gyro_notch_update(gyro_notch_t *notch, float v[MSZ]);
+
+/**
+ * @Function Gyro_notch_analyze(gyro_notch_t *notch)
+ * @param notch, the filter
+ * @return TRUE when this step finished an analysis and moved the notches,
+ * FALSE otherwise
+ * @brief runs the next analysis step, see the cost of each above, nothing
+ * until the ring has filled
+ * @author Aaron Hunter
+ */
+uint8_t Gyro_notch_analyze(gyro_notch_t *notch);
+
+/**
+ * @Function Gyro_notch_steps(const gyro_notch_config_t *config)
+ * @param config, the analysis step size
+ * @return Gyro_notch_analyze() calls per analysis
+ * @author Aaron Hunter
+ */
+uint16_t Gyro_notch_steps(const gyro_notch_config_t *config);
+
+#endif	/* GYRO_NOTCH_H */ // End of header guard
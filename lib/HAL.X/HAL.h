@@ -0,0 +1,79 @@
+/*
+ * File:   HAL.h
+ * Author: Aaron Hunter
+ * Brief: Thin hardware abstraction layer.  The lib/ drivers keep talking to
+ * the PIC32 special function registers directly; what differs per target is
+ * provided here: a cycle counter for profiling and interrupt-safe critical
+ * sections.  Two backends implement this header:
+ *   HAL_pic32.c - the PIC32MX795F512L (XC32), core timer and CP0 status
+ *   HAL_linux.c - a Linux host process.  Together with the headers in
+ *                 linux/ it simulates the SFRs, peripherals and interrupt
+ *                 dispatch so the driver state machines run unmodified.
+ *                 See HAL_sim.h for the simulator API.
+ * Host build, from the repository root, e.g. the HAL self test:
+ *   gcc -O2 -DHAL_SIM -DHAL_TESTING -Ilib/HAL.X/linux -Ilib/HAL.X \
+ *       -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X ... \
+ *       lib/HAL.X/HAL_linux.c lib/Board.X/Board.c lib/Serial.X/SerialM32.c ...
+ * The linux/ directory must come first on the include path so that <xc.h>,
+ * <sys/attribs.h> and <proc/p32mx795f512l.h> resolve to the simulated ones.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef HAL_H // Header guard
+#define	HAL_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#ifdef HAL_SIM
+#define HAL_CYCLE_UNITS "ns" // host counter is CLOCK_MONOTONIC nanoseconds
+#define HAL_CYCLES_PER_USEC 1000
+#else
+#define HAL_CYCLE_UNITS "cycles" // CPU cycles at SYSCLK
+#define HAL_CYCLES_PER_USEC 80 // must agree with Board_get_sys_clock()
+#endif
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef uint32_t HAL_cycles_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_get_cycles(void)
+ * @return free running counter in HAL_CYCLE_UNITS
+ * @brief profiling time base.  On the PIC32 this is the CP0 core timer scaled
+ * to CPU cycles, on the host it is wall clock nanoseconds.  The counter wraps,
+ * always take differences with unsigned arithmetic.
+ * @author Aaron Hunter
+ */
+HAL_cycles_t HAL_get_cycles(void);
+
+/**
+ * @Function HAL_critical_enter(void)
+ * @return previous interrupt state, pass to HAL_critical_exit()
+ * @brief disables interrupts at the CPU, nests safely
+ * @author Aaron Hunter
+ */
+uint32_t HAL_critical_enter(void);
+
+/**
+ * @Function HAL_critical_exit(uint32_t state)
+ * @param state, value returned by the matching HAL_critical_enter()
+ * @return none
+ * @brief re-enables interrupts only if they were enabled on entry
+ * @author Aaron Hunter
+ */
+void HAL_critical_exit(uint32_t state);
+
+#endif	/* HAL_H */ // End of header guard
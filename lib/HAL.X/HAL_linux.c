@@ -0,0 +1,1478 @@
+/*
+ * File:   HAL_linux.c
+ * Author: Aaron Hunter
+ * Brief: Linux host backend of the hardware abstraction layer.  Owns the
+ * simulated SFR storage declared in linux/proc/p32mx795f512l.h, models the
+ * SPI, UART, timer, output compare and DMA peripherals and dispatches the
+ * driver ISRs.  See HAL_sim.h for the execution model.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#define HAL_SFR_DEFINE // allocate the register storage in this file
+#include "HAL.h" // The header file for this source file.
+#include "HAL_sim.h"
+#include "Board.h"
+#include <xc.h>
+#include <sys/attribs.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define SLOT_IDLE (1ull << 32) // set while a data register slot holds no write
+#define MAX_SPI_DEVICES 8
+#define NUM_SPI 3
+#define NUM_UART 7
+#define NUM_PORTS 7
+#define NUM_DMA 8
+#define MAX_PA_HANDLES 32 // distinct addresses passed through KVA_TO_PA()
+#define DMA_IFS 1 // DMAxIF is IFS1<16 + x>
+#define NUM_EXT_INT 5
+#define EXT_INT_FLAG_BIT(n) (3 + 4 * (n)) // INTxIF is IFS0<3 + 4 x>
+#define DMA_FLAG_BIT 16
+#define UART_FIFO_SIZE 8 // PIC32MX hardware FIFO depth
+#define UART_LINE_SIZE 4096 // bytes waiting on the wire
+#define MAX_DISPATCH 100000 // ISRs per service call before declaring a storm
+#define NSEC_PER_SEC 1000000000ull
+#define CORE_TIMER_NSEC 25 // SYSCLK/2 = 40 MHz
+#define NO_FLAG 0xFF
+
+#define LAT_CLR 0
+#define LAT_SET 1
+#define LAT_INV 2
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef void (*isr_t)(void);
+
+typedef struct {
+    uint8_t vector;
+    const char *name;
+    uint8_t ifs; // which IFSx/IECx pair
+    uint32_t mask; // source bits sharing the vector
+    isr_t isr;
+} vector_entry_t;
+
+typedef struct {
+    uint8_t ifs; // IFSx/IECx holding the error flag, NO_FLAG if unsimulated
+    uint8_t ebit; // error flag bit, RX is ebit + 1 and TX ebit + 2
+} flag_map_t;
+
+struct uart_sim {
+    uint8_t tx_fifo[UART_FIFO_SIZE];
+    int tx_count;
+    int8_t shifting; // a byte is in the transmit shift register
+    uint8_t shift_byte;
+    uint64_t shift_done; // virtual time the shift register empties
+    uint8_t rx_fifo[UART_FIFO_SIZE];
+    int rx_head;
+    int rx_count;
+    uint32_t rx_latch; // last value read from UxRXREG
+    uint8_t line[UART_LINE_SIZE]; // bytes in flight towards the RX pin
+    int line_head;
+    int line_count;
+    uint64_t line_next; // virtual time the next line byte completes
+    int8_t oerr_seen;
+    HAL_sim_uart_sink_t sink;
+    void *ctx;
+    uint64_t tx_bytes;
+    uint64_t rx_bytes;
+    uint32_t overruns;
+};
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void sim_sync(void);
+static void sim_service(void);
+static void sim_step(uint64_t nsec);
+static void spi_transfer(uint8_t module, uint32_t mosi);
+static void uart_flush_tx(uint8_t module);
+static void uart_tick(uint8_t module);
+static void uart_update_flags(uint8_t module);
+static void timers_tick(uint64_t pb_cycles);
+static void set_flag(uint8_t ifs, uint8_t bit);
+static void dma_sync(void);
+static void dma_event(uint8_t irq);
+static void dma_cell(uint8_t ch);
+static void dma_reset_channel(uint8_t ch);
+static uint32_t dma_size(uint32_t size);
+static uint8_t dma_read(uint32_t pa, uint32_t offset);
+static void dma_write(uint32_t pa, uint32_t offset, uint8_t byte);
+static uint64_t uart_byte_nsec(uint8_t module);
+static uint64_t host_nsec(void);
+static void stdout_sink(void *ctx, uint8_t byte);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* The ISRs live in sections named hal_isr_<vector> (see linux/sys/attribs.h),
+ * the linker resolves the section start to the handler or leaves it NULL */
+#define ISR_SECTION(n) extern void __start_hal_isr_##n(void) __attribute__((weak));
+ISR_SECTION(3) ISR_SECTION(4) ISR_SECTION(7) ISR_SECTION(8) ISR_SECTION(11)
+ISR_SECTION(12) ISR_SECTION(15) ISR_SECTION(16) ISR_SECTION(19) ISR_SECTION(20)
+ISR_SECTION(23) ISR_SECTION(24) ISR_SECTION(25) ISR_SECTION(26) ISR_SECTION(27)
+ISR_SECTION(31) ISR_SECTION(32) ISR_SECTION(33) ISR_SECTION(36) ISR_SECTION(37)
+ISR_SECTION(38) ISR_SECTION(39) ISR_SECTION(40) ISR_SECTION(41) ISR_SECTION(42)
+ISR_SECTION(43) ISR_SECTION(49) ISR_SECTION(50) ISR_SECTION(51)
+
+static const vector_entry_t vectors[] = {
+    {3, "INT0", 0, 1u << 3, __start_hal_isr_3},
+    {4, "TIMER1", 0, 1u << 4, __start_hal_isr_4},
+    {7, "INT1", 0, 1u << 7, __start_hal_isr_7},
+    {8, "TIMER2", 0, 1u << 8, __start_hal_isr_8},
+    {11, "INT2", 0, 1u << 11, __start_hal_isr_11},
+    {12, "TIMER3", 0, 1u << 12, __start_hal_isr_12},
+    {15, "INT3", 0, 1u << 15, __start_hal_isr_15},
+    {16, "TIMER4", 0, 1u << 16, __start_hal_isr_16},
+    {19, "INT4", 0, 1u << 19, __start_hal_isr_19},
+    {20, "TIMER5", 0, 1u << 20, __start_hal_isr_20},
+    {23, "SPI1", 0, 7u << 23, __start_hal_isr_23},
+    {24, "UART1", 0, 7u << 26, __start_hal_isr_24},
+    {25, "I2C1", 0, 7u << 29, __start_hal_isr_25},
+    {26, "CN", 1, 1u << 0, __start_hal_isr_26},
+    {27, "ADC", 1, 1u << 1, __start_hal_isr_27},
+    {31, "SPI2", 1, 7u << 5, __start_hal_isr_31},
+    {32, "UART2", 1, 7u << 8, __start_hal_isr_32},
+    {33, "I2C2", 1, 7u << 11, __start_hal_isr_33},
+    {36, "DMA0", 1, 1u << 16, __start_hal_isr_36},
+    {37, "DMA1", 1, 1u << 17, __start_hal_isr_37},
+    {38, "DMA2", 1, 1u << 18, __start_hal_isr_38},
+    {39, "DMA3", 1, 1u << 19, __start_hal_isr_39},
+    {40, "DMA4", 1, 1u << 20, __start_hal_isr_40},
+    {41, "DMA5", 1, 1u << 21, __start_hal_isr_41},
+    {42, "DMA6", 1, 1u << 22, __start_hal_isr_42},
+    {43, "DMA7", 1, 1u << 23, __start_hal_isr_43},
+    {49, "UART4", 2, 7u << 8, __start_hal_isr_49},
+    {50, "UART6", 2, 7u << 11, __start_hal_isr_50},
+    {51, "UART5", 2, 7u << 14, __start_hal_isr_51},
+};
+#define NUM_VECTORS (sizeof(vectors) / sizeof(vectors[0]))
+
+static volatile uint32_t * const ifs_reg[3] = {&HAL_IFS0.w, &HAL_IFS1.w, &HAL_IFS2.w};
+static volatile uint32_t * const iec_reg[3] = {&HAL_IEC0.w, &HAL_IEC1.w, &HAL_IEC2.w};
+
+/* flag locations of the simulated modules, UART3 shares SPI2's flags */
+static const flag_map_t spi_flags[NUM_SPI] = {
+    {NO_FLAG, 0}, {0, 23}, {1, 5}
+};
+static const flag_map_t uart_flags[NUM_UART] = {
+    {NO_FLAG, 0}, {0, 26}, {1, 8}, {NO_FLAG, 0}, {2, 8}, {2, 14}, {2, 11}
+};
+static const uint8_t spi_vector[NUM_SPI] = {0, _SPI_1_VECTOR, _SPI_2_VECTOR};
+static const uint8_t uart_vector[NUM_UART] = {
+    0, _UART_1_VECTOR, _UART_2_VECTOR, 0, _UART_4_VECTOR, _UART_5_VECTOR, _UART_6_VECTOR
+};
+static const uint16_t timer_prescale[8] = {1, 2, 4, 8, 16, 32, 64, 256};
+
+static uint64_t sim_time; // virtual nsec
+static uint64_t pb_last; // PBCLK cycles accounted to the timers
+static uint32_t timer_rem[6]; // prescaler remainders
+static uint32_t quantum = HAL_SIM_DEFAULT_QUANTUM;
+static uint32_t core_timer_offset;
+static int8_t irq_enabled;
+static int8_t in_isr;
+static int8_t in_sync;
+static int8_t storm_reported;
+
+static volatile uint64_t spi_slot[NUM_SPI];
+static uint32_t spi_rx[NUM_SPI];
+static uint64_t spi_bytes[NUM_SPI];
+static const HAL_sim_spi_device_t *spi_devs[MAX_SPI_DEVICES];
+static int num_spi_devs;
+
+static uint32_t dma_count[NUM_DMA]; // bytes moved in the current block
+static uint64_t dma_bytes[NUM_DMA];
+static const volatile void *pa_table[MAX_PA_HANDLES]; // handle - 1 to host address
+static int num_pa;
+
+static volatile uint64_t uart_slot[NUM_UART];
+static struct uart_sim uart[NUM_UART];
+
+static uint32_t lat_seen[NUM_PORTS]; // latch values last reported to devices
+static volatile uint32_t lat_op_slot;
+static int8_t lat_op_port = -1;
+static uint8_t lat_op;
+
+static HAL_sim_isr_stats_t isr_stats[HAL_SIM_NUM_VECTORS];
+
+static HAL_sim_tick_hook_t tick_hook;
+static void *tick_ctx;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_get_cycles(void)
+ * @return host CLOCK_MONOTONIC in nanoseconds, truncated to 32 bits
+ * @author Aaron Hunter
+ */
+HAL_cycles_t HAL_get_cycles(void) {
+    return ((HAL_cycles_t) host_nsec());
+}
+
+/**
+ * @Function HAL_critical_enter(void)
+ * @return previous simulated interrupt enable state
+ * @author Aaron Hunter
+ */
+uint32_t HAL_critical_enter(void) {
+    return (HAL_sim_disable_interrupts());
+}
+
+/**
+ * @Function HAL_critical_exit(uint32_t state)
+ * @param state, value returned by HAL_critical_enter()
+ * @author Aaron Hunter
+ */
+void HAL_critical_exit(uint32_t state) {
+    if (state & 0x1) {
+        HAL_sim_enable_interrupts();
+    }
+}
+
+/**
+ * @Function HAL_sim_reset(void)
+ * @author Aaron Hunter
+ */
+void HAL_sim_reset(void) {
+    uint8_t i;
+    memset((void *) HAL_SPI, 0, sizeof (HAL_SPI));
+    memset((void *) HAL_UART, 0, sizeof (HAL_UART));
+    memset((void *) HAL_TMR, 0, sizeof (HAL_TMR));
+    memset((void *) HAL_OC, 0, sizeof (HAL_OC));
+    memset((void *) HAL_I2C, 0, sizeof (HAL_I2C));
+    memset((void *) HAL_PORT, 0, sizeof (HAL_PORT));
+    memset((void *) HAL_IPC, 0, sizeof (HAL_IPC));
+    memset((void *) HAL_DCH, 0, sizeof (HAL_DCH));
+    HAL_DMACON.w = 0;
+    memset(dma_count, 0, sizeof (dma_count));
+    num_pa = 0;
+    HAL_IFS0.w = HAL_IFS1.w = HAL_IFS2.w = 0;
+    HAL_IEC0.w = HAL_IEC1.w = HAL_IEC2.w = 0;
+    HAL_INTCON.w = HAL_CHECON.w = HAL_BMXCON.w = HAL_DDPCON.w = 0;
+    for (i = 0; i < NUM_PORTS; i++) {
+        HAL_PORT[i].TRIS = 0xFFFF; // pins come out of reset as inputs
+        lat_seen[i] = 0;
+    }
+    for (i = 0; i < 6; i++) {
+        HAL_TMR[i].PR = 0xFFFF;
+        timer_rem[i] = 0;
+    }
+    for (i = 0; i < NUM_SPI; i++) {
+        HAL_SPI[i].STAT.SPITBE = 1;
+        spi_slot[i] = SLOT_IDLE;
+        spi_rx[i] = 0;
+    }
+    memset(uart, 0, sizeof (uart));
+    for (i = 0; i < NUM_UART; i++) {
+        HAL_UART[i].STA.TRMT = 1;
+        uart_slot[i] = SLOT_IDLE;
+    }
+    uart[1].sink = stdout_sink;
+    num_spi_devs = 0;
+    tick_hook = NULL;
+    tick_ctx = NULL;
+    lat_op_port = -1;
+    sim_time = 0;
+    pb_last = 0;
+    core_timer_offset = 0;
+    quantum = HAL_SIM_DEFAULT_QUANTUM;
+    irq_enabled = FALSE; // the CPU comes out of reset with interrupts off
+    in_isr = FALSE;
+    in_sync = FALSE;
+    HAL_sim_clear_stats();
+}
+
+/**
+ * @Function HAL_sim_poll(void)
+ * @author Aaron Hunter
+ */
+void HAL_sim_poll(void) {
+    sim_step(quantum);
+}
+
+/**
+ * @Function HAL_sim_advance_nsec(uint64_t nsec)
+ * @author Aaron Hunter
+ */
+void HAL_sim_advance_nsec(uint64_t nsec) {
+    while (nsec > quantum) {
+        sim_step(quantum);
+        nsec -= quantum;
+    }
+    sim_step(nsec);
+}
+
+/**
+ * @Function HAL_sim_set_quantum_nsec(uint32_t nsec)
+ * @author Aaron Hunter
+ */
+void HAL_sim_set_quantum_nsec(uint32_t nsec) {
+    quantum = nsec > 0 ? nsec : 1;
+}
+
+/**
+ * @Function HAL_sim_get_time_nsec(void)
+ * @author Aaron Hunter
+ */
+uint64_t HAL_sim_get_time_nsec(void) {
+    return sim_time;
+}
+
+/**
+ * @Function HAL_sim_set_tick_hook(HAL_sim_tick_hook_t hook, void *ctx)
+ * @author Aaron Hunter
+ */
+void HAL_sim_set_tick_hook(HAL_sim_tick_hook_t hook, void *ctx) {
+    tick_hook = hook;
+    tick_ctx = ctx;
+}
+
+/**
+ * @Function HAL_sim_spi_attach(const HAL_sim_spi_device_t *dev)
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_spi_attach(const HAL_sim_spi_device_t *dev) {
+    if (num_spi_devs >= MAX_SPI_DEVICES || dev->module >= NUM_SPI) {
+        return ERROR;
+    }
+    spi_devs[num_spi_devs++] = dev;
+    return SUCCESS;
+}
+
+/**
+ * @Function HAL_sim_uart_attach(uint8_t module, HAL_sim_uart_sink_t sink, void *ctx)
+ * @author Aaron Hunter
+ */
+void HAL_sim_uart_attach(uint8_t module, HAL_sim_uart_sink_t sink, void *ctx) {
+    if (module < NUM_UART) {
+        uart[module].sink = sink;
+        uart[module].ctx = ctx;
+    }
+}
+
+/**
+ * @Function HAL_sim_uart_feed(uint8_t module, const uint8_t *data, int len)
+ * @author Aaron Hunter
+ */
+int HAL_sim_uart_feed(uint8_t module, const uint8_t *data, int len) {
+    struct uart_sim *u;
+    int i;
+    if (module >= NUM_UART || uart_flags[module].ifs == NO_FLAG) {
+        return 0;
+    }
+    u = &uart[module];
+    if (u->line_count == 0) {
+        u->line_next = sim_time + uart_byte_nsec(module);
+    }
+    for (i = 0; i < len && u->line_count < UART_LINE_SIZE; i++) {
+        u->line[(u->line_head + u->line_count) % UART_LINE_SIZE] = data[i];
+        u->line_count++;
+    }
+    return i;
+}
+
+/**
+ * @Function HAL_sim_uart_rx_pending(uint8_t module)
+ * @author Aaron Hunter
+ */
+int HAL_sim_uart_rx_pending(uint8_t module) {
+    return (module < NUM_UART ? uart[module].line_count : 0);
+}
+
+/**
+ * @Function HAL_sim_pin_get(char port, uint8_t pin)
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_pin_get(char port, uint8_t pin) {
+    return ((HAL_PORT[port - 'A'].LAT >> pin) & 0x1);
+}
+
+/**
+ * @Function HAL_sim_pin_set(char port, uint8_t pin, int8_t level)
+ * @author Aaron Hunter
+ */
+void HAL_sim_pin_set(char port, uint8_t pin, int8_t level) {
+    /* INT0 on RD0, INT1 on RE8, INT2 on RE9, INT3 on RA14 and INT4 on RA15 */
+    static const char ext_int_port[NUM_EXT_INT] = {'D', 'E', 'E', 'A', 'A'};
+    static const uint8_t ext_int_pin[NUM_EXT_INT] = {0, 8, 9, 14, 15};
+    volatile HAL_port_regs_t *p = &HAL_PORT[port - 'A'];
+    int8_t was = (p->PORT >> pin) & 0x1;
+    uint8_t n;
+    level = (level != 0);
+    if (level) {
+        p->PORT |= (1u << pin);
+    } else {
+        p->PORT &= ~(1u << pin);
+    }
+    for (n = 0; n < NUM_EXT_INT; n++) {
+        if (ext_int_port[n] == port && ext_int_pin[n] == pin && level != was
+                && level == (int8_t) ((HAL_INTCON.w >> n) & 0x1)) { // INTxEP set is rising
+            set_flag(0, EXT_INT_FLAG_BIT(n));
+        }
+    }
+}
+
+/**
+ * @Function HAL_sim_oc_pulse_nsec(uint8_t module)
+ * @author Aaron Hunter
+ */
+uint32_t HAL_sim_oc_pulse_nsec(uint8_t module) {
+    volatile HAL_oc_regs_t *oc = &HAL_OC[module];
+    uint16_t prescale;
+    if (oc->CON.ON == 0 || oc->CON.OCM < 0b110) {
+        return 0;
+    }
+    prescale = timer_prescale[HAL_TMR[oc->CON.OCTSEL ? 3 : 2].CON.TCKPS];
+    return ((uint32_t) (((uint64_t) oc->RS * prescale * NSEC_PER_SEC) / HAL_SIM_PB_CLOCK));
+}
+
+/**
+ * @Function HAL_sim_get_isr_stats(uint8_t vector, HAL_sim_isr_stats_t *stats)
+ * @author Aaron Hunter
+ */
+void HAL_sim_get_isr_stats(uint8_t vector, HAL_sim_isr_stats_t *stats) {
+    uint8_t i;
+    *stats = isr_stats[vector];
+    for (i = 0; i < NUM_SPI; i++) {
+        if (spi_vector[i] == vector && i > 0) {
+            stats->bytes = spi_bytes[i];
+        }
+    }
+    for (i = 0; i < NUM_UART; i++) {
+        if (uart_vector[i] == vector && i > 0) {
+            stats->bytes = uart[i].rx_bytes + uart[i].tx_bytes;
+        }
+    }
+    if (vector >= _DMA_0_VECTOR && vector < _DMA_0_VECTOR + NUM_DMA) {
+        stats->bytes = dma_bytes[vector - _DMA_0_VECTOR];
+    }
+}
+
+/**
+ * @Function HAL_sim_clear_stats(void)
+ * @author Aaron Hunter
+ */
+void HAL_sim_clear_stats(void) {
+    uint8_t i;
+    memset(isr_stats, 0, sizeof (isr_stats));
+    memset(spi_bytes, 0, sizeof (spi_bytes));
+    memset(dma_bytes, 0, sizeof (dma_bytes));
+    for (i = 0; i < NUM_UART; i++) {
+        uart[i].rx_bytes = uart[i].tx_bytes = 0;
+        uart[i].overruns = 0;
+    }
+}
+
+/**
+ * @Function HAL_sim_print_stats(FILE *out)
+ * @author Aaron Hunter
+ */
+void HAL_sim_print_stats(FILE *out) {
+    HAL_sim_isr_stats_t s;
+    uint8_t i;
+    double mean;
+    double per_byte;
+    fprintf(out, "vector,name,calls,total_ns,mean_ns,max_ns,bytes,ns_per_byte,max_bytes_per_sec\n");
+    for (i = 0; i < NUM_VECTORS; i++) {
+        HAL_sim_get_isr_stats(vectors[i].vector, &s);
+        if (s.calls == 0) {
+            continue;
+        }
+        mean = (double) s.total_nsec / s.calls;
+        per_byte = s.bytes ? (double) s.total_nsec / s.bytes : 0.0;
+        fprintf(out, "%u,%s,%u,%llu,%.1f,%u,%llu,%.1f,%.0f\n", vectors[i].vector,
+                vectors[i].name, s.calls, (unsigned long long) s.total_nsec, mean,
+                s.max_nsec, (unsigned long long) s.bytes, per_byte,
+                per_byte > 0.0 ? 1e9 / per_byte : 0.0);
+    }
+}
+
+/*******************************************************************************
+ * REGISTER ACCESS HOOKS                                                       *
+ ******************************************************************************/
+/* Data registers hand out a 64 bit slot preloaded with SLOT_IDLE.  A read
+ * sees the receive value, a write overwrites the whole slot and clears
+ * SLOT_IDLE, which the next sim_sync() picks up as a transmit. */
+
+volatile uint64_t *HAL_sim_spi_buf(uint8_t module) {
+    sim_sync();
+    HAL_SPI[module].STAT.SPIRBF = 0; // a read empties the receive buffer
+    spi_slot[module] = SLOT_IDLE | spi_rx[module];
+    return &spi_slot[module];
+}
+
+volatile __SPIxSTATbits_t *HAL_sim_spi_stat(uint8_t module) {
+    sim_sync();
+    return &HAL_SPI[module].STAT;
+}
+
+volatile uint64_t *HAL_sim_uart_txreg(uint8_t module) {
+    sim_sync();
+    uart_slot[module] = SLOT_IDLE;
+    return &uart_slot[module];
+}
+
+volatile uint32_t *HAL_sim_uart_rxreg(uint8_t module) {
+    struct uart_sim *u = &uart[module];
+    sim_sync();
+    if (u->rx_count > 0) { // reading an empty FIFO returns the last byte
+        u->rx_latch = u->rx_fifo[u->rx_head];
+        u->rx_head = (u->rx_head + 1) % UART_FIFO_SIZE;
+        u->rx_count--;
+    }
+    uart_update_flags(module);
+    return &u->rx_latch;
+}
+
+volatile void *HAL_sim_lat(uint8_t port) {
+    sim_sync();
+    return &HAL_PORT[port].LAT;
+}
+
+volatile uint32_t *HAL_sim_lat_op(uint8_t port, uint8_t op) {
+    sim_sync();
+    lat_op_port = port;
+    lat_op = op;
+    lat_op_slot = 0;
+    return &lat_op_slot;
+}
+
+uint32_t HAL_sim_core_timer(void) {
+    return ((uint32_t) (sim_time / CORE_TIMER_NSEC) + core_timer_offset);
+}
+
+void HAL_sim_set_core_timer(uint32_t count) {
+    core_timer_offset = count - (uint32_t) (sim_time / CORE_TIMER_NSEC);
+}
+
+uint32_t HAL_sim_disable_interrupts(void) {
+    uint32_t status = irq_enabled ? 0x1 : 0x0;
+    irq_enabled = FALSE;
+    return status;
+}
+
+uint32_t HAL_sim_enable_interrupts(void) {
+    uint32_t status = irq_enabled ? 0x1 : 0x0;
+    irq_enabled = TRUE;
+    sim_service(); // anything that became pending while masked runs now
+    return status;
+}
+
+uint32_t HAL_sim_kva_to_pa(const volatile void *address) {
+    int i;
+    for (i = 0; i < num_pa; i++) {
+        if (pa_table[i] == address) {
+            return (i + 1);
+        }
+    }
+    if (num_pa >= MAX_PA_HANDLES) {
+        fprintf(stderr, "HAL sim: more than %d DMA addresses\n", MAX_PA_HANDLES);
+        return 0;
+    }
+    pa_table[num_pa++] = address;
+    return num_pa; // 0 is never a valid handle
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function sim_sync(void)
+ * @brief applies the writes the firmware made since the last hook: pending
+ * LATxCLR/SET/INV, chip select edges, DMA forces and aborts, SPI and UART
+ * transmit slots
+ * @author Aaron Hunter
+ */
+static void sim_sync(void) {
+    uint8_t i;
+    int d;
+    uint32_t changed;
+    const HAL_sim_spi_device_t *dev;
+    if (in_sync) {
+        return;
+    }
+    in_sync = TRUE;
+    if (lat_op_port >= 0) {
+        volatile uint32_t *lat = &HAL_PORT[lat_op_port].LAT;
+        switch (lat_op) {
+            case LAT_CLR:
+                *lat &= ~lat_op_slot;
+                break;
+            case LAT_SET:
+                *lat |= lat_op_slot;
+                break;
+            default:
+                *lat ^= lat_op_slot;
+                break;
+        }
+        lat_op_port = -1;
+    }
+    for (i = 0; i < NUM_PORTS; i++) {
+        volatile HAL_port_regs_t *p = &HAL_PORT[i];
+        changed = p->LAT ^ lat_seen[i];
+        if (changed) {
+            lat_seen[i] = p->LAT;
+            /* outputs read back on PORTx */
+            p->PORT = (p->PORT & p->TRIS) | (p->LAT & ~p->TRIS);
+            for (d = 0; d < num_spi_devs; d++) {
+                dev = spi_devs[d];
+                if ((dev->cs_port - 'A') == i && (changed & (1u << dev->cs_pin))
+                        && dev->select != NULL) {
+                    dev->select(dev->ctx, ((p->LAT >> dev->cs_pin) & 0x1) == 0);
+                }
+            }
+        }
+    }
+    dma_sync();
+    for (i = 1; i < NUM_SPI; i++) {
+        /* a DMA channel started by the receive flag writes the next word
+         * from inside spi_transfer(), so a whole burst runs here */
+        while ((spi_slot[i] & SLOT_IDLE) == 0) {
+            uint32_t mosi = (uint32_t) spi_slot[i];
+            spi_slot[i] = SLOT_IDLE | spi_rx[i];
+            spi_transfer(i, mosi);
+        }
+    }
+    for (i = 1; i < NUM_UART; i++) {
+        if ((uart_slot[i] & SLOT_IDLE) == 0) {
+            uart_flush_tx(i);
+        }
+    }
+    in_sync = FALSE;
+}
+
+/**
+ * @Function sim_service(void)
+ * @brief updates level sensitive flags and runs pending ISRs until none are
+ * left, highest priority first
+ * @author Aaron Hunter
+ */
+static void sim_service(void) {
+    uint32_t n;
+    uint8_t i;
+    uint8_t priority;
+    uint8_t best_priority;
+    const vector_entry_t *best;
+    uint64_t t0;
+    uint32_t dt;
+    HAL_sim_isr_stats_t *s;
+    if (in_isr) {
+        return;
+    }
+    for (n = 0; n < MAX_DISPATCH; n++) {
+        sim_sync();
+        for (i = 1; i < NUM_UART; i++) {
+            uart_update_flags(i);
+        }
+        if (!irq_enabled) {
+            return;
+        }
+        best = NULL;
+        best_priority = 0;
+        for (i = 0; i < NUM_VECTORS; i++) {
+            if ((*ifs_reg[vectors[i].ifs] & *iec_reg[vectors[i].ifs] & vectors[i].mask)
+                    && vectors[i].isr != NULL) {
+                /* IPCx holds four vectors, IP<2:0> sits above IS<1:0> */
+                priority = (HAL_IPC[vectors[i].vector / 4]
+                        >> ((vectors[i].vector % 4) * 8 + 2)) & 0x7;
+                if (priority > best_priority) { // priority 0 is disabled
+                    best = &vectors[i];
+                    best_priority = priority;
+                }
+            }
+        }
+        if (best == NULL) {
+            return;
+        }
+        in_isr = TRUE;
+        t0 = host_nsec();
+        best->isr();
+        dt = (uint32_t) (host_nsec() - t0);
+        in_isr = FALSE;
+        s = &isr_stats[best->vector];
+        s->calls++;
+        s->total_nsec += dt;
+        if (dt > s->max_nsec) {
+            s->max_nsec = dt;
+        }
+    }
+    if (!storm_reported) {
+        fprintf(stderr, "HAL sim: interrupt storm, an ISR is not clearing its flag\n");
+        storm_reported = TRUE;
+    }
+}
+
+/**
+ * @Function sim_step(uint64_t nsec)
+ * @brief moves virtual time forward and clocks the peripherals
+ * @author Aaron Hunter
+ */
+static void sim_step(uint64_t nsec) {
+    uint64_t pb_now;
+    uint8_t i;
+    sim_sync();
+    sim_time += nsec;
+    pb_now = sim_time * (HAL_SIM_PB_CLOCK / 1000000) / 1000;
+    timers_tick(pb_now - pb_last);
+    pb_last = pb_now;
+    if (tick_hook != NULL) {
+        tick_hook(tick_ctx, sim_time);
+    }
+    for (i = 1; i < NUM_UART; i++) {
+        uart_tick(i);
+    }
+    sim_service();
+}
+
+/**
+ * @Function spi_transfer(uint8_t module, uint32_t mosi)
+ * @brief clocks one frame out to the selected device and latches the reply
+ * @author Aaron Hunter
+ */
+static void spi_transfer(uint8_t module, uint32_t mosi) {
+    volatile HAL_spi_regs_t *spi = &HAL_SPI[module];
+    uint32_t width_mask;
+    uint32_t miso;
+    int8_t selected = FALSE;
+    int d;
+    const HAL_sim_spi_device_t *dev;
+    if (spi->CON.ON == 0) {
+        return;
+    }
+    width_mask = spi->CON.MODE32 ? 0xFFFFFFFF : (spi->CON.MODE16 ? 0xFFFF : 0xFF);
+    miso = width_mask; // MISO floats high with nobody selected
+    for (d = 0; d < num_spi_devs; d++) {
+        dev = spi_devs[d];
+        if (dev->module == module && selected == FALSE
+                && HAL_sim_pin_get(dev->cs_port, dev->cs_pin) == 0) {
+            miso = dev->transfer(dev->ctx, mosi & width_mask) & width_mask;
+            selected = TRUE;
+        }
+    }
+    if (spi->STAT.SPIRBF) {
+        spi->STAT.SPIROV = 1; // previous word never read, new one is lost
+    } else {
+        spi_rx[module] = miso;
+        spi->STAT.SPIRBF = 1;
+    }
+    spi_slot[module] = SLOT_IDLE | spi_rx[module];
+    set_flag(spi_flags[module].ifs, spi_flags[module].ebit + 1);
+    spi_bytes[module] += spi->CON.MODE32 ? 4 : (spi->CON.MODE16 ? 2 : 1);
+}
+
+/**
+ * @Function uart_flush_tx(uint8_t module)
+ * @brief moves a UxTXREG write into the transmit FIFO
+ * @author Aaron Hunter
+ */
+static void uart_flush_tx(uint8_t module) {
+    struct uart_sim *u = &uart[module];
+    volatile HAL_uart_regs_t *r = &HAL_UART[module];
+    uint8_t byte = (uint8_t) uart_slot[module];
+    uart_slot[module] = SLOT_IDLE;
+    if (r->MODE.ON == 0 || r->STA.UTXEN == 0 || u->tx_count >= UART_FIFO_SIZE) {
+        return; // writes to a full FIFO are dropped by the hardware too
+    }
+    u->tx_fifo[u->tx_count++] = byte;
+    if (u->shifting == FALSE) {
+        u->shift_byte = u->tx_fifo[0];
+        memmove(u->tx_fifo, u->tx_fifo + 1, --u->tx_count);
+        u->shifting = TRUE;
+        u->shift_done = sim_time + uart_byte_nsec(module);
+    }
+    uart_update_flags(module);
+}
+
+/**
+ * @Function uart_tick(uint8_t module)
+ * @brief completes transmit and receive bytes whose time has come
+ * @author Aaron Hunter
+ */
+static void uart_tick(uint8_t module) {
+    struct uart_sim *u = &uart[module];
+    volatile HAL_uart_regs_t *r = &HAL_UART[module];
+    uint64_t byte_time;
+    uint8_t byte;
+    if (uart_flags[module].ifs == NO_FLAG) {
+        return;
+    }
+    byte_time = uart_byte_nsec(module);
+    while (u->shifting && sim_time >= u->shift_done) {
+        if (u->sink != NULL) {
+            u->sink(u->ctx, u->shift_byte);
+        }
+        u->tx_bytes++;
+        if (u->tx_count > 0) {
+            u->shift_byte = u->tx_fifo[0];
+            memmove(u->tx_fifo, u->tx_fifo + 1, --u->tx_count);
+            u->shift_done += byte_time;
+        } else {
+            u->shifting = FALSE;
+        }
+    }
+    if (r->STA.OERR == 0 && u->oerr_seen) {
+        u->rx_count = 0; // clearing OERR resets the receive FIFO
+        u->oerr_seen = FALSE;
+    }
+    while (u->line_count > 0 && sim_time >= u->line_next) {
+        byte = u->line[u->line_head];
+        u->line_head = (u->line_head + 1) % UART_LINE_SIZE;
+        u->line_count--;
+        u->line_next += byte_time;
+        if (r->MODE.ON == 0 || r->STA.URXEN == 0 || r->STA.OERR) {
+            continue; // receiver off or stalled on overrun, byte is lost
+        }
+        if (u->rx_count >= UART_FIFO_SIZE) {
+            r->STA.OERR = 1;
+            u->oerr_seen = TRUE;
+            u->overruns++;
+            set_flag(uart_flags[module].ifs, uart_flags[module].ebit);
+            continue;
+        }
+        u->rx_fifo[(u->rx_head + u->rx_count) % UART_FIFO_SIZE] = byte;
+        u->rx_count++;
+        u->rx_bytes++;
+    }
+    uart_update_flags(module);
+}
+
+/**
+ * @Function uart_update_flags(uint8_t module)
+ * @brief status bits and the level triggered RX/TX interrupt conditions
+ * @author Aaron Hunter
+ */
+static void uart_update_flags(uint8_t module) {
+    struct uart_sim *u = &uart[module];
+    volatile HAL_uart_regs_t *r = &HAL_UART[module];
+    int8_t rx_int;
+    int8_t tx_int;
+    if (uart_flags[module].ifs == NO_FLAG) {
+        return;
+    }
+    r->STA.URXDA = u->rx_count > 0;
+    r->STA.UTXBF = u->tx_count >= UART_FIFO_SIZE;
+    r->STA.TRMT = (u->shifting == FALSE && u->tx_count == 0);
+    if (r->MODE.ON == 0) {
+        return;
+    }
+    switch (r->STA.URXISEL) {
+        case 0:
+            rx_int = u->rx_count > 0;
+            break;
+        case 1:
+            rx_int = u->rx_count >= (UART_FIFO_SIZE * 3) / 4;
+            break;
+        default:
+            rx_int = u->rx_count >= UART_FIFO_SIZE;
+            break;
+    }
+    switch (r->STA.UTXISEL) {
+        case 0:
+            tx_int = u->tx_count < UART_FIFO_SIZE;
+            break;
+        case 1:
+            tx_int = r->STA.TRMT;
+            break;
+        default:
+            tx_int = u->tx_count == 0;
+            break;
+    }
+    if (rx_int) {
+        set_flag(uart_flags[module].ifs, uart_flags[module].ebit + 1);
+    }
+    if (tx_int && r->STA.UTXEN) {
+        set_flag(uart_flags[module].ifs, uart_flags[module].ebit + 2);
+    }
+}
+
+/**
+ * @Function timers_tick(uint64_t pb_cycles)
+ * @brief counts the type B timers and raises their period match flags
+ * @author Aaron Hunter
+ */
+static void timers_tick(uint64_t pb_cycles) {
+    uint8_t i;
+    uint16_t prescale;
+    uint64_t total;
+    uint64_t position;
+    uint32_t period;
+    volatile HAL_timer_regs_t *t;
+    for (i = 2; i < 6; i++) {
+        t = &HAL_TMR[i];
+        if (t->CON.ON == 0) {
+            continue;
+        }
+        prescale = timer_prescale[t->CON.TCKPS];
+        total = timer_rem[i] + pb_cycles;
+        timer_rem[i] = total % prescale;
+        period = (t->PR & 0xFFFF) + 1;
+        position = (t->TMR % period) + total / prescale;
+        if (position >= period) {
+            set_flag(0, i * 4); // TxIF sits at IFS0<4n>
+        }
+        t->TMR = (uint32_t) (position % period);
+    }
+}
+
+static void set_flag(uint8_t ifs, uint8_t bit) {
+    *ifs_reg[ifs] |= (1u << bit);
+    dma_event(ifs * 32 + bit); // the event starts DMA whether or not the flag was clear
+}
+
+/**
+ * @Function dma_sync(void)
+ * @brief carries out the CABORT and CFORCE bits the firmware set
+ * @author Aaron Hunter
+ */
+static void dma_sync(void) {
+    uint8_t ch;
+    volatile HAL_dma_regs_t *d;
+    for (ch = 0; ch < NUM_DMA; ch++) {
+        d = &HAL_DCH[ch];
+        if (d->ECON.CABORT) {
+            d->ECON.CABORT = 0;
+            d->CON.CHEN = 0;
+            dma_reset_channel(ch);
+        }
+        if (d->ECON.CFORCE) {
+            d->ECON.CFORCE = 0;
+            if (HAL_DMACON.ON && d->CON.CHEN) {
+                dma_cell(ch);
+            }
+        }
+    }
+}
+
+/**
+ * @Function dma_event(uint8_t irq)
+ * @brief starts a cell transfer on every enabled channel waiting for irq,
+ * highest CHPRI first and lowest channel number on ties, then aborts the
+ * channels whose abort IRQ it is
+ * @author Aaron Hunter
+ */
+static void dma_event(uint8_t irq) {
+    uint8_t ch;
+    int8_t priority;
+    volatile HAL_dma_regs_t *d;
+    if (HAL_DMACON.ON == 0) {
+        return;
+    }
+    for (priority = 3; priority >= 0; priority--) {
+        for (ch = 0; ch < NUM_DMA; ch++) {
+            d = &HAL_DCH[ch];
+            if (d->CON.CHEN && d->CON.CHBUSY == 0 && d->CON.CHPRI == priority
+                    && d->ECON.SIRQEN && d->ECON.CHSIRQ == irq) {
+                dma_cell(ch);
+            }
+        }
+    }
+    for (ch = 0; ch < NUM_DMA; ch++) {
+        d = &HAL_DCH[ch];
+        if (d->CON.CHEN && d->ECON.AIRQEN && d->ECON.CHAIRQ == irq) {
+            d->CON.CHEN = 0;
+            dma_reset_channel(ch);
+            d->INT.CHTAIF = 1;
+            if (d->INT.w & (d->INT.w >> 16) & 0xFF) {
+                set_flag(DMA_IFS, DMA_FLAG_BIT + ch);
+            }
+        }
+    }
+}
+
+/**
+ * @Function dma_cell(uint8_t ch)
+ * @brief moves one cell, CSIZ bytes or what is left of the block, which is
+ * the larger of the source and destination sizes.  The channel disables at
+ * the end of the block unless CHAEN is set.
+ * @author Aaron Hunter
+ */
+static void dma_cell(uint8_t ch) {
+    volatile HAL_dma_regs_t *d = &HAL_DCH[ch];
+    uint32_t ssiz = dma_size(d->SSIZ);
+    uint32_t dsiz = dma_size(d->DSIZ);
+    uint32_t csiz = dma_size(d->CSIZ);
+    uint32_t block = ssiz > dsiz ? ssiz : dsiz;
+    uint32_t i;
+    d->CON.CHBUSY = 1; // a DMA IRQ raised below cannot restart this channel
+    for (i = 0; i < csiz && dma_count[ch] < block; i++) {
+        dma_write(d->DSA, d->DPTR, dma_read(d->SSA, d->SPTR));
+        dma_count[ch]++;
+        dma_bytes[ch]++;
+        if (++d->SPTR >= ssiz) {
+            d->SPTR = 0;
+            d->INT.CHSDIF = 1;
+        }
+        if (++d->DPTR >= dsiz) {
+            d->DPTR = 0;
+            d->INT.CHDDIF = 1;
+        }
+    }
+    d->INT.CHCCIF = 1;
+    if (dma_count[ch] >= block) {
+        dma_reset_channel(ch);
+        d->INT.CHBCIF = 1;
+        if (d->CON.CHAEN == 0) {
+            d->CON.CHEN = 0;
+        }
+    }
+    d->CON.CHBUSY = 0;
+    if (d->INT.w & (d->INT.w >> 16) & 0xFF) {
+        set_flag(DMA_IFS, DMA_FLAG_BIT + ch);
+    }
+}
+
+static void dma_reset_channel(uint8_t ch) {
+    HAL_DCH[ch].SPTR = 0;
+    HAL_DCH[ch].DPTR = 0;
+    HAL_DCH[ch].CPTR = 0;
+    dma_count[ch] = 0;
+}
+
+static uint32_t dma_size(uint32_t size) {
+    size &= 0xFF;
+    return (size == 0 ? 256 : size);
+}
+
+/**
+ * @Function dma_read(uint32_t pa, uint32_t offset)
+ * @return the byte at a KVA_TO_PA() handle plus offset.  An SPI buffer is
+ * read the way the CPU reads it, emptying the receive buffer, 8 bit mode only.
+ * @author Aaron Hunter
+ */
+static uint8_t dma_read(uint32_t pa, uint32_t offset) {
+    const volatile uint8_t *address;
+    uint8_t i;
+    if (pa == 0 || pa > (uint32_t) num_pa) {
+        return 0;
+    }
+    address = (const volatile uint8_t *) pa_table[pa - 1];
+    for (i = 1; i < NUM_SPI; i++) {
+        if (address == (const volatile uint8_t *) &spi_slot[i]) {
+            HAL_SPI[i].STAT.SPIRBF = 0;
+            spi_slot[i] = SLOT_IDLE | spi_rx[i];
+            return ((uint8_t) spi_rx[i]);
+        }
+    }
+    return address[offset];
+}
+
+/**
+ * @Function dma_write(uint32_t pa, uint32_t offset, uint8_t byte)
+ * @brief stores a byte at a KVA_TO_PA() handle plus offset.  Writing an SPI
+ * buffer starts a transfer, 8 bit mode only.
+ * @author Aaron Hunter
+ */
+static void dma_write(uint32_t pa, uint32_t offset, uint8_t byte) {
+    volatile uint8_t *address;
+    uint8_t i;
+    if (pa == 0 || pa > (uint32_t) num_pa) {
+        return;
+    }
+    address = (volatile uint8_t *) pa_table[pa - 1];
+    for (i = 1; i < NUM_SPI; i++) {
+        if (address == (volatile uint8_t *) &spi_slot[i]) {
+            spi_slot[i] = byte; // clears SLOT_IDLE, sim_sync() sends it
+            return;
+        }
+    }
+    address[offset] = byte;
+}
+
+/**
+ * @Function uart_byte_nsec(uint8_t module)
+ * @return time on the wire of one character at the configured framing
+ */
+static uint64_t uart_byte_nsec(uint8_t module) {
+    volatile HAL_uart_regs_t *r = &HAL_UART[module];
+    uint32_t bits = 1 + 8 + 1; // start, data, stop
+    uint64_t clocks_per_bit = (r->MODE.BRGH ? 4 : 16) * ((uint64_t) (r->BRG & 0xFFFF) + 1);
+    if (r->MODE.PDSEL == 1 || r->MODE.PDSEL == 2) {
+        bits++; // parity
+    } else if (r->MODE.PDSEL == 3) {
+        bits++; // ninth data bit
+    }
+    bits += r->MODE.STSEL;
+    return (bits * clocks_per_bit * NSEC_PER_SEC) / HAL_SIM_PB_CLOCK;
+}
+
+static uint64_t host_nsec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec);
+}
+
+static void stdout_sink(void *ctx, uint8_t byte) {
+    (void) ctx;
+    putchar(byte);
+}
+
+/**
+ * @Function sim_constructor(void)
+ * @brief registers start at their reset values before main() runs.  The low
+ * priority number runs it ahead of any constructor that attaches device models.
+ */
+static void __attribute__((constructor(101))) sim_constructor(void) {
+    HAL_sim_reset();
+}
+
+/*******************************************************************************
+ * MODULE UNIT TESTS                                                           *
+ ******************************************************************************/
+#ifdef HAL_TESTING
+/* Runs every interrupt driven driver in lib/ against minimal device models and
+ * reports the host cost of each ISR per byte moved.  Build from the repo root:
+ * gcc -O2 -DHAL_SIM -DHAL_TESTING -Ilib/HAL.X/linux -Ilib/HAL.X -Ilib/Board.X
+ *   -Ilib/Serial.X -Ilib/Radio_serial.X -Ilib/System_timer.X -Ilib/NEO_M8N.X
+ *   -Ilib/RC_RX.X -Ilib/AS5047D.X -Ilib/RC_servo.X -Ilib/ICM-20948.X
+ *   lib/HAL.X/HAL_linux.c lib/HAL.X/HAL_sim_devices.c lib/Board.X/Board.c
+ *   lib/Serial.X/SerialM32.c lib/Radio_serial.X/Radio_serial.c
+ *   lib/System_timer.X/System_timer.c lib/NEO_M8N.X/NEO_M8N.c lib/RC_RX.X/RC_RX.c
+ *   lib/AS5047D.X/AS5047D.c lib/RC_servo.X/RC_servo.c lib/ICM-20948.X/ICM_20948.c -lm -o hal_test */
+#include "SerialM32.h"
+#include "Radio_serial.h"
+#include "System_timer.h"
+#include "NEO_M8N.h"
+#include "RC_RX.h"
+#include "AS5047D.h"
+#include "RC_servo.h"
+#include "ICM_20948.h"
+#include "HAL_sim_devices.h"
+
+#define TEST_BYTES 1500 // stays below the 2048 byte driver buffers
+#define NUM_GPS_MSGS 20
+#define NUM_SBUS_FRAMES 50
+#define ICM_DATA_BYTES 23 // accel, gyro, temp and the mag slave registers
+#define NUM_IMU_SAMPLES 100
+#define IMU_FIFO_SAMPLES 6
+#define IMU_DRDY_SAMPLES 10
+#define IMU_FIFO_OVERFLOW_SAMPLES 25 // 575 bytes into a 512 byte FIFO
+
+struct capture {
+    uint8_t data[TEST_BYTES];
+    int length;
+};
+
+static int test_count = 0;
+static int pass_count = 0;
+
+static void capture_sink(void *ctx, uint8_t byte) {
+    struct capture *c = ctx;
+    if (c->length < TEST_BYTES) {
+        c->data[c->length++] = byte;
+    }
+}
+
+static void check(int condition, const char *name) {
+    test_count++;
+    if (condition) {
+        pass_count++;
+    }
+    printf("%s: %s\r\n", name, condition ? "SUCCESS" : "FAIL");
+}
+
+static void run_until(int (*done)(void), uint64_t timeout_nsec) {
+    uint64_t start = HAL_sim_get_time_nsec();
+    while (!done() && HAL_sim_get_time_nsec() - start < timeout_nsec) {
+        HAL_sim_poll();
+    }
+}
+
+static struct capture serial_out;
+static struct capture radio_out;
+
+static int serial_drained(void) {
+    return serial_out.length >= TEST_BYTES;
+}
+
+static int radio_drained(void) {
+    return radio_out.length >= TEST_BYTES;
+}
+
+/* runs NUM_IMU_SAMPLES burst reads in one interface mode, returns the raw
+ * data and the interrupts the reads took on the vector that ends them */
+static int imu_burst_cost(char mode, uint8_t vector, struct IMU_out *imu,
+        HAL_sim_isr_stats_t *cost) {
+    HAL_sim_isr_stats_t before;
+    int ok;
+    int i;
+    ok = IMU_init(mode) == SUCCESS;
+    HAL_sim_poll(); // flush the stale flag left by the blocking setup reads
+    IMU_is_data_ready();
+    IMU_get_raw_data(imu);
+    HAL_sim_get_isr_stats(vector, &before);
+    for (i = 0; i < NUM_IMU_SAMPLES; i++) {
+        IMU_start_data_acq();
+        HAL_sim_poll();
+    }
+    HAL_sim_get_isr_stats(vector, cost);
+    cost->calls -= before.calls;
+    cost->total_nsec -= before.total_nsec;
+    cost->bytes -= before.bytes;
+    ok = ok && IMU_is_data_ready();
+    IMU_get_raw_data(imu);
+    return ok;
+}
+
+/* queues samples in the IMU FIFO, accel x counts the samples */
+static void imu_fifo_fill(HAL_sim_icm_t *icm, int num_samples, int first) {
+    int i;
+    for (i = 0; i < num_samples; i++) {
+        icm->regs[0][AGB0_REG_ACCEL_XOUT_H] = 0;
+        icm->regs[0][AGB0_REG_ACCEL_XOUT_L] = (uint8_t) (first + i);
+        HAL_sim_icm_sample(icm);
+    }
+}
+
+int main(void) {
+    static HAL_sim_icm_t icm;
+    static HAL_sim_as5047d_t enc[NUM_ENCODERS];
+    uint8_t line[HAL_SIM_SBUS_FRAME_LENGTH * NUM_SBUS_FRAMES];
+    uint8_t echo[TEST_BYTES];
+    char nmea[NUM_GPS_MSGS * 96];
+    uint16_t channels[CHANNELS];
+    RCRX_channel_buffer rc_cmd[CHANNELS];
+    struct GPS_data gps;
+    struct IMU_out imu;
+    struct IMU_out batch[IMU_FIFO_MAX_BATCH];
+    uint32_t transactions;
+    HAL_sim_isr_stats_t spi_cost;
+    HAL_sim_isr_stats_t dma_cost;
+    uint32_t start;
+    int length;
+    int i;
+    int ok;
+
+    Board_init();
+    Serial_init();
+    Sys_timer_init();
+    printf("HAL Linux backend test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    /* System timer: one virtual second is 1000 Timer5 interrupts */
+    start = Sys_timer_get_msec();
+    HAL_sim_advance_nsec(1000000000ull);
+    i = Sys_timer_get_msec() - start;
+    check(i >= 1000 && i <= 1001, "Sys_timer 1000 msec per second");
+
+    /* UART1 transmit path through the serial driver ISR */
+    HAL_sim_uart_attach(1, capture_sink, &serial_out);
+    for (i = 0; i < TEST_BYTES; i++) {
+        put_char((unsigned char) ('A' + i % 26));
+    }
+    run_until(serial_drained, 1000000000ull);
+    ok = serial_out.length == TEST_BYTES;
+    for (i = 0; i < serial_out.length; i++) {
+        ok = ok && serial_out.data[i] == 'A' + i % 26;
+    }
+    check(ok, "Serial TX bytes out in order");
+    HAL_sim_uart_attach(1, NULL, NULL);
+
+    /* UART4 radio, echo a burst back through the driver */
+    Radio_serial_init();
+    HAL_sim_uart_attach(4, capture_sink, &radio_out);
+    for (i = 0; i < TEST_BYTES; i++) {
+        echo[i] = (uint8_t) i;
+    }
+    HAL_sim_uart_feed(4, echo, TEST_BYTES);
+    length = 0;
+    start = Sys_timer_get_msec();
+    while (length < TEST_BYTES && Sys_timer_get_msec() - start < 1000) {
+        if (Radio_data_available()) {
+            Radio_put_char(Radio_get_char());
+            length++;
+        }
+    }
+    run_until(radio_drained, 1000000000ull);
+    ok = radio_out.length == TEST_BYTES;
+    for (i = 0; i < radio_out.length; i++) {
+        ok = ok && radio_out.data[i] == (uint8_t) i;
+    }
+    check(ok, "Radio RX to TX echo");
+
+    /* UART2 GPS NMEA stream */
+    GPS_init();
+    length = 0;
+    for (i = 0; i < NUM_GPS_MSGS; i++) {
+        length += HAL_sim_nmea_rmc(nmea + length, 77220.0 + i, 36.9603855, -122.0329238,
+                0.038, 0.0);
+    }
+    HAL_sim_uart_feed(2, (uint8_t *) nmea, length);
+    ok = 0;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 100) {
+        if (GPS_is_msg_avail()) {
+            GPS_parse_stream();
+        }
+        if (GPS_is_data_avail()) {
+            GPS_get_data(&gps);
+            ok++;
+        }
+    }
+    check(ok > 0 && gps.lat > 36.9 && gps.lat < 37.0 && gps.lon < -122.0,
+            "GPS RMC parsed from the UART stream");
+
+    /* UART5 SBUS receiver */
+    RCRX_init();
+    for (i = 0; i < CHANNELS; i++) {
+        channels[i] = RC_RX_MIN_COUNTS + 100 * i;
+    }
+    for (i = 0; i < NUM_SBUS_FRAMES; i++) {
+        HAL_sim_sbus_frame(line + i * HAL_SIM_SBUS_FRAME_LENGTH, channels);
+    }
+    HAL_sim_uart_feed(5, line, sizeof (line));
+    ok = 0;
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < 200) {
+        if (RCRX_new_cmd_avail()) {
+            RCRX_get_cmd(rc_cmd);
+            ok = 1;
+            for (i = 0; i < CHANNELS; i++) {
+                ok = ok && rc_cmd[i] == channels[i];
+            }
+        }
+    }
+    check(ok, "SBUS channels decoded");
+
+    /* SPI2 encoders, three chip selects on port E */
+    for (i = 0; i < NUM_ENCODERS; i++) {
+        enc[i].angle = 1000 * (i + 1);
+        HAL_sim_as5047d_attach(&enc[i], 2, 'E', i + 1);
+    }
+    Encoder_init();
+    for (i = 0; i < 3; i++) { // the encoder replies one frame late
+        Encoder_start_data_acq();
+        HAL_sim_poll();
+    }
+    check(Encoder_is_data_ready() && Encoder_get_angle(RIGHT_MOTOR) == enc[1].angle
+            && Encoder_get_angle(HEADING) == enc[2].angle, "AS5047D angles read");
+
+    /* SPI1 IMU burst read */
+    HAL_sim_icm_attach(&icm, 1, 'E', 0);
+    for (i = 0; i < ICM_DATA_BYTES; i++) {
+        icm.regs[0][AGB0_REG_ACCEL_XOUT_H + i] = (uint8_t) (i + 1);
+    }
+    ok = imu_burst_cost(IMU_SPI_MODE, _SPI_1_VECTOR, &imu, &spi_cost);
+    check(ok && imu.acc.x == ((1 << 8) | 2), "ICM-20948 SPI burst read");
+    for (i = 0; i < ICM_DATA_BYTES; i++) {
+        icm.regs[0][AGB0_REG_ACCEL_XOUT_H + i] = (uint8_t) (i + 101);
+    }
+    ok = imu_burst_cost(IMU_SPI_DMA_MODE, _DMA_0_VECTOR, &imu, &dma_cost);
+    check(ok && imu.acc.x == ((101 << 8) | 102) && imu.mag.x == ((117 << 8) | 116)
+            && dma_cost.calls == NUM_IMU_SAMPLES
+            && dma_cost.bytes == NUM_IMU_SAMPLES * (ICM_DATA_BYTES + 1),
+            "ICM-20948 DMA burst read, one interrupt per sample");
+    printf("ICM-20948 ISR cost per sample: SPI %.1f calls %.0f ns, DMA %.1f calls %.0f ns\r\n",
+            (double) spi_cost.calls / NUM_IMU_SAMPLES,
+            (double) spi_cost.total_nsec / NUM_IMU_SAMPLES,
+            (double) dma_cost.calls / NUM_IMU_SAMPLES,
+            (double) dma_cost.total_nsec / NUM_IMU_SAMPLES);
+
+    /* SPI1 IMU FIFO, a read below the watermark only counts */
+    ok = IMU_init(IMU_SPI_FIFO_MODE) == SUCCESS;
+    HAL_sim_poll();
+    imu_fifo_fill(&icm, IMU_FIFO_WATERMARK - 1, 0);
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    ok = ok && IMU_is_data_ready() == FALSE
+            && icm.fifo_count == (IMU_FIFO_WATERMARK - 1) * ICM_DATA_BYTES;
+    imu_fifo_fill(&icm, IMU_FIFO_SAMPLES - IMU_FIFO_WATERMARK + 1, IMU_FIFO_WATERMARK - 1);
+    transactions = icm.transactions;
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    length = IMU_get_batch(batch, IMU_FIFO_MAX_BATCH);
+    ok = ok && length == IMU_FIFO_SAMPLES && icm.transactions - transactions == 2
+            && icm.fifo_count == 0 && batch[length - 1].usec <= Sys_timer_get_usec();
+    for (i = 0; i < length; i++) {
+        ok = ok && batch[i].acc.x == i
+                && (i == 0 || batch[i].usec - batch[i - 1].usec == batch[1].usec - batch[0].usec);
+    }
+    check(ok && batch[1].usec - batch[0].usec == 1778,
+            "ICM-20948 FIFO batch in two transactions, 562.5 Hz time stamps");
+    /* a full FIFO is counted and reset by the next read */
+    imu_fifo_fill(&icm, IMU_FIFO_OVERFLOW_SAMPLES, 0);
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    ok = IMU_is_data_ready() == FALSE && IMU_get_fifo_overflows() == 1;
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    imu_fifo_fill(&icm, IMU_FIFO_WATERMARK, 1);
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    length = IMU_get_batch(batch, 2);
+    check(ok && length == 2 && batch[0].acc.x == IMU_FIFO_WATERMARK - 1
+            && batch[1].acc.x == IMU_FIFO_WATERMARK, "ICM-20948 FIFO overflow reset");
+    /* a batch published between IMU_get_batch() and its raw counts is kept */
+    imu_fifo_fill(&icm, IMU_FIFO_WATERMARK, 0);
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    length = IMU_get_batch(batch, IMU_FIFO_MAX_BATCH);
+    imu_fifo_fill(&icm, IMU_FIFO_WATERMARK, IMU_FIFO_WATERMARK);
+    IMU_start_data_acq();
+    HAL_sim_poll();
+    IMU_get_batch_raw_data(&imu);
+    ok = length == IMU_FIFO_WATERMARK && imu.acc.x == IMU_FIFO_WATERMARK - 1;
+    length = IMU_get_batch(batch, IMU_FIFO_MAX_BATCH);
+    check(ok && length == IMU_FIFO_WATERMARK && batch[0].acc.x == IMU_FIFO_WATERMARK,
+            "ICM-20948 batch raw counts leave the next batch");
+
+    /* SPI1 IMU data ready, each INT2 pulse reads and time stamps one sample */
+    icm.int_port = 'E';
+    icm.int_pin = 9;
+    ok = IMU_init(IMU_SPI_DRDY_MODE) == SUCCESS;
+    HAL_sim_poll();
+    IMU_get_raw_data(&imu);
+    HAL_sim_get_isr_stats(_EXTERNAL_2_VECTOR, &spi_cost);
+    transactions = icm.transactions;
+    for (i = 0; i < IMU_DRDY_SAMPLES; i++) {
+        icm.regs[0][AGB0_REG_ACCEL_XOUT_L] = (uint8_t) i;
+        HAL_sim_advance_nsec(4444444ull);
+        start = Sys_timer_get_usec();
+        IMU_start_data_acq(); // does nothing in this mode
+        HAL_sim_icm_sample(&icm);
+        HAL_sim_poll();
+        HAL_sim_advance_nsec(1000000ull); // the stamp is the pulse, not the read
+        ok = ok && IMU_is_data_ready();
+        IMU_get_raw_data(&imu);
+        /* the ISR runs a quantum after the pulse and its timer read polls another */
+        ok = ok && imu.acc.x == i && imu.usec - start <= 2 * HAL_SIM_DEFAULT_QUANTUM / 1000;
+    }
+    HAL_sim_get_isr_stats(_EXTERNAL_2_VECTOR, &dma_cost);
+    check(ok && dma_cost.calls - spi_cost.calls == IMU_DRDY_SAMPLES
+            && icm.transactions - transactions == IMU_DRDY_SAMPLES,
+            "ICM-20948 data ready read, one per INT2 pulse, time stamped");
+    /* frames published while the consumer is away, the newest is taken whole */
+    for (i = 0; i < IMU_DRDY_SAMPLES; i++) {
+        memset(&icm.regs[0][AGB0_REG_ACCEL_XOUT_H], i, ICM_DATA_BYTES);
+        HAL_sim_icm_sample(&icm);
+        HAL_sim_poll();
+    }
+    ok = IMU_is_data_ready();
+    IMU_get_raw_data(&imu);
+    i = IMU_DRDY_SAMPLES - 1;
+    check(ok && imu.acc.x == ((i << 8) | i) && imu.gyro.z == ((i << 8) | i)
+            && imu.mag.z == -((i << 8) | i) && IMU_is_data_ready() == FALSE,
+            "ICM-20948 newest frame handed over whole");
+    icm.int_port = 0;
+
+    /* output compare PWM on Timer3 */
+    RC_servo_init(RC_SERVO_TYPE, SERVO_PWM_1);
+    RC_servo_set_pulse(1250, SERVO_PWM_1);
+    i = HAL_sim_oc_pulse_nsec(2);
+    check(i > 1240000 && i < 1260000, "RC servo pulse width on OC2");
+
+    printf("%d of %d tests passed\r\n", pass_count, test_count);
+    HAL_sim_print_stats(stdout);
+    return (pass_count == test_count ? 0 : 1);
+}
+#endif
@@ -0,0 +1,54 @@
+/*
+ * File:   HAL_pic32.c
+ * Author: Aaron Hunter
+ * Brief: PIC32MX795F512L backend of the hardware abstraction layer
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "HAL.h" // The header file for this source file.
+#include <xc.h>
+#include <sys/attribs.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define CORE_TIMER_DIV 2 // the core timer increments every other SYSCLK cycle
+#define STATUS_IE 0x1 // interrupt enable bit of the CP0 status register
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_get_cycles(void)
+ * @return CPU cycles since the core timer was last reset, wraps every 53 s
+ * @author Aaron Hunter
+ */
+HAL_cycles_t HAL_get_cycles(void) {
+    return ((HAL_cycles_t) _CP0_GET_COUNT() * CORE_TIMER_DIV);
+}
+
+/**
+ * @Function HAL_critical_enter(void)
+ * @return previous CP0 status register
+ * @author Aaron Hunter
+ */
+uint32_t HAL_critical_enter(void) {
+    return (__builtin_disable_interrupts());
+}
+
+/**
+ * @Function HAL_critical_exit(uint32_t state)
+ * @param state, CP0 status returned by HAL_critical_enter()
+ * @author Aaron Hunter
+ */
+void HAL_critical_exit(uint32_t state) {
+    if (state & STATUS_IE) {
+        __builtin_enable_interrupts();
+    }
+}
@@ -0,0 +1,205 @@
+/*
+ * File:   HAL_sim.h
+ * Author: Aaron Hunter
+ * Brief: Simulator side of the Linux HAL backend.  Host programs (unit test
+ * harnesses, SITL device models) use this to advance virtual time, attach
+ * models of the devices wired to the SPI buses and UARTs, drive input pins and
+ * read back per-interrupt cost statistics.
+ *
+ * Execution model: the firmware runs in the host thread.  Interrupts are only
+ * taken at well defined points: whenever virtual time advances
+ * (HAL_sim_poll(), HAL_sim_advance_nsec()), when the firmware re-enables
+ * interrupts, and right after an ISR returns.  ISRs never nest and the highest
+ * IPCx priority pending source wins, lowest vector number on ties.  Firmware
+ * code takes zero virtual time; peripherals take their real time (SPI and
+ * UART bytes at the configured bit rate, timers at PBCLK/prescale) except that
+ * an SPI transfer completes as soon as the firmware observes the bus.
+ *
+ * Device callbacks run from inside the register hooks and must not access
+ * SFRs through the register names, use HAL_sim_pin_get() and friends instead.
+ * Only the peripherals the lib/ drivers use are simulated: SPI1/2, UART1/2/4/5/6,
+ * Timers 2-5, OC1-5, the I/O ports, the INT0-4 external interrupt edges and the
+ * DMA channels between RAM and the SPI buffers.  A DMA cell moves at once when its start IRQ fires, so a burst paced
+ * by the SPI receive flag completes in a single firmware observation of the
+ * bus.  I2C registers exist but the bus is not modelled.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef HAL_SIM_H // Header guard
+#define	HAL_SIM_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define HAL_SIM_PB_CLOCK 80000000ul // must agree with Board_get_PB_clock()
+#define HAL_SIM_NUM_VECTORS 64
+#define HAL_SIM_DEFAULT_QUANTUM 10000 // nsec of virtual time per HAL_sim_poll()
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+/* a slave on one of the SPI buses, selected by an active low chip select */
+typedef struct {
+    uint8_t module; // SPI module number, 1 or 2
+    char cs_port; // chip select port letter, 'A' - 'G'
+    uint8_t cs_pin; // chip select pin number
+    /* called on chip select edges, selected is TRUE on the falling edge */
+    void (*select)(void *ctx, int8_t selected);
+    /* one 8/16 bit frame, returns the MISO word for the MOSI word */
+    uint32_t (*transfer)(void *ctx, uint32_t mosi);
+    void *ctx;
+} HAL_sim_spi_device_t;
+
+/* receives every byte the UART shifts out */
+typedef void (*HAL_sim_uart_sink_t)(void *ctx, uint8_t byte);
+
+/* runs once per quantum after virtual time advances, plant models live here */
+typedef void (*HAL_sim_tick_hook_t)(void *ctx, uint64_t time_nsec);
+
+typedef struct {
+    uint32_t calls; // number of times the ISR ran
+    uint64_t total_nsec; // host time spent inside the ISR
+    uint32_t max_nsec; // longest single call
+    uint64_t bytes; // bytes moved by the peripheral on this vector
+} HAL_sim_isr_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_sim_reset(void)
+ * @brief returns every register to its reset value, detaches all devices,
+ * clears the statistics and sets virtual time to zero
+ * @author Aaron Hunter
+ */
+void HAL_sim_reset(void);
+
+/**
+ * @Function HAL_sim_poll(void)
+ * @brief advances virtual time by one quantum and services the peripherals.
+ * Called from the firmware's time base (Sys_timer) so busy-wait loops progress.
+ * @author Aaron Hunter
+ */
+void HAL_sim_poll(void);
+
+/**
+ * @Function HAL_sim_advance_nsec(uint64_t nsec)
+ * @param nsec, virtual time to run, in quantum sized steps
+ * @author Aaron Hunter
+ */
+void HAL_sim_advance_nsec(uint64_t nsec);
+
+/**
+ * @Function HAL_sim_set_quantum_nsec(uint32_t nsec)
+ * @param nsec, virtual time step per poll, smaller is more accurate and slower
+ * @author Aaron Hunter
+ */
+void HAL_sim_set_quantum_nsec(uint32_t nsec);
+
+/**
+ * @Function HAL_sim_get_time_nsec(void)
+ * @return virtual time since the last reset
+ * @author Aaron Hunter
+ */
+uint64_t HAL_sim_get_time_nsec(void);
+
+/**
+ * @Function HAL_sim_set_tick_hook(HAL_sim_tick_hook_t hook, void *ctx)
+ * @param hook, called every quantum with the new virtual time, NULL removes it
+ * @param ctx, passed through to the hook
+ * @note the hook may feed UARTs, set pins and change device model state but
+ * must not access SFRs through the register names
+ * @author Aaron Hunter
+ */
+void HAL_sim_set_tick_hook(HAL_sim_tick_hook_t hook, void *ctx);
+
+/**
+ * @Function HAL_sim_spi_attach(const HAL_sim_spi_device_t *dev)
+ * @param dev, device description, must stay valid until the next reset
+ * @return SUCCESS or ERROR if the device table is full
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_spi_attach(const HAL_sim_spi_device_t *dev);
+
+/**
+ * @Function HAL_sim_uart_attach(uint8_t module, HAL_sim_uart_sink_t sink, void *ctx)
+ * @param module, UART number
+ * @param sink, called for each transmitted byte, NULL discards
+ * @note UART1 defaults to stdout so the serial console shows up on the host
+ * @author Aaron Hunter
+ */
+void HAL_sim_uart_attach(uint8_t module, HAL_sim_uart_sink_t sink, void *ctx);
+
+/**
+ * @Function HAL_sim_uart_feed(uint8_t module, const uint8_t *data, int len)
+ * @param module, UART number
+ * @param data, bytes to arrive on the RX pin back to back at the baud rate
+ * @param len, number of bytes
+ * @return number of bytes queued, less than len if the line queue is full
+ * @author Aaron Hunter
+ */
+int HAL_sim_uart_feed(uint8_t module, const uint8_t *data, int len);
+
+/**
+ * @Function HAL_sim_uart_rx_pending(uint8_t module)
+ * @return bytes queued on the line that have not reached the UART yet
+ * @author Aaron Hunter
+ */
+int HAL_sim_uart_rx_pending(uint8_t module);
+
+/**
+ * @Function HAL_sim_pin_get(char port, uint8_t pin)
+ * @return output latch level of a pin, 0 or 1
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_pin_get(char port, uint8_t pin);
+
+/**
+ * @Function HAL_sim_pin_set(char port, uint8_t pin, int8_t level)
+ * @brief drives the level seen by PORTx on an input pin, on an INTx pin the
+ * edge selected by INTCON<INTxEP> sets INTxIF
+ * @author Aaron Hunter
+ */
+void HAL_sim_pin_set(char port, uint8_t pin, int8_t level);
+
+/**
+ * @Function HAL_sim_oc_pulse_nsec(uint8_t module)
+ * @param module, output compare number
+ * @return high time of the PWM output, 0 if not in PWM mode
+ * @author Aaron Hunter
+ */
+uint32_t HAL_sim_oc_pulse_nsec(uint8_t module);
+
+/**
+ * @Function HAL_sim_get_isr_stats(uint8_t vector, HAL_sim_isr_stats_t *stats)
+ * @param vector, interrupt vector number, e.g. _SPI_1_VECTOR
+ * @param stats, filled in
+ * @author Aaron Hunter
+ */
+void HAL_sim_get_isr_stats(uint8_t vector, HAL_sim_isr_stats_t *stats);
+
+/**
+ * @Function HAL_sim_clear_stats(void)
+ * @author Aaron Hunter
+ */
+void HAL_sim_clear_stats(void);
+
+/**
+ * @Function HAL_sim_print_stats(FILE *out)
+ * @brief CSV table of every vector that ran: calls, host nsec per call, bytes
+ * moved, nsec of ISR time per byte and the byte rate that ISR cost sustains
+ * @author Aaron Hunter
+ */
+void HAL_sim_print_stats(FILE *out);
+
+#endif	/* HAL_SIM_H */ // End of header guard
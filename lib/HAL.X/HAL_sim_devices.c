@@ -0,0 +1,377 @@
+/*
+ * File:   HAL_sim_devices.c
+ * Author: Aaron Hunter
+ * Brief: Sensor models for the Linux HAL backend
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "HAL_sim_devices.h" // The header file for this source file.
+#include "Board.h"
+#include "ICM_20948_registers.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define ICM_BANK_SEL 0x7F
+#define ICM_WHO_AM_I_VAL 0xEA
+#define AK09916_WIA2_VAL 0x09
+#define AK09916_ST1_DRDY 0x01
+#define ICM_USER_CTRL_FIFO_EN 0x40
+#define ICM_FIFO_EN_ACCEL 0x10
+#define ICM_FIFO_EN_GYRO_X 0x02 // then Y and Z in the next two bits
+#define ICM_FIFO_EN_TEMP 0x01
+#define ICM_FIFO_EN_SLV_0 0x01
+#define ICM_FIFO_SNAPSHOT 0x01
+#define ICM_FIFO_COUNT_H_MASK 0x1F
+#define ICM_SLV_LENG_MASK 0x0F
+#define ICM_INT1_ACTL 0x80 // INT active low
+#define ICM_RAW_DATA_0_RDY_EN 0x01
+#define ENC_ANGLE_CMD 0x3FFF
+#define SBUS_START_BYTE 0x0F
+#define SBUS_CHANNEL_BITS 11
+#define SEC_PER_DAY 86400.0
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void icm_select(void *ctx, int8_t selected);
+static uint32_t icm_transfer(void *ctx, uint32_t mosi);
+static uint8_t icm_read(HAL_sim_icm_t *m);
+static void icm_fifo_write(HAL_sim_icm_t *m, const uint8_t *data, uint8_t length);
+static uint32_t as5047d_transfer(void *ctx, uint32_t mosi);
+static int nmea_coordinate(char *out, double degrees, int deg_digits, char pos, char neg);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_sim_icm_attach(HAL_sim_icm_t *icm, uint8_t module, char cs_port, uint8_t cs_pin)
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_icm_attach(HAL_sim_icm_t *icm, uint8_t module, char cs_port, uint8_t cs_pin) {
+    memset(icm, 0, sizeof (*icm));
+    icm->regs[0][AGB0_REG_WHO_AM_I] = ICM_WHO_AM_I_VAL;
+    icm->regs[3][AGB3_REG_I2C_SLV4_DI] = AK09916_WIA2_VAL;
+    icm->dev.module = module;
+    icm->dev.cs_port = cs_port;
+    icm->dev.cs_pin = cs_pin;
+    icm->dev.select = icm_select;
+    icm->dev.transfer = icm_transfer;
+    icm->dev.ctx = icm;
+    return HAL_sim_spi_attach(&icm->dev);
+}
+
+/**
+ * @Function HAL_sim_icm_set_data(HAL_sim_icm_t *icm, const int16_t acc[3], const int16_t gyro[3], const int16_t mag[3], int16_t temp)
+ * @author Aaron Hunter
+ */
+void HAL_sim_icm_set_data(HAL_sim_icm_t *icm, const int16_t acc[3], const int16_t gyro[3],
+        const int16_t mag[3], int16_t temp) {
+    uint8_t *out = &icm->regs[0][AGB0_REG_ACCEL_XOUT_H];
+    int i;
+    /* accel, gyro and temperature are big endian */
+    for (i = 0; i < 3; i++) {
+        out[2 * i] = (uint8_t) (acc[i] >> 8);
+        out[2 * i + 1] = (uint8_t) acc[i];
+        out[6 + 2 * i] = (uint8_t) (gyro[i] >> 8);
+        out[7 + 2 * i] = (uint8_t) gyro[i];
+    }
+    out[12] = (uint8_t) (temp >> 8);
+    out[13] = (uint8_t) temp;
+    /* the slave 0 copy of AK09916 ST1, HXL..HZH, TMPS and ST2, little endian */
+    out[14] = AK09916_ST1_DRDY;
+    for (i = 0; i < 3; i++) {
+        out[15 + 2 * i] = (uint8_t) mag[i];
+        out[16 + 2 * i] = (uint8_t) (mag[i] >> 8);
+    }
+    out[21] = 0;
+    out[22] = 0;
+}
+
+/**
+ * @Function HAL_sim_icm_sample(HAL_sim_icm_t *icm)
+ * @author Aaron Hunter
+ */
+void HAL_sim_icm_sample(HAL_sim_icm_t *icm) {
+    const uint8_t *out = &icm->regs[0][AGB0_REG_ACCEL_XOUT_H];
+    uint8_t enable = icm->regs[0][AGB0_REG_FIFO_EN_2];
+    int8_t active;
+    int i;
+    if (icm->int_port != 0 && (icm->regs[0][AGB0_REG_INT_ENABLE_1] & ICM_RAW_DATA_0_RDY_EN)) {
+        active = (icm->regs[0][AGB0_REG_INT_PIN_CONFIG] & ICM_INT1_ACTL) == 0;
+        HAL_sim_pin_set(icm->int_port, icm->int_pin, active);
+        HAL_sim_pin_set(icm->int_port, icm->int_pin, !active);
+    }
+    if ((icm->regs[0][AGB0_REG_USER_CTRL] & ICM_USER_CTRL_FIFO_EN) == 0) {
+        return;
+    }
+    if (enable & ICM_FIFO_EN_ACCEL) {
+        icm_fifo_write(icm, out, 6);
+    }
+    for (i = 0; i < 3; i++) {
+        if (enable & (ICM_FIFO_EN_GYRO_X << i)) {
+            icm_fifo_write(icm, out + 6 + 2 * i, 2);
+        }
+    }
+    if (enable & ICM_FIFO_EN_TEMP) {
+        icm_fifo_write(icm, out + 12, 2);
+    }
+    if (icm->regs[0][AGB0_REG_FIFO_EN_1] & ICM_FIFO_EN_SLV_0) {
+        icm_fifo_write(icm, out + 14, icm->regs[3][AGB3_REG_I2C_SLV0_CTRL] & ICM_SLV_LENG_MASK);
+    }
+}
+
+/**
+ * @Function HAL_sim_as5047d_attach(HAL_sim_as5047d_t *enc, uint8_t module, char cs_port, uint8_t cs_pin)
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_as5047d_attach(HAL_sim_as5047d_t *enc, uint8_t module, char cs_port, uint8_t cs_pin) {
+    enc->reply = 0;
+    enc->dev.module = module;
+    enc->dev.cs_port = cs_port;
+    enc->dev.cs_pin = cs_pin;
+    enc->dev.select = NULL;
+    enc->dev.transfer = as5047d_transfer;
+    enc->dev.ctx = enc;
+    return HAL_sim_spi_attach(&enc->dev);
+}
+
+/**
+ * @Function HAL_sim_nmea_rmc(char *out, double time, double lat, double lon, float speed, float cog)
+ * @author Aaron Hunter
+ */
+int HAL_sim_nmea_rmc(char *out, double time, double lat, double lon, float speed, float cog) {
+    char body[HAL_SIM_NMEA_MAX_LENGTH];
+    uint8_t checksum = 0;
+    int hours;
+    int minutes;
+    int length;
+    int i;
+
+    time = fmod(time, SEC_PER_DAY);
+    hours = (int) (time / 3600.0);
+    minutes = (int) ((time - hours * 3600.0) / 60.0);
+    length = sprintf(body, "GNRMC,%02d%02d%05.2f,A,", hours, minutes,
+            time - hours * 3600.0 - minutes * 60.0);
+    length += nmea_coordinate(body + length, lat, 2, 'N', 'S');
+    length += nmea_coordinate(body + length, lon, 3, 'E', 'W');
+    sprintf(body + length, "%.3f,%.2f,100820,,,D", speed, cog);
+    for (i = 0; body[i] != '\0'; i++) {
+        checksum ^= (uint8_t) body[i];
+    }
+    return sprintf(out, "$%s*%02X\r\n", body, checksum);
+}
+
+/**
+ * @Function HAL_sim_sbus_frame(uint8_t *frame, const uint16_t *channels)
+ * @author Aaron Hunter
+ */
+void HAL_sim_sbus_frame(uint8_t *frame, const uint16_t *channels) {
+    int ch;
+    int bit;
+    int pos = 0;
+    memset(frame, 0, HAL_SIM_SBUS_FRAME_LENGTH);
+    frame[0] = SBUS_START_BYTE;
+    for (ch = 0; ch < HAL_SIM_SBUS_CHANNELS; ch++) {
+        for (bit = 0; bit < SBUS_CHANNEL_BITS; bit++, pos++) {
+            if (channels[ch] & (1 << bit)) {
+                frame[1 + pos / 8] |= (1 << (pos % 8));
+            }
+        }
+    }
+    /* frame[23] flags and frame[24] end byte stay zero */
+}
+
+/**
+ * @Function HAL_sim_uncalibrate(float A[3][3], float b[3], const double cal[3], double nominal, double raw[3])
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_uncalibrate(float A[3][3], float b[3], const double cal[3], double nominal,
+        double raw[3]) {
+    double r[3];
+    double det;
+    int i;
+    det = A[0][0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+            - A[0][1] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+            + A[0][2] * (A[1][0] * A[2][1] - A[1][1] * A[2][0]);
+    if (fabs(det) < 1e-30) {
+        for (i = 0; i < 3; i++) {
+            raw[i] = cal[i] * nominal;
+        }
+        return ERROR;
+    }
+    for (i = 0; i < 3; i++) {
+        r[i] = cal[i] - b[i];
+    }
+    /* Cramer's rule */
+    raw[0] = (r[0] * (A[1][1] * A[2][2] - A[1][2] * A[2][1])
+            - A[0][1] * (r[1] * A[2][2] - A[1][2] * r[2])
+            + A[0][2] * (r[1] * A[2][1] - A[1][1] * r[2])) / det;
+    raw[1] = (A[0][0] * (r[1] * A[2][2] - A[1][2] * r[2])
+            - r[0] * (A[1][0] * A[2][2] - A[1][2] * A[2][0])
+            + A[0][2] * (A[1][0] * r[2] - r[1] * A[2][0])) / det;
+    raw[2] = (A[0][0] * (A[1][1] * r[2] - r[1] * A[2][1])
+            - A[0][1] * (A[1][0] * r[2] - r[1] * A[2][0])
+            + r[0] * (A[1][0] * A[2][1] - A[1][1] * A[2][0])) / det;
+    return SUCCESS;
+}
+
+/**
+ * @Function HAL_sim_counts(double counts)
+ * @author Aaron Hunter
+ */
+int16_t HAL_sim_counts(double counts) {
+    if (counts > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (counts < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t) lround(counts);
+}
+
+/**
+ * @Function HAL_sim_gauss(uint64_t *state)
+ * @brief Box-Muller on two xorshift64 draws
+ * @author Aaron Hunter
+ */
+double HAL_sim_gauss(uint64_t *state) {
+    double u1;
+    double u2;
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    u1 = ((*state >> 11) + 1.0) / 9007199254740993.0;
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    u2 = (*state >> 11) / 9007199254740992.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+static void icm_select(void *ctx, int8_t selected) {
+    HAL_sim_icm_t *m = ctx;
+    m->first_byte = selected;
+    if (selected) {
+        m->transactions++;
+    }
+}
+
+/**
+ * @Function icm_transfer(void *ctx, uint32_t mosi)
+ * @brief the first byte after chip select is R/W and the register address,
+ * the address then auto increments within the selected bank
+ */
+static uint32_t icm_transfer(void *ctx, uint32_t mosi) {
+    HAL_sim_icm_t *m = ctx;
+    uint8_t value = 0;
+    if (m->first_byte) {
+        m->first_byte = FALSE;
+        m->reading = (mosi >> 7) & 0x1;
+        m->address = mosi & 0x7F;
+        return 0;
+    }
+    if (m->reading) {
+        value = icm_read(m);
+        if (m->bank == 0 && m->address == AGB0_REG_FIFO_R_W) {
+            return value; // a burst keeps reading the FIFO
+        }
+    } else if (m->address == ICM_BANK_SEL) {
+        m->bank = mosi & 0x30;
+    } else if (m->bank == 0x30 && m->address == AGB3_REG_I2C_SLV4_CTRL) {
+        m->regs[3][m->address] = mosi & 0x7F; // slave 4 transaction completes at once
+    } else {
+        m->regs[m->bank >> 4][m->address] = mosi;
+        if (m->bank == 0 && m->address == AGB0_REG_FIFO_RST && (mosi & 0x1F)) {
+            m->fifo_head = 0;
+            m->fifo_count = 0;
+        }
+    }
+    m->address = (m->address + 1) & 0x7F;
+    return value;
+}
+
+/**
+ * @Function icm_read(HAL_sim_icm_t *m)
+ * @brief the register at the burst address, FIFO reads have side effects
+ */
+static uint8_t icm_read(HAL_sim_icm_t *m) {
+    uint8_t value;
+    if (m->address == ICM_BANK_SEL) {
+        return m->bank;
+    }
+    if (m->bank != 0) {
+        return m->regs[m->bank >> 4][m->address];
+    }
+    switch (m->address) {
+        case AGB0_REG_FIFO_COUNT_H:
+            m->fifo_count_l = (uint8_t) m->fifo_count;
+            m->fifo_count_reads++;
+            return (m->fifo_count >> 8) & ICM_FIFO_COUNT_H_MASK;
+        case AGB0_REG_FIFO_COUNT_L:
+            return m->fifo_count_l;
+        case AGB0_REG_FIFO_R_W:
+            if (m->fifo_count == 0) {
+                return 0xFF;
+            }
+            value = m->fifo[m->fifo_head];
+            m->fifo_head = (m->fifo_head + 1) % HAL_SIM_ICM_FIFO_SIZE;
+            m->fifo_count--;
+            return value;
+        default:
+            return m->regs[0][m->address];
+    }
+}
+
+/**
+ * @Function icm_fifo_write(HAL_sim_icm_t *m, const uint8_t *data, uint8_t length)
+ * @brief appends bytes, a full FIFO in snapshot mode keeps its contents and in
+ * stream mode loses the oldest byte
+ */
+static void icm_fifo_write(HAL_sim_icm_t *m, const uint8_t *data, uint8_t length) {
+    uint8_t i;
+    for (i = 0; i < length; i++) {
+        if (m->fifo_count == HAL_SIM_ICM_FIFO_SIZE) {
+            m->fifo_dropped++;
+            if (m->regs[0][AGB0_REG_FIFO_MODE] & ICM_FIFO_SNAPSHOT) {
+                continue;
+            }
+            m->fifo_head = (m->fifo_head + 1) % HAL_SIM_ICM_FIFO_SIZE;
+            m->fifo_count--;
+        }
+        m->fifo[(m->fifo_head + m->fifo_count) % HAL_SIM_ICM_FIFO_SIZE] = data[i];
+        m->fifo_count++;
+    }
+}
+
+static uint32_t as5047d_transfer(void *ctx, uint32_t mosi) {
+    HAL_sim_as5047d_t *m = ctx;
+    uint16_t reply = m->reply;
+    m->reply = ((mosi & 0x3FFF) == ENC_ANGLE_CMD) ? (m->angle & 0x3FFF) : 0;
+    return reply;
+}
+
+/**
+ * @Function nmea_coordinate(char *out, double degrees, int deg_digits, char pos, char neg)
+ * @brief writes "dddmm.mmmmm,H," with the hemisphere letter
+ */
+static int nmea_coordinate(char *out, double degrees, int deg_digits, char pos, char neg) {
+    char hemisphere = degrees < 0 ? neg : pos;
+    int whole;
+    degrees = fabs(degrees);
+    whole = (int) degrees;
+    return sprintf(out, "%0*d%08.5f,%c,", deg_digits, whole, (degrees - whole) * 60.0, hemisphere);
+}
@@ -0,0 +1,165 @@
+/*
+ * File:   HAL_sim_devices.h
+ * Author: Aaron Hunter
+ * Brief: Models of the sensors wired to the OSAVC board for the Linux HAL
+ * backend.  The SPI devices (ICM-20948, AS5047D) answer the drivers' register
+ * traffic, the serial devices (NEO-M8N, SBUS receiver) are byte generators to
+ * pass to HAL_sim_uart_feed().  Shared by the HAL self test and the SITL
+ * targets.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef HAL_SIM_DEVICES_H // Header guard
+#define	HAL_SIM_DEVICES_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "HAL_sim.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define HAL_SIM_SBUS_FRAME_LENGTH 25
+#define HAL_SIM_SBUS_CHANNELS 16
+#define HAL_SIM_NMEA_MAX_LENGTH 96 // longest sentence HAL_sim_nmea_rmc() emits
+#define HAL_SIM_AS5047D_COUNTS 16384 // 14 bit angle
+#define HAL_SIM_ICM_FIFO_SIZE 512
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+/* ICM-20948 register file, four user banks, with the AK09916 behind the
+ * auxiliary I2C master.  Slave 4 transactions complete immediately.  The FIFO
+ * fills on HAL_sim_icm_sample(), reads of FIFO_R_W pop it without advancing
+ * the burst address and reading FIFO_COUNT_H latches FIFO_COUNT_L.  Set
+ * int_port and int_pin after attaching to wire the INT output. */
+typedef struct {
+    HAL_sim_spi_device_t dev;
+    uint8_t regs[4][128];
+    uint8_t bank;
+    uint8_t address;
+    int8_t first_byte;
+    int8_t reading;
+    uint32_t transactions; // chip select falling edges, one per burst read
+    uint8_t fifo[HAL_SIM_ICM_FIFO_SIZE];
+    uint16_t fifo_head;
+    uint16_t fifo_count;
+    uint8_t fifo_count_l; // latched by reading FIFO_COUNT_H
+    uint32_t fifo_count_reads; // FIFO_COUNT_H reads, one per FIFO mode read
+    uint32_t fifo_dropped; // bytes lost to a full FIFO
+    char int_port; // INT output, 0 if not wired
+    uint8_t int_pin;
+} HAL_sim_icm_t;
+
+/* AS5047D angle sensor, replies to each command in the following frame */
+typedef struct {
+    HAL_sim_spi_device_t dev;
+    uint16_t angle; // 0 - 16383
+    uint16_t reply;
+} HAL_sim_as5047d_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function HAL_sim_icm_attach(HAL_sim_icm_t *icm, uint8_t module, char cs_port, uint8_t cs_pin)
+ * @param icm, model storage, must stay valid until the next HAL_sim_reset()
+ * @param module, SPI module
+ * @param cs_port, chip select port letter
+ * @param cs_pin, chip select pin
+ * @return SUCCESS or ERROR
+ * @brief loads the WHO_AM_I values the driver checks and attaches the model
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_icm_attach(HAL_sim_icm_t *icm, uint8_t module, char cs_port, uint8_t cs_pin);
+
+/**
+ * @Function HAL_sim_icm_set_data(HAL_sim_icm_t *icm, const int16_t acc[3], const int16_t gyro[3], const int16_t mag[3], int16_t temp)
+ * @param acc, accelerometer counts in the ICM axes
+ * @param gyro, gyro counts in the ICM axes
+ * @param mag, magnetometer counts in the AK09916 axes
+ * @param temp, temperature counts
+ * @brief updates the output registers the driver burst reads
+ * @author Aaron Hunter
+ */
+void HAL_sim_icm_set_data(HAL_sim_icm_t *icm, const int16_t acc[3], const int16_t gyro[3],
+        const int16_t mag[3], int16_t temp);
+
+/**
+ * @Function HAL_sim_icm_sample(HAL_sim_icm_t *icm)
+ * @brief one output data rate tick: appends the output registers enabled in
+ * FIFO_EN_1 and FIFO_EN_2 to the FIFO, in register order, if USER_CTRL has
+ * the FIFO on.  A full FIFO drops the rest in snapshot mode and the oldest
+ * bytes in stream mode, the packets then lose alignment as on the device.
+ * With RAW_DATA_0_RDY_EN set a wired INT pin pulses at the INT_PIN_CFG
+ * level, the 50 usec pulse takes no virtual time.
+ * @author Aaron Hunter
+ */
+void HAL_sim_icm_sample(HAL_sim_icm_t *icm);
+
+/**
+ * @Function HAL_sim_as5047d_attach(HAL_sim_as5047d_t *enc, uint8_t module, char cs_port, uint8_t cs_pin)
+ * @param enc, model storage, must stay valid until the next HAL_sim_reset()
+ * @return SUCCESS or ERROR
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_as5047d_attach(HAL_sim_as5047d_t *enc, uint8_t module, char cs_port, uint8_t cs_pin);
+
+/**
+ * @Function HAL_sim_nmea_rmc(char *out, double time, double lat, double lon, float speed, float cog)
+ * @param out, at least HAL_SIM_NMEA_MAX_LENGTH bytes
+ * @param time, UTC seconds since midnight
+ * @param lat, latitude in degrees, north positive
+ * @param lon, longitude in degrees, east positive
+ * @param speed, speed over ground in knots
+ * @param cog, course over ground in degrees
+ * @return sentence length, including the checksum and CR LF
+ * @author Aaron Hunter
+ */
+int HAL_sim_nmea_rmc(char *out, double time, double lat, double lon, float speed, float cog);
+
+/**
+ * @Function HAL_sim_sbus_frame(uint8_t *frame, const uint16_t *channels)
+ * @param frame, HAL_SIM_SBUS_FRAME_LENGTH bytes
+ * @param channels, HAL_SIM_SBUS_CHANNELS 11 bit values
+ * @brief packs one SBUS frame, no failsafe or frame lost flags
+ * @author Aaron Hunter
+ */
+void HAL_sim_sbus_frame(uint8_t *frame, const uint16_t *channels);
+
+/**
+ * @Function HAL_sim_uncalibrate(float A[3][3], float b[3], const double cal[3], double nominal, double raw[3])
+ * @param A, b, the calibration the firmware applies, cal = A raw + b
+ * @param cal, physical value the calibrated reading should come out as
+ * @param nominal, counts per unit used while A is all zero (not loaded yet)
+ * @param raw, sensor counts, unrounded
+ * @return SUCCESS or ERROR if A is singular and the nominal scale was used
+ * @brief inverts a sensor calibration so a model can write counts that the
+ * firmware turns back into the physical value
+ * @author Aaron Hunter
+ */
+int8_t HAL_sim_uncalibrate(float A[3][3], float b[3], const double cal[3], double nominal,
+        double raw[3]);
+
+/**
+ * @Function HAL_sim_counts(double counts)
+ * @return counts rounded and saturated to a 16 bit register
+ * @author Aaron Hunter
+ */
+int16_t HAL_sim_counts(double counts);
+
+/**
+ * @Function HAL_sim_gauss(uint64_t *state)
+ * @param state, xorshift generator state, seed with any non-zero value
+ * @return unit normal deviate, runs repeat for the same seed
+ * @author Aaron Hunter
+ */
+double HAL_sim_gauss(uint64_t *state);
+
+#endif	/* HAL_SIM_DEVICES_H */ // End of header guard
@@ -0,0 +1,961 @@
+/*
+ * File:   p32mx795f512l.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) stand-in for the XC32 device header.  Declares the
+ * special function registers used by the lib/ drivers as simulated storage
+ * owned by HAL_linux.c so the drivers compile unmodified with gcc.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef P32MX795F512L_HOST_H // Header guard
+#define	P32MX795F512L_HOST_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+/* HAL_linux.c defines HAL_SFR_DEFINE before including this file to allocate
+ * the register storage, everyone else gets extern declarations */
+#ifdef HAL_SFR_DEFINE
+#define HAL_SFR volatile
+#else
+#define HAL_SFR extern volatile
+#endif
+
+/* interrupt vector numbers, these match the PIC32MX795F512L vector table */
+#define _CORE_TIMER_VECTOR 0
+#define _EXTERNAL_0_VECTOR 3
+#define _TIMER_1_VECTOR 4
+#define _EXTERNAL_1_VECTOR 7
+#define _TIMER_2_VECTOR 8
+#define _EXTERNAL_2_VECTOR 11
+#define _TIMER_3_VECTOR 12
+#define _EXTERNAL_3_VECTOR 15
+#define _TIMER_4_VECTOR 16
+#define _EXTERNAL_4_VECTOR 19
+#define _TIMER_5_VECTOR 20
+#define _SPI_1_VECTOR 23
+#define _UART_1_VECTOR 24
+#define _I2C_1_VECTOR 25
+#define _I2C1_VECTOR 25
+#define _CHANGE_NOTICE_VECTOR 26
+#define _ADC_VECTOR 27
+#define _SPI_2_VECTOR 31
+#define _UART_2_VECTOR 32
+#define _I2C_2_VECTOR 33
+#define _I2C2_VECTOR 33
+#define _DMA_0_VECTOR 36
+#define _DMA_1_VECTOR 37
+#define _DMA_2_VECTOR 38
+#define _DMA_3_VECTOR 39
+#define _DMA_4_VECTOR 40
+#define _DMA_5_VECTOR 41
+#define _DMA_6_VECTOR 42
+#define _DMA_7_VECTOR 43
+#define _UART_4_VECTOR 49
+#define _UART_6_VECTOR 50
+#define _UART_5_VECTOR 51
+
+/* interrupt request numbers, bit n of IFS0 is IRQ n, bit n of IFS1 IRQ 32 + n,
+ * the DMA channels are started by these */
+#define _SPI1_RX_IRQ 24
+#define _SPI1_TX_IRQ 25
+#define _SPI2_RX_IRQ 38
+#define _SPI2_TX_IRQ 39
+#define _DMA0_IRQ 48
+#define _DMA1_IRQ 49
+
+/* CP0 access is meaningless on the host, cache setup becomes a no-op and the
+ * core timer is derived from simulated time (SYSCLK/2) */
+#define _CP0_CONFIG 16
+#define _CP0_CONFIG_SELECT 0
+#define _CP0_COUNT 9
+#define _CP0_COUNT_SELECT 0
+#define __builtin_mtc0(reg, sel, val) ((void) (val))
+#define __builtin_mfc0(reg, sel) (0u)
+#define _CP0_GET_COUNT() HAL_sim_core_timer()
+#define _CP0_SET_COUNT(val) HAL_sim_set_core_timer(val)
+#define __builtin_disable_interrupts() HAL_sim_disable_interrupts()
+#define __builtin_enable_interrupts() HAL_sim_enable_interrupts()
+#define Nop() ((void) 0)
+#define _nop() ((void) 0)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+/* Each register is a union of the named bit fields the drivers use and the
+ * full 32 bit word.  Bit positions follow the PIC32MX5XX/6XX/7XX datasheet. */
+
+typedef union {
+    struct {
+        unsigned SRXISEL : 2;
+        unsigned STXISEL : 2;
+        unsigned DISSDI : 1;
+        unsigned MSTEN : 1;
+        unsigned CKP : 1;
+        unsigned SSEN : 1;
+        unsigned CKE : 1;
+        unsigned SMP : 1;
+        unsigned MODE16 : 1;
+        unsigned MODE32 : 1;
+        unsigned DISSDO : 1;
+        unsigned SIDL : 1;
+        unsigned FRZ : 1;
+        unsigned ON : 1;
+        unsigned : 1;
+        unsigned SPIFE : 1;
+        unsigned : 5;
+        unsigned MCLKSEL : 1;
+        unsigned FRMCNT : 3;
+        unsigned FRMSYPW : 1;
+        unsigned MSSEN : 1;
+        unsigned FRMPOL : 1;
+        unsigned FRMSYNC : 1;
+        unsigned FRMEN : 1;
+    };
+    uint32_t w;
+} __SPIxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned SPIRBF : 1;
+        unsigned SPITBF : 1;
+        unsigned : 1;
+        unsigned SPITBE : 1;
+        unsigned : 1;
+        unsigned SPIRBE : 1;
+        unsigned SPIROV : 1;
+        unsigned SRMT : 1;
+        unsigned SPITUR : 1;
+        unsigned : 2;
+        unsigned SPIBUSY : 1;
+        unsigned : 4;
+        unsigned TXBUFELM : 5;
+        unsigned : 3;
+        unsigned RXBUFELM : 5;
+    };
+    uint32_t w;
+} __SPIxSTATbits_t;
+
+typedef struct {
+    __SPIxCONbits_t CON;
+    __SPIxSTATbits_t STAT;
+    uint32_t BRG;
+} HAL_spi_regs_t;
+
+typedef union {
+    struct {
+        unsigned STSEL : 1;
+        unsigned PDSEL : 2;
+        unsigned BRGH : 1;
+        unsigned RXINV : 1;
+        unsigned ABAUD : 1;
+        unsigned LPBACK : 1;
+        unsigned WAKE : 1;
+        unsigned UEN : 2;
+        unsigned : 1;
+        unsigned RTSMD : 1;
+        unsigned IREN : 1;
+        unsigned SIDL : 1;
+        unsigned FRZ : 1;
+        unsigned ON : 1;
+    };
+    uint32_t w;
+} __UxMODEbits_t;
+
+typedef union {
+    struct {
+        unsigned URXDA : 1;
+        unsigned OERR : 1;
+        unsigned FERR : 1;
+        unsigned PERR : 1;
+        unsigned RIDLE : 1;
+        unsigned ADDEN : 1;
+        unsigned URXISEL : 2;
+        unsigned TRMT : 1;
+        unsigned UTXBF : 1;
+        unsigned UTXEN : 1;
+        unsigned UTXBRK : 1;
+        unsigned URXEN : 1;
+        unsigned UTXINV : 1;
+        unsigned UTXISEL : 2;
+        unsigned ADDR : 8;
+        unsigned ADM_EN : 1;
+    };
+    uint32_t w;
+} __UxSTAbits_t;
+
+typedef struct {
+    __UxMODEbits_t MODE;
+    __UxSTAbits_t STA;
+    uint32_t BRG;
+} HAL_uart_regs_t;
+
+typedef union {
+    struct {
+        unsigned : 1;
+        unsigned TCS : 1;
+        unsigned : 1;
+        unsigned T32 : 1;
+        unsigned TCKPS : 3;
+        unsigned TGATE : 1;
+        unsigned : 5;
+        unsigned SIDL : 1;
+        unsigned : 1;
+        unsigned ON : 1;
+    };
+    uint32_t w;
+} __TxCONbits_t;
+
+typedef struct {
+    __TxCONbits_t CON;
+    uint32_t TMR;
+    uint32_t PR;
+} HAL_timer_regs_t;
+
+typedef union {
+    struct {
+        unsigned OCM : 3;
+        unsigned OCTSEL : 1;
+        unsigned OCFLT : 1;
+        unsigned OC32 : 1;
+        unsigned : 7;
+        unsigned SIDL : 1;
+        unsigned : 1;
+        unsigned ON : 1;
+    };
+    uint32_t w;
+} __OCxCONbits_t;
+
+typedef struct {
+    __OCxCONbits_t CON;
+    uint32_t R;
+    uint32_t RS;
+} HAL_oc_regs_t;
+
+typedef union {
+    struct {
+        unsigned SEN : 1;
+        unsigned RSEN : 1;
+        unsigned PEN : 1;
+        unsigned RCEN : 1;
+        unsigned ACKEN : 1;
+        unsigned ACKDT : 1;
+        unsigned STREN : 1;
+        unsigned GCEN : 1;
+        unsigned SMEN : 1;
+        unsigned DISSLW : 1;
+        unsigned A10M : 1;
+        unsigned STRICT : 1;
+        unsigned SCLREL : 1;
+        unsigned SIDL : 1;
+        unsigned : 1;
+        unsigned ON : 1;
+    };
+    uint32_t w;
+} __I2CxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned TBF : 1;
+        unsigned RBF : 1;
+        unsigned R_W : 1;
+        unsigned S : 1;
+        unsigned P : 1;
+        unsigned D_A : 1;
+        unsigned I2COV : 1;
+        unsigned IWCOL : 1;
+        unsigned ADD10 : 1;
+        unsigned GCSTAT : 1;
+        unsigned BCL : 1;
+        unsigned : 3;
+        unsigned TRSTAT : 1;
+        unsigned ACKSTAT : 1;
+    };
+    uint32_t w;
+} __I2CxSTATbits_t;
+
+typedef struct {
+    __I2CxCONbits_t CON;
+    __I2CxSTATbits_t STAT;
+    uint32_t BRG;
+    uint32_t TRN;
+    uint32_t RCV;
+} HAL_i2c_regs_t;
+
+typedef union {
+    struct {
+        unsigned : 11;
+        unsigned DMABUSY : 1;
+        unsigned SUSPEND : 1;
+        unsigned : 2;
+        unsigned ON : 1;
+    };
+    uint32_t w;
+} __DMACONbits_t;
+
+typedef union {
+    struct {
+        unsigned CHPRI : 2;
+        unsigned CHEDET : 1;
+        unsigned : 1;
+        unsigned CHAEN : 1;
+        unsigned CHCHN : 1;
+        unsigned CHAED : 1;
+        unsigned CHEN : 1;
+        unsigned CHCHNS : 1;
+        unsigned : 6;
+        unsigned CHBUSY : 1;
+    };
+    uint32_t w;
+} __DCHxCONbits_t;
+
+typedef union {
+    struct {
+        unsigned : 3;
+        unsigned AIRQEN : 1;
+        unsigned SIRQEN : 1;
+        unsigned PATEN : 1;
+        unsigned CABORT : 1;
+        unsigned CFORCE : 1;
+        unsigned CHSIRQ : 8;
+        unsigned CHAIRQ : 8;
+    };
+    uint32_t w;
+} __DCHxECONbits_t;
+
+typedef union {
+    struct {
+        unsigned CHERIF : 1;
+        unsigned CHTAIF : 1;
+        unsigned CHCCIF : 1;
+        unsigned CHBCIF : 1;
+        unsigned CHDHIF : 1;
+        unsigned CHDDIF : 1;
+        unsigned CHSHIF : 1;
+        unsigned CHSDIF : 1;
+        unsigned : 8;
+        unsigned CHERIE : 1;
+        unsigned CHTAIE : 1;
+        unsigned CHCCIE : 1;
+        unsigned CHBCIE : 1;
+        unsigned CHDHIE : 1;
+        unsigned CHDDIE : 1;
+        unsigned CHSHIE : 1;
+        unsigned CHSDIE : 1;
+    };
+    uint32_t w;
+} __DCHxINTbits_t;
+
+/* addresses are physical, see KVA_TO_PA() in linux/sys/kmem.h, sizes are
+ * 8 bits with 0 meaning 256 bytes and the pointers are read only */
+typedef struct {
+    __DCHxCONbits_t CON;
+    __DCHxECONbits_t ECON;
+    __DCHxINTbits_t INT;
+    uint32_t SSA;
+    uint32_t DSA;
+    uint32_t SSIZ;
+    uint32_t DSIZ;
+    uint32_t SPTR;
+    uint32_t DPTR;
+    uint32_t CSIZ;
+    uint32_t CPTR;
+    uint32_t DAT;
+} HAL_dma_regs_t;
+
+/* I/O ports, one bit field per pin named the way XC32 names them */
+#define HAL_PORT_PINS(p) \
+    unsigned p##0 : 1; unsigned p##1 : 1; unsigned p##2 : 1; unsigned p##3 : 1; \
+    unsigned p##4 : 1; unsigned p##5 : 1; unsigned p##6 : 1; unsigned p##7 : 1; \
+    unsigned p##8 : 1; unsigned p##9 : 1; unsigned p##10 : 1; unsigned p##11 : 1; \
+    unsigned p##12 : 1; unsigned p##13 : 1; unsigned p##14 : 1; unsigned p##15 : 1;
+
+#define HAL_PORT_TYPES(x) \
+    typedef union { struct { HAL_PORT_PINS(LAT##x) }; uint32_t w; } __LAT##x##bits_t; \
+    typedef union { struct { HAL_PORT_PINS(TRIS##x) }; uint32_t w; } __TRIS##x##bits_t; \
+    typedef union { struct { HAL_PORT_PINS(R##x) }; uint32_t w; } __PORT##x##bits_t; \
+    typedef union { struct { HAL_PORT_PINS(ODC##x) }; uint32_t w; } __ODC##x##bits_t;
+
+HAL_PORT_TYPES(A)
+HAL_PORT_TYPES(B)
+HAL_PORT_TYPES(C)
+HAL_PORT_TYPES(D)
+HAL_PORT_TYPES(E)
+HAL_PORT_TYPES(F)
+HAL_PORT_TYPES(G)
+
+typedef struct {
+    uint32_t TRIS;
+    uint32_t PORT;
+    uint32_t LAT;
+    uint32_t ODC;
+} HAL_port_regs_t;
+
+typedef union {
+    struct {
+        unsigned CTIF : 1;
+        unsigned CS0IF : 1;
+        unsigned CS1IF : 1;
+        unsigned INT0IF : 1;
+        unsigned T1IF : 1;
+        unsigned IC1IF : 1;
+        unsigned OC1IF : 1;
+        unsigned INT1IF : 1;
+        unsigned T2IF : 1;
+        unsigned IC2IF : 1;
+        unsigned OC2IF : 1;
+        unsigned INT2IF : 1;
+        unsigned T3IF : 1;
+        unsigned IC3IF : 1;
+        unsigned OC3IF : 1;
+        unsigned INT3IF : 1;
+        unsigned T4IF : 1;
+        unsigned IC4IF : 1;
+        unsigned OC4IF : 1;
+        unsigned INT4IF : 1;
+        unsigned T5IF : 1;
+        unsigned IC5IF : 1;
+        unsigned OC5IF : 1;
+        unsigned SPI1EIF : 1;
+        unsigned SPI1RXIF : 1;
+        unsigned SPI1TXIF : 1;
+        unsigned U1EIF : 1;
+        unsigned U1RXIF : 1;
+        unsigned U1TXIF : 1;
+        unsigned I2C1BIF : 1;
+        unsigned I2C1SIF : 1;
+        unsigned I2C1MIF : 1;
+    };
+    uint32_t w;
+} __IFS0bits_t;
+
+typedef union {
+    struct {
+        unsigned CTIE : 1;
+        unsigned CS0IE : 1;
+        unsigned CS1IE : 1;
+        unsigned INT0IE : 1;
+        unsigned T1IE : 1;
+        unsigned IC1IE : 1;
+        unsigned OC1IE : 1;
+        unsigned INT1IE : 1;
+        unsigned T2IE : 1;
+        unsigned IC2IE : 1;
+        unsigned OC2IE : 1;
+        unsigned INT2IE : 1;
+        unsigned T3IE : 1;
+        unsigned IC3IE : 1;
+        unsigned OC3IE : 1;
+        unsigned INT3IE : 1;
+        unsigned T4IE : 1;
+        unsigned IC4IE : 1;
+        unsigned OC4IE : 1;
+        unsigned INT4IE : 1;
+        unsigned T5IE : 1;
+        unsigned IC5IE : 1;
+        unsigned OC5IE : 1;
+        unsigned SPI1EIE : 1;
+        unsigned SPI1RXIE : 1;
+        unsigned SPI1TXIE : 1;
+        unsigned U1EIE : 1;
+        unsigned U1RXIE : 1;
+        unsigned U1TXIE : 1;
+        unsigned I2C1BIE : 1;
+        unsigned I2C1SIE : 1;
+        unsigned I2C1MIE : 1;
+    };
+    uint32_t w;
+} __IEC0bits_t;
+
+typedef union {
+    struct {
+        unsigned CNIF : 1;
+        unsigned AD1IF : 1;
+        unsigned PMPIF : 1;
+        unsigned CMP1IF : 1;
+        unsigned CMP2IF : 1;
+        unsigned SPI2EIF : 1;
+        unsigned SPI2RXIF : 1;
+        unsigned SPI2TXIF : 1;
+        unsigned U2EIF : 1;
+        unsigned U2RXIF : 1;
+        unsigned U2TXIF : 1;
+        unsigned I2C2BIF : 1;
+        unsigned I2C2SIF : 1;
+        unsigned I2C2MIF : 1;
+        unsigned FSCMIF : 1;
+        unsigned RTCCIF : 1;
+        unsigned DMA0IF : 1;
+        unsigned DMA1IF : 1;
+        unsigned DMA2IF : 1;
+        unsigned DMA3IF : 1;
+        unsigned DMA4IF : 1;
+        unsigned DMA5IF : 1;
+        unsigned DMA6IF : 1;
+        unsigned DMA7IF : 1;
+        unsigned FCEIF : 1;
+        unsigned USBIF : 1;
+        unsigned CAN1IF : 1;
+        unsigned CAN2IF : 1;
+        unsigned ETHIF : 1;
+        unsigned : 3;
+    };
+    uint32_t w;
+} __IFS1bits_t;
+
+typedef union {
+    struct {
+        unsigned CNIE : 1;
+        unsigned AD1IE : 1;
+        unsigned PMPIE : 1;
+        unsigned CMP1IE : 1;
+        unsigned CMP2IE : 1;
+        unsigned SPI2EIE : 1;
+        unsigned SPI2RXIE : 1;
+        unsigned SPI2TXIE : 1;
+        unsigned U2EIE : 1;
+        unsigned U2RXIE : 1;
+        unsigned U2TXIE : 1;
+        unsigned I2C2BIE : 1;
+        unsigned I2C2SIE : 1;
+        unsigned I2C2MIE : 1;
+        unsigned FSCMIE : 1;
+        unsigned RTCCIE : 1;
+        unsigned DMA0IE : 1;
+        unsigned DMA1IE : 1;
+        unsigned DMA2IE : 1;
+        unsigned DMA3IE : 1;
+        unsigned DMA4IE : 1;
+        unsigned DMA5IE : 1;
+        unsigned DMA6IE : 1;
+        unsigned DMA7IE : 1;
+        unsigned FCEIE : 1;
+        unsigned USBIE : 1;
+        unsigned CAN1IE : 1;
+        unsigned CAN2IE : 1;
+        unsigned ETHIE : 1;
+        unsigned : 3;
+    };
+    uint32_t w;
+} __IEC1bits_t;
+
+typedef union {
+    struct {
+        unsigned IC3EIF : 1;
+        unsigned IC4EIF : 1;
+        unsigned IC5EIF : 1;
+        unsigned : 5;
+        unsigned U4EIF : 1;
+        unsigned U4RXIF : 1;
+        unsigned U4TXIF : 1;
+        unsigned U6EIF : 1;
+        unsigned U6RXIF : 1;
+        unsigned U6TXIF : 1;
+        unsigned U5EIF : 1;
+        unsigned U5RXIF : 1;
+        unsigned U5TXIF : 1;
+        unsigned : 15;
+    };
+    uint32_t w;
+} __IFS2bits_t;
+
+typedef union {
+    struct {
+        unsigned IC3EIE : 1;
+        unsigned IC4EIE : 1;
+        unsigned IC5EIE : 1;
+        unsigned : 5;
+        unsigned U4EIE : 1;
+        unsigned U4RXIE : 1;
+        unsigned U4TXIE : 1;
+        unsigned U6EIE : 1;
+        unsigned U6RXIE : 1;
+        unsigned U6TXIE : 1;
+        unsigned U5EIE : 1;
+        unsigned U5RXIE : 1;
+        unsigned U5TXIE : 1;
+        unsigned : 15;
+    };
+    uint32_t w;
+} __IEC2bits_t;
+
+/* interrupt priority registers, four sources of IS<1:0>/IP<2:0> per word */
+#define HAL_IPC_FIELDS(a, b, c, d) \
+    unsigned a##IS : 2; unsigned a##IP : 3; unsigned : 3; \
+    unsigned b##IS : 2; unsigned b##IP : 3; unsigned : 3; \
+    unsigned c##IS : 2; unsigned c##IP : 3; unsigned : 3; \
+    unsigned d##IS : 2; unsigned d##IP : 3; unsigned : 3;
+
+typedef union { struct { HAL_IPC_FIELDS(CT, CS0, CS1, INT0) }; uint32_t w; } __IPC0bits_t;
+typedef union { struct { HAL_IPC_FIELDS(T1, IC1, OC1, INT1) }; uint32_t w; } __IPC1bits_t;
+typedef union { struct { HAL_IPC_FIELDS(T2, IC2, OC2, INT2) }; uint32_t w; } __IPC2bits_t;
+typedef union { struct { HAL_IPC_FIELDS(T3, IC3, OC3, INT3) }; uint32_t w; } __IPC3bits_t;
+typedef union { struct { HAL_IPC_FIELDS(T4, IC4, OC4, INT4) }; uint32_t w; } __IPC4bits_t;
+typedef union { struct { HAL_IPC_FIELDS(T5, IC5, OC5, SPI1) }; uint32_t w; } __IPC5bits_t;
+typedef union { struct { HAL_IPC_FIELDS(U1, I2C1, CN, AD1) }; uint32_t w; } __IPC6bits_t;
+typedef union { struct { HAL_IPC_FIELDS(PMP, CMP1, CMP2, SPI2) }; uint32_t w; } __IPC7bits_t;
+typedef union { struct { HAL_IPC_FIELDS(U2, I2C2, FSCM, RTCC) }; uint32_t w; } __IPC8bits_t;
+typedef union { struct { HAL_IPC_FIELDS(DMA0, DMA1, DMA2, DMA3) }; uint32_t w; } __IPC9bits_t;
+typedef union { struct { HAL_IPC_FIELDS(DMA4, DMA5, DMA6, DMA7) }; uint32_t w; } __IPC10bits_t;
+typedef union { struct { HAL_IPC_FIELDS(FCE, USB, CAN1, CAN2) }; uint32_t w; } __IPC11bits_t;
+typedef union { struct { HAL_IPC_FIELDS(ETH, U4, U6, U5) }; uint32_t w; } __IPC12bits_t;
+
+typedef union {
+    struct {
+        unsigned INT0EP : 1;
+        unsigned INT1EP : 1;
+        unsigned INT2EP : 1;
+        unsigned INT3EP : 1;
+        unsigned INT4EP : 1;
+        unsigned : 3;
+        unsigned TPC : 3;
+        unsigned : 1;
+        unsigned MVEC : 1;
+        unsigned : 1;
+        unsigned FRZ : 1;
+        unsigned : 1;
+        unsigned SS0 : 1;
+    };
+    uint32_t w;
+} __INTCONbits_t;
+
+typedef union {
+    struct {
+        unsigned PFMWS : 3;
+        unsigned : 1;
+        unsigned PREFEN : 2;
+        unsigned : 2;
+        unsigned DCSZ : 2;
+        unsigned : 6;
+        unsigned CHECOH : 1;
+    };
+    uint32_t w;
+} __CHECONbits_t;
+
+typedef union {
+    struct {
+        unsigned BMXARB : 3;
+        unsigned : 3;
+        unsigned BMXWSDRM : 1;
+        unsigned : 9;
+        unsigned BMXERRIS : 1;
+        unsigned BMXERRDS : 1;
+        unsigned BMXERRDMA : 1;
+        unsigned BMXERRICD : 1;
+        unsigned BMXERRIXI : 1;
+        unsigned : 5;
+        unsigned BMXCHEDMA : 1;
+    };
+    uint32_t w;
+} __BMXCONbits_t;
+
+typedef union {
+    struct {
+        unsigned : 2;
+        unsigned TROEN : 1;
+        unsigned JTAGEN : 1;
+    };
+    uint32_t w;
+} __DDPCONbits_t;
+
+/*******************************************************************************
+ * SIMULATED REGISTER STORAGE                                                  *
+ ******************************************************************************/
+/* modules are indexed by their datasheet number, ports by letter - 'A' */
+HAL_SFR HAL_spi_regs_t HAL_SPI[3];
+HAL_SFR HAL_uart_regs_t HAL_UART[7];
+HAL_SFR HAL_timer_regs_t HAL_TMR[6];
+HAL_SFR HAL_oc_regs_t HAL_OC[6];
+HAL_SFR HAL_i2c_regs_t HAL_I2C[3];
+HAL_SFR HAL_port_regs_t HAL_PORT[7];
+HAL_SFR HAL_dma_regs_t HAL_DCH[8];
+HAL_SFR __DMACONbits_t HAL_DMACON;
+HAL_SFR __IFS0bits_t HAL_IFS0;
+HAL_SFR __IFS1bits_t HAL_IFS1;
+HAL_SFR __IFS2bits_t HAL_IFS2;
+HAL_SFR __IEC0bits_t HAL_IEC0;
+HAL_SFR __IEC1bits_t HAL_IEC1;
+HAL_SFR __IEC2bits_t HAL_IEC2;
+HAL_SFR uint32_t HAL_IPC[13];
+HAL_SFR __INTCONbits_t HAL_INTCON;
+HAL_SFR __CHECONbits_t HAL_CHECON;
+HAL_SFR __BMXCONbits_t HAL_BMXCON;
+HAL_SFR __DDPCONbits_t HAL_DDPCON;
+
+/* access hooks implemented in HAL_linux.c, see HAL_sim.h */
+volatile uint64_t *HAL_sim_spi_buf(uint8_t module);
+volatile __SPIxSTATbits_t *HAL_sim_spi_stat(uint8_t module);
+volatile uint64_t *HAL_sim_uart_txreg(uint8_t module);
+volatile uint32_t *HAL_sim_uart_rxreg(uint8_t module);
+volatile void *HAL_sim_lat(uint8_t port);
+volatile uint32_t *HAL_sim_lat_op(uint8_t port, uint8_t op);
+uint32_t HAL_sim_core_timer(void);
+void HAL_sim_set_core_timer(uint32_t count);
+uint32_t HAL_sim_disable_interrupts(void);
+uint32_t HAL_sim_enable_interrupts(void);
+uint32_t HAL_sim_kva_to_pa(const volatile void *address);
+
+/*******************************************************************************
+ * REGISTER NAMES                                                              *
+ ******************************************************************************/
+/* Data registers and latches go through the access hooks so the simulator can
+ * see the write (a transfer starts, a chip select toggles).  Everything else
+ * is plain storage. */
+
+#define SPI1CON HAL_SPI[1].CON.w
+#define SPI1CONbits HAL_SPI[1].CON
+#define SPI1STAT (HAL_sim_spi_stat(1)->w)
+#define SPI1STATbits (*HAL_sim_spi_stat(1))
+#define SPI1BRG HAL_SPI[1].BRG
+#define SPI1BUF (*HAL_sim_spi_buf(1))
+#define SPI2CON HAL_SPI[2].CON.w
+#define SPI2CONbits HAL_SPI[2].CON
+#define SPI2STAT (HAL_sim_spi_stat(2)->w)
+#define SPI2STATbits (*HAL_sim_spi_stat(2))
+#define SPI2BRG HAL_SPI[2].BRG
+#define SPI2BUF (*HAL_sim_spi_buf(2))
+
+#define U1MODE HAL_UART[1].MODE.w
+#define U1MODEbits HAL_UART[1].MODE
+#define U1STA HAL_UART[1].STA.w
+#define U1STAbits HAL_UART[1].STA
+#define U1BRG HAL_UART[1].BRG
+#define U1TXREG (*HAL_sim_uart_txreg(1))
+#define U1RXREG (*HAL_sim_uart_rxreg(1))
+#define U2MODE HAL_UART[2].MODE.w
+#define U2MODEbits HAL_UART[2].MODE
+#define U2STA HAL_UART[2].STA.w
+#define U2STAbits HAL_UART[2].STA
+#define U2BRG HAL_UART[2].BRG
+#define U2TXREG (*HAL_sim_uart_txreg(2))
+#define U2RXREG (*HAL_sim_uart_rxreg(2))
+#define U3MODE HAL_UART[3].MODE.w
+#define U3MODEbits HAL_UART[3].MODE
+#define U3STA HAL_UART[3].STA.w
+#define U3STAbits HAL_UART[3].STA
+#define U3BRG HAL_UART[3].BRG
+#define U3TXREG (*HAL_sim_uart_txreg(3))
+#define U3RXREG (*HAL_sim_uart_rxreg(3))
+#define U4MODE HAL_UART[4].MODE.w
+#define U4MODEbits HAL_UART[4].MODE
+#define U4STA HAL_UART[4].STA.w
+#define U4STAbits HAL_UART[4].STA
+#define U4BRG HAL_UART[4].BRG
+#define U4TXREG (*HAL_sim_uart_txreg(4))
+#define U4RXREG (*HAL_sim_uart_rxreg(4))
+#define U5MODE HAL_UART[5].MODE.w
+#define U5MODEbits HAL_UART[5].MODE
+#define U5STA HAL_UART[5].STA.w
+#define U5STAbits HAL_UART[5].STA
+#define U5BRG HAL_UART[5].BRG
+#define U5TXREG (*HAL_sim_uart_txreg(5))
+#define U5RXREG (*HAL_sim_uart_rxreg(5))
+#define U6MODE HAL_UART[6].MODE.w
+#define U6MODEbits HAL_UART[6].MODE
+#define U6STA HAL_UART[6].STA.w
+#define U6STAbits HAL_UART[6].STA
+#define U6BRG HAL_UART[6].BRG
+#define U6TXREG (*HAL_sim_uart_txreg(6))
+#define U6RXREG (*HAL_sim_uart_rxreg(6))
+
+#define T2CON HAL_TMR[2].CON.w
+#define T2CONbits HAL_TMR[2].CON
+#define TMR2 HAL_TMR[2].TMR
+#define PR2 HAL_TMR[2].PR
+#define T3CON HAL_TMR[3].CON.w
+#define T3CONbits HAL_TMR[3].CON
+#define TMR3 HAL_TMR[3].TMR
+#define PR3 HAL_TMR[3].PR
+#define T4CON HAL_TMR[4].CON.w
+#define T4CONbits HAL_TMR[4].CON
+#define TMR4 HAL_TMR[4].TMR
+#define PR4 HAL_TMR[4].PR
+#define T5CON HAL_TMR[5].CON.w
+#define T5CONbits HAL_TMR[5].CON
+#define TMR5 HAL_TMR[5].TMR
+#define PR5 HAL_TMR[5].PR
+
+#define OC1CON HAL_OC[1].CON.w
+#define OC1CONbits HAL_OC[1].CON
+#define OC1R HAL_OC[1].R
+#define OC1RS HAL_OC[1].RS
+#define OC2CON HAL_OC[2].CON.w
+#define OC2CONbits HAL_OC[2].CON
+#define OC2R HAL_OC[2].R
+#define OC2RS HAL_OC[2].RS
+#define OC3CON HAL_OC[3].CON.w
+#define OC3CONbits HAL_OC[3].CON
+#define OC3R HAL_OC[3].R
+#define OC3RS HAL_OC[3].RS
+#define OC4CON HAL_OC[4].CON.w
+#define OC4CONbits HAL_OC[4].CON
+#define OC4R HAL_OC[4].R
+#define OC4RS HAL_OC[4].RS
+#define OC5CON HAL_OC[5].CON.w
+#define OC5CONbits HAL_OC[5].CON
+#define OC5R HAL_OC[5].R
+#define OC5RS HAL_OC[5].RS
+
+/* I2C is declared so the I2C paths compile; the bus itself is not simulated */
+#define I2C1CON HAL_I2C[1].CON.w
+#define I2C1CONbits HAL_I2C[1].CON
+#define I2C1STAT HAL_I2C[1].STAT.w
+#define I2C1STATbits HAL_I2C[1].STAT
+#define I2C1BRG HAL_I2C[1].BRG
+#define I2C1TRN HAL_I2C[1].TRN
+#define I2C1RCV HAL_I2C[1].RCV
+#define I2C2CON HAL_I2C[2].CON.w
+#define I2C2CONbits HAL_I2C[2].CON
+#define I2C2STAT HAL_I2C[2].STAT.w
+#define I2C2STATbits HAL_I2C[2].STAT
+#define I2C2BRG HAL_I2C[2].BRG
+#define I2C2TRN HAL_I2C[2].TRN
+#define I2C2RCV HAL_I2C[2].RCV
+
+#define TRISA HAL_PORT[0].TRIS
+#define TRISAbits (*(volatile __TRISAbits_t *) &HAL_PORT[0].TRIS)
+#define PORTA HAL_PORT[0].PORT
+#define PORTAbits (*(volatile __PORTAbits_t *) &HAL_PORT[0].PORT)
+#define ODCA HAL_PORT[0].ODC
+#define LATA (*(volatile uint32_t *) HAL_sim_lat(0))
+#define LATAbits (*(volatile __LATAbits_t *) HAL_sim_lat(0))
+#define LATACLR (*HAL_sim_lat_op(0, 0))
+#define LATASET (*HAL_sim_lat_op(0, 1))
+#define LATAINV (*HAL_sim_lat_op(0, 2))
+#define TRISB HAL_PORT[1].TRIS
+#define TRISBbits (*(volatile __TRISBbits_t *) &HAL_PORT[1].TRIS)
+#define PORTB HAL_PORT[1].PORT
+#define PORTBbits (*(volatile __PORTBbits_t *) &HAL_PORT[1].PORT)
+#define ODCB HAL_PORT[1].ODC
+#define LATB (*(volatile uint32_t *) HAL_sim_lat(1))
+#define LATBbits (*(volatile __LATBbits_t *) HAL_sim_lat(1))
+#define LATBCLR (*HAL_sim_lat_op(1, 0))
+#define LATBSET (*HAL_sim_lat_op(1, 1))
+#define LATBINV (*HAL_sim_lat_op(1, 2))
+#define TRISC HAL_PORT[2].TRIS
+#define TRISCbits (*(volatile __TRISCbits_t *) &HAL_PORT[2].TRIS)
+#define PORTC HAL_PORT[2].PORT
+#define PORTCbits (*(volatile __PORTCbits_t *) &HAL_PORT[2].PORT)
+#define ODCC HAL_PORT[2].ODC
+#define LATC (*(volatile uint32_t *) HAL_sim_lat(2))
+#define LATCbits (*(volatile __LATCbits_t *) HAL_sim_lat(2))
+#define LATCCLR (*HAL_sim_lat_op(2, 0))
+#define LATCSET (*HAL_sim_lat_op(2, 1))
+#define LATCINV (*HAL_sim_lat_op(2, 2))
+#define TRISD HAL_PORT[3].TRIS
+#define TRISDbits (*(volatile __TRISDbits_t *) &HAL_PORT[3].TRIS)
+#define PORTD HAL_PORT[3].PORT
+#define PORTDbits (*(volatile __PORTDbits_t *) &HAL_PORT[3].PORT)
+#define ODCD HAL_PORT[3].ODC
+#define LATD (*(volatile uint32_t *) HAL_sim_lat(3))
+#define LATDbits (*(volatile __LATDbits_t *) HAL_sim_lat(3))
+#define LATDCLR (*HAL_sim_lat_op(3, 0))
+#define LATDSET (*HAL_sim_lat_op(3, 1))
+#define LATDINV (*HAL_sim_lat_op(3, 2))
+#define TRISE HAL_PORT[4].TRIS
+#define TRISEbits (*(volatile __TRISEbits_t *) &HAL_PORT[4].TRIS)
+#define PORTE HAL_PORT[4].PORT
+#define PORTEbits (*(volatile __PORTEbits_t *) &HAL_PORT[4].PORT)
+#define ODCE HAL_PORT[4].ODC
+#define LATE (*(volatile uint32_t *) HAL_sim_lat(4))
+#define LATEbits (*(volatile __LATEbits_t *) HAL_sim_lat(4))
+#define LATECLR (*HAL_sim_lat_op(4, 0))
+#define LATESET (*HAL_sim_lat_op(4, 1))
+#define LATEINV (*HAL_sim_lat_op(4, 2))
+#define TRISF HAL_PORT[5].TRIS
+#define TRISFbits (*(volatile __TRISFbits_t *) &HAL_PORT[5].TRIS)
+#define PORTF HAL_PORT[5].PORT
+#define PORTFbits (*(volatile __PORTFbits_t *) &HAL_PORT[5].PORT)
+#define ODCF HAL_PORT[5].ODC
+#define LATF (*(volatile uint32_t *) HAL_sim_lat(5))
+#define LATFbits (*(volatile __LATFbits_t *) HAL_sim_lat(5))
+#define LATFCLR (*HAL_sim_lat_op(5, 0))
+#define LATFSET (*HAL_sim_lat_op(5, 1))
+#define LATFINV (*HAL_sim_lat_op(5, 2))
+#define TRISG HAL_PORT[6].TRIS
+#define TRISGbits (*(volatile __TRISGbits_t *) &HAL_PORT[6].TRIS)
+#define PORTG HAL_PORT[6].PORT
+#define PORTGbits (*(volatile __PORTGbits_t *) &HAL_PORT[6].PORT)
+#define ODCG HAL_PORT[6].ODC
+#define LATG (*(volatile uint32_t *) HAL_sim_lat(6))
+#define LATGbits (*(volatile __LATGbits_t *) HAL_sim_lat(6))
+#define LATGCLR (*HAL_sim_lat_op(6, 0))
+#define LATGSET (*HAL_sim_lat_op(6, 1))
+#define LATGINV (*HAL_sim_lat_op(6, 2))
+
+#define IFS0 HAL_IFS0.w
+#define IFS0bits HAL_IFS0
+#define IFS1 HAL_IFS1.w
+#define IFS1bits HAL_IFS1
+#define IFS2 HAL_IFS2.w
+#define IFS2bits HAL_IFS2
+#define IEC0 HAL_IEC0.w
+#define IEC0bits HAL_IEC0
+#define IEC1 HAL_IEC1.w
+#define IEC1bits HAL_IEC1
+#define IEC2 HAL_IEC2.w
+#define IEC2bits HAL_IEC2
+#define IPC0bits (*(volatile __IPC0bits_t *) &HAL_IPC[0])
+#define IPC1bits (*(volatile __IPC1bits_t *) &HAL_IPC[1])
+#define IPC2bits (*(volatile __IPC2bits_t *) &HAL_IPC[2])
+#define IPC3bits (*(volatile __IPC3bits_t *) &HAL_IPC[3])
+#define IPC4bits (*(volatile __IPC4bits_t *) &HAL_IPC[4])
+#define IPC5bits (*(volatile __IPC5bits_t *) &HAL_IPC[5])
+#define IPC6bits (*(volatile __IPC6bits_t *) &HAL_IPC[6])
+#define IPC7bits (*(volatile __IPC7bits_t *) &HAL_IPC[7])
+#define IPC8bits (*(volatile __IPC8bits_t *) &HAL_IPC[8])
+#define IPC9bits (*(volatile __IPC9bits_t *) &HAL_IPC[9])
+#define IPC10bits (*(volatile __IPC10bits_t *) &HAL_IPC[10])
+#define IPC11bits (*(volatile __IPC11bits_t *) &HAL_IPC[11])
+#define IPC12bits (*(volatile __IPC12bits_t *) &HAL_IPC[12])
+#define INTCON HAL_INTCON.w
+#define INTCONbits HAL_INTCON
+#define CHECON HAL_CHECON.w
+#define CHECONbits HAL_CHECON
+#define BMXCON HAL_BMXCON.w
+#define BMXCONbits HAL_BMXCON
+#define DDPCON HAL_DDPCON.w
+#define DDPCONbits HAL_DDPCON
+
+/* DMA channels 0 and 1, the others are storage only until a driver uses them */
+#define DMACON HAL_DMACON.w
+#define DMACONbits HAL_DMACON
+#define DCH0CON HAL_DCH[0].CON.w
+#define DCH0CONbits HAL_DCH[0].CON
+#define DCH0ECON HAL_DCH[0].ECON.w
+#define DCH0ECONbits HAL_DCH[0].ECON
+#define DCH0INT HAL_DCH[0].INT.w
+#define DCH0INTbits HAL_DCH[0].INT
+#define DCH0SSA HAL_DCH[0].SSA
+#define DCH0DSA HAL_DCH[0].DSA
+#define DCH0SSIZ HAL_DCH[0].SSIZ
+#define DCH0DSIZ HAL_DCH[0].DSIZ
+#define DCH0SPTR HAL_DCH[0].SPTR
+#define DCH0DPTR HAL_DCH[0].DPTR
+#define DCH0CSIZ HAL_DCH[0].CSIZ
+#define DCH0CPTR HAL_DCH[0].CPTR
+#define DCH0DAT HAL_DCH[0].DAT
+#define DCH1CON HAL_DCH[1].CON.w
+#define DCH1CONbits HAL_DCH[1].CON
+#define DCH1ECON HAL_DCH[1].ECON.w
+#define DCH1ECONbits HAL_DCH[1].ECON
+#define DCH1INT HAL_DCH[1].INT.w
+#define DCH1INTbits HAL_DCH[1].INT
+#define DCH1SSA HAL_DCH[1].SSA
+#define DCH1DSA HAL_DCH[1].DSA
+#define DCH1SSIZ HAL_DCH[1].SSIZ
+#define DCH1DSIZ HAL_DCH[1].DSIZ
+#define DCH1SPTR HAL_DCH[1].SPTR
+#define DCH1DPTR HAL_DCH[1].DPTR
+#define DCH1CSIZ HAL_DCH[1].CSIZ
+#define DCH1CPTR HAL_DCH[1].CPTR
+#define DCH1DAT HAL_DCH[1].DAT
+
+#endif	/* P32MX795F512L_HOST_H */ // End of header guard
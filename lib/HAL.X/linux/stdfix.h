@@ -0,0 +1,14 @@
+/*
+ * File:   stdfix.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) stand-in for the XC32 <stdfix.h>.  gcc for x86/arm hosts
+ * has no _Fract/_Accum support, nothing in lib/ uses those types, so this is
+ * intentionally empty.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef STDFIX_HOST_H // Header guard
+#define	STDFIX_HOST_H //
+
+#endif	/* STDFIX_HOST_H */ // End of header guard
@@ -0,0 +1,22 @@
+/*
+ * File:   attribs.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) stand-in for the XC32 <sys/attribs.h>.  An ISR is placed
+ * in a linker section named after its vector, HAL_linux.c finds it through the
+ * __start_<section> symbol the GNU linker provides and calls it when the
+ * simulated interrupt flag and enable bits are both set.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef ATTRIBS_HOST_H // Header guard
+#define	ATTRIBS_HOST_H //
+
+#define HAL_ISR_STR(x) #x
+#define HAL_ISR_XSTR(x) HAL_ISR_STR(x)
+
+/* the priority argument is ignored, the simulator never nests interrupts */
+#define __ISR(vector, ...) \
+    __attribute__((used, noinline, section("hal_isr_" HAL_ISR_XSTR(vector))))
+
+#endif	/* ATTRIBS_HOST_H */ // End of header guard
@@ -0,0 +1,19 @@
+/*
+ * File:   kmem.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) stand-in for the XC32 <sys/kmem.h>.  The simulated DMA
+ * controller cannot hold a 64 bit host pointer in a 32 bit address register,
+ * so KVA_TO_PA() hands out a handle that HAL_linux.c maps back to the pointer.
+ * Only the handle is meaningful, do not do arithmetic on it.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef KMEM_HOST_H // Header guard
+#define	KMEM_HOST_H //
+
+#include <xc.h>
+
+#define KVA_TO_PA(v) HAL_sim_kva_to_pa((const volatile void *) (v))
+
+#endif	/* KMEM_HOST_H */ // End of header guard
@@ -0,0 +1,16 @@
+/*
+ * File:   types.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) wrapper for <sys/types.h>.  XC32 makes the fixed width
+ * integer types visible through this header, glibc does not.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef TYPES_HOST_H // Header guard
+#define	TYPES_HOST_H //
+
+#include_next <sys/types.h>
+#include <stdint.h>
+
+#endif	/* TYPES_HOST_H */ // End of header guard
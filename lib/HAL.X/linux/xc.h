@@ -0,0 +1,15 @@
+/*
+ * File:   xc.h
+ * Author: Aaron Hunter
+ * Brief: Host (Linux) stand-in for the XC32 <xc.h>, pulls in the simulated
+ * PIC32MX795F512L register map
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef XC_HOST_H // Header guard
+#define	XC_HOST_H //
+
+#include <proc/p32mx795f512l.h>
+
+#endif	/* XC_HOST_H */ // End of header guard
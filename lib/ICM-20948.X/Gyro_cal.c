@@ -0,0 +1,414 @@
+/*
+ * File:   Gyro_cal.c
+ * Author: Aaron Hunter
+ * Brief: Startup gyro bias calibration, see Gyro_cal.h.  Each axis keeps
+ * Welford's running mean and sum of squared deviations, which stay accurate in
+ * float where a running sum of squares would cancel.  The seed enters as a
+ * Gaussian prior: the estimate is the precision weighted mean of the seed and
+ * the sample mean, and its precision is the sum of theirs.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Gyro_cal.h"
+#include "Board.h"
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define SEED_PRECISION (1.0f / (float) (GYRO_CAL_SEED_STD * GYRO_CAL_SEED_STD))
+#define VAR_MIN ((float) (GYRO_CAL_STD_MIN * GYRO_CAL_STD_MIN))
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void stats_restart(void);
+static float axis_var(uint8_t axis);
+static float axis_precision(uint8_t axis, float var);
+static float axis_estimate(uint8_t axis, float var);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static uint16_t n; // stationary samples
+static float mean[MSZ];
+static float m2[MSZ]; // sum of squared deviations from the mean
+static float seed[MSZ];
+static float bias[MSZ]; // result once converged
+
+static gyro_cal_status_t status;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_cal_init(void)
+ * @brief clears the statistics, the seed and the result
+ * @author Aaron Hunter
+ */
+void Gyro_cal_init(void) {
+    memset(&status, 0, sizeof (status));
+    memset(seed, 0, sizeof (seed));
+    memset(bias, 0, sizeof (bias));
+    stats_restart();
+}
+
+/**
+ * @Function Gyro_cal_seed(float bias[MSZ])
+ * @param bias, a previously calibrated bias in deg/sec
+ * @return SUCCESS or ERROR if the seed is not finite or over GYRO_CAL_BIAS_MAX
+ * @brief uses bias as the prior of the estimate
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_seed(float bias_seed[MSZ]) {
+    uint8_t axis;
+
+    for (axis = 0; axis < MSZ; axis++) {
+        /* NaN fails the comparison too */
+        if (!(fabsf(bias_seed[axis]) <= GYRO_CAL_BIAS_MAX)) {
+            return ERROR;
+        }
+    }
+    memcpy(seed, bias_seed, sizeof (seed));
+    status.is_seeded = TRUE;
+    status.is_seed_rejected = FALSE;
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_cal_update(float gyro[MSZ], float acc[MSZ])
+ * @param gyro, calibrated gyro rates in deg/sec
+ * @param acc, calibrated accelerometer in g
+ * @return TRUE once the bias has converged, FALSE while calibrating
+ * @brief one Welford step per axis and the convergence test
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_update(float gyro[MSZ], float acc[MSZ]) {
+    float acc_sq;
+    float delta;
+    float var[MSZ];
+    float tol_sq;
+    uint8_t axis;
+    int8_t is_moving = FALSE;
+
+    if (status.is_converged == TRUE) {
+        return TRUE;
+    }
+
+    /* stationarity: 1 g of specific force and rates close to the bias, the
+     * running mean or, before there is one, the seed */
+    acc_sq = acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2];
+    if ((acc_sq < (float) ((1.0 - GYRO_CAL_ACC_TOL) * (1.0 - GYRO_CAL_ACC_TOL)))
+            || (acc_sq > (float) ((1.0 + GYRO_CAL_ACC_TOL) * (1.0 + GYRO_CAL_ACC_TOL)))) {
+        is_moving = TRUE;
+    }
+    for (axis = 0; axis < MSZ; axis++) {
+        if (fabsf(gyro[axis]) > GYRO_CAL_BIAS_MAX) {
+            is_moving = TRUE;
+        } else if ((n > 0) && (fabsf(gyro[axis] - mean[axis]) > GYRO_CAL_RATE_MAX)) {
+            is_moving = TRUE;
+        } else if ((n == 0) && (status.is_seeded == TRUE)
+                && (fabsf(gyro[axis] - seed[axis]) > GYRO_CAL_RATE_MAX)) {
+            is_moving = TRUE;
+        }
+    }
+    if (is_moving == TRUE) {
+        if (n > 0) {
+            status.restarts++;
+        }
+        stats_restart();
+        return FALSE;
+    }
+
+    /* Welford */
+    n++;
+    for (axis = 0; axis < MSZ; axis++) {
+        delta = gyro[axis] - mean[axis];
+        mean[axis] += delta / n;
+        m2[axis] += delta * (gyro[axis] - mean[axis]);
+    }
+    status.samples = n;
+    if (n < GYRO_CAL_MIN_SAMPLES) {
+        return FALSE;
+    }
+
+    for (axis = 0; axis < MSZ; axis++) {
+        var[axis] = axis_var(axis);
+    }
+    /* converged when Z / sqrt(precision) < CI on every axis */
+    for (axis = 0; axis < MSZ; axis++) {
+        if (axis_precision(axis, var[axis]) * (float) (GYRO_CAL_CI * GYRO_CAL_CI)
+                < (float) (GYRO_CAL_Z * GYRO_CAL_Z)) {
+            return FALSE;
+        }
+    }
+    /* tested once, here, rather than every sample, which would reject good
+     * seeds by chance: a seed the samples disagree with beyond both
+     * uncertainties is dropped and the samples carry on alone */
+    if (status.is_seeded == TRUE) {
+        for (axis = 0; axis < MSZ; axis++) {
+            delta = mean[axis] - seed[axis];
+            tol_sq = (float) (GYRO_CAL_SEED_Z * GYRO_CAL_SEED_Z)
+                    * (var[axis] / n + (float) (GYRO_CAL_SEED_STD * GYRO_CAL_SEED_STD));
+            if (delta * delta > tol_sq) {
+                status.is_seeded = FALSE;
+                status.is_seed_rejected = TRUE;
+            }
+        }
+        if (status.is_seeded == FALSE) {
+            return FALSE;
+        }
+    }
+    for (axis = 0; axis < MSZ; axis++) {
+        bias[axis] = axis_estimate(axis, var[axis]);
+    }
+    status.is_converged = TRUE;
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_cal_get_bias(float bias[MSZ])
+ * @param bias, the bias estimate in deg/sec
+ * @return SUCCESS if it has converged, ERROR if bias is the estimate so far
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_get_bias(float bias_out[MSZ]) {
+    uint8_t axis;
+
+    if (status.is_converged == TRUE) {
+        memcpy(bias_out, bias, sizeof (bias));
+        return SUCCESS;
+    }
+    for (axis = 0; axis < MSZ; axis++) {
+        bias_out[axis] = axis_estimate(axis, axis_var(axis));
+    }
+    return ERROR;
+}
+
+/**
+ * @Function Gyro_cal_get_status(gyro_cal_status_t *status)
+ * @param status, progress of the calibration
+ * @author Aaron Hunter
+ */
+void Gyro_cal_get_status(gyro_cal_status_t *status_out) {
+    float var;
+    float precision;
+    uint8_t axis;
+
+    status.ci = 0;
+    status.std_max = 0;
+    for (axis = 0; axis < MSZ; axis++) {
+        var = axis_var(axis);
+        precision = axis_precision(axis, var);
+        if ((n > 1) && (var > status.std_max * status.std_max)) {
+            status.std_max = sqrtf(var);
+        }
+        if (precision <= 0) {
+            status.ci = INFINITY;
+        } else if ((float) GYRO_CAL_Z / sqrtf(precision) > status.ci) {
+            status.ci = (float) GYRO_CAL_Z / sqrtf(precision);
+        }
+    }
+    *status_out = status;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function stats_restart(void)
+ * @brief discards the samples, keeps the seed
+ */
+static void stats_restart(void) {
+    n = 0;
+    memset(mean, 0, sizeof (mean));
+    memset(m2, 0, sizeof (m2));
+    status.samples = 0;
+}
+
+/**
+ * @Function axis_var(uint8_t axis)
+ * @return sample variance of the axis, at least GYRO_CAL_STD_MIN squared
+ */
+static float axis_var(uint8_t axis) {
+    float var;
+
+    if (n < 2) {
+        return VAR_MIN;
+    }
+    var = m2[axis] / (n - 1);
+    return var > VAR_MIN ? var : VAR_MIN;
+}
+
+/**
+ * @Function axis_precision(uint8_t axis, float var)
+ * @return inverse variance of the estimate, samples plus seed
+ */
+static float axis_precision(uint8_t axis, float var) {
+    float precision = n / var;
+
+    if (status.is_seeded == TRUE) {
+        precision += SEED_PRECISION;
+    }
+    return precision;
+}
+
+/**
+ * @Function axis_estimate(uint8_t axis, float var)
+ * @return precision weighted mean of the samples and the seed
+ */
+static float axis_estimate(uint8_t axis, float var) {
+    float precision = axis_precision(axis, var);
+
+    if (precision <= 0) {
+        return 0;
+    }
+    if (status.is_seeded == TRUE) {
+        return (mean[axis] * n / var + seed[axis] * SEED_PRECISION) / precision;
+    }
+    return mean[axis];
+}
+
+#ifdef GYRO_CAL_TESTING
+#include "SerialM32.h"
+#include <stdio.h>
+
+#define TEST_TRIALS 50
+#define TEST_NOISE 0.15 // deg/sec rms, as the SITL gyros
+#define TEST_ACC_NOISE 0.005 // g rms
+#define TEST_RATE 50 // Hz, MEAS_PERIOD of the AHRS apps
+#define TEST_MAX_SAMPLES 2000
+#define TEST_MOTION_START 50 // stationary samples before motion, too few to converge
+#define TEST_ERR_TOL (1.5 * GYRO_CAL_CI) // worst error over all trials and axes
+
+static uint32_t lcg_state = 12345;
+
+static float test_uniform(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return ((lcg_state >> 8) + 0.5f) / 16777216.0f;
+}
+
+static float test_gauss(void) {
+    return sqrtf(-2.0f * logf(test_uniform())) * cosf(6.2831853f * test_uniform());
+}
+
+/* runs one calibration, turning and tilting at rate deg/sec for motion_samples
+ * after TEST_MOTION_START, and returns the samples to converge or more than
+ * TEST_MAX_SAMPLES */
+static int test_run(float truth[MSZ], float seed_in[MSZ], int motion_samples, float rate,
+        float *err) {
+    float gyro[MSZ];
+    float acc[MSZ];
+    float bias_est[MSZ];
+    float tilt;
+    int i;
+    int8_t is_moving;
+    uint8_t axis;
+
+    Gyro_cal_init();
+    if (seed_in != NULL) {
+        Gyro_cal_seed(seed_in);
+    }
+    for (i = 0; i < TEST_MAX_SAMPLES; i++) {
+        is_moving = (motion_samples > 0) && (i >= TEST_MOTION_START)
+                && (i < TEST_MOTION_START + motion_samples);
+        tilt = is_moving ? rate * (i - TEST_MOTION_START) / TEST_RATE * 0.0174533f : 0;
+        for (axis = 0; axis < MSZ; axis++) {
+            gyro[axis] = truth[axis] + (float) TEST_NOISE * test_gauss() + (is_moving ? rate : 0);
+        }
+        acc[0] = sinf(tilt) + (float) TEST_ACC_NOISE * test_gauss();
+        acc[1] = (float) TEST_ACC_NOISE * test_gauss();
+        acc[2] = cosf(tilt) + (float) TEST_ACC_NOISE * test_gauss();
+        if (Gyro_cal_update(gyro, acc) == TRUE) {
+            break;
+        }
+    }
+    Gyro_cal_get_bias(bias_est);
+    *err = 0;
+    for (axis = 0; axis < MSZ; axis++) {
+        if (fabsf(bias_est[axis] - truth[axis]) > *err) {
+            *err = fabsf(bias_est[axis] - truth[axis]);
+        }
+    }
+    return i + 1;
+}
+
+/* one case over TEST_TRIALS random biases, seeds off by seed_err */
+static int test_case(const char *name, int8_t is_seeded, float seed_err, int motion_samples,
+        float rate, int8_t expect_rejected) {
+    float truth[MSZ];
+    float seed_in[MSZ];
+    float err;
+    float err_max = 0;
+    long samples_sum = 0;
+    int samples_max = 0;
+    int samples;
+    int failures = 0;
+    int trial;
+    uint8_t axis;
+    gyro_cal_status_t s;
+
+    for (trial = 0; trial < TEST_TRIALS; trial++) {
+        for (axis = 0; axis < MSZ; axis++) {
+            truth[axis] = 2.0f * test_uniform() - 1.0f;
+            seed_in[axis] = truth[axis] + (axis == 0 ? seed_err : 0);
+        }
+        samples = test_run(truth, is_seeded == TRUE ? seed_in : NULL, motion_samples, rate, &err);
+        Gyro_cal_get_status(&s);
+        samples -= motion_samples > 0 ? TEST_MOTION_START + motion_samples : 0;
+        samples_sum += samples;
+        samples_max = samples > samples_max ? samples : samples_max;
+        err_max = err > err_max ? err : err_max;
+        if ((s.is_converged != TRUE) || (s.is_seed_rejected != expect_rejected)
+                || ((motion_samples > 0) && (s.restarts == 0))) {
+            failures++;
+        }
+    }
+    printf("%s: mean %.0f ms, max %.0f ms to converge, max error %.4f dps\r\n", name,
+            1000.0 * samples_sum / TEST_TRIALS / TEST_RATE, 1000.0 * samples_max / TEST_RATE,
+            (double) err_max);
+    if (failures > 0 || err_max > TEST_ERR_TOL) {
+        printf("FAIL %s, %d trials\r\n", name, failures);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    float truth[MSZ] = {0.5, -0.5, 0.2};
+    float err;
+    int samples;
+    int failures = 0;
+    gyro_cal_status_t s;
+
+    Board_init();
+    Serial_init();
+    printf("Gyro_cal test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    failures += test_case("cold start", FALSE, 0, 0, 0, FALSE);
+    failures += test_case("warm start", TRUE, 0.01f, 0, 0, FALSE);
+    failures += test_case("stale seed", TRUE, 0.5f, 0, 0, TRUE);
+    failures += test_case("picked up", FALSE, 0, 100, 20.0f, FALSE);
+
+    /* turning the whole time must never converge */
+    samples = test_run(truth, NULL, TEST_MAX_SAMPLES, 20.0f, &err);
+    Gyro_cal_get_status(&s);
+    printf("moving: %d samples, %u restarts, %s\r\n", samples, s.restarts,
+            samples > TEST_MAX_SAMPLES ? "no calibration" : "converged");
+    if ((samples <= TEST_MAX_SAMPLES) || (s.restarts != 1)) {
+        printf("FAIL moving\r\n");
+        failures++;
+    }
+
+    printf("%s\r\n", failures == 0 ? "Gyro_cal tests passed" : "Gyro_cal tests FAILED");
+    return 0;
+}
+#endif //GYRO_CAL_TESTING
@@ -0,0 +1,120 @@
+/*
+ * File:   Gyro_cal.h
+ * Author: Aaron Hunter
+ * Brief: Startup gyro bias calibration that ends as soon as the bias is known.
+ * Instead of averaging for a fixed time, a streaming (Welford) mean and
+ * variance per axis gives the confidence interval of the bias after every
+ * sample, and the calibration ends when the interval is under GYRO_CAL_CI on
+ * all three axes, typically after a second or two.
+ *
+ * Only stationary samples count.  A sample more than GYRO_CAL_RATE_MAX from the
+ * running mean, or an accelerometer magnitude off 1 g by more than
+ * GYRO_CAL_ACC_TOL, restarts the statistics, so the vehicle being picked up or
+ * bumped during calibration does not bias the result.
+ *
+ * A bias stored from a previous calibration, e.g. in EEPROM, can seed the
+ * estimate as a prior with a standard deviation of GYRO_CAL_SEED_STD.  Once
+ * the samples agree with it the interval closes after a few hundred
+ * milliseconds.  A seed the samples disagree with by more than GYRO_CAL_SEED_Z
+ * standard deviations is dropped and the calibration continues as a cold
+ * start.
+ *
+ * Usage:
+ *     Gyro_cal_init();
+ *     Gyro_cal_seed(stored_bias); // optional
+ *     while (Gyro_cal_update(gyro, acc) == FALSE) { next sample }
+ *     Gyro_cal_get_bias(bias);
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef GYRO_CAL_H // Header guard
+#define	GYRO_CAL_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MSZ 3 //matrix/vector size per dimension
+
+/* rates in deg/sec, as IMU_get_norm_data() returns them */
+#ifndef GYRO_CAL_CI
+#define GYRO_CAL_CI 0.05 // confidence interval half width to end calibration
+#endif
+#define GYRO_CAL_Z 3.0 // standard deviations in the confidence interval
+#define GYRO_CAL_MIN_SAMPLES 10 // before the variance is trusted
+#define GYRO_CAL_STD_MIN 0.01 // floor on the sample standard deviation, ~1 LSB
+#define GYRO_CAL_RATE_MAX 1.0 // deviation from the mean that counts as motion
+#define GYRO_CAL_BIAS_MAX 5.0 // larger rates or seeds are not a bias
+#define GYRO_CAL_ACC_TOL 0.05 // g, accelerometer magnitude error that counts as motion
+#define GYRO_CAL_SEED_STD 0.02 // bias change between calibrations, 1 sigma
+#define GYRO_CAL_SEED_Z 4.0 // standard deviations of disagreement that drop the seed
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint16_t samples; // stationary samples since the last restart
+    uint16_t restarts; // restarts on motion
+    uint8_t is_seeded; // TRUE while the seed is part of the estimate
+    uint8_t is_seed_rejected; // TRUE if the samples disagreed with the seed
+    uint8_t is_converged;
+    float ci; // largest confidence interval half width, deg/sec
+    float std_max; // largest sample standard deviation, deg/sec
+} gyro_cal_status_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_cal_init(void)
+ * @brief clears the statistics, the seed and the result
+ * @author Aaron Hunter
+ */
+void Gyro_cal_init(void);
+
+/**
+ * @Function Gyro_cal_seed(float bias[MSZ])
+ * @param bias, a previously calibrated bias in deg/sec
+ * @return SUCCESS or ERROR if the seed is not finite or over GYRO_CAL_BIAS_MAX,
+ * as an erased EEPROM reads
+ * @brief uses bias as the prior of the estimate
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_seed(float bias[MSZ]);
+
+/**
+ * @Function Gyro_cal_update(float gyro[MSZ], float acc[MSZ])
+ * @param gyro, calibrated gyro rates in deg/sec
+ * @param acc, calibrated accelerometer in g
+ * @return TRUE once the bias has converged, FALSE while calibrating.  Samples
+ * after convergence are ignored.
+ * @brief one Welford step per axis and the convergence test, about 40
+ * multiplies and 3 divides
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_update(float gyro[MSZ], float acc[MSZ]);
+
+/**
+ * @Function Gyro_cal_get_bias(float bias[MSZ])
+ * @param bias, the bias estimate in deg/sec
+ * @return SUCCESS if it has converged, ERROR if bias is the estimate so far,
+ * the seed or zero
+ * @author Aaron Hunter
+ */
+int8_t Gyro_cal_get_bias(float bias[MSZ]);
+
+/**
+ * @Function Gyro_cal_get_status(gyro_cal_status_t *status)
+ * @param status, progress of the calibration
+ * @author Aaron Hunter
+ */
+void Gyro_cal_get_status(gyro_cal_status_t *status);
+
+#endif	/* GYRO_CAL_H */ // End of header guard
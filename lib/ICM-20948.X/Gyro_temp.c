@@ -0,0 +1,638 @@
+/*
+ * File:   Gyro_temp.c
+ * Author: Aaron Hunter
+ * Brief: Gyro bias against temperature, see Gyro_temp.h.  The batch keeps a
+ * running mean per axis for the motion test and the bins an exponentially
+ * weighted mean.  The fit solves the normal equations in (T - 25 C) / 10 C so
+ * the powers stay near one and float keeps the small second order term.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Gyro_temp.h"
+#include "Board.h"
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define TABLE_MAGIC 20948.25f // first float of a saved table, changes with the layout
+#define FIT_SCALE_C 10.0f // fit in (T - IMU_TEMP_REF_C) / FIT_SCALE_C
+#define PIVOT_MIN 1e-6f // normal equations closer to singular drop a degree
+#define BIN_TEMP_TOL 0.5f // deg C a saved bin temperature may sit outside its bin
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    float temp; // mean temperature of the batches, deg C
+    float batches; // 0 for an empty bin, up to GYRO_TEMP_BIN_BATCHES
+    float bias[MSZ];
+} gyro_temp_bin_t;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void batch_restart(void);
+static void bin_add(float temp_c, const float bias[MSZ]);
+static int8_t fit_degree(uint8_t degree, float coef[MSZ][IMU_TEMP_TERMS]);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static gyro_temp_bin_t bins[GYRO_TEMP_BINS];
+static uint16_t n; // samples in the batch
+static float batch_mean[MSZ];
+static float batch_temp;
+
+static gyro_temp_status_t status;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_temp_init(void)
+ * @brief clears the bins and the batch
+ * @author Aaron Hunter
+ */
+void Gyro_temp_init(void) {
+    memset(bins, 0, sizeof (bins));
+    memset(&status, 0, sizeof (status));
+    status.degree = -1;
+    batch_restart();
+}
+
+/**
+ * @Function Gyro_temp_update(float gyro[MSZ], float acc[MSZ], float temp_c)
+ * @param gyro, gyro rates without temperature compensation in deg/sec
+ * @param acc, calibrated accelerometer in g
+ * @param temp_c, die temperature in deg C
+ * @return TRUE when a batch was binned, FALSE otherwise
+ * @brief one running mean step per axis, the batch is binned every
+ * GYRO_TEMP_BATCH stationary samples
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_update(float gyro[MSZ], float acc[MSZ], float temp_c) {
+    float acc_sq;
+    uint8_t axis;
+    int8_t is_moving = FALSE;
+
+    /* stationarity as Gyro_cal_update(): 1 g of specific force and rates
+     * close to the batch mean */
+    acc_sq = acc[0] * acc[0] + acc[1] * acc[1] + acc[2] * acc[2];
+    if ((acc_sq < (float) ((1.0 - GYRO_TEMP_ACC_TOL) * (1.0 - GYRO_TEMP_ACC_TOL)))
+            || (acc_sq > (float) ((1.0 + GYRO_TEMP_ACC_TOL) * (1.0 + GYRO_TEMP_ACC_TOL)))) {
+        is_moving = TRUE;
+    }
+    for (axis = 0; axis < MSZ; axis++) {
+        /* NaN fails the comparison too */
+        if (!(fabsf(gyro[axis]) <= GYRO_TEMP_BIAS_MAX)) {
+            is_moving = TRUE;
+        } else if ((n > 0) && (fabsf(gyro[axis] - batch_mean[axis]) > GYRO_TEMP_RATE_MAX)) {
+            is_moving = TRUE;
+        }
+    }
+    if (is_moving == TRUE) {
+        batch_restart();
+        return FALSE;
+    }
+
+    n++;
+    for (axis = 0; axis < MSZ; axis++) {
+        batch_mean[axis] += (gyro[axis] - batch_mean[axis]) / n;
+    }
+    batch_temp += (temp_c - batch_temp) / n;
+    status.samples = n;
+    if (n < GYRO_TEMP_BATCH) {
+        return FALSE;
+    }
+    bin_add(batch_temp, batch_mean);
+    batch_restart();
+    return TRUE;
+}
+
+/**
+ * @Function Gyro_temp_fit(IMU_gyro_temp_model_t *model)
+ * @param model, the polynomials through the bins
+ * @return SUCCESS or ERROR with no bins, which leaves model as it was
+ * @brief drops a degree while the span is short of GYRO_TEMP_SPAN_C per
+ * degree, there are too few bins or the normal equations are singular
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_fit(IMU_gyro_temp_model_t *model) {
+    float coef[MSZ][IMU_TEMP_TERMS];
+    float min_c = 0;
+    float max_c = 0;
+    float err;
+    float dt;
+    float sum_sq = 0;
+    int16_t degree;
+    uint8_t used = 0;
+    uint8_t axis;
+    uint8_t k;
+
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        if (bins[k].batches > 0) {
+            if ((used == 0) || (bins[k].temp < min_c)) {
+                min_c = bins[k].temp;
+            }
+            if ((used == 0) || (bins[k].temp > max_c)) {
+                max_c = bins[k].temp;
+            }
+            used++;
+        }
+    }
+    status.bins = used;
+    if (used == 0) {
+        return ERROR;
+    }
+    degree = (int16_t) ((max_c - min_c) / GYRO_TEMP_SPAN_C);
+    if (degree > used - 1) {
+        degree = used - 1;
+    }
+    if (degree > IMU_TEMP_TERMS - 1) {
+        degree = IMU_TEMP_TERMS - 1;
+    }
+    /* a single bin always fits as a constant */
+    while (fit_degree((uint8_t) degree, coef) == ERROR) {
+        degree--;
+    }
+
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        if (bins[k].batches > 0) {
+            dt = bins[k].temp - IMU_TEMP_REF_C;
+            for (axis = 0; axis < MSZ; axis++) {
+                err = coef[axis][0] + dt * (coef[axis][1] + dt * coef[axis][2]) - bins[k].bias[axis];
+                sum_sq += err * err;
+            }
+        }
+    }
+    memcpy(model->c, coef, sizeof (model->c));
+    model->min_c = min_c;
+    model->max_c = max_c;
+    status.degree = (int8_t) degree;
+    status.min_c = min_c;
+    status.max_c = max_c;
+    status.rms = sqrtf(sum_sq / (used * MSZ));
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_temp_get_table(float table[GYRO_TEMP_TABLE_SIZE])
+ * @param table, the magic number, the bin count and per bin the temperature,
+ * batches and bias, zero padded to whole pages
+ * @author Aaron Hunter
+ */
+void Gyro_temp_get_table(float table[GYRO_TEMP_TABLE_SIZE]) {
+    float *entry = &table[2];
+    uint8_t k;
+
+    memset(table, 0, GYRO_TEMP_TABLE_SIZE * sizeof (float));
+    table[0] = TABLE_MAGIC;
+    table[1] = GYRO_TEMP_BINS;
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        entry[0] = bins[k].temp;
+        entry[1] = bins[k].batches;
+        memcpy(&entry[2], bins[k].bias, sizeof (bins[k].bias));
+        entry += GYRO_TEMP_BIN_FLOATS;
+    }
+}
+
+/**
+ * @Function Gyro_temp_set_table(const float table[GYRO_TEMP_TABLE_SIZE])
+ * @param table, bins saved by Gyro_temp_get_table()
+ * @return SUCCESS or ERROR for a table that is erased, from another layout or
+ * holds values out of range, which leaves the bins as they were
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_set_table(const float table[GYRO_TEMP_TABLE_SIZE]) {
+    const float *entry = &table[2];
+    float edge;
+    uint8_t axis;
+    uint8_t k;
+
+    /* an erased EEPROM reads NaN and fails the comparisons */
+    if (!(table[0] == TABLE_MAGIC) || !(table[1] == GYRO_TEMP_BINS)) {
+        return ERROR;
+    }
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        if (!(entry[1] >= 0) || !(entry[1] <= GYRO_TEMP_BIN_BATCHES)) {
+            return ERROR;
+        }
+        if (entry[1] > 0) {
+            edge = GYRO_TEMP_MIN_C + k * GYRO_TEMP_BIN_C;
+            if (!(entry[0] >= edge - BIN_TEMP_TOL)
+                    || !(entry[0] <= edge + GYRO_TEMP_BIN_C + BIN_TEMP_TOL)) {
+                return ERROR;
+            }
+            for (axis = 0; axis < MSZ; axis++) {
+                if (!(fabsf(entry[2 + axis]) <= GYRO_TEMP_BIAS_MAX)) {
+                    return ERROR;
+                }
+            }
+        }
+        entry += GYRO_TEMP_BIN_FLOATS;
+    }
+
+    entry = &table[2];
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        bins[k].temp = entry[0];
+        bins[k].batches = entry[1];
+        memcpy(bins[k].bias, &entry[2], sizeof (bins[k].bias));
+        entry += GYRO_TEMP_BIN_FLOATS;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function Gyro_temp_get_status(gyro_temp_status_t *status)
+ * @param status, progress of the learning and the last fit
+ * @author Aaron Hunter
+ */
+void Gyro_temp_get_status(gyro_temp_status_t *status_out) {
+    *status_out = status;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function batch_restart(void)
+ * @brief empties the batch
+ * @author Aaron Hunter
+ */
+static void batch_restart(void) {
+    n = 0;
+    memset(batch_mean, 0, sizeof (batch_mean));
+    batch_temp = 0;
+    status.samples = 0;
+}
+
+/**
+ * @Function bin_add(float temp_c, const float bias[MSZ])
+ * @param temp_c, mean temperature of the batch
+ * @param bias, mean rates of the batch
+ * @brief folds the batch into its bin with weight 1 / batches, which stops
+ * shrinking at GYRO_TEMP_BIN_BATCHES so the bin then forgets old batches
+ * exponentially.  A batch outside the bins is dropped.
+ * @author Aaron Hunter
+ */
+static void bin_add(float temp_c, const float bias[MSZ]) {
+    gyro_temp_bin_t *bin;
+    float weight;
+    float slot = floorf((temp_c - GYRO_TEMP_MIN_C) / GYRO_TEMP_BIN_C);
+    uint8_t axis;
+
+    if (!(slot >= 0) || !(slot < GYRO_TEMP_BINS)) {
+        return;
+    }
+    bin = &bins[(uint8_t) slot];
+    if (bin->batches < GYRO_TEMP_BIN_BATCHES) {
+        bin->batches += 1.0f;
+    }
+    weight = 1.0f / bin->batches;
+    bin->temp += weight * (temp_c - bin->temp);
+    for (axis = 0; axis < MSZ; axis++) {
+        bin->bias[axis] += weight * (bias[axis] - bin->bias[axis]);
+    }
+    status.batches++;
+}
+
+/**
+ * @Function fit_degree(uint8_t degree, float coef[MSZ][IMU_TEMP_TERMS])
+ * @param degree, 0 to IMU_TEMP_TERMS - 1
+ * @param coef, the polynomials in (T - IMU_TEMP_REF_C), zero above degree
+ * @return SUCCESS or ERROR if the normal equations are singular
+ * @brief least squares with every bin weighted the same, Gaussian
+ * elimination with partial pivoting on the shared matrix and all three axes
+ * as right hand sides
+ * @author Aaron Hunter
+ */
+static int8_t fit_degree(uint8_t degree, float coef[MSZ][IMU_TEMP_TERMS]) {
+    float m[IMU_TEMP_TERMS][IMU_TEMP_TERMS + MSZ]; // normal matrix and right hand sides
+    float x_pow[2 * IMU_TEMP_TERMS - 1];
+    float swap;
+    float factor;
+    float x;
+    float scale;
+    uint8_t terms = degree + 1;
+    uint8_t cols = terms + MSZ;
+    uint8_t row;
+    uint8_t col;
+    uint8_t pivot;
+    uint8_t axis;
+    uint8_t k;
+
+    memset(m, 0, sizeof (m));
+    for (k = 0; k < GYRO_TEMP_BINS; k++) {
+        if (bins[k].batches > 0) {
+            x = (bins[k].temp - IMU_TEMP_REF_C) / FIT_SCALE_C;
+            x_pow[0] = 1.0f;
+            for (col = 1; col < 2 * terms - 1; col++) {
+                x_pow[col] = x_pow[col - 1] * x;
+            }
+            for (row = 0; row < terms; row++) {
+                for (col = 0; col < terms; col++) {
+                    m[row][col] += x_pow[row + col];
+                }
+                for (axis = 0; axis < MSZ; axis++) {
+                    m[row][terms + axis] += x_pow[row] * bins[k].bias[axis];
+                }
+            }
+        }
+    }
+
+    /* forward elimination, the pivot is relative to the bin count on the
+     * diagonal of row 0 */
+    for (row = 0; row < terms; row++) {
+        pivot = row;
+        for (k = row + 1; k < terms; k++) {
+            if (fabsf(m[k][row]) > fabsf(m[pivot][row])) {
+                pivot = k;
+            }
+        }
+        if (!(fabsf(m[pivot][row]) > PIVOT_MIN * m[0][0])) {
+            return ERROR;
+        }
+        if (pivot != row) {
+            for (col = 0; col < cols; col++) {
+                swap = m[row][col];
+                m[row][col] = m[pivot][col];
+                m[pivot][col] = swap;
+            }
+        }
+        for (k = row + 1; k < terms; k++) {
+            factor = m[k][row] / m[row][row];
+            for (col = row; col < cols; col++) {
+                m[k][col] -= factor * m[row][col];
+            }
+        }
+    }
+    /* back substitution, then undo the temperature scaling */
+    memset(coef, 0, MSZ * IMU_TEMP_TERMS * sizeof (float));
+    for (axis = 0; axis < MSZ; axis++) {
+        for (row = terms; row-- > 0;) {
+            x = m[row][terms + axis];
+            for (col = row + 1; col < terms; col++) {
+                x -= m[row][col] * coef[axis][col];
+            }
+            coef[axis][row] = x / m[row][row];
+        }
+        scale = 1.0f;
+        for (row = 1; row < terms; row++) {
+            scale /= FIT_SCALE_C;
+            coef[axis][row] *= scale;
+        }
+    }
+    return SUCCESS;
+}
+
+#ifdef GYRO_TEMP_TESTING
+#include "SerialM32.h"
+#include <stdio.h>
+#ifdef HAL_SIM
+#include "HAL_sim.h"
+#include "HAL_sim_devices.h"
+#endif
+
+#define TEST_RATE 50 // Hz, MEAS_PERIOD of the AHRS apps
+#define TEST_NOISE 0.15 // deg/sec rms, as the SITL gyros
+#define TEST_ACC_NOISE 0.005 // g rms
+#define TEST_WARMUP_C 12.0f // die temperature rise over a session
+#define TEST_WARMUP_SEC 600.0f // time constant of the rise
+#define TEST_SESSION_SEC 1800
+#define TEST_MOTION_SEC 20 // handled every TEST_MOTION_EVERY sec for this long
+#define TEST_MOTION_EVERY 120
+#define TEST_ERR_TOL 0.03f // model error over the learned range, deg/sec
+
+static uint32_t lcg_state = 12345;
+
+/* deg/sec at 25 C, per deg C and per deg C^2, a few times the ICM-20948's
+ * typical sensitivity so the curvature is well above the noise */
+static const float truth[MSZ][IMU_TEMP_TERMS] = {
+    {0.20f, 0.030f, 0.0008f},
+    {-0.15f, -0.020f, 0.0005f},
+    {0.30f, 0.010f, -0.0006f}
+};
+
+static float test_uniform(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return ((lcg_state >> 8) + 0.5f) / 16777216.0f;
+}
+
+static float test_gauss(void) {
+    return sqrtf(-2.0f * logf(test_uniform())) * cosf(6.2831853f * test_uniform());
+}
+
+static float test_bias(uint8_t axis, float temp_c) {
+    float dt = temp_c - IMU_TEMP_REF_C;
+    return truth[axis][0] + dt * (truth[axis][1] + dt * truth[axis][2]);
+}
+
+/* worst model error over min_c to max_c in 0.5 C steps */
+static float test_model_err(const IMU_gyro_temp_model_t *model, float min_c, float max_c) {
+    float err_max = 0;
+    float err;
+    float temp_c;
+    float dt;
+    uint8_t axis;
+
+    for (temp_c = min_c; temp_c <= max_c; temp_c += 0.5f) {
+        dt = temp_c - IMU_TEMP_REF_C;
+        for (axis = 0; axis < MSZ; axis++) {
+            err = fabsf(model->c[axis][0] + dt * (model->c[axis][1] + dt * model->c[axis][2])
+                    - test_bias(axis, temp_c));
+            err_max = err > err_max ? err : err_max;
+        }
+    }
+    return err_max;
+}
+
+/* one warm-up from ambient_c, picked up and turned now and then, or the whole
+ * time if always_moving */
+static void test_session(float ambient_c, int8_t always_moving) {
+    float gyro[MSZ];
+    float acc[MSZ];
+    float temp_c;
+    float tilt;
+    float t;
+    long i;
+    int8_t is_moving;
+    uint8_t axis;
+
+    for (i = 0; i < (long) TEST_SESSION_SEC * TEST_RATE; i++) {
+        t = (float) i / TEST_RATE;
+        temp_c = ambient_c + TEST_WARMUP_C * (1.0f - expf(-t / TEST_WARMUP_SEC));
+        is_moving = always_moving || (((long) t % TEST_MOTION_EVERY) < TEST_MOTION_SEC);
+        tilt = is_moving ? 0.5f * sinf(t) : 0;
+        for (axis = 0; axis < MSZ; axis++) {
+            gyro[axis] = test_bias(axis, temp_c) + (float) TEST_NOISE * test_gauss()
+                    + (is_moving ? 28.6f * cosf(t) : 0);
+        }
+        acc[0] = sinf(tilt) + (float) TEST_ACC_NOISE * test_gauss();
+        acc[1] = (float) TEST_ACC_NOISE * test_gauss();
+        acc[2] = cosf(tilt) + (float) TEST_ACC_NOISE * test_gauss();
+        Gyro_temp_update(gyro, acc, temp_c);
+    }
+}
+
+/* saves the bins, clears them and loads them back as across a power cycle */
+static int8_t test_power_cycle(void) {
+    float table[GYRO_TEMP_TABLE_SIZE];
+    Gyro_temp_get_table(table);
+    Gyro_temp_init();
+    return Gyro_temp_set_table(table);
+}
+
+static int test_check(const char *name, int8_t is_ok) {
+    if (is_ok == FALSE) {
+        printf("FAIL %s\r\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+#ifdef HAL_SIM
+#define TEST_GYRO_COUNTS_PER_DPS (32767.0f / 500.0f)
+
+static HAL_sim_icm_t icm;
+
+/* reads one sample through the driver at temp_c, returns the worst axis error
+ * against the true rate, zero */
+static float test_driver_sample(float temp_c, float gyro_out[MSZ]) {
+    int16_t acc_counts[MSZ] = {0, 0, 16384};
+    int16_t mag_counts[MSZ] = {0, 0, 0};
+    int16_t gyro_counts[MSZ];
+    struct IMU_out data;
+    float err = 0;
+    uint8_t axis;
+
+    for (axis = 0; axis < MSZ; axis++) {
+        gyro_counts[axis] = (int16_t) lroundf(test_bias(axis, temp_c) * TEST_GYRO_COUNTS_PER_DPS);
+    }
+    HAL_sim_icm_set_data(&icm, acc_counts, gyro_counts, mag_counts,
+            (int16_t) lroundf((temp_c - IMU_TEMP_OFFSET_C) * IMU_TEMP_SENSE));
+    IMU_start_data_acq();
+    while (IMU_is_data_ready() == FALSE) {
+        HAL_sim_poll();
+    }
+    IMU_get_norm_data(&data);
+    gyro_out[0] = data.gyro.x;
+    gyro_out[1] = data.gyro.y;
+    gyro_out[2] = data.gyro.z;
+    for (axis = 0; axis < MSZ; axis++) {
+        err = fabsf(gyro_out[axis]) > err ? fabsf(gyro_out[axis]) : err;
+    }
+    return err;
+}
+#endif
+
+int main(void) {
+    IMU_gyro_temp_model_t model;
+    IMU_gyro_temp_model_t first;
+    gyro_temp_status_t s;
+    float table[GYRO_TEMP_TABLE_SIZE];
+    float err;
+    int failures = 0;
+
+    Board_init();
+    Serial_init();
+    printf("Gyro_temp test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    /* nothing learned, nothing to fit */
+    Gyro_temp_init();
+    failures += test_check("empty fit", Gyro_temp_fit(&model) == ERROR);
+
+    /* one warm-up from 20 C covers a span for a line */
+    test_session(20.0f, FALSE);
+    Gyro_temp_fit(&first);
+    Gyro_temp_get_status(&s);
+    err = test_model_err(&first, s.min_c, s.max_c);
+    printf("one warm-up: %u batches, %u bins, %.1f to %.1f C, degree %d, "
+            "rms %.4f, max error %.4f dps\r\n", s.batches, s.bins, (double) s.min_c,
+            (double) s.max_c, s.degree, (double) s.rms, (double) err);
+    failures += test_check("one warm-up", (s.degree == 1) && (err < TEST_ERR_TOL));
+
+    /* warm-ups from other ambients, each after a power cycle */
+    failures += test_check("power cycle", test_power_cycle() == SUCCESS);
+    test_session(5.0f, FALSE);
+    failures += test_check("power cycle", test_power_cycle() == SUCCESS);
+    test_session(35.0f, FALSE);
+    failures += test_check("power cycle", test_power_cycle() == SUCCESS);
+    Gyro_temp_fit(&model);
+    Gyro_temp_get_status(&s);
+    err = test_model_err(&model, s.min_c, s.max_c);
+    printf("three warm-ups: %u bins, %.1f to %.1f C, degree %d, rms %.4f, "
+            "max error %.4f dps\r\n", s.bins, (double) s.min_c, (double) s.max_c, s.degree,
+            (double) s.rms, (double) err);
+    failures += test_check("three warm-ups", (s.degree == 2) && (err < TEST_ERR_TOL)
+            && (s.min_c < 10.0f) && (s.max_c > 40.0f));
+
+    /* always moving learns nothing */
+    Gyro_temp_get_table(table);
+    Gyro_temp_init();
+    test_session(20.0f, TRUE);
+    Gyro_temp_get_status(&s);
+    failures += test_check("moving", (s.batches == 0) && (Gyro_temp_fit(&model) == ERROR));
+
+    /* erased and corrupted tables are rejected and change nothing */
+    Gyro_temp_set_table(table);
+    table[0] = NAN;
+    failures += test_check("erased table", Gyro_temp_set_table(table) == ERROR);
+    table[0] = 20948.25f;
+    table[2 + 7 * GYRO_TEMP_BIN_FLOATS + 2] = 50.0f;
+    failures += test_check("corrupted table", Gyro_temp_set_table(table) == ERROR);
+    Gyro_temp_fit(&model);
+    Gyro_temp_get_status(&s);
+    printf("rejected tables: %u bins kept, degree %d\r\n", s.bins, s.degree);
+    failures += test_check("table kept", (s.degree == 2) && (s.bins > 4));
+
+#ifdef HAL_SIM
+    {
+        IMU_gyro_temp_model_t bad = model;
+        struct IMU_out raw;
+        float bias[MSZ];
+        float gyro[MSZ];
+        float temp_c;
+        float err_max = 0;
+        float err_raw = 0;
+
+        /* the driver takes the model off the samples over the learned range */
+        HAL_sim_icm_attach(&icm, 1, 'E', 0);
+        IMU_init(IMU_SPI_DMA_MODE);
+        failures += test_check("model set", IMU_set_gyro_temp_model(&model) == SUCCESS);
+        for (temp_c = s.min_c; temp_c <= s.max_c; temp_c += 0.25f) {
+            err = test_driver_sample(temp_c, gyro);
+            err_max = err > err_max ? err : err_max;
+        }
+        IMU_get_gyro_temp_bias(bias);
+        failures += test_check("bias readback", fabsf(bias[0] - test_bias(0, s.max_c)) < 0.05f);
+        /* below 21 C the temperature counts are negative */
+        temp_c = s.min_c + 1.0f;
+        test_driver_sample(temp_c, gyro);
+        IMU_get_raw_data(&raw);
+        IMU_get_gyro_temp_bias(bias);
+        failures += test_check("cold die", (temp_c < IMU_TEMP_OFFSET_C)
+                && (raw.temp == lroundf((temp_c - IMU_TEMP_OFFSET_C) * IMU_TEMP_SENSE))
+                && (fabsf(bias[0] - test_bias(0, temp_c)) < 0.05f));
+        bad.c[1][2] = NAN;
+        failures += test_check("bad model", IMU_set_gyro_temp_model(&bad) == ERROR);
+        IMU_set_gyro_temp_model(NULL);
+        err_raw = test_driver_sample(50.0f, gyro);
+        printf("driver: max rate error %.4f dps compensated, %.4f dps without\r\n",
+                (double) err_max, (double) err_raw);
+        failures += test_check("driver", (err_max < TEST_ERR_TOL + 0.01f) && (err_raw > 0.5f));
+    }
+#endif
+
+    printf("%s\r\n", failures == 0 ? "Gyro_temp tests passed" : "Gyro_temp tests FAILED");
+    return 0;
+}
+#endif //GYRO_TEMP_TESTING
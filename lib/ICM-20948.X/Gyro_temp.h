@@ -0,0 +1,146 @@
+/*
+ * File:   Gyro_temp.h
+ * Author: Aaron Hunter
+ * Brief: Learns the gyro bias against die temperature for
+ * IMU_set_gyro_temp_model().  The ICM-20948 bias moves by a few hundredths of
+ * a deg/sec per degree C, so after every warm-up the AHRS has to integrate
+ * the change out slowly.  With the bias known as a function of temperature
+ * the driver takes it off the samples and the AHRS starts close to the right
+ * bias and can run lower integral gains.
+ *
+ * Learning: every sample taken while the IMU sits still goes into a batch,
+ * the same stationarity tests as Gyro_cal, and a batch of GYRO_TEMP_BATCH
+ * samples is averaged into the bin of its temperature.  Motion throws the
+ * batch away.  The bins are GYRO_TEMP_BIN_C wide and each holds the mean
+ * temperature and bias of its batches, the newest GYRO_TEMP_BIN_BATCHES
+ * weighted the most, so a long stay at one temperature counts as one point
+ * and an old bias fades out.
+ *
+ * Fitting: a least squares polynomial through the bin means, each bin
+ * weighted the same.  The degree grows with the temperature span the bins
+ * cover, GYRO_TEMP_SPAN_C per degree up to quadratic, so a short span gives
+ * a constant or a line rather than a curve through the noise.
+ *
+ * Persistence: the bins, not the fit, are saved, so the learning carries on
+ * over warm-ups that each cover a few degrees.  The table is
+ * GYRO_TEMP_TABLE_PAGES EEPROM pages of 16 floats, e.g.
+ *     Gyro_temp_get_table(table);
+ *     for (page = 0; page < GYRO_TEMP_TABLE_PAGES; page++)
+ *         EEPROM_write_float_array(&table[page * GYRO_TEMP_PAGE_FLOATS],
+ *                 GYRO_TEMP_PAGE_FLOATS, first_page + page, 0);
+ * and read back the same way into Gyro_temp_set_table(), which rejects an
+ * erased or foreign table.
+ *
+ * Usage:
+ *     Gyro_temp_init();
+ *     Gyro_temp_set_table(table); // optional
+ *     Gyro_temp_fit(&model) == SUCCESS then IMU_set_gyro_temp_model(&model);
+ *     every sample: Gyro_temp_update(rates + IMU_get_gyro_temp_bias(), acc, temp)
+ *     refit after Gyro_temp_update() returns TRUE
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef GYRO_TEMP_H // Header guard
+#define	GYRO_TEMP_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "ICM_20948.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+/* rates in deg/sec, temperatures in deg C */
+#ifndef GYRO_TEMP_BATCH
+#define GYRO_TEMP_BATCH 250 // stationary samples per batch, 5 sec at 50 Hz
+#endif
+#define GYRO_TEMP_BINS 16
+#define GYRO_TEMP_MIN_C -15.0f // lower edge of the first bin
+#define GYRO_TEMP_BIN_C 5.0f // bin width, the bins cover -15 to 65 C
+#define GYRO_TEMP_BIN_BATCHES 20.0f // batches a bin averages before it forgets
+#define GYRO_TEMP_SPAN_C 6.0f // temperature span the bins need per polynomial degree
+#define GYRO_TEMP_RATE_MAX 1.0 // deviation from the batch mean that counts as motion
+#define GYRO_TEMP_BIAS_MAX 5.0 // larger rates are not a bias
+#define GYRO_TEMP_ACC_TOL 0.05 // g, accelerometer magnitude error that counts as motion
+
+#define GYRO_TEMP_PAGE_FLOATS 16 // floats in a 64 byte EEPROM page
+#define GYRO_TEMP_BIN_FLOATS 5 // temperature, batches and bias per bin in the table
+#define GYRO_TEMP_TABLE_PAGES ((2 + GYRO_TEMP_BINS * GYRO_TEMP_BIN_FLOATS \
+        + GYRO_TEMP_PAGE_FLOATS - 1) / GYRO_TEMP_PAGE_FLOATS)
+#define GYRO_TEMP_TABLE_SIZE (GYRO_TEMP_TABLE_PAGES * GYRO_TEMP_PAGE_FLOATS)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint16_t samples; // stationary samples in the current batch
+    uint16_t batches; // batches binned since Gyro_temp_init()
+    uint8_t bins; // bins holding a bias
+    int8_t degree; // of the last fit, -1 before one
+    float min_c; // bin temperatures, deg C
+    float max_c;
+    float rms; // fit residual over the bins, deg/sec
+} gyro_temp_status_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Gyro_temp_init(void)
+ * @brief clears the bins and the batch
+ * @author Aaron Hunter
+ */
+void Gyro_temp_init(void);
+
+/**
+ * @Function Gyro_temp_update(float gyro[MSZ], float acc[MSZ], float temp_c)
+ * @param gyro, calibrated gyro rates without temperature compensation in
+ * deg/sec, the outputs plus IMU_get_gyro_temp_bias()
+ * @param acc, calibrated accelerometer in g
+ * @param temp_c, die temperature in deg C
+ * @return TRUE when a batch was binned, FALSE otherwise
+ * @brief adds the sample to the batch or, on motion, drops the batch
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_update(float gyro[MSZ], float acc[MSZ], float temp_c);
+
+/**
+ * @Function Gyro_temp_fit(IMU_gyro_temp_model_t *model)
+ * @param model, the polynomials through the bins
+ * @return SUCCESS or ERROR with no bins, which leaves model as it was
+ * @brief weighted least squares of the highest degree the span supports, a
+ * few hundred float operations, call it after new batches
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_fit(IMU_gyro_temp_model_t *model);
+
+/**
+ * @Function Gyro_temp_get_table(float table[GYRO_TEMP_TABLE_SIZE])
+ * @param table, the bins to save
+ * @author Aaron Hunter
+ */
+void Gyro_temp_get_table(float table[GYRO_TEMP_TABLE_SIZE]);
+
+/**
+ * @Function Gyro_temp_set_table(const float table[GYRO_TEMP_TABLE_SIZE])
+ * @param table, bins saved by Gyro_temp_get_table()
+ * @return SUCCESS or ERROR for a table that is erased, from another layout or
+ * holds values out of range, which leaves the bins as they were
+ * @author Aaron Hunter
+ */
+int8_t Gyro_temp_set_table(const float table[GYRO_TEMP_TABLE_SIZE]);
+
+/**
+ * @Function Gyro_temp_get_status(gyro_temp_status_t *status)
+ * @param status, progress of the learning and the last fit
+ * @author Aaron Hunter
+ */
+void Gyro_temp_get_status(gyro_temp_status_t *status);
+
+#endif	/* GYRO_TEMP_H */ // End of header guard
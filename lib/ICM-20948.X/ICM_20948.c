@@ -14,10 +14,19 @@
 #include "ICM_20948_registers.h"  //register definitions for the device
 #include "SerialM32.h"
 #include "Board.h"
+#include "System_timer.h"
+#ifdef AHRS_FIXED_POINT
+#include "Lin_alg_inline.h"
+#endif
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/attribs.h>  //for ISR definitions
+#include <sys/kmem.h> //for KVA_TO_PA() DMA addresses
 #include <proc/p32mx795f512l.h>
+#ifdef ICM_BENCHMARK
+#include "Benchmark.h"
+#endif
 
 
 /*******************************************************************************
@@ -51,6 +60,27 @@
 //#define INTERFACE_MODE IMU_I2C_MODE 
 #define IMU_CS_TRIS TRISEbits.TRISE0 //chip select for IMU
 #define IMU_CS_LAT LATEbits.LATE0
+#define IMU_DMA_RX_PRIORITY 3 // must beat the TX channel to SPI1BUF on each RX event
+#define IMU_DMA_TX_PRIORITY 2
+#define IMU_NUM_FRAMES 3 // being filled, newest complete, being read
+#define IMU_INT_TRIS TRISEbits.TRISE9 // IMU INT on INT2, J20 pin 2
+
+/*FIFO mode, a FIFO packet has the layout of the IMU_NUM_BYTES data registers*/
+#define IMU_FIFO_SIZE 512
+#define IMU_FIFO_MAX_BYTES (IMU_FIFO_MAX_BATCH * IMU_NUM_BYTES) // one DMA block, under 256
+#define IMU_FIFO_COUNT_BYTES 2
+#define IMU_FIFO_COUNT_MASK 0x1FFF
+#define IMU_FIFO_ODR_DIV 1 // 1125 Hz / (1 + div) = 562.5 Hz gyro and accel
+#define IMU_FIFO_PERIOD_USEC (((1 + IMU_FIFO_ODR_DIV) * 1000000ul + 562) / 1125)
+#define IMU_DRDY_ODR_DIV 4 // 225 Hz, a fresh sample for every 100 Hz control step
+#define USER_CTRL_MST_EN_IF_DIS 0x30 // I2C master on, I2C slave interface off
+#define USER_CTRL_FIFO_EN 0x40
+#define FIFO_EN_1_SLV_0 0x01 // the magnetometer registers read by slave 0
+#define FIFO_EN_2_ACC_GYRO_TEMP 0x1F
+#define FIFO_MODE_SNAPSHOT 0x01 // stop when full, a stream would split packets
+#define FIFO_RST_ALL 0x1F
+#define INT_PIN_CFG_PULSE 0x00 // active high, push pull, 50 usec pulse
+#define INT_ENABLE_1_RAW_DATA_RDY 0x01
 
 /*IMU scaling factors*/
 #define ACCEL_SCALE 2.0  //+/-2000mg
@@ -61,8 +91,7 @@
 #define MAG_DIV 32752.0 // max reading
 #define E_b 47.4148 //expected value of earth's mag field in uTesla
 #define T_BIAS 0
-#define T_SENSE 333.87
-#define T_OFFSET 21
+#define T_STEP_COUNTS 33 // ~0.1 C, temperature change that re-evaluates the gyro bias model
 #define RAW 0
 #define SCALED 1
 #define HIGHRES 2
@@ -86,21 +115,65 @@ typedef enum {
     IMU_SPI_READ_LAST_REG,
 } IMU_SPI_SM_states_t;
 
+typedef enum {
+    IMU_FIFO_IDLE,
+    IMU_FIFO_READ_COUNT,
+    IMU_FIFO_READ_DATA,
+} IMU_FIFO_states_t;
+
+/* a burst read frame: the byte clocked in while the register address goes
+ * out, then the data registers, or in FIFO mode up to IMU_FIFO_MAX_BATCH
+ * packets, so DMA can land the frame in one block */
+typedef struct {
+    uint8_t spi[IMU_FIFO_MAX_BYTES + 1];
+    uint8_t packets; // IMU_NUM_BYTES packets in the frame
+    uint32_t usec; // Sys_timer_get_usec() time of the newest packet
+} IMU_frame_t;
+
+/* v = A counts + b, register counts to output units for one sensor */
+typedef struct {
+    float A[MSZ][MSZ];
+    float b[MSZ];
+} IMU_affine_t;
+
 /*module level variables*/
-static uint8_t IMU_raw_data[IMU_NUM_BYTES];
-static float acc_v_raw[3] = {0, 0, 0};
+/* The ISRs fill one frame while another holds the newest complete frame and
+ * the getters read the third, so a frame being read is never written and no
+ * frame is copied.  IMU_publish_frame() and IMU_take_frame() swap them. */
+static IMU_frame_t IMU_frames[IMU_NUM_FRAMES];
+static volatile uint8_t IMU_fill_frame = 0;
+static volatile uint8_t IMU_ready_frame = 1;
+static volatile uint8_t IMU_read_frame = 2;
+static volatile uint32_t IMU_frame_seq = 0; // frames published
+static uint32_t IMU_read_seq = 0; // IMU_frame_seq of the frame read
+#define IMU_fill_data (IMU_frames[IMU_fill_frame].spi + 1)
+static uint8_t IMU_dma_tx[IMU_FIFO_MAX_BYTES]; // MOSI is don't care once the read address is sent
+static char IMU_interface = IMU_SPI_MODE;
+/* FIFO batch read state, the batch is one packet in the other modes */
+static volatile IMU_FIFO_states_t IMU_fifo_state = IMU_FIFO_IDLE;
+static uint8_t IMU_fifo_watermark = IMU_FIFO_WATERMARK;
+static volatile uint8_t IMU_batch_size = 1; // packets in the frame
+static volatile uint32_t IMU_acq_usec = 0; // Sys_timer_get_usec() of the frame being filled
+static volatile uint8_t IMU_fifo_full = FALSE;
+static volatile uint32_t IMU_fifo_overflows = 0;
+/* register counts of the newest sample, the mag in its own axes */
+static int16_t acc_v_counts[3] = {0, 0, 0};
+static int16_t mag_v_counts[3] = {0, 0, 0};
+static int16_t gyro_v_counts[3] = {0, 0, 0};
 static float acc_v_scaled[3] = {0, 0, 0};
 static float acc_v_norm[3] = {0, 0, 0};
-static float mag_v_raw[3] = {0, 0, 0};
 static float mag_v_scaled[3] = {0, 0, 0};
 static float mag_v_norm[3] = {0, 0, 0};
-static float gyro_v_raw[3] = {0, 0, 0};
 static float gyro_v_scaled[3] = {0, 0, 0};
 static int16_t temp_raw = 0;
+static uint32_t sample_usec = 0;
 static float temp_scaled = 0;
 static int16_t status = 0;
-
-static volatile uint8_t IMU_data_ready = 0;
+/* IMU_NORM_DONE and IMU_SCALED_DONE once the sample is converted, cleared by
+ * a new sample or calibration */
+static uint8_t IMU_converted = 0;
+#define IMU_NORM_DONE 0x01
+#define IMU_SCALED_DONE 0x02
 const float acc_scale = ACCEL_SCALE / ACCEL_DIV;
 const float mag_scale = MAG_SCALE / MAG_DIV;
 const float gyro_scale = GYRO_SCALE / GYRO_DIV;
@@ -126,6 +199,43 @@ static float A_gyro[3][3] = {
     {0, 0, 1}
 };
 static float b_gyro[3] = {0, 0, 0};
+
+/* the mag x axis is the accel x axis, y and z are reversed */
+static const float mag_axis[MSZ] = {1, -1, -1};
+
+/* the calibrations, axis rotation and scale factors folded into one transform
+ * per sensor and output by IMU_update_cal() */
+static IMU_affine_t acc_norm_cal;
+static IMU_affine_t mag_norm_cal;
+static IMU_affine_t gyro_scaled_cal;
+static IMU_affine_t acc_scaled_cal;
+static IMU_affine_t mag_scaled_cal;
+
+/* gyro bias against temperature, the bias at gyro_temp_counts is the negated
+ * gyro offset of the transforms */
+static IMU_gyro_temp_model_t gyro_temp_model;
+static int8_t is_gyro_temp_model = FALSE;
+static int16_t gyro_temp_counts = 0;
+static float gyro_temp_bias[MSZ] = {0, 0, 0};
+
+#ifdef AHRS_FIXED_POINT
+/* fixed point copies of the calibrations, identity until one is set */
+#define CAL_FIX_IDENTITY {{{Q30_ONE, 0, 0}, {0, Q30_ONE, 0}, {0, 0, Q30_ONE}}, 0, {0, 0, 0}}
+static lin_alg_fix_cal_t acc_cal_fix = CAL_FIX_IDENTITY;
+static lin_alg_fix_cal_t mag_cal_fix = CAL_FIX_IDENTITY;
+/* counts to rad/sec, gyro_scale * pi / 180 ~ 2.7e-4 scaled by 2^(30 + 12) */
+#define GYRO_FIX_SHIFT 12
+#define GYRO_FIX_SCALE ((int32_t) (GYRO_SCALE / GYRO_DIV * 3.14159265358979 / 180.0 \
+        * (double) (1LL << (30 + GYRO_FIX_SHIFT)) + 0.5))
+static lin_alg_fix_cal_t gyro_cal_fix = {
+    {
+        {GYRO_FIX_SCALE, 0, 0},
+        {0, GYRO_FIX_SCALE, 0},
+        {0, 0, GYRO_FIX_SCALE}
+    }, GYRO_FIX_SHIFT,
+    {0, 0, 0}
+};
+#endif
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                 *
  ******************************************************************************/
@@ -158,14 +268,126 @@ static void IMU_run_I2C_state_machine(void);
 static void IMU_run_SPI_state_machine(uint8_t byte_read);
 
 /**
- * @Function IMU_process_data(void)
- * @param none
+ * @Function IMU_DMA_init(void)
+ * @brief sets up DMA channel 0 to move SPI1BUF into the frame buffer and
+ * channel 1 to write the next don't care byte, both on the SPI1 RX event
+ * @author Aaron Hunter
+ */
+static void IMU_DMA_init(void);
+
+/**
+ * @Function IMU_DMA_start(uint16_t num_bytes)
+ * @param num_bytes, bytes to read after the address byte
+ * @brief points channel 0 at the frame being filled, then sizes and enables
+ * both channels
+ * @author Aaron Hunter
+ */
+static void IMU_DMA_start(uint16_t num_bytes);
+
+/**
+ * @Function IMU_acq_init(char interface_mode)
+ * @param interface_mode, one of the SPI modes
+ * @brief sets the sample rate, the FIFO and the data ready interrupt the mode
+ * uses and turns off the others
+ * @author Aaron Hunter
+ */
+static void IMU_acq_init(char interface_mode);
+
+/**
+ * @Function IMU_FIFO_start_count(void)
+ * @return SUCCESS
+ * @brief first half of a FIFO read, reads FIFO_COUNT by DMA
+ * @author Aaron Hunter
+ */
+static int8_t IMU_FIFO_start_count(void);
+
+/**
+ * @Function IMU_FIFO_start_batch(void)
+ * @brief second half of a FIFO read, run from the DMA interrupt: reads the
+ * whole packets counted if they reach the watermark
+ * @author Aaron Hunter
+ */
+static void IMU_FIFO_start_batch(void);
+
+/**
+ * @Function IMU_latest_packet(void)
+ * @return the newest packet of the frame being read
+ * @author Aaron Hunter
+ */
+static const uint8_t *IMU_latest_packet(void);
+
+/**
+ * @Function IMU_publish_frame(void)
+ * @brief makes the frame just filled the newest and picks the next to fill,
+ * run at the end of a read
+ * @author Aaron Hunter
+ */
+static void IMU_publish_frame(void);
+
+/**
+ * @Function IMU_take_frame(void)
+ * @return TRUE if a frame was published since the last one taken
+ * @brief hands the newest frame to the getters and converts its newest packet
+ * @author Aaron Hunter
+ */
+static uint8_t IMU_take_frame(void);
+
+/**
+ * @Function IMU_norm_to_output(struct IMU_out* IMU_data)
+ * @param IMU_data, the sample loaded by IMU_process_data(), calibrated
+ * @brief the IMU_get_norm_data() conversion without taking a frame, so
+ * IMU_get_batch() converts its own packets and a frame published meanwhile
+ * cannot replace them
+ * @author Aaron Hunter
+ */
+static void IMU_norm_to_output(struct IMU_out* IMU_data);
+
+/**
+ * @Function IMU_raw_to_output(struct IMU_out* IMU_data)
+ * @param IMU_data, the counts of the sample loaded by IMU_process_data()
+ * @author Aaron Hunter
+ */
+static void IMU_raw_to_output(struct IMU_out* IMU_data);
+
+/**
+ * @Function IMU_process_data(const uint8_t *raw)
+ * @param raw, IMU_NUM_BYTES of data registers or one FIFO packet
  * @return SUCCESS or ERROR
  * @brief converts raw register data into module variable data
  * @note mag data has reversed byte order
  * @author ahunter
  * @modified  7/19/22*/
-static void IMU_process_data(void);
+static void IMU_process_data(const uint8_t *raw);
+
+/**
+ * @Function IMU_update_cal(void)
+ * @brief rebuilds the transforms from the calibrations and scale factors
+ * @author Aaron Hunter
+ */
+static void IMU_update_cal(void);
+
+/**
+ * @Function IMU_update_temp_bias(void)
+ * @brief evaluates the gyro bias model at temp_raw and sets the gyro offsets
+ * @author Aaron Hunter
+ */
+static void IMU_update_temp_bias(void);
+
+/**
+ * @Function IMU_check_temp_bias(void)
+ * @brief IMU_update_temp_bias() once temp_raw has moved T_STEP_COUNTS
+ * @author Aaron Hunter
+ */
+static void IMU_check_temp_bias(void);
+
+/**
+ * @Function IMU_apply_cal(const IMU_affine_t *cal, const int16_t counts[MSZ], float v_out[MSZ])
+ * @param cal, the transform
+ * @param counts, register counts
+ * @param v_out, A counts + b
+ * @author Aaron Hunter
+ */
+static void IMU_apply_cal(const IMU_affine_t *cal, const int16_t counts[MSZ], float v_out[MSZ]);
 
 /**
  * @Function IMU_assign_data_to_output(struct IMU_output* IMU_data);
@@ -177,25 +399,6 @@ static void IMU_process_data(void);
 static uint8_t IMU_assign_data_to_output(struct IMU_out* IMU_data);
 
 
-/**
- * @function m_v_mult()
- * Multiplies a matrix with a vector
- * @param m A matrix to be multiplied with a vector
- * @param v A vector to be multiplied with a matrix
- * @param v_out The product of the matrix and vector
- * @return SUCCESS or ERROR
- */
-static uint8_t m_v_mult(float m[MSZ][MSZ], float v[MSZ], float v_out[MSZ]);
-
-/**
- * @function v_v_add()
- * Add a vector value to a vector
- * @param v1 Vector to add to another vector
- * @param v2 Vector to have a vector added to it
- * @param v_out Vector as sum of two vectors
- */
-static void v_v_add(float v1[MSZ], float v2[MSZ], float v_out[MSZ]);
-
 /**
  * @function m_scale()
  * Scales matrix
@@ -226,7 +429,10 @@ static void v_scale(float s, float v[MSZ]);
 uint8_t IMU_init(char interface_mode) {
     uint32_t pb_clk;
     uint8_t value = 0;
+    uint8_t frame;
     pb_clk = Board_get_PB_clock();
+    IMU_interface = interface_mode;
+    IMU_update_cal();
     if (interface_mode == IMU_I2C_MODE) {
         __builtin_disable_interrupts();
         /*config priority and subpriority--must match IPL level*/
@@ -264,6 +470,7 @@ uint8_t IMU_init(char interface_mode) {
     } else {
         /*Disable the SPI interrupts in the respective IEC0/1 register.*/
         __builtin_disable_interrupts();
+        IEC0bits.INT2IE = 0; // no data ready reads during setup
         SPI1CON = 0; // Stop and reset the SPI module by clearing the ON bit.
         /* Note: When using 1:1 PBCLK divisor, the user's software should not
          *  read/write the peripheral's SFRs in the SYSCLK cycle immediately
@@ -272,9 +479,9 @@ uint8_t IMU_init(char interface_mode) {
         IMU_CS_TRIS = 0; // set CS as output 
         IMU_CS_LAT = 1; // deselect device 
         SPI1BUF; // clear receive buffer 
-        /*set up SPI1 RX interrupt*/
+        /*set up SPI1 RX interrupt, in DMA mode the RX event only starts the DMA*/
         IFS0bits.SPI1RXIF = 0; // clear interrupt flag
-        IEC0bits.SPI1RXIE = 1; //enable interrupt
+        IEC0bits.SPI1RXIE = (interface_mode == IMU_SPI_MODE); //enable interrupt
         IPC5bits.SPI1IP = 5; //interrupt priority 5
         IPC5bits.SPI1IS = 0; //subpriority 0
         SPI1BRG = pb_clk / (2 * IMU_SPI_FREQ) - 1; // set frequency 
@@ -296,7 +503,7 @@ uint8_t IMU_init(char interface_mode) {
             return ERROR;
         }
         //printf("IMU returned who am I = 0x%x \r\n", value);
-        SPI_set_reg(AGB0_REG_USER_CTRL, 0x30); //enable master I2C, disable slave I2C interface
+        SPI_set_reg(AGB0_REG_USER_CTRL, USER_CTRL_MST_EN_IF_DIS); //enable master I2C, disable slave I2C interface
         SPI_set_reg(AGB0_REG_PWR_MGMT_1, 0x01); //clear sleep bit and set clock to best available
         /*switch to user bank 3 to configure slave devices*/
         SPI_set_reg(AGB0_REG_REG_BANK_SEL, USER_BANK_3);
@@ -331,6 +538,29 @@ uint8_t IMU_init(char interface_mode) {
         SPI_set_reg(AGB2_REG_ACCEL_CONFIG, 0b00010001); // 114Hz 3dB LP, +/-2g FS
         /*return to user bank 0 for data read*/
         SPI_set_reg(AGB3_REG_REG_BANK_SEL, USER_BANK_0);
+        IMU_acq_init(interface_mode);
+        IMU_fifo_state = IMU_FIFO_IDLE;
+        IMU_batch_size = 1;
+        for (frame = 0; frame < IMU_NUM_FRAMES; frame++) {
+            IMU_frames[frame].packets = 1;
+        }
+        IMU_read_seq = IMU_frame_seq;
+        if (interface_mode != IMU_SPI_MODE) {
+            IMU_DMA_init();
+        }
+        if (interface_mode == IMU_SPI_DRDY_MODE) {
+            /*the data ready edge starts the reads, at the SPI interrupt's
+             *priority. RE9 is the Garmin LIDAR power enable otherwise, so it
+             *is only made an input here*/
+            IMU_INT_TRIS = 1;
+            INTCONbits.INT2EP = 1; // rising edge
+            IFS0bits.INT2IF = 0;
+            IPC2bits.INT2IP = 5;
+            IPC2bits.INT2IS = 0;
+            IEC0bits.INT2IE = 1;
+        } else {
+            IEC0bits.INT2IE = 0;
+        }
         /*restart interrupts*/
         __builtin_enable_interrupts();
         /*retrieve calibration matrices and vectors*/
@@ -343,20 +573,40 @@ uint8_t IMU_init(char interface_mode) {
  * @return none
  * @param none
  * @brief this function starts the SPI data read
+ * @note in the DMA modes a read still in flight is aborted and ERROR
+ * returned, the next call starts a fresh frame.  In FIFO mode this reads the
+ * FIFO count and the data follows only once the watermark is reached.
  * @author Aaron Hunter
  */
 int8_t IMU_start_data_acq(void) {
     int8_t error = FALSE;
+    if (IMU_interface == IMU_SPI_DRDY_MODE) {
+        return SUCCESS; // the data ready interrupt starts the reads
+    }
     if (IMU_CS_LAT == 0) {
         // printf("IMU error found\r\n");
         SPI1BUF; //read buffer
         IFS0bits.SPI1RXIF = 0; //clear any interrupt flag
         error = TRUE;
+        if (IMU_interface != IMU_SPI_MODE) {
+            DCH0ECONbits.CABORT = 1; // resets the channel pointers
+            DCH1ECONbits.CABORT = 1;
+            IMU_CS_LAT = 1;
+            IMU_fifo_state = IMU_FIFO_IDLE;
+            return ERROR;
+        }
     } else {
         error = FALSE;
     }
+    if (IMU_interface == IMU_SPI_FIFO_MODE) {
+        return IMU_FIFO_start_count();
+    }
     uint8_t data_reg = AGB0_REG_ACCEL_XOUT_H;
     data_reg = data_reg | (READ << 7);
+    if (IMU_interface == IMU_SPI_DMA_MODE) {
+        IMU_DMA_start(IMU_NUM_BYTES);
+    }
+    IMU_acq_usec = Sys_timer_get_usec();
     IMU_CS_LAT = 0; //select the IMU 
     SPI1BUF = data_reg; //start SPI transaction 
     if (error) {
@@ -373,7 +623,7 @@ int8_t IMU_start_data_acq(void) {
  * @author Aaron Hunter,
  * @modified  */
 uint8_t IMU_is_data_ready(void) {
-    return IMU_data_ready;
+    return (IMU_read_seq != IMU_frame_seq);
 }
 
 /**
@@ -384,23 +634,8 @@ uint8_t IMU_is_data_ready(void) {
  * @author Aaron Hunter,
  * @modified  */
 uint8_t IMU_get_raw_data(struct IMU_out* IMU_data) {
-    /* process data if new data is available */
-    if (IMU_data_ready == TRUE) {
-        IMU_process_data();
-        IMU_data_ready = FALSE; //clear the data ready flag
-    }
-    /* set output data to point at vector components*/
-    IMU_data->acc.x = acc_v_raw[0];
-    IMU_data->acc.y = acc_v_raw[1];
-    IMU_data->acc.z = acc_v_raw[2];
-    IMU_data->gyro.x = gyro_v_raw[0];
-    IMU_data->gyro.y = gyro_v_raw[1];
-    IMU_data->gyro.z = gyro_v_raw[2];
-    IMU_data->temp = temp_raw;
-    IMU_data->mag.x = mag_v_raw[0];
-    IMU_data->mag.y = mag_v_raw[1];
-    IMU_data->mag.z = mag_v_raw[2];
-    IMU_data->mag_status = status;
+    IMU_take_frame(); // convert the newest frame if there is one
+    IMU_raw_to_output(IMU_data);
     return SUCCESS;
 }
 
@@ -413,26 +648,118 @@ uint8_t IMU_get_raw_data(struct IMU_out* IMU_data) {
  * @author Aaron Hunter,
  **/
 void IMU_get_norm_data(struct IMU_out* IMU_data) {
-    /* process data if new data is available */
-    if (IMU_data_ready == TRUE) {
-        IMU_process_data(); // get raw data and return pointer
-        IMU_data_ready = FALSE; //clear the data ready flag
+    IMU_take_frame(); // convert the newest frame if there is one
+    IMU_norm_to_output(IMU_data);
+}
+
+/**
+ * @Function IMU_get_batch(struct IMU_out samples[], uint8_t max_samples)
+ * @return number of samples copied, 0 if no batch is ready or the interface
+ * is not IMU_SPI_FIFO_MODE
+ * @brief returns the last FIFO batch oldest first, each sample calibrated as
+ * IMU_get_norm_data() and stamped with its Sys_timer_get_usec() time
+ * @note the stamps count back one sample period per packet from the FIFO
+ * count, so they are exact relative to each other and within a period
+ * absolute.  With room for fewer than the batch the newest are returned.
+ * @author Aaron Hunter
+ **/
+uint8_t IMU_get_batch(struct IMU_out samples[], uint8_t max_samples) {
+    const IMU_frame_t *frame;
+    uint8_t first;
+    uint8_t k;
+    uint8_t n = 0;
+    if (IMU_interface != IMU_SPI_FIFO_MODE || IMU_take_frame() == FALSE) {
+        return 0;
     }
-    IMU_normalize_data(); //scale mag and acc by A matrix and b vector from Dorveaux
-    /* set output data to point at vector components*/
-    IMU_data->acc.x = acc_v_norm[0];
-    IMU_data->acc.y = acc_v_norm[1];
-    IMU_data->acc.z = acc_v_norm[2];
-    IMU_data->gyro.x = gyro_v_scaled[0];
-    IMU_data->gyro.y = gyro_v_scaled[1];
-    IMU_data->gyro.z = gyro_v_scaled[2];
-    IMU_data->temp = temp_raw;
-    IMU_data->mag.x = mag_v_norm[0];
-    IMU_data->mag.y = mag_v_norm[1];
-    IMU_data->mag.z = mag_v_norm[2];
-    IMU_data->mag_status = status;
+    frame = &IMU_frames[IMU_read_frame];
+    first = (frame->packets > max_samples) ? frame->packets - max_samples : 0;
+    for (k = first; k < frame->packets; k++) {
+        IMU_process_data(frame->spi + 1 + k * IMU_NUM_BYTES);
+        sample_usec = frame->usec - (uint32_t) (frame->packets - 1 - k) * IMU_FIFO_PERIOD_USEC;
+        IMU_norm_to_output(&samples[n]);
+        n++;
+    }
+    return n;
 }
 
+/**
+ * @Function IMU_get_batch_raw_data(struct IMU_out* IMU_data)
+ * @param IMU_data, the counts of the newest sample of the last batch
+ * @return SUCCESS
+ * @brief IMU_get_raw_data() without taking a newer frame, so a batch
+ * published since IMU_get_batch() is left for the next call
+ * @author Aaron Hunter
+ **/
+uint8_t IMU_get_batch_raw_data(struct IMU_out* IMU_data) {
+    IMU_raw_to_output(IMU_data); // IMU_get_batch() ends on the newest packet
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_set_fifo_watermark(uint8_t num_samples)
+ * @param num_samples, packets the FIFO must hold before a read fetches them,
+ * 1 to IMU_FIFO_MAX_BATCH
+ * @return SUCCESS or ERROR if out of range
+ * @author Aaron Hunter
+ **/
+int8_t IMU_set_fifo_watermark(uint8_t num_samples) {
+    if (num_samples < 1 || num_samples > IMU_FIFO_MAX_BATCH) {
+        return ERROR;
+    }
+    IMU_fifo_watermark = num_samples;
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_get_fifo_overflows(void)
+ * @return times the FIFO filled up and was reset, samples were lost each time
+ * @author Aaron Hunter
+ **/
+uint32_t IMU_get_fifo_overflows(void) {
+    return IMU_fifo_overflows;
+}
+
+#ifdef AHRS_FIXED_POINT
+
+/**
+ * @Function IMU_get_norm_data_fix(struct IMU_out_fix* IMU_data)
+ * @return SUCCESS
+ * @brief applies the Dorveaux calibration to the raw counts in fixed point
+ * @note the counts are taken straight from the frame, the float raw vectors
+ * are converted as well but not calibrated by this call
+ * @author Aaron Hunter,
+ **/
+uint8_t IMU_get_norm_data_fix(struct IMU_out_fix* IMU_data) {
+    int16_t acc_counts[MSZ];
+    int16_t gyro_counts[MSZ];
+    int16_t mag_counts[MSZ];
+    const uint8_t *raw;
+
+    IMU_take_frame();
+    raw = IMU_latest_packet();
+
+    /* same byte order and mag axis rotation as IMU_process_data() */
+    acc_counts[0] = (int16_t) (raw[0] << 8 | raw[1]);
+    acc_counts[1] = (int16_t) (raw[2] << 8 | raw[3]);
+    acc_counts[2] = (int16_t) (raw[4] << 8 | raw[5]);
+    gyro_counts[0] = (int16_t) (raw[6] << 8 | raw[7]);
+    gyro_counts[1] = (int16_t) (raw[8] << 8 | raw[9]);
+    gyro_counts[2] = (int16_t) (raw[10] << 8 | raw[11]);
+    mag_counts[0] = (int16_t) (raw[16] << 8 | raw[15]);
+    mag_counts[1] = (int16_t) ((raw[18] << 8 | raw[17])*-1);
+    mag_counts[2] = (int16_t) ((raw[20] << 8 | raw[19])*-1);
+    IMU_data->temp = (int16_t) (raw[12] << 8 | raw[13]);
+    IMU_data->mag_status = (raw[14] << 8 | raw[22] & 0x8);
+    IMU_data->usec = IMU_frames[IMU_read_frame].usec;
+    IMU_check_temp_bias();
+
+    lin_alg_fix_cal_apply_inline(&acc_cal_fix, acc_counts, IMU_data->acc);
+    lin_alg_fix_cal_apply_inline(&gyro_cal_fix, gyro_counts, IMU_data->gyro);
+    lin_alg_fix_cal_apply_inline(&mag_cal_fix, mag_counts, IMU_data->mag);
+    return SUCCESS;
+}
+#endif //AHRS_FIXED_POINT
+
 /**
  * @Function IMU_get_scaled_data(void)
  * @return pointer to IMU_output struct 
@@ -441,13 +768,11 @@ void IMU_get_norm_data(struct IMU_out* IMU_data) {
  * @author Aaron Hunter,
  **/
 uint8_t IMU_get_scaled_data(struct IMU_out* IMU_data) {
-    /* process data if new data is available */
-    if (IMU_data_ready == TRUE) {
-        IMU_process_data(); // get and store raw data
-        IMU_data_ready = FALSE; //clear the data ready flag
+    IMU_take_frame(); // convert the newest frame if there is one
+    if ((IMU_converted & IMU_SCALED_DONE) == 0) {
+        IMU_scale_data(); // Dorveaux normalization and engineering units
+        IMU_converted |= IMU_SCALED_DONE;
     }
-    IMU_normalize_data(); // apply Dorveaux normalization
-    IMU_scale_data(); // scale the data to engineering units
     /* set output data to point at vector components*/
     IMU_data->acc.x = acc_v_scaled[0];
     IMU_data->acc.y = acc_v_scaled[1];
@@ -460,6 +785,7 @@ uint8_t IMU_get_scaled_data(struct IMU_out* IMU_data) {
     IMU_data->mag.y = mag_v_scaled[1];
     IMU_data->mag.z = mag_v_scaled[2];
     IMU_data->mag_status = status;
+    IMU_data->usec = sample_usec;
     return SUCCESS;
 }
 
@@ -476,6 +802,12 @@ int8_t IMU_set_mag_cal(float A[MSZ][MSZ], float b[MSZ]) {
     if (A != NULL && b != NULL) {
         memcpy(A_mag, A, sizeof (A_mag));
         memcpy(b_mag, b, sizeof (b_mag));
+        IMU_update_cal();
+#ifdef AHRS_FIXED_POINT
+        if (lin_alg_fix_cal_set(A, b, &mag_cal_fix) == ERROR) {
+            return ERROR;
+        }
+#endif
         //v_scale(E_b, b_mag); // need to scale the offset into eng units
         return SUCCESS;
     } else {
@@ -497,8 +829,14 @@ int8_t IMU_set_acc_cal(float A[MSZ][MSZ], float b[MSZ]) {
     if (A != NULL && b != NULL) {
         memcpy(A_acc, A, sizeof (A_acc));
         memcpy(b_acc, b, sizeof (b_acc));
+#ifdef AHRS_FIXED_POINT
+        if (lin_alg_fix_cal_set(A, b, &acc_cal_fix) == ERROR) {
+            return ERROR;
+        }
+#endif
         //v_scale(E_g, b_acc); // need to scale the offset into eng units
         is_A_matrix = TRUE;
+        IMU_update_cal();
         return SUCCESS;
     } else {
         return ERROR;
@@ -544,6 +882,49 @@ int8_t IMU_get_acc_cal(float A[MSZ][MSZ], float b[MSZ]) {
     }
 }
 
+/**
+ * @Function IMU_set_gyro_temp_model(const IMU_gyro_temp_model_t *model)
+ * @param model, the gyro bias against temperature, NULL turns the
+ * compensation off
+ * @return SUCCESS or ERROR for coefficients that are not finite or an empty
+ * range, which leaves the compensation as it was
+ * @author Aaron Hunter
+ **/
+int8_t IMU_set_gyro_temp_model(const IMU_gyro_temp_model_t *model) {
+    int row;
+    int term;
+    if (model == NULL) {
+        is_gyro_temp_model = FALSE;
+        memset(gyro_temp_bias, 0, sizeof (gyro_temp_bias));
+    } else {
+        for (row = 0; row < MSZ; row++) {
+            for (term = 0; term < IMU_TEMP_TERMS; term++) {
+                if (!isfinite(model->c[row][term])) {
+                    return ERROR;
+                }
+            }
+        }
+        /* NaN fails the comparison too */
+        if (!(model->min_c <= model->max_c) || !isfinite(model->min_c) || !isfinite(model->max_c)) {
+            return ERROR;
+        }
+        gyro_temp_model = *model;
+        is_gyro_temp_model = TRUE;
+        IMU_update_temp_bias();
+    }
+    IMU_update_cal();
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_get_gyro_temp_bias(float bias[MSZ])
+ * @param bias, the bias taken off the current gyro outputs in deg/sec
+ * @author Aaron Hunter
+ **/
+void IMU_get_gyro_temp_bias(float bias[MSZ]) {
+    memcpy(bias, gyro_temp_bias, sizeof (gyro_temp_bias));
+}
+
 
 /*******************************************************************************
  * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
@@ -703,13 +1084,12 @@ static void SPI_read_data(void) {
         }
         val = SPI1BUF;
         if (i > 0) {
-            IMU_raw_data[i - 1] = val;
+            IMU_fill_data[i - 1] = val;
         }
         data_reg++;
     }
     IMU_CS_LAT = 1;
-    IMU_process_data();
-    IMU_data_ready = TRUE;
+    IMU_publish_frame();
 }
 
 /**
@@ -739,6 +1119,45 @@ static void __ISR(_SPI_1_VECTOR, IPL5AUTO) IMU_SPI_interrupt_handler(void) {
     IMU_run_SPI_state_machine(data);
 }
 
+/**
+ * @Function IMU_DMA_interrupt_handler()
+ * @param none
+ * @brief ends a DMA burst read, the only interrupt of the IMU_SPI_DMA_MODE
+ * frame against one per byte for IMU_SPI_interrupt_handler().  In FIFO mode
+ * the end of the count read starts the data read.
+ * @author ahunter
+ */
+static void __ISR(_DMA_0_VECTOR, IPL5AUTO) IMU_DMA_interrupt_handler(void) {
+    IMU_CS_LAT = 1; // deselect IMU
+    DCH0INTbits.CHBCIF = 0;
+    IFS1bits.DMA0IF = 0; // clear interrupt flag
+    if (IMU_fifo_state == IMU_FIFO_READ_COUNT) {
+        IMU_FIFO_start_batch();
+    } else {
+        IMU_fifo_state = IMU_FIFO_IDLE;
+        IMU_publish_frame();
+    }
+}
+
+/**
+ * @Function IMU_DRDY_interrupt_handler()
+ * @param none
+ * @brief starts a DMA burst read on the IMU's data ready pulse and time
+ * stamps the sample, IMU_SPI_DRDY_MODE.  A read still in flight means this
+ * interrupt was held off for a whole sample period, the sample is skipped.
+ * @author ahunter
+ */
+static void __ISR(_EXTERNAL_2_VECTOR, IPL5AUTO) IMU_DRDY_interrupt_handler(void) {
+    IFS0bits.INT2IF = 0; // clear interrupt flag
+    if (IMU_CS_LAT == 0) {
+        return;
+    }
+    IMU_acq_usec = Sys_timer_get_usec();
+    IMU_DMA_start(IMU_NUM_BYTES);
+    IMU_CS_LAT = 0; //select the IMU
+    SPI1BUF = AGB0_REG_ACCEL_XOUT_H | (READ << 7);
+}
+
 /**
  * @Function IMU_read_data()
  * @param none
@@ -770,7 +1189,7 @@ static void IMU_read_data() {
             ;
         }
         LATAINV = 0x8;
-        IMU_raw_data[i] = I2C1RCV;
+        IMU_fill_data[i] = I2C1RCV;
         /*ACK the byte except last one*/
         if (i < (num_bytes - 1)) {
             I2C1CONbits.ACKDT = 0; // ACK the byte
@@ -808,8 +1227,7 @@ static void IMU_run_I2C_state_machine(void) {
         case(IMU_SEND_ADDR_W):
             next_state = IMU_SEND_REG;
             I2C1TRN = (ICM_I2C_ADDR << 1 | WRITE);
-            /*reset error and data ready flags*/
-            IMU_data_ready = FALSE;
+            /*reset error flag*/
             error = FALSE;
             break;
         case(IMU_SEND_REG):
@@ -849,7 +1267,7 @@ static void IMU_run_I2C_state_machine(void) {
             }
             break;
         case(IMU_ACK_DATA):
-            IMU_raw_data[byte_count] = I2C1RCV; // get and store data in array
+            IMU_fill_data[byte_count] = I2C1RCV; // get and store data in array
             byte_count++; //increment and check byte count
             if (byte_count == IMU_NUM_BYTES) {
                 I2C1CONbits.ACKDT = 1; // NACK the byte
@@ -862,7 +1280,7 @@ static void IMU_run_I2C_state_machine(void) {
             break;
         case(IMU_DATA_RCVD):
             /*indicate data is ready*/
-            IMU_data_ready = 1;
+            IMU_publish_frame();
             /*stop the device*/
             I2C1CONbits.PEN = 1; //send stop condition 
             next_state = IMU_STOP;
@@ -897,7 +1315,7 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
         case IMU_SPI_SEND_NEXT_REG:
             //store spi buffer in raw data struct
             if (byte_index >= 0) {
-                IMU_raw_data[byte_index] = byte_read;
+                IMU_fill_data[byte_index] = byte_read;
             }
             byte_index++; //increment byte count
             if (byte_index >= max_index) { // only change states after we have read all the data
@@ -908,9 +1326,9 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
             SPI1BUF = (++reg_address); //increment and send next register value
             break;
         case IMU_SPI_READ_LAST_REG:
-            IMU_raw_data[byte_index] = byte_read; //store last data byte in raw data struct
+            IMU_fill_data[byte_index] = byte_read; //store last data byte in raw data struct
             IMU_CS_LAT = 1; // deselect IMU
-            IMU_data_ready = TRUE; // set data read flag
+            IMU_publish_frame(); // set data read flag
             byte_index = -1; //reset byte counter
             break;
         default:
@@ -920,30 +1338,275 @@ static void IMU_run_SPI_state_machine(uint8_t byte_read) {
 }
 
 /**
- * @Function IMU_process_data(void)
- * @param none
+ * @Function IMU_DMA_init(void)
+ * @brief sets up DMA channel 0 to move SPI1BUF into the frame buffer and
+ * channel 1 to write the next don't care byte, both on the SPI1 RX event.
+ * Pacing the transmit by the receive keeps one byte in flight, so SPI1BUF
+ * can't overrun, and channel 0's higher priority empties it before channel
+ * 1 refills it.  IMU_start_data_acq() sends the address byte, the channels
+ * clock the other IMU_NUM_BYTES and only the end of the frame interrupts.
+ * @author Aaron Hunter
+ */
+static void IMU_DMA_init(void) {
+    IEC1bits.DMA0IE = 0;
+    DMACONbits.ON = 1;
+    /* channel 0: SPI1BUF to the frame buffer */
+    DCH0CON = 0;
+    DCH0CONbits.CHPRI = IMU_DMA_RX_PRIORITY;
+    DCH0ECON = 0;
+    DCH0ECONbits.CHSIRQ = _SPI1_RX_IRQ;
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0SSA = KVA_TO_PA(&SPI1BUF);
+    DCH0DSA = KVA_TO_PA(IMU_frames[IMU_fill_frame].spi);
+    DCH0SSIZ = 1;
+    DCH0DSIZ = IMU_NUM_BYTES + 1;
+    DCH0CSIZ = 1;
+    DCH0INT = 0;
+    DCH0INTbits.CHBCIE = 1; // interrupt once the block is in
+    /* channel 1: don't care bytes to SPI1BUF */
+    DCH1CON = 0;
+    DCH1CONbits.CHPRI = IMU_DMA_TX_PRIORITY;
+    DCH1ECON = 0;
+    DCH1ECONbits.CHSIRQ = _SPI1_RX_IRQ;
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1SSA = KVA_TO_PA(IMU_dma_tx);
+    DCH1DSA = KVA_TO_PA(&SPI1BUF);
+    DCH1SSIZ = IMU_NUM_BYTES;
+    DCH1DSIZ = 1;
+    DCH1CSIZ = 1;
+    DCH1INT = 0;
+    /* block complete interrupt at the SPI interrupt's priority */
+    IFS1bits.DMA0IF = 0;
+    IPC9bits.DMA0IP = 5;
+    IPC9bits.DMA0IS = 0;
+    IEC1bits.DMA0IE = 1;
+}
+
+/**
+ * @Function IMU_DMA_start(uint16_t num_bytes)
+ * @param num_bytes, bytes to read after the address byte
+ * @brief points channel 0 at the frame being filled, then sizes and enables
+ * both channels
+ * @author Aaron Hunter
+ */
+static void IMU_DMA_start(uint16_t num_bytes) {
+    DCH0DSA = KVA_TO_PA(IMU_frames[IMU_fill_frame].spi);
+    DCH0DSIZ = num_bytes + 1; // the byte clocked in with the address as well
+    DCH1SSIZ = num_bytes;
+    DCH0CONbits.CHEN = 1; // both disable themselves at the end of the block
+    DCH1CONbits.CHEN = 1;
+}
+
+/**
+ * @Function IMU_acq_init(char interface_mode)
+ * @param interface_mode, one of the SPI modes
+ * @brief sets the sample rate, the FIFO and the data ready interrupt the mode
+ * uses and turns off the others.  The FIFO takes accel, gyro, temperature and
+ * the slave 0 magnetometer registers each sample, the same 23 bytes in the
+ * same order as the data registers.  Gyro and accel share the rate so one
+ * sample holds one instant of both.
+ * @author Aaron Hunter
+ */
+static void IMU_acq_init(char interface_mode) {
+    uint8_t fifo = (interface_mode == IMU_SPI_FIFO_MODE);
+    uint8_t drdy = (interface_mode == IMU_SPI_DRDY_MODE);
+    uint8_t div = 0; // the reset value, 1125 Hz
+    if (fifo) {
+        div = IMU_FIFO_ODR_DIV;
+    } else if (drdy) {
+        div = IMU_DRDY_ODR_DIV;
+    }
+    SPI_set_reg(AGB0_REG_REG_BANK_SEL, USER_BANK_2);
+    SPI_set_reg(AGB2_REG_GYRO_SMPLRT_DIV, div);
+    SPI_set_reg(AGB2_REG_ACCEL_SMPLRT_DIV_2, div);
+    SPI_set_reg(AGB2_REG_ODR_ALIGN_EN, fifo || drdy);
+    SPI_set_reg(AGB2_REG_REG_BANK_SEL, USER_BANK_0);
+    SPI_set_reg(AGB0_REG_INT_PIN_CONFIG, INT_PIN_CFG_PULSE);
+    SPI_set_reg(AGB0_REG_INT_ENABLE_1, drdy ? INT_ENABLE_1_RAW_DATA_RDY : 0);
+    SPI_set_reg(AGB0_REG_USER_CTRL, USER_CTRL_MST_EN_IF_DIS);
+    SPI_set_reg(AGB0_REG_FIFO_EN_1, fifo ? FIFO_EN_1_SLV_0 : 0);
+    SPI_set_reg(AGB0_REG_FIFO_EN_2, fifo ? FIFO_EN_2_ACC_GYRO_TEMP : 0);
+    SPI_set_reg(AGB0_REG_FIFO_MODE, FIFO_MODE_SNAPSHOT);
+    SPI_set_reg(AGB0_REG_FIFO_RST, FIFO_RST_ALL);
+    SPI_set_reg(AGB0_REG_FIFO_RST, 0);
+    if (fifo) {
+        SPI_set_reg(AGB0_REG_USER_CTRL, USER_CTRL_MST_EN_IF_DIS | USER_CTRL_FIFO_EN);
+    }
+    IMU_fifo_full = FALSE;
+}
+
+/**
+ * @Function IMU_FIFO_start_count(void)
+ * @return SUCCESS
+ * @brief first half of a FIFO read, reads FIFO_COUNT by DMA
+ * @note a FIFO that filled up is reset here with blocking writes, its
+ * packets may be split and the time stamps would not hold across the gap
+ * @author Aaron Hunter
+ */
+static int8_t IMU_FIFO_start_count(void) {
+    if (IMU_fifo_full == TRUE) {
+        SPI_set_reg(AGB0_REG_FIFO_RST, FIFO_RST_ALL);
+        SPI_set_reg(AGB0_REG_FIFO_RST, 0);
+        IMU_fifo_full = FALSE;
+    }
+    IMU_fifo_state = IMU_FIFO_READ_COUNT;
+    IMU_DMA_start(IMU_FIFO_COUNT_BYTES);
+    IMU_CS_LAT = 0; //select the IMU
+    SPI1BUF = AGB0_REG_FIFO_COUNT_H | (READ << 7);
+    return SUCCESS;
+}
+
+/**
+ * @Function IMU_FIFO_start_batch(void)
+ * @brief second half of a FIFO read, run from the DMA interrupt: reads the
+ * whole packets counted, up to IMU_FIFO_MAX_BATCH, if they reach the
+ * watermark.  A burst of FIFO_R_W keeps popping the FIFO, so one block holds
+ * the batch.  The time of the count dates the newest packet counted to
+ * within one sample period.
+ * @author Aaron Hunter
+ */
+static void IMU_FIFO_start_batch(void) {
+    uint16_t count = (IMU_fill_data[0] << 8 | IMU_fill_data[1]) & IMU_FIFO_COUNT_MASK;
+    uint8_t queued = count / IMU_NUM_BYTES;
+    IMU_fifo_state = IMU_FIFO_IDLE;
+    if (count > IMU_FIFO_SIZE - IMU_NUM_BYTES) { // no room for the next packet
+        IMU_fifo_full = TRUE;
+        IMU_fifo_overflows++;
+        return;
+    }
+    if (queued < IMU_fifo_watermark) {
+        return;
+    }
+    IMU_batch_size = (queued < IMU_FIFO_MAX_BATCH) ? queued : IMU_FIFO_MAX_BATCH;
+    /* the newest packet read is queued - batch size periods older than the count */
+    IMU_acq_usec = Sys_timer_get_usec() - (uint32_t) (queued - IMU_batch_size) * IMU_FIFO_PERIOD_USEC;
+    IMU_fifo_state = IMU_FIFO_READ_DATA;
+    IMU_DMA_start(IMU_batch_size * IMU_NUM_BYTES);
+    IMU_CS_LAT = 0; //select the IMU
+    SPI1BUF = AGB0_REG_FIFO_R_W | (READ << 7);
+}
+
+/**
+ * @Function IMU_latest_packet(void)
+ * @return the newest packet of the frame being read
+ * @author Aaron Hunter
+ */
+static const uint8_t *IMU_latest_packet(void) {
+    const IMU_frame_t *frame = &IMU_frames[IMU_read_frame];
+    return frame->spi + 1 + (frame->packets - 1) * IMU_NUM_BYTES;
+}
+
+/**
+ * @Function IMU_publish_frame(void)
+ * @brief makes the frame just filled the newest and picks the next to fill,
+ * run at the end of a read.  The next is the one neither newest nor being
+ * read, an unread frame is overwritten so the getters always get the newest.
+ * @author Aaron Hunter
+ */
+static void IMU_publish_frame(void) {
+    uint8_t done = IMU_fill_frame;
+    IMU_frames[done].packets = IMU_batch_size;
+    IMU_frames[done].usec = IMU_acq_usec;
+    IMU_ready_frame = done;
+    IMU_fill_frame = 3 - done - IMU_read_frame; // frames 0, 1 and 2 sum to 3
+    IMU_frame_seq++;
+}
+
+/**
+ * @Function IMU_take_frame(void)
+ * @return TRUE if a frame was published since the last one taken
+ * @brief hands the newest frame to the getters and converts its newest
+ * packet.  A frame published between reading IMU_ready_frame and claiming it
+ * may have picked the claimed frame to fill, so the claim is retried until
+ * no frame was published across it, after which the ISRs fill around it.
+ * @author Aaron Hunter
+ */
+static uint8_t IMU_take_frame(void) {
+    uint32_t seq;
+    if (IMU_read_seq == IMU_frame_seq) {
+        return FALSE;
+    }
+    do {
+        seq = IMU_frame_seq;
+        IMU_read_frame = IMU_ready_frame;
+    } while (seq != IMU_frame_seq);
+    IMU_read_seq = seq;
+    IMU_process_data(IMU_latest_packet());
+    sample_usec = IMU_frames[IMU_read_frame].usec;
+    return TRUE;
+}
+
+/**
+ * @Function IMU_norm_to_output(struct IMU_out* IMU_data)
+ * @param IMU_data, the sample loaded by IMU_process_data(), calibrated
+ * @brief the IMU_get_norm_data() conversion without taking a frame
+ * @author Aaron Hunter
+ */
+/**
+ * @Function IMU_raw_to_output(struct IMU_out* IMU_data)
+ * @param IMU_data, the counts of the sample loaded by IMU_process_data()
+ * @author Aaron Hunter
+ */
+static void IMU_raw_to_output(struct IMU_out* IMU_data) {
+    /* the counts with the mag rotated onto the accel axes*/
+    IMU_data->acc.x = acc_v_counts[0];
+    IMU_data->acc.y = acc_v_counts[1];
+    IMU_data->acc.z = acc_v_counts[2];
+    IMU_data->gyro.x = gyro_v_counts[0];
+    IMU_data->gyro.y = gyro_v_counts[1];
+    IMU_data->gyro.z = gyro_v_counts[2];
+    IMU_data->temp = temp_raw;
+    IMU_data->mag.x = mag_axis[0] * mag_v_counts[0];
+    IMU_data->mag.y = mag_axis[1] * mag_v_counts[1];
+    IMU_data->mag.z = mag_axis[2] * mag_v_counts[2];
+    IMU_data->mag_status = status;
+    IMU_data->usec = sample_usec;
+}
+
+static void IMU_norm_to_output(struct IMU_out* IMU_data) {
+    if ((IMU_converted & IMU_NORM_DONE) == 0) {
+        IMU_normalize_data(); //scale mag and acc by A matrix and b vector from Dorveaux
+        IMU_converted |= IMU_NORM_DONE;
+    }
+    /* set output data to point at vector components*/
+    IMU_data->acc.x = acc_v_norm[0];
+    IMU_data->acc.y = acc_v_norm[1];
+    IMU_data->acc.z = acc_v_norm[2];
+    IMU_data->gyro.x = gyro_v_scaled[0];
+    IMU_data->gyro.y = gyro_v_scaled[1];
+    IMU_data->gyro.z = gyro_v_scaled[2];
+    IMU_data->temp = temp_raw;
+    IMU_data->mag.x = mag_v_norm[0];
+    IMU_data->mag.y = mag_v_norm[1];
+    IMU_data->mag.z = mag_v_norm[2];
+    IMU_data->mag_status = status;
+    IMU_data->usec = sample_usec;
+}
+
+/**
+ * @Function IMU_process_data(const uint8_t *raw)
+ * @param raw, IMU_NUM_BYTES of data registers or one FIFO packet
  * @return SUCCESS or ERROR
  * @brief converts raw register data into module variable data
  * @note mag data has reversed byte order
  * @author ahunter
  * @modified  */
-static void IMU_process_data(void) {
+static void IMU_process_data(const uint8_t *raw) {
+    IMU_converted = 0;
     /*store data in module vectors*/
-    /*data needs to be converted to short then cast as float */
-    acc_v_raw[0] = (float) (int16_t) (IMU_raw_data[0] << 8 | IMU_raw_data[1]);
-    acc_v_raw[1] = (float) (int16_t) (IMU_raw_data[2] << 8 | IMU_raw_data[3]);
-    acc_v_raw[2] = (float) (int16_t) (IMU_raw_data[4] << 8 | IMU_raw_data[5]);
-    gyro_v_raw[0] = (float) (int16_t) (IMU_raw_data[6] << 8 | IMU_raw_data[7]);
-    gyro_v_raw[1] = (float) (int16_t) (IMU_raw_data[8] << 8 | IMU_raw_data[9]);
-    gyro_v_raw[2] = (float) (int16_t) (IMU_raw_data[10] << 8 | IMU_raw_data[11]);
-    temp_raw = (float) (IMU_raw_data[12] << 8 | IMU_raw_data[13]);
-    //need to orient mag data to accel and gyros by rotating around x axis
-    mag_v_raw[0] = (float) (int16_t) (IMU_raw_data[16] << 8 | IMU_raw_data[15]);
-    mag_v_raw[1] = (float) (int16_t) ((IMU_raw_data[18] << 8 | IMU_raw_data[17])*-1);
-    mag_v_raw[2] = (float) (int16_t) ((IMU_raw_data[20] << 8 | IMU_raw_data[19])*-1);
+    acc_v_counts[0] = (int16_t) (raw[0] << 8 | raw[1]);
+    acc_v_counts[1] = (int16_t) (raw[2] << 8 | raw[3]);
+    acc_v_counts[2] = (int16_t) (raw[4] << 8 | raw[5]);
+    gyro_v_counts[0] = (int16_t) (raw[6] << 8 | raw[7]);
+    gyro_v_counts[1] = (int16_t) (raw[8] << 8 | raw[9]);
+    gyro_v_counts[2] = (int16_t) (raw[10] << 8 | raw[11]);
+    temp_raw = (int16_t) (raw[12] << 8 | raw[13]);
+    mag_v_counts[0] = (int16_t) (raw[16] << 8 | raw[15]);
+    mag_v_counts[1] = (int16_t) (raw[18] << 8 | raw[17]);
+    mag_v_counts[2] = (int16_t) (raw[20] << 8 | raw[19]);
     /*status 1 is high byte and status 2 is low byte*/
     /*status 2 indicates mag overflow only*/
-    status = (IMU_raw_data[14] << 8 | IMU_raw_data[22] & 0x8);
+    status = (raw[14] << 8 | raw[22] & 0x8);
 }
 
 /**
@@ -951,99 +1614,138 @@ static void IMU_process_data(void) {
  * @param none
  * @return none
  * @brief normalizes raw acc and mag data using Dorveaux A matrix and b vector
- * @note mag data has reversed byte order
+ * and scales the gyro to deg/sec, one transform per sensor
  * @author ahunter
  * @modified  */
 static void IMU_normalize_data(void) {
-    int8_t row;
-    if (is_A_matrix) { //only normalize is A matrix exists
-        /* Normalize inertial sensors using Dorveaux calibration*/
-        /* apply calibration matrix to raw values */
-        m_v_mult(A_acc, acc_v_raw, acc_v_norm);
-        m_v_mult(A_mag, mag_v_raw, mag_v_norm);
-        /* apply offset calibration */
-        v_v_add(acc_v_norm, b_acc, acc_v_norm);
-        v_v_add(mag_v_norm, b_mag, mag_v_norm);
-    } else { // otherwise just assign norm to raw values
-        for (row = 0; row < MSZ; row++) {
-            acc_v_norm[row] = acc_v_raw[row];
-            mag_v_norm[row] = mag_v_raw[row];
-        }
-    }
-    /*copy gyro data to scaled vector*/
-    for (row = 0; row < MSZ; row++) {
-        gyro_v_scaled[row] = gyro_v_raw[row];
-    }
-    v_scale(gyro_scale, gyro_v_scaled); // convert to deg/sec
+    IMU_check_temp_bias();
+    IMU_apply_cal(&acc_norm_cal, acc_v_counts, acc_v_norm);
+    IMU_apply_cal(&mag_norm_cal, mag_v_counts, mag_v_norm);
+    IMU_apply_cal(&gyro_scaled_cal, gyro_v_counts, gyro_v_scaled);
 }
 
 /**
  * @Function IMU_scale_data(void)
  * @param none
  * @return none
- * @brief normalizes raw acc and mag data using Dorveaux A matrix and b vector
- * @note mag data has reversed byte order
+ * @brief converts the counts to g, uTesla and deg/sec, calibrated if an A
+ * matrix is set, straight from the counts without the normalized vectors
  * @author ahunter
  * @modified  */
 static void IMU_scale_data(void) {
-    int8_t row;
-    /*scale the normalized data using engineering units*/
-    if (is_A_matrix) { // if an A matrix has been set
-        /*if normalized, then accelerometer is already scaled to g*/
-        v_scale(E_b, mag_v_norm); //scale to uTesla
-        for (row = 0; row < MSZ; row++) {
-            acc_v_scaled[row] = acc_v_norm[row];
-            mag_v_scaled[row] = mag_v_norm[row];
-        }
-    } else { // `norm' data is raw, so scale using scaling factors
-        for (row = 0; row < MSZ; row++) {
-            acc_v_scaled[row] = acc_v_raw[row];
-            mag_v_scaled[row] = mag_v_raw[row];
-        }
-        v_scale(acc_scale, acc_v_scaled); // convert to g
-        v_scale(mag_scale, mag_v_scaled); // convert to uTesla
-    }
-    temp_scaled = (temp_raw - T_BIAS) / T_SENSE + T_OFFSET; //scale temperature
+    IMU_check_temp_bias();
+    IMU_apply_cal(&acc_scaled_cal, acc_v_counts, acc_v_scaled);
+    IMU_apply_cal(&mag_scaled_cal, mag_v_counts, mag_v_scaled);
+    IMU_apply_cal(&gyro_scaled_cal, gyro_v_counts, gyro_v_scaled);
+    temp_scaled = (temp_raw - T_BIAS) / IMU_TEMP_SENSE + IMU_TEMP_OFFSET_C; //scale temperature
 }
 
-/*-----------LINEAR ALGEBRA routines----------------------------------------*/
-
 /**
- * @function m_v_mult()
- * Multiplies a matrix with a vector
- * @param m A matrix to be multiplied with a vector
- * @param v A vector to be multiplied with a matrix
- * @param v_out The product of the matrix and vector
- * @return SUCCESS or ERROR
+ * @Function IMU_update_cal(void)
+ * @brief rebuilds the transforms from the calibrations and scale factors.
+ * The normalized outputs are the Dorveaux calibration of the counts, or the
+ * counts if no A matrix is set, and the scaled outputs the same in g and
+ * uTesla.  The mag axis rotation reverses columns of A, which is exact, so
+ * the normalized outputs match calibrating the rotated counts to the bit.
+ * @author Aaron Hunter
  */
-static uint8_t m_v_mult(float m[MSZ][MSZ], float v[MSZ], float v_out[MSZ]) {
+static void IMU_update_cal(void) {
     int row;
     int col;
-
     for (row = 0; row < MSZ; row++) {
-        v_out[row] = 0;
         for (col = 0; col < MSZ; col++) {
-            v_out[row] += m[row][col] * v[col];
+            if (is_A_matrix) {
+                acc_norm_cal.A[row][col] = A_acc[row][col];
+                mag_norm_cal.A[row][col] = A_mag[row][col] * mag_axis[col];
+            } else {
+                acc_norm_cal.A[row][col] = (row == col);
+                mag_norm_cal.A[row][col] = (row == col) * mag_axis[col];
+            }
+            gyro_scaled_cal.A[row][col] = (row == col) * gyro_scale;
         }
+        acc_norm_cal.b[row] = is_A_matrix ? b_acc[row] : 0;
+        mag_norm_cal.b[row] = is_A_matrix ? b_mag[row] : 0;
+        gyro_scaled_cal.b[row] = -gyro_temp_bias[row];
     }
-    return SUCCESS;
+    /*a calibrated accelerometer is already in g, the mag is normalized to one*/
+    acc_scaled_cal = acc_norm_cal;
+    mag_scaled_cal = mag_norm_cal;
+    if (is_A_matrix) {
+        m_scale(E_b, mag_scaled_cal.A);
+        v_scale(E_b, mag_scaled_cal.b);
+    } else {
+        m_scale(acc_scale, acc_scaled_cal.A);
+        m_scale(mag_scale, mag_scaled_cal.A);
+    }
+    IMU_converted = 0;
 }
 
 /**
- * @function v_v_add()
- * Add a vector value to a vector
- * @param v1 Vector to add to another vector
- * @param v2 Vector to have a vector added to it
- * @param v_out Vector as sum of two vectors
+ * @Function IMU_update_temp_bias(void)
+ * @brief evaluates the gyro bias model at temp_raw, held at the ends of its
+ * range, and makes the negated bias the gyro offset of the float and fixed
+ * point transforms
+ * @author Aaron Hunter
  */
-static void v_v_add(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
+static void IMU_update_temp_bias(void) {
+    float temp_c = (temp_raw - T_BIAS) / IMU_TEMP_SENSE + IMU_TEMP_OFFSET_C;
+    float dt;
+    const float *c;
     int row;
 
+    gyro_temp_counts = temp_raw;
+    if (temp_c < gyro_temp_model.min_c) {
+        temp_c = gyro_temp_model.min_c;
+    } else if (temp_c > gyro_temp_model.max_c) {
+        temp_c = gyro_temp_model.max_c;
+    }
+    dt = temp_c - IMU_TEMP_REF_C;
+    for (row = 0; row < MSZ; row++) {
+        c = gyro_temp_model.c[row];
+        gyro_temp_bias[row] = c[0] + dt * (c[1] + dt * c[2]);
+        gyro_scaled_cal.b[row] = -gyro_temp_bias[row];
+#ifdef AHRS_FIXED_POINT
+        /* deg/sec to Q16.16 rad/sec */
+        gyro_cal_fix.b[row] = (q16_t) lroundf(-gyro_temp_bias[row]
+                * (float) (3.14159265358979 / 180.0 * 65536.0));
+#endif
+    }
+    IMU_converted = 0;
+}
+
+/**
+ * @Function IMU_check_temp_bias(void)
+ * @brief IMU_update_temp_bias() once temp_raw has moved T_STEP_COUNTS, an
+ * integer compare per sample otherwise
+ * @author Aaron Hunter
+ */
+static void IMU_check_temp_bias(void) {
+    int32_t step = (int32_t) temp_raw - gyro_temp_counts;
+    if ((is_gyro_temp_model == TRUE) && ((step >= T_STEP_COUNTS) || (step <= -T_STEP_COUNTS))) {
+        IMU_update_temp_bias();
+    }
+}
+
+/**
+ * @Function IMU_apply_cal(const IMU_affine_t *cal, const int16_t counts[MSZ], float v_out[MSZ])
+ * @param cal, the transform
+ * @param counts, register counts
+ * @param v_out, A counts + b, summed in the order of the matrix product
+ * followed by the offset
+ * @author Aaron Hunter
+ */
+static void IMU_apply_cal(const IMU_affine_t *cal, const int16_t counts[MSZ], float v_out[MSZ]) {
+    float x = counts[0];
+    float y = counts[1];
+    float z = counts[2];
+    int row;
     for (row = 0; row < MSZ; row++) {
-        v_out[row] = v1[row] + v2[row];
+        v_out[row] = cal->A[row][0] * x + cal->A[row][1] * y + cal->A[row][2] * z + cal->b[row];
     }
 }
 
+/*-----------LINEAR ALGEBRA routines----------------------------------------*/
+
 /**
  * @function m_scale()
  * Scales matrix
@@ -1076,6 +1778,50 @@ static void v_scale(float s, float v[MSZ]) {
 }
 
 #ifdef ICM_TESTING
+#define ACQ_SAMPLES 100
+#define SPIN_CALIBRATION 10000
+#define CORE_TIMER_DIV 2 // the core timer counts every other SYSCLK cycle
+#define SERIAL_DRAIN_TICKS 400000 // 10 msec of core timer, the banner goes out in 5
+#define FIFO_FILL_MSEC 20 // 11 samples at 562.5 Hz
+
+/* spins until a sample is ready or max_spins, returns the spin count */
+static uint32_t spin_until_ready(uint32_t max_spins) {
+    uint32_t spins = 0;
+    while (IMU_is_data_ready() == FALSE && spins < max_spins) {
+        spins++;
+    }
+    return spins;
+}
+
+/**
+ * @Function acq_isr_cycles(char mode)
+ * @return CPU cycles per sample the acquisition interrupts take from the
+ * foreground, entry and exit included.  The foreground spins while a burst is
+ * in flight, and the cycles its spin count does not account for went to the
+ * ISRs.  Nothing else may interrupt, so run it before other modules start.
+ */
+static float acq_isr_cycles(char mode) {
+    struct IMU_out data;
+    uint32_t start;
+    uint32_t elapsed = 0;
+    uint32_t spins = 0;
+    float cycles_per_spin;
+    int i;
+
+    IMU_init(mode);
+    IMU_get_raw_data(&data); // clears the ready flag
+    start = _CP0_GET_COUNT();
+    spin_until_ready(SPIN_CALIBRATION);
+    cycles_per_spin = (float) ((_CP0_GET_COUNT() - start) * CORE_TIMER_DIV) / SPIN_CALIBRATION;
+    for (i = 0; i < ACQ_SAMPLES; i++) {
+        start = _CP0_GET_COUNT();
+        IMU_start_data_acq();
+        spins += spin_until_ready(0xFFFFFFFF);
+        elapsed += (_CP0_GET_COUNT() - start) * CORE_TIMER_DIV;
+        IMU_get_raw_data(&data);
+    }
+    return ((elapsed - spins * cycles_per_spin) / ACQ_SAMPLES);
+}
 
 int main(void) {
     int value = 0;
@@ -1085,6 +1831,8 @@ int main(void) {
     int IMU_err = 0;
     struct IMU_out IMU_data_raw = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
     struct IMU_out IMU_data_scaled = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    struct IMU_out batch[IMU_FIFO_MAX_BATCH];
+    uint32_t start;
     /* test values: mag cal from Dorveaux*/
 
     float A_acc[MSZ][MSZ] = {
@@ -1104,7 +1852,28 @@ int main(void) {
 
     Board_init();
     Serial_init();
+    Sys_timer_init();
     printf("\r\nICM-20948 Test Harness %s, %s\r\n", __DATE__, __TIME__);
+    /* CPU time the DMA burst read gives back to the foreground, measured
+     * once the UART interrupts have stopped */
+    i = _CP0_GET_COUNT();
+    while (_CP0_GET_COUNT() - i < SERIAL_DRAIN_TICKS) {
+        ;
+    }
+    printf("ISR cycles per sample: SPI %.0f, SPI DMA %.0f\r\n",
+            (double) acq_isr_cycles(IMU_SPI_MODE), (double) acq_isr_cycles(IMU_SPI_DMA_MODE));
+    /* FIFO: one read collects what queued up, spaced by the sample period */
+    IMU_init(IMU_SPI_FIFO_MODE);
+    start = Sys_timer_get_msec();
+    while (Sys_timer_get_msec() - start < FIFO_FILL_MSEC) {
+        ;
+    }
+    IMU_start_data_acq();
+    spin_until_ready(0xFFFFFF);
+    value = IMU_get_batch(batch, IMU_FIFO_MAX_BATCH);
+    printf("FIFO batch of %d samples over %lu usec, %lu overflows\r\n", value,
+            (unsigned long) (value > 0 ? batch[value - 1].usec - batch[0].usec : 0),
+            (unsigned long) IMU_get_fifo_overflows());
     IMU_err = IMU_init(INTERFACE_MODE);
     //set LEDs for troubleshooting
     TRISAbits.TRISA4 = 0; //pin 72 Max32
@@ -1158,3 +1927,157 @@ int main(void) {
 #endif //ICM_TESTING
 
 
+
+#ifdef ICM_BENCHMARK
+/*
+ * Time per sample to turn the register bytes into calibrated outputs: the
+ * fused count to output transforms against the multi pass conversion they
+ * replaced (floats, mag axis flips, A matrix, offset and scaling each a
+ * separate pass).  CSV as in Benchmark.h, "#" lines are comments.  On the host:
+ *     gcc -O2 -DHAL_SIM -DICM_BENCHMARK -Ilib/HAL.X/linux -Ilib/HAL.X
+ *         -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X -Ilib/ICM-20948.X
+ *         -Ilib/Benchmark.X lib/ICM-20948.X/ICM_20948.c lib/Benchmark.X/Benchmark.c
+ *         lib/HAL.X/HAL_linux.c lib/HAL.X/HAL_sim_devices.c lib/Board.X/Board.c
+ *         lib/Serial.X/SerialM32.c lib/System_timer.X/System_timer.c -lm
+ */
+#define BENCH_SUITE "icm_20948"
+
+typedef struct {
+    uint8_t packet[IMU_NUM_BYTES];
+    float acc[MSZ];
+    float mag[MSZ];
+    float gyro[MSZ];
+} bench_operands_t;
+
+/* the conversion before the transforms were fused */
+static void multi_pass_norm(bench_operands_t *o) {
+    const uint8_t *raw = o->packet;
+    float acc_raw[MSZ];
+    float mag_raw[MSZ];
+    int row;
+    int col;
+
+    acc_raw[0] = (float) (int16_t) (raw[0] << 8 | raw[1]);
+    acc_raw[1] = (float) (int16_t) (raw[2] << 8 | raw[3]);
+    acc_raw[2] = (float) (int16_t) (raw[4] << 8 | raw[5]);
+    o->gyro[0] = (float) (int16_t) (raw[6] << 8 | raw[7]);
+    o->gyro[1] = (float) (int16_t) (raw[8] << 8 | raw[9]);
+    o->gyro[2] = (float) (int16_t) (raw[10] << 8 | raw[11]);
+    mag_raw[0] = (float) (int16_t) (raw[16] << 8 | raw[15]);
+    mag_raw[1] = (float) (int16_t) ((raw[18] << 8 | raw[17])*-1);
+    mag_raw[2] = (float) (int16_t) ((raw[20] << 8 | raw[19])*-1);
+    if (is_A_matrix) {
+        for (row = 0; row < MSZ; row++) {
+            o->acc[row] = 0;
+            o->mag[row] = 0;
+            for (col = 0; col < MSZ; col++) {
+                o->acc[row] += A_acc[row][col] * acc_raw[col];
+                o->mag[row] += A_mag[row][col] * mag_raw[col];
+            }
+        }
+        for (row = 0; row < MSZ; row++) {
+            o->acc[row] = o->acc[row] + b_acc[row];
+            o->mag[row] = o->mag[row] + b_mag[row];
+        }
+    } else {
+        for (row = 0; row < MSZ; row++) {
+            o->acc[row] = acc_raw[row];
+            o->mag[row] = mag_raw[row];
+        }
+    }
+    v_scale(gyro_scale, o->gyro);
+}
+
+static void multi_pass_scaled(bench_operands_t *o) {
+    multi_pass_norm(o);
+    if (is_A_matrix) {
+        v_scale(E_b, o->mag);
+    } else {
+        v_scale(acc_scale, o->acc);
+        v_scale(mag_scale, o->mag);
+    }
+}
+
+static void bench_norm_multi_pass(void *ctx) {
+    multi_pass_norm((bench_operands_t *) ctx);
+}
+
+static void bench_norm_fused(void *ctx) {
+    IMU_process_data(((bench_operands_t *) ctx)->packet);
+    IMU_normalize_data();
+}
+
+static void bench_scaled_multi_pass(void *ctx) {
+    multi_pass_scaled((bench_operands_t *) ctx);
+}
+
+static void bench_scaled_fused(void *ctx) {
+    IMU_process_data(((bench_operands_t *) ctx)->packet);
+    IMU_scale_data();
+}
+
+static const benchmark_t kernels[] = {
+    {"norm_multi_pass", bench_norm_multi_pass},
+    {"norm_fused", bench_norm_fused},
+    {"scaled_multi_pass", bench_scaled_multi_pass},
+    {"scaled_fused", bench_scaled_fused},
+};
+
+/* largest difference between the reference and the module outputs */
+static float max_diff(bench_operands_t *o, float acc[MSZ], float mag[MSZ]) {
+    float diff = 0;
+    int row;
+
+    for (row = 0; row < MSZ; row++) {
+        diff = fmaxf(diff, fabsf(o->acc[row] - acc[row]));
+        diff = fmaxf(diff, fabsf(o->mag[row] - mag[row]));
+        diff = fmaxf(diff, fabsf(o->gyro[row] - gyro_v_scaled[row]));
+    }
+    return diff;
+}
+
+int main(void) {
+    static bench_operands_t operands = {
+        /* a level board: 1 g on z, a slow roll rate, the field north and down */
+        .packet = {0x00, 0x40, 0xff, 0x9c, 0x40, 0x00, 0x00, 0x83, 0xff, 0xd8,
+            0x00, 0x0c, 0x0a, 0x3c, 0x01, 0x48, 0x00, 0x1e, 0xff, 0x2c, 0xfe, 0x00, 0x00}
+    };
+    float A_acc_cal[MSZ][MSZ] = {
+        6.01180201773358e-05, -6.28352073406424e-07, -3.91326747595870e-07,
+        -1.18653342135860e-06, 6.01268083773005e-05, -2.97010157797952e-07,
+        -3.19011230800348e-07, -3.62174516629958e-08, 6.04564465269327e-05
+    };
+    float A_mag_cal[MSZ][MSZ] = {
+        0.00351413733554131, -1.74599042407869e-06, -1.62761272908763e-05,
+        6.73767225208446e-06, 0.00334531206332366, -1.35302929502152e-05,
+        -3.28233797524166e-05, 9.29337701972177e-06, 0.00343350080131375
+    };
+    float b_acc_cal[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
+    float b_mag_cal[MSZ] = {-0.809679246097106, 0.700742334522691, -0.571694648765172};
+
+    Board_init();
+    Serial_init();
+    printf("# ICM-20948 conversion benchmark %s, %s\r\n", __DATE__, __TIME__);
+    IMU_update_cal();
+    multi_pass_scaled(&operands);
+    IMU_process_data(operands.packet);
+    IMU_scale_data();
+    printf("# uncalibrated, scaled outputs differ by %g\r\n",
+            (double) max_diff(&operands, acc_v_scaled, mag_v_scaled));
+    IMU_set_mag_cal(A_mag_cal, b_mag_cal);
+    IMU_set_acc_cal(A_acc_cal, b_acc_cal);
+    multi_pass_norm(&operands);
+    IMU_normalize_data();
+    printf("# calibrated, normalized outputs differ by %g\r\n",
+            (double) max_diff(&operands, acc_v_norm, mag_v_norm));
+    multi_pass_scaled(&operands);
+    IMU_scale_data();
+    printf("# calibrated, scaled outputs differ by %g\r\n",
+            (double) max_diff(&operands, acc_v_scaled, mag_v_scaled));
+
+    Benchmark_header();
+    Benchmark_run_table(BENCH_SUITE, kernels, sizeof (kernels) / sizeof (kernels[0]), &operands);
+    printf("# done\r\n");
+    return 0;
+}
+#endif //ICM_BENCHMARK
@@ -14,12 +14,25 @@
 #include <sys/types.h>
 #include <stdfix.h> //fixed point library
 #include "ICM_20948_registers.h"
+#ifdef AHRS_FIXED_POINT
+#include "Lin_alg_fix.h"
+#endif
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
 #define IMU_SPI_MODE 0
 #define IMU_I2C_MODE 1
+#define IMU_SPI_DMA_MODE 2 // SPI burst read by DMA, one interrupt per sample
+#define IMU_SPI_FIFO_MODE 3 // FIFO at 562.5 Hz read in batches by DMA
+#define IMU_SPI_DRDY_MODE 4 // DMA burst read at 225 Hz started by INT on INT2/RE9
+#define IMU_FIFO_MAX_BATCH 10 // samples per FIFO read
+#define IMU_FIFO_WATERMARK 4 // default samples queued before a read fetches them
+#define IMU_FIFO_ODR_HZ 562.5f // sample rate in IMU_SPI_FIFO_MODE
+#define IMU_TEMP_SENSE 333.87f // temperature counts per deg C
+#define IMU_TEMP_OFFSET_C 21.0f // deg C at 0 counts
+#define IMU_TEMP_TERMS 3 // gyro bias polynomial coefficients per axis, up to quadratic
+#define IMU_TEMP_REF_C 25.0f // the bias polynomials are in (temp - IMU_TEMP_REF_C)
 /*lin alg constants*/
 #define MSZ 3 //matrix/vector size per dimension
 
@@ -39,8 +52,32 @@ struct IMU_out {
     struct IMU_axis mag;
     float temp;
     uint16_t mag_status;
+    uint32_t usec; // Sys_timer_get_usec() time of the sample
 };
 
+/* gyro bias against die temperature in deg/sec,
+ * bias = c[0] + c[1] dT + c[2] dT^2 per axis with dT = temp - IMU_TEMP_REF_C in
+ * deg C.  Outside min_c to max_c, the range it was fit over, the bias is held
+ * at its value at the nearer end rather than extrapolated. */
+typedef struct {
+    float c[MSZ][IMU_TEMP_TERMS];
+    float min_c;
+    float max_c;
+} IMU_gyro_temp_model_t;
+
+#ifdef AHRS_FIXED_POINT
+
+/* calibrated data in Q16.16, acc and mag normalized, gyro in rad/sec */
+struct IMU_out_fix {
+    q16_t acc[MSZ];
+    q16_t gyro[MSZ];
+    q16_t mag[MSZ];
+    int16_t temp;
+    uint16_t mag_status;
+    uint32_t usec; // Sys_timer_get_usec() time of the sample
+};
+#endif
+
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
@@ -49,7 +86,13 @@ struct IMU_out {
  * @Function IMU_init(void)
  * @return SUCCESS or ERROR
  * @brief initializes the I2C system for IMU operation
- * @note 
+ * @note IMU_SPI_MODE takes an interrupt for every byte of the burst read,
+ * IMU_SPI_DMA_MODE uses DMA channels 0 and 1 and interrupts once per sample.
+ * IMU_SPI_FIFO_MODE queues every sample in the IMU's FIFO and reads them in
+ * batches with IMU_get_batch(), two DMA interrupts per batch.
+ * IMU_SPI_DRDY_MODE reads each sample as the IMU signals it, which needs the
+ * IMU INT line wired to RE9 (INT2, pin 2 of the LIDAR connector J20, so not
+ * with the Garmin LIDAR power enable), and IMU_start_data_acq() does nothing.
  * @author Aaron Hunter
  **/
 uint8_t IMU_init(char interface_mode);
@@ -58,6 +101,10 @@ uint8_t IMU_init(char interface_mode);
  * @return none
  * @param none
  * @brief this function starts the SPI data read
+ * @note in IMU_SPI_FIFO_MODE data is ready only once IMU_FIFO_WATERMARK
+ * samples are queued, call it at least that often to keep the FIFO from
+ * filling (22 samples, 39 msec).  In the other SPI modes the sample is time
+ * stamped when the read starts.
  * @author Aaron Hunter
  **/
 int8_t IMU_start_data_acq(void);
@@ -75,7 +122,9 @@ uint8_t IMU_is_data_ready(void);
  * @Function IMU_get_raw_data(void)
  * @return pointer to IMU_output struct 
  * @brief returns most current (raw) data from the IMU
- * @note 
+ * @note the reads land in a triple buffer, so the getters always convert a
+ * whole frame, the newest, even while the next is being read.  Each frame is
+ * converted and calibrated once, later calls return the same sample.
  * @author Aaron Hunter,
  **/
 uint8_t IMU_get_raw_data(struct IMU_out* IMU_data);
@@ -89,6 +138,58 @@ uint8_t IMU_get_raw_data(struct IMU_out* IMU_data);
  **/
 void IMU_get_norm_data(struct IMU_out* IMU_data);
 
+/**
+ * @Function IMU_get_batch(struct IMU_out samples[], uint8_t max_samples)
+ * @param samples, room for max_samples
+ * @param max_samples, up to IMU_FIFO_MAX_BATCH
+ * @return number of samples copied, 0 if no batch is ready or the interface
+ * is not IMU_SPI_FIFO_MODE
+ * @brief returns the last FIFO batch oldest first, calibrated as
+ * IMU_get_norm_data() and time stamped
+ * @note IMU_get_norm_data() and the others return the newest sample of the
+ * batch
+ * @author Aaron Hunter,
+ **/
+uint8_t IMU_get_batch(struct IMU_out samples[], uint8_t max_samples);
+
+/**
+ * @Function IMU_get_batch_raw_data(struct IMU_out* IMU_data)
+ * @param IMU_data, the counts of the newest sample of the last batch
+ * @return SUCCESS
+ * @brief IMU_get_raw_data() for the batch IMU_get_batch() returned, it does
+ * not take a newer frame, so no batch is skipped between the two calls
+ * @author Aaron Hunter,
+ **/
+uint8_t IMU_get_batch_raw_data(struct IMU_out* IMU_data);
+
+/**
+ * @Function IMU_set_fifo_watermark(uint8_t num_samples)
+ * @param num_samples, 1 to IMU_FIFO_MAX_BATCH, IMU_FIFO_WATERMARK by default
+ * @return SUCCESS or ERROR
+ * @brief sets the samples the FIFO must hold before a read fetches them
+ * @author Aaron Hunter,
+ **/
+int8_t IMU_set_fifo_watermark(uint8_t num_samples);
+
+/**
+ * @Function IMU_get_fifo_overflows(void)
+ * @return times the FIFO filled up and was reset
+ * @author Aaron Hunter,
+ **/
+uint32_t IMU_get_fifo_overflows(void);
+
+#ifdef AHRS_FIXED_POINT
+/**
+ * @Function IMU_get_norm_data_fix(struct IMU_out_fix* IMU_data)
+ * @return SUCCESS
+ * @brief applies the Dorveaux calibration to the raw counts in fixed point
+ * @note same result as IMU_get_norm_data() without any float operations, except
+ * the gyro is converted to rad/sec for AHRS_fix_update()
+ * @author Aaron Hunter,
+ **/
+uint8_t IMU_get_norm_data_fix(struct IMU_out_fix* IMU_data);
+#endif
+
 /**
  * @Function IMU_get_scaled_data(void)
  * @return pointer to IMU_output struct 
@@ -131,6 +232,30 @@ int8_t IMU_set_acc_cal(float A[MSZ][MSZ], float b[MSZ]);
  **/
 int8_t IMU_set_gyro_cal(float A[MSZ][MSZ], float b[MSZ]);
 
+/**
+ * @Function IMU_set_gyro_temp_model(const IMU_gyro_temp_model_t *model)
+ * @param model, the gyro bias against temperature, NULL turns the
+ * compensation off
+ * @return SUCCESS or ERROR for coefficients that are not finite or an empty
+ * range, which leaves the compensation as it was
+ * @brief subtracts the bias at the die temperature from the gyro outputs of
+ * IMU_get_norm_data(), IMU_get_scaled_data(), IMU_get_batch() and
+ * IMU_get_norm_data_fix()
+ * @note the model is evaluated when the temperature has moved by about
+ * 0.1 C and folded into the gyro offset, the samples in between cost nothing
+ * @author Aaron Hunter
+ **/
+int8_t IMU_set_gyro_temp_model(const IMU_gyro_temp_model_t *model);
+
+/**
+ * @Function IMU_get_gyro_temp_bias(float bias[MSZ])
+ * @param bias, the bias taken off the current gyro outputs in deg/sec, zero
+ * with no model
+ * @brief add it back to the outputs for the uncompensated rates
+ * @author Aaron Hunter
+ **/
+void IMU_get_gyro_temp_bias(float bias[MSZ]);
+
 /**
  * @Function IMU_get_mag_cal(accum A[MSZ][MSZ], accum b[MSZ])
  * @param A destination matrix
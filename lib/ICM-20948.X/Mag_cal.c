@@ -0,0 +1,559 @@
+/*
+ * File:   Mag_cal.c
+ * Author: Aaron Hunter
+ * Brief: Online hard and soft iron calibration of the magnetometer, see
+ * Mag_cal.h.  The fit is the implicit ellipsoid
+ *     w0 x^2 + w1 y^2 + w2 z^2 + w3 xy + w4 xz + w5 yz + w6 x + w7 y + w8 z = 1
+ * of python/recursive_least_squares.py, estimated by recursive least squares
+ * without forgetting over one epoch.  Working on the calibrated vectors keeps
+ * the regressors near one, well conditioned in float, and the ellipsoid away
+ * from the origin where this form breaks down.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Mag_cal.h"
+#include "Board.h"
+#include <math.h>
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define NP MAG_CAL_NUM_PARAMS
+#define JACOBI_SWEEPS 10
+#define JACOBI_TOL 1e-12
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void fit_start(void);
+static int8_t fit_test(void);
+static int8_t m_inv(float m[MSZ][MSZ], float m_out[MSZ][MSZ]);
+static void sym_eig(float S[MSZ][MSZ], float V[MSZ][MSZ], float d[MSZ]);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+/* implicit parameters and their covariance, upper triangle only */
+static float w[NP];
+static float P[NP][NP];
+static float last[MSZ]; // last accepted sample
+static float residual_sum; // squared a priori residuals, second half of the epoch
+static uint8_t has_last = FALSE;
+
+/* correction of the last converged fit */
+static float A_fit[MSZ][MSZ];
+static float center[MSZ];
+static uint8_t is_pending = FALSE;
+
+static mag_cal_status_t status;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Mag_cal_init(void)
+ * @brief clears the fit and any pending correction and starts an epoch
+ * @author Aaron Hunter
+ */
+void Mag_cal_init(void) {
+    memset(&status, 0, sizeof (status));
+    is_pending = FALSE;
+    fit_start();
+}
+
+/**
+ * @Function Mag_cal_update(float mag[MSZ])
+ * @param mag, calibrated magnetometer vector, normalized to the local field
+ * @return TRUE when this sample completed an epoch whose fit converged
+ * @brief one recursive least squares step
+ * @author Aaron Hunter
+ */
+int8_t Mag_cal_update(float mag[MSZ]) {
+    float phi[NP]; // regressors
+    float Pphi[NP];
+    float norm_sq = mag[0] * mag[0] + mag[1] * mag[1] + mag[2] * mag[2];
+    float dot;
+    float denom;
+    float e;
+    float g;
+    int8_t row;
+    int8_t col;
+
+    /* skip interference and samples too close to the last one */
+    if ((norm_sq < MAG_CAL_NORM_MIN * MAG_CAL_NORM_MIN)
+            || (norm_sq > MAG_CAL_NORM_MAX * MAG_CAL_NORM_MAX)) {
+        return FALSE;
+    }
+    if (has_last == TRUE) {
+        dot = mag[0] * last[0] + mag[1] * last[1] + mag[2] * last[2];
+        if ((dot > 0) && (dot * dot > (float) (MAG_CAL_SPACING * MAG_CAL_SPACING)
+                * norm_sq * (last[0] * last[0] + last[1] * last[1] + last[2] * last[2]))) {
+            return FALSE;
+        }
+    }
+    for (row = 0; row < MSZ; row++) {
+        last[row] = mag[row];
+    }
+    has_last = TRUE;
+
+    phi[0] = mag[0] * mag[0];
+    phi[1] = mag[1] * mag[1];
+    phi[2] = mag[2] * mag[2];
+    phi[3] = mag[0] * mag[1];
+    phi[4] = mag[0] * mag[2];
+    phi[5] = mag[1] * mag[2];
+    phi[6] = mag[0];
+    phi[7] = mag[1];
+    phi[8] = mag[2];
+
+    /* a priori residual, gain P phi / (1 + phi' P phi) */
+    e = 1.0f;
+    denom = 1.0f;
+    for (row = 0; row < NP; row++) {
+        e -= phi[row] * w[row];
+        Pphi[row] = 0;
+        for (col = 0; col < NP; col++) {
+            Pphi[row] += (row <= col ? P[row][col] : P[col][row]) * phi[col];
+        }
+        denom += phi[row] * Pphi[row];
+    }
+    g = 1.0f / denom;
+    for (row = 0; row < NP; row++) {
+        w[row] += Pphi[row] * e * g;
+        for (col = row; col < NP; col++) {
+            P[row][col] -= Pphi[row] * Pphi[col] * g;
+        }
+    }
+
+    status.samples++;
+    if (status.samples > MAG_CAL_EPOCH / 2) {
+        residual_sum += e * e;
+    }
+    if (status.samples < MAG_CAL_EPOCH) {
+        return FALSE;
+    }
+    status.epochs++;
+    if (fit_test() == SUCCESS) {
+        status.fits++;
+        is_pending = TRUE;
+        fit_start();
+        return TRUE;
+    }
+    fit_start();
+    return FALSE;
+}
+
+/**
+ * @Function Mag_cal_apply(float A[MSZ][MSZ], float b[MSZ])
+ * @param A, b, the calibration the fitted samples were taken with, replaced by
+ * the corrected calibration
+ * @return SUCCESS or ERROR if no converged fit is pending
+ * @author Aaron Hunter
+ */
+int8_t Mag_cal_apply(float A[MSZ][MSZ], float b[MSZ]) {
+    float A_new[MSZ][MSZ];
+    float b_new[MSZ];
+    int8_t row;
+    int8_t col;
+    int8_t i;
+
+    if (is_pending == FALSE) {
+        return ERROR;
+    }
+    for (row = 0; row < MSZ; row++) {
+        b_new[row] = 0;
+        for (col = 0; col < MSZ; col++) {
+            A_new[row][col] = 0;
+            for (i = 0; i < MSZ; i++) {
+                A_new[row][col] += A_fit[row][i] * A[i][col];
+            }
+            b_new[row] += A_fit[row][col] * (b[col] - center[col]);
+        }
+    }
+    memcpy(A, A_new, sizeof (A_new));
+    memcpy(b, b_new, sizeof (b_new));
+    is_pending = FALSE;
+    return SUCCESS;
+}
+
+/**
+ * @Function Mag_cal_get_status(mag_cal_status_t *status)
+ * @author Aaron Hunter
+ */
+void Mag_cal_get_status(mag_cal_status_t *status_out) {
+    *status_out = status;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function fit_start(void)
+ * @brief starts an epoch at the unit sphere, the calibration in use
+ * @author Aaron Hunter
+ */
+static void fit_start(void) {
+    int8_t row;
+    int8_t col;
+
+    for (row = 0; row < NP; row++) {
+        w[row] = row < MSZ ? 1.0f : 0;
+        for (col = 0; col < NP; col++) {
+            P[row][col] = row == col ? MAG_CAL_P_INIT : 0;
+        }
+    }
+    residual_sum = 0;
+    status.samples = 0;
+    has_last = FALSE;
+}
+
+/**
+ * @Function fit_test(void)
+ * @return SUCCESS and the correction in A_fit and center if the epoch
+ * converged, ERROR otherwise
+ * @brief (m - c)' M (m - c) = k = 1 + c' M c with c = -M^-1 l / 2, so the
+ * correction is the symmetric square root of M / k
+ * @author Aaron Hunter
+ */
+static int8_t fit_test(void) {
+    float M[MSZ][MSZ];
+    float M_inv[MSZ][MSZ];
+    float V[MSZ][MSZ];
+    float d[MSZ];
+    float k;
+    int8_t row;
+    int8_t col;
+    int8_t i;
+
+    status.residual_rms = sqrtf(residual_sum / (MAG_CAL_EPOCH - MAG_CAL_EPOCH / 2));
+    status.p_max = 0;
+    for (row = 0; row < NP; row++) {
+        if (P[row][row] > status.p_max) {
+            status.p_max = P[row][row];
+        }
+    }
+    status.scale_min = 0;
+    status.scale_max = 0;
+    if ((status.p_max > MAG_CAL_P_CONVERGED)
+            || (status.residual_rms > MAG_CAL_RESIDUAL_MAX)) {
+        return ERROR;
+    }
+
+    M[0][0] = w[0];
+    M[1][1] = w[1];
+    M[2][2] = w[2];
+    M[0][1] = M[1][0] = 0.5f * w[3];
+    M[0][2] = M[2][0] = 0.5f * w[4];
+    M[1][2] = M[2][1] = 0.5f * w[5];
+    if (m_inv(M, M_inv) == ERROR) {
+        return ERROR;
+    }
+    k = 1.0f;
+    for (row = 0; row < MSZ; row++) {
+        center[row] = -0.5f * (M_inv[row][0] * w[6] + M_inv[row][1] * w[7]
+                + M_inv[row][2] * w[8]);
+    }
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            k += center[row] * M[row][col] * center[col];
+        }
+    }
+    if (fabsf(k) < 1e-6f) {
+        return ERROR; // the ellipsoid passes through the origin
+    }
+
+    /* A_fit = V sqrt(D) V', the eigenvalues are the squared scales.  M and k
+     * are both negative when the origin is outside the ellipsoid. */
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            M[row][col] /= k;
+        }
+    }
+    sym_eig(M, V, d);
+    status.scale_min = MAG_CAL_SCALE_MAX * MAG_CAL_SCALE_MAX;
+    for (i = 0; i < MSZ; i++) {
+        if (d[i] < status.scale_min) {
+            status.scale_min = d[i];
+        }
+        if (d[i] > status.scale_max) {
+            status.scale_max = d[i];
+        }
+    }
+    if ((status.scale_min < MAG_CAL_SCALE_MIN * MAG_CAL_SCALE_MIN)
+            || (status.scale_max > MAG_CAL_SCALE_MAX * MAG_CAL_SCALE_MAX)) {
+        status.scale_min = status.scale_min > 0 ? sqrtf(status.scale_min) : 0;
+        status.scale_max = sqrtf(status.scale_max);
+        return ERROR;
+    }
+    status.scale_min = sqrtf(status.scale_min);
+    status.scale_max = sqrtf(status.scale_max);
+    for (i = 0; i < MSZ; i++) {
+        d[i] = sqrtf(d[i]);
+    }
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            A_fit[row][col] = 0;
+            for (i = 0; i < MSZ; i++) {
+                A_fit[row][col] += V[row][i] * d[i] * V[col][i];
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function m_inv(float m[MSZ][MSZ], float m_out[MSZ][MSZ])
+ * @return SUCCESS or ERROR if m is singular
+ * @brief inverse by the adjugate
+ * @author Aaron Hunter
+ */
+static int8_t m_inv(float m[MSZ][MSZ], float m_out[MSZ][MSZ]) {
+    float det;
+    int8_t row;
+    int8_t col;
+
+    m_out[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    m_out[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    m_out[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    m_out[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    m_out[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    m_out[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    m_out[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    m_out[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    m_out[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+    det = m[0][0] * m_out[0][0] + m[0][1] * m_out[1][0] + m[0][2] * m_out[2][0];
+    if (fabsf(det) < 1e-12f) {
+        return ERROR;
+    }
+    det = 1.0f / det;
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            m_out[row][col] *= det;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @Function sym_eig(float S[MSZ][MSZ], float V[MSZ][MSZ], float d[MSZ])
+ * @param S, symmetric matrix, overwritten
+ * @param V, returns the eigenvectors as columns
+ * @param d, returns the eigenvalues
+ * @brief cyclic Jacobi rotations, a 3x3 converges in a few sweeps
+ * @author Aaron Hunter
+ */
+static void sym_eig(float S[MSZ][MSZ], float V[MSZ][MSZ], float d[MSZ]) {
+    float off;
+    float theta;
+    float t;
+    float c;
+    float s;
+    float tmp_p;
+    float tmp_q;
+    int8_t sweep;
+    int8_t p;
+    int8_t q;
+    int8_t i;
+
+    for (p = 0; p < MSZ; p++) {
+        for (q = 0; q < MSZ; q++) {
+            V[p][q] = p == q ? 1.0f : 0;
+        }
+    }
+    for (sweep = 0; sweep < JACOBI_SWEEPS; sweep++) {
+        off = S[0][1] * S[0][1] + S[0][2] * S[0][2] + S[1][2] * S[1][2];
+        if (off < JACOBI_TOL) {
+            break;
+        }
+        for (p = 0; p < MSZ - 1; p++) {
+            for (q = p + 1; q < MSZ; q++) {
+                if (S[p][q] == 0) {
+                    continue;
+                }
+                /* rotation that zeroes S[p][q] */
+                theta = (S[q][q] - S[p][p]) / (2.0f * S[p][q]);
+                t = (theta >= 0 ? 1.0f : -1.0f) / (fabsf(theta) + sqrtf(theta * theta + 1.0f));
+                c = 1.0f / sqrtf(t * t + 1.0f);
+                s = t * c;
+                for (i = 0; i < MSZ; i++) {
+                    tmp_p = S[i][p];
+                    tmp_q = S[i][q];
+                    S[i][p] = c * tmp_p - s * tmp_q;
+                    S[i][q] = s * tmp_p + c * tmp_q;
+                }
+                for (i = 0; i < MSZ; i++) {
+                    tmp_p = S[p][i];
+                    tmp_q = S[q][i];
+                    S[p][i] = c * tmp_p - s * tmp_q;
+                    S[q][i] = s * tmp_p + c * tmp_q;
+                }
+                for (i = 0; i < MSZ; i++) {
+                    tmp_p = V[i][p];
+                    tmp_q = V[i][q];
+                    V[i][p] = c * tmp_p - s * tmp_q;
+                    V[i][q] = s * tmp_p + c * tmp_q;
+                }
+            }
+        }
+    }
+    for (i = 0; i < MSZ; i++) {
+        d[i] = S[i][i];
+    }
+}
+
+#ifdef MAG_CAL_TESTING
+#include "SerialM32.h"
+#include <stdio.h>
+
+#define TEST_SAMPLES 20000
+#define TEST_NOISE 0.01 // fraction of the field, rms
+#define TEST_CAL_TOL 0.01 // largest element error of the recovered calibration
+
+static uint32_t lcg_state = 12345;
+
+static float test_rand(float scale) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return scale * ((int32_t) lcg_state / 2147483648.0f);
+}
+
+/* points the unit field vector in a random direction, as a hand tumble does
+ * between accepted samples, or turns it about z only when planar, and returns
+ * it distorted by D u + h plus noise */
+static void test_sample(float u[MSZ], float D[MSZ][MSZ], float h[MSZ], int8_t planar,
+        float mag[MSZ]) {
+    float n;
+    int8_t row;
+
+    if (planar == TRUE) {
+        float c = cosf(0.05f);
+        float s = sinf(0.05f);
+        float x = c * u[0] - s * u[1];
+        u[1] = s * u[0] + c * u[1];
+        u[0] = x;
+    } else {
+        do {
+            for (row = 0; row < MSZ; row++) {
+                u[row] = test_rand(1.0f);
+            }
+            n = u[0] * u[0] + u[1] * u[1] + u[2] * u[2];
+        } while ((n > 1.0f) || (n < 0.01f));
+        n = 1.0f / sqrtf(n);
+        for (row = 0; row < MSZ; row++) {
+            u[row] *= n;
+        }
+    }
+    for (row = 0; row < MSZ; row++) {
+        mag[row] = D[row][0] * u[0] + D[row][1] * u[1] + D[row][2] * u[2] + h[row]
+                + test_rand(TEST_NOISE * 1.732f);
+    }
+}
+
+int main(void) {
+    /* payload soft iron and hard iron seen through the old calibration */
+    float D[MSZ][MSZ] = {
+        {1.10, 0.04, -0.02},
+        {0.04, 0.92, 0.03},
+        {-0.02, 0.03, 1.05}
+    };
+    float h[MSZ] = {0.25, -0.15, 0.10};
+    float A[MSZ][MSZ];
+    float b[MSZ];
+    float u[MSZ] = {0.11, 0.48, -0.87};
+    float mag[MSZ];
+    float cal[MSZ];
+    float e;
+    float err_cal = 0;
+    float err_norm = 0;
+    mag_cal_status_t s;
+    int failures = 0;
+    int updates = 0;
+    int first_update = 0;
+    int i;
+    int8_t row;
+    int8_t col;
+
+    Board_init();
+    Serial_init();
+    printf("Mag_cal test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    /* tumble: the composed calibration must converge on D^-1 and -D^-1 h */
+    for (row = 0; row < MSZ; row++) {
+        b[row] = 0;
+        for (col = 0; col < MSZ; col++) {
+            A[row][col] = row == col ? 1.0f : 0;
+        }
+    }
+    Mag_cal_init();
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        test_sample(u, D, h, FALSE, mag);
+        for (row = 0; row < MSZ; row++) {
+            cal[row] = A[row][0] * mag[0] + A[row][1] * mag[1] + A[row][2] * mag[2] + b[row];
+        }
+        if (Mag_cal_update(cal) == TRUE) {
+            Mag_cal_apply(A, b);
+            if (updates++ == 0) {
+                first_update = i;
+            }
+        }
+    }
+    Mag_cal_get_status(&s);
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            /* A D should be the identity and A h + b zero */
+            e = A[row][0] * D[0][col] + A[row][1] * D[1][col] + A[row][2] * D[2][col]
+                    - (row == col ? 1.0f : 0);
+            err_cal = fabsf(e) > err_cal ? fabsf(e) : err_cal;
+        }
+        e = A[row][0] * h[0] + A[row][1] * h[1] + A[row][2] * h[2] + b[row];
+        err_cal = fabsf(e) > err_cal ? fabsf(e) : err_cal;
+    }
+    for (i = 0; i < 1000; i++) {
+        test_sample(u, D, h, FALSE, mag);
+        for (row = 0; row < MSZ; row++) {
+            cal[row] = A[row][0] * mag[0] + A[row][1] * mag[1] + A[row][2] * mag[2] + b[row];
+        }
+        e = sqrtf(cal[0] * cal[0] + cal[1] * cal[1] + cal[2] * cal[2]) - 1.0f;
+        err_norm += e * e;
+    }
+    err_norm = sqrtf(err_norm / 1000);
+    printf("tumble: %d updates, first after %d samples, %u epochs, residual %.4f, "
+            "p_max %.5f, calibration error %.5f, field rms error %.4f\r\n",
+            updates, first_update, s.epochs, (double) s.residual_rms, (double) s.p_max,
+            (double) err_cal, (double) err_norm);
+    if (updates == 0 || err_cal > TEST_CAL_TOL || err_norm > 2 * TEST_NOISE) {
+        printf("FAIL tumble\r\n");
+        failures++;
+    }
+
+    /* turning about z only must never update */
+    Mag_cal_init();
+    updates = 0;
+    u[0] = 0.11;
+    u[1] = 0.48;
+    u[2] = -0.87;
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        test_sample(u, D, h, TRUE, mag);
+        if (Mag_cal_update(mag) == TRUE) {
+            updates++;
+        }
+    }
+    Mag_cal_get_status(&s);
+    printf("planar: %d updates, %u epochs, p_max %.3f\r\n", updates, s.epochs,
+            (double) s.p_max);
+    if (updates != 0 || Mag_cal_apply(A, b) != ERROR) {
+        printf("FAIL planar\r\n");
+        failures++;
+    }
+
+    printf("%s\r\n", failures == 0 ? "Mag_cal tests passed" : "Mag_cal tests FAILED");
+    return 0;
+}
+#endif //MAG_CAL_TESTING
@@ -0,0 +1,114 @@
+/*
+ * File:   Mag_cal.h
+ * Author: Aaron Hunter
+ * Brief: Online hard and soft iron calibration of the magnetometer.  A
+ * recursive least squares ellipsoid fit, as prototyped in
+ * python/recursive_least_squares.py, runs on the calibrated magnetometer
+ * vectors, one sample at a time and without storing any.  It finds the
+ * correction that maps them back onto the unit sphere.  Mag_cal_apply() folds
+ * the correction into the A matrix and b vector of IMU_set_mag_cal(), so the
+ * offline tumble fit is only needed once per sensor and changes of payload are
+ * tracked in service.
+ *
+ * Samples closer than MAG_CAL_SPACING to the last accepted one are skipped, so
+ * a vehicle sitting still or driving straight does not swamp the fit.  After
+ * every MAG_CAL_EPOCH accepted samples the fit is tested: every parameter
+ * variance must be under MAG_CAL_P_CONVERGED, which needs rotations about all
+ * three axes, the residual under MAG_CAL_RESIDUAL_MAX and the correction must
+ * be a proper ellipsoid with scales within MAG_CAL_SCALE_MIN to
+ * MAG_CAL_SCALE_MAX.  Either way the next epoch starts from scratch.  A ground
+ * vehicle that only turns about z therefore never updates its calibration.
+ *
+ * Usage: feed calibrated vectors (IMU_get_norm_data()) at a low rate from the
+ * background loop.  When Mag_cal_update() returns TRUE:
+ *     IMU_get_mag_cal(A, b);
+ *     Mag_cal_apply(A, b);
+ *     IMU_set_mag_cal(A, b);
+ * The starting calibration only needs to give a field magnitude within
+ * MAG_CAL_NORM_MIN to MAG_CAL_NORM_MAX.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef MAG_CAL_H // Header guard
+#define	MAG_CAL_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define MSZ 3 //matrix/vector size per dimension
+#define MAG_CAL_NUM_PARAMS 9 // x^2, y^2, z^2, xy, xz, yz, x, y, z
+
+#ifndef MAG_CAL_EPOCH
+#define MAG_CAL_EPOCH 800 // accepted samples per fit
+#endif
+#define MAG_CAL_SPACING 0.99619 // cos(5 deg), minimum angle between accepted samples
+#define MAG_CAL_NORM_MIN 0.25 // field magnitudes outside are interference, not data
+#define MAG_CAL_NORM_MAX 4.0
+#define MAG_CAL_P_INIT 100.0 // initial parameter variance, normalized units
+#define MAG_CAL_P_CONVERGED 0.1 // times the residual variance, ~0.007 std per parameter
+#define MAG_CAL_RESIDUAL_MAX 0.1 // rms of 1 - fit, about twice the field error
+#define MAG_CAL_SCALE_MIN 0.5
+#define MAG_CAL_SCALE_MAX 2.0
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint16_t samples; // accepted in the current epoch
+    uint16_t epochs; // fits tested
+    uint16_t fits; // fits that converged
+    float residual_rms; // of the last tested fit
+    float p_max; // largest parameter variance of the last tested fit
+    float scale_min; // smallest and largest scale of the last tested fit
+    float scale_max;
+} mag_cal_status_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Mag_cal_init(void)
+ * @brief clears the fit and any pending correction and starts an epoch
+ * @author Aaron Hunter
+ */
+void Mag_cal_init(void);
+
+/**
+ * @Function Mag_cal_update(float mag[MSZ])
+ * @param mag, calibrated magnetometer vector, normalized to the local field
+ * @return TRUE when this sample completed an epoch whose fit converged, then
+ * Mag_cal_apply() holds the correction, FALSE otherwise
+ * @brief one recursive least squares step, about 250 multiplies, or a
+ * dot product when the sample is skipped
+ * @author Aaron Hunter
+ */
+int8_t Mag_cal_update(float mag[MSZ]);
+
+/**
+ * @Function Mag_cal_apply(float A[MSZ][MSZ], float b[MSZ])
+ * @param A, b, the calibration the fitted samples were taken with, replaced by
+ * the corrected calibration
+ * @return SUCCESS or ERROR if no converged fit is pending
+ * @brief A = A_fit A, b = A_fit (b - c) with c the fitted center and A_fit
+ * the symmetric square root of the fitted ellipsoid, so the correction adds
+ * no rotation
+ * @author Aaron Hunter
+ */
+int8_t Mag_cal_apply(float A[MSZ][MSZ], float b[MSZ]);
+
+/**
+ * @Function Mag_cal_get_status(mag_cal_status_t *status)
+ * @param status, progress of the current epoch and the last tested fit
+ * @author Aaron Hunter
+ */
+void Mag_cal_get_status(mag_cal_status_t *status);
+
+#endif	/* MAG_CAL_H */ // End of header guard
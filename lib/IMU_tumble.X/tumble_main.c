@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <stdfix.h>
 #include "ICM_20948.h"  
+#include "Mag_cal.h"
 #include "SerialM32.h"
 #include "Board.h"
 #include "System_timer.h"
@@ -24,6 +25,7 @@
  ******************************************************************************/
 #define RAW_DATA_OUT
 //#define NORM_DATA_OUT
+//#define ONLINE_CAL_OUT // runs Mag_cal on the tumble, prints each converged A_mag, b_mag
 #define MSZ 3
 
 int main(void) {
@@ -48,6 +50,9 @@ int main(void) {
     };
     float b_acc[MSZ] = {0.00591423067694908, 0.0173747801090554, 0.0379428158730668};
     float b_mag[MSZ] = {0.214140746707571, -1.08116057610690, -0.727337561140470};
+#ifdef ONLINE_CAL_OUT
+    float mag[MSZ];
+#endif
 
 
     Board_init();
@@ -61,9 +66,12 @@ int main(void) {
         if ((current_time - start_time) >= warmup_time) timer_expired = TRUE;
     }
     IMU_init(IMU_SPI_MODE);
-#ifdef NORM_DATA_OUT
+#if defined(NORM_DATA_OUT) || defined(ONLINE_CAL_OUT)
     IMU_set_mag_cal(A_mag, b_mag);
     IMU_set_acc_cal(A_acc, b_acc);
+#endif
+#ifdef ONLINE_CAL_OUT
+    Mag_cal_init();
 #endif
     timer_expired = FALSE;
     start_time = Sys_timer_get_msec();
@@ -90,6 +98,22 @@ int main(void) {
                     IMU_data_out.acc.x, IMU_data_out.acc.y, IMU_data_out.acc.z,
                     IMU_data_out.mag.x, IMU_data_out.mag.y, IMU_data_out.mag.z,
                     IMU_data_out.gyro.x, IMU_data_out.gyro.y, IMU_data_out.gyro.z);
+#endif
+#ifdef ONLINE_CAL_OUT
+            IMU_get_norm_data(&IMU_data_out);
+            mag[0] = IMU_data_out.mag.x;
+            mag[1] = IMU_data_out.mag.y;
+            mag[2] = IMU_data_out.mag.z;
+            if (Mag_cal_update(mag) == TRUE) {
+                IMU_get_mag_cal(A_mag, b_mag);
+                Mag_cal_apply(A_mag, b_mag);
+                IMU_set_mag_cal(A_mag, b_mag);
+                printf("A_mag = [%g, %g, %g; %g, %g, %g; %g, %g, %g]\r\n",
+                        A_mag[0][0], A_mag[0][1], A_mag[0][2],
+                        A_mag[1][0], A_mag[1][1], A_mag[1][2],
+                        A_mag[2][0], A_mag[2][1], A_mag[2][2]);
+                printf("b_mag = [%g, %g, %g]\r\n", b_mag[0], b_mag[1], b_mag[2]);
+            }
 #endif
         }
 
@@ -0,0 +1,156 @@
+/*
+ * File:   Latency.c
+ * Author: Aaron Hunter
+ * Brief: Execution time statistics for control loop stages
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Latency.h" // The header file for this source file.
+#include <string.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define CYCLES_MAX 0xFFFFFFFFu
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static uint8_t latency_bin(HAL_cycles_t elapsed);
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS                                             *
+ ******************************************************************************/
+
+/**
+ * @Function Latency_reset(latency_stats_t *stats)
+ * @author Aaron Hunter
+ */
+void Latency_reset(latency_stats_t *stats) {
+    memset(stats, 0, sizeof (*stats));
+    stats->min = CYCLES_MAX;
+}
+
+/**
+ * @Function Latency_add(latency_stats_t *stats, HAL_cycles_t elapsed)
+ * @author Aaron Hunter
+ */
+void Latency_add(latency_stats_t *stats, HAL_cycles_t elapsed) {
+    uint8_t bin = latency_bin(elapsed);
+    stats->samples++;
+    stats->total += elapsed;
+    if (elapsed < stats->min) {
+        stats->min = elapsed;
+    }
+    if (elapsed > stats->max) {
+        stats->max = elapsed;
+    }
+    if (stats->bins[bin] < UINT16_MAX) {
+        stats->bins[bin]++;
+    }
+}
+
+/**
+ * @Function Latency_mark(latency_stats_t *stats, HAL_cycles_t start)
+ * @author Aaron Hunter
+ */
+HAL_cycles_t Latency_mark(latency_stats_t *stats, HAL_cycles_t start) {
+    HAL_cycles_t now = HAL_get_cycles();
+    Latency_add(stats, now - start);
+    return now;
+}
+
+/**
+ * @Function Latency_to_array(const latency_stats_t *stats, float out[LATENCY_ARRAY_LENGTH])
+ * @author Aaron Hunter
+ */
+uint8_t Latency_to_array(const latency_stats_t *stats, float out[LATENCY_ARRAY_LENGTH]) {
+    const float usec_per_cycle = 1.0 / HAL_CYCLES_PER_USEC;
+    uint8_t i;
+    out[0] = (float) stats->samples;
+    if (stats->samples > 0) {
+        out[1] = stats->min * usec_per_cycle;
+        out[2] = stats->max * usec_per_cycle;
+        out[3] = ((float) stats->total / stats->samples) * usec_per_cycle;
+    } else {
+        out[1] = 0;
+        out[2] = 0;
+        out[3] = 0;
+    }
+    out[4] = HAL_CYCLES_PER_USEC;
+    for (i = 0; i < LATENCY_BINS; i++) {
+        out[LATENCY_HEADER + i] = stats->bins[i];
+    }
+    return LATENCY_ARRAY_LENGTH;
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+/**
+ * @Function latency_bin(HAL_cycles_t elapsed)
+ * @return number of significant bits in elapsed, clamped to the last bin
+ * @note the MIPS32 clz instruction makes this a single cycle on the PIC32
+ */
+static uint8_t latency_bin(HAL_cycles_t elapsed) {
+    uint8_t bits;
+    if (elapsed == 0) {
+        return 0;
+    }
+    bits = 32 - __builtin_clz(elapsed);
+    return bits < LATENCY_BINS ? bits : LATENCY_BINS - 1;
+}
+
+#ifdef LATENCY_TESTING
+#include <stdio.h>
+#include "Board.h"
+#include "SerialM32.h"
+
+int main(void) {
+    latency_stats_t stats;
+    float out[LATENCY_ARRAY_LENGTH];
+    const HAL_cycles_t test_values[] = {0, 1, 2, 3, 4, 1000, 1023, 1024, 0x800000, 0xFFFFFFFF};
+    const uint8_t expected_bins[] = {0, 1, 2, 2, 3, 10, 10, 11, 23, 23};
+    uint8_t num_values = sizeof (test_values) / sizeof (test_values[0]);
+    uint8_t failures = 0;
+    HAL_cycles_t start;
+    uint8_t i;
+
+    Board_init();
+    Serial_init();
+    printf("Latency test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    Latency_reset(&stats);
+    for (i = 0; i < num_values; i++) {
+        Latency_add(&stats, test_values[i]);
+        if (latency_bin(test_values[i]) != expected_bins[i]) {
+            printf("bin of %u is %d, expected %d\r\n", test_values[i],
+                    latency_bin(test_values[i]), expected_bins[i]);
+            failures++;
+        }
+    }
+    if (stats.samples != num_values || stats.min != 0 || stats.max != 0xFFFFFFFF
+            || stats.bins[2] != 2 || stats.bins[23] != 2) {
+        printf("statistics wrong: samples %u min %u max %u\r\n", stats.samples, stats.min, stats.max);
+        failures++;
+    }
+
+    /* time an empty stage to show the cost of the instrumentation itself */
+    Latency_reset(&stats);
+    start = HAL_get_cycles();
+    for (i = 0; i < 100; i++) {
+        start = Latency_mark(&stats, start);
+    }
+    Latency_to_array(&stats, out);
+    printf("empty stage: %d samples, min %.3f us, max %.3f us, mean %.3f us\r\n",
+            (int) out[0], out[1], out[2], out[3]);
+    printf("%s\r\n", failures == 0 ? "Latency tests passed" : "Latency tests FAILED");
+    return 0;
+}
+#endif //LATENCY_TESTING
@@ -0,0 +1,83 @@
+/*
+ * File:   Latency.h
+ * Author: Aaron Hunter
+ * Brief: Execution time statistics for control loop stages.  Each stage keeps
+ * its sample count, min, max, mean and a log2 histogram of HAL_get_cycles()
+ * differences, cheap enough to run on every pass of a 100 Hz loop.  The
+ * histogram shows the tail that a single sampled timing hides.
+ * Usage: take start = HAL_get_cycles() once, then after each stage
+ * start = Latency_mark(&stage_stats, start) so consecutive stages share one
+ * counter read per boundary.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef LATENCY_H // Header guard
+#define	LATENCY_H //
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include "HAL.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+#define LATENCY_BINS 24 // bin k counts 2^(k-1) <= cycles < 2^k, the last bin everything above
+#define LATENCY_HEADER 5 // samples, min, max, mean, cycles per usec
+#define LATENCY_ARRAY_LENGTH (LATENCY_HEADER + LATENCY_BINS)
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+typedef struct {
+    uint32_t samples;
+    HAL_cycles_t min;
+    HAL_cycles_t max;
+    uint64_t total;
+    uint16_t bins[LATENCY_BINS]; // saturate at UINT16_MAX
+} latency_stats_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Latency_reset(latency_stats_t *stats)
+ * @param stats, statistics to clear
+ * @brief starts a new measurement window
+ * @author Aaron Hunter
+ */
+void Latency_reset(latency_stats_t *stats);
+
+/**
+ * @Function Latency_add(latency_stats_t *stats, HAL_cycles_t elapsed)
+ * @param stats, statistics of the stage
+ * @param elapsed, execution time in HAL_CYCLE_UNITS
+ * @author Aaron Hunter
+ */
+void Latency_add(latency_stats_t *stats, HAL_cycles_t elapsed);
+
+/**
+ * @Function Latency_mark(latency_stats_t *stats, HAL_cycles_t start)
+ * @param stats, statistics of the stage that just finished
+ * @param start, HAL_get_cycles() at the start of the stage
+ * @return HAL_get_cycles() now, the start of the next stage
+ * @author Aaron Hunter
+ */
+HAL_cycles_t Latency_mark(latency_stats_t *stats, HAL_cycles_t start);
+
+/**
+ * @Function Latency_to_array(const latency_stats_t *stats, float out[LATENCY_ARRAY_LENGTH])
+ * @param stats, statistics of the stage
+ * @param out, samples, min, max and mean in microseconds, HAL_CYCLES_PER_USEC,
+ * then the LATENCY_BINS histogram counts
+ * @return number of values written, LATENCY_ARRAY_LENGTH
+ * @brief layout used for the DEBUG_FLOAT_ARRAY telemetry message
+ * @author Aaron Hunter
+ */
+uint8_t Latency_to_array(const latency_stats_t *stats, float out[LATENCY_ARRAY_LENGTH]);
+
+#endif	/* LATENCY_H */ // End of header guard
@@ -0,0 +1,259 @@
+/*
+ * File:   Lin_alg_batch.c
+ * Author: Aaron Hunter
+ * Brief: Structure of arrays Lin_alg kernels, see Lin_alg_batch.h.  Each batch
+ * is one restrict parameter and the component rows are offsets into it, which
+ * tells gcc the batches do not overlap.  Restrict locals copied from an array
+ * of row pointers do not: gcc ignores them, and with a dozen rows the runtime
+ * overlap checks it would need exceed its limit and the loops stay scalar.
+ * sqrtf() and 1.0f / x round the same as the double sqrt() and 1.0 / x of
+ * Lin_alg_float rounded back to float.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES
+ ******************************************************************************/
+#include "Lin_alg_batch.h"
+#include <math.h>
+
+/*******************************************************************************
+ * PUBLIC FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_batch_q_mult()
+ * r = q p for n pairs, lin_alg_q_mult()
+ */
+void lin_alg_batch_q_mult(float *restrict q, float *restrict p, float *restrict r_out, uint32_t n) {
+    float *q0 = q, *q1 = q + n, *q2 = q + 2 * n, *q3 = q + 3 * n;
+    float *p0 = p, *p1 = p + n, *p2 = p + 2 * n, *p3 = p + 3 * n;
+    float *r0 = r_out, *r1 = r_out + n, *r2 = r_out + 2 * n, *r3 = r_out + 3 * n;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        r0[i] = p0[i] * q0[i] - p1[i] * q1[i] - p2[i] * q2[i] - p3[i] * q3[i];
+        r1[i] = p1[i] * q0[i] + p0[i] * q1[i] + p3[i] * q2[i] - p2[i] * q3[i];
+        r2[i] = p2[i] * q0[i] - p3[i] * q1[i] + p0[i] * q2[i] + p1[i] * q3[i];
+        r3[i] = p3[i] * q0[i] + p2[i] * q1[i] - p1[i] * q2[i] + p0[i] * q3[i];
+    }
+}
+
+/**
+ * @function lin_alg_batch_cross()
+ * w = u x v for n pairs, lin_alg_cross()
+ */
+void lin_alg_batch_cross(float *restrict u, float *restrict v, float *restrict w_out, uint32_t n) {
+    float *u0 = u, *u1 = u + n, *u2 = u + 2 * n;
+    float *v0 = v, *v1 = v + n, *v2 = v + 2 * n;
+    float *w0 = w_out, *w1 = w_out + n, *w2 = w_out + 2 * n;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        w0[i] = u1[i] * v2[i] - u2[i] * v1[i];
+        w1[i] = u2[i] * v0[i] - u0[i] * v2[i];
+        w2[i] = u0[i] * v1[i] - u1[i] * v0[i];
+    }
+}
+
+/**
+ * @function lin_alg_batch_m_v_mult()
+ * v_out = m v for one matrix and n vectors, lin_alg_m_v_mult()
+ * @note the sums start from 0 as in lin_alg_m_v_mult(), which turns a -0
+ * result into +0
+ */
+void lin_alg_batch_m_v_mult(float m[MSZ][MSZ], float *restrict v, float *restrict v_out, uint32_t n) {
+    float *x = v, *y = v + n, *z = v + 2 * n;
+    float *o0 = v_out, *o1 = v_out + n, *o2 = v_out + 2 * n;
+    const float m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+    const float m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+    const float m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        o0[i] = 0.0f + m00 * x[i] + m01 * y[i] + m02 * z[i];
+        o1[i] = 0.0f + m10 * x[i] + m11 * y[i] + m12 * z[i];
+        o2[i] = 0.0f + m20 * x[i] + m21 * y[i] + m22 * z[i];
+    }
+}
+
+/**
+ * @function lin_alg_batch_v_normalize()
+ * v = v / |v| for n vectors
+ */
+void lin_alg_batch_v_normalize(float *restrict v, uint32_t n) {
+    float *x = v, *y = v + n, *z = v + 2 * n;
+    float s;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        s = 1.0f / sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+        x[i] = s * x[i];
+        y[i] = s * y[i];
+        z[i] = s * z[i];
+    }
+}
+
+/**
+ * @function lin_alg_batch_q_normalize()
+ * q = q / |q| for n quaternions
+ */
+void lin_alg_batch_q_normalize(float *restrict q, uint32_t n) {
+    float *q0 = q, *q1 = q + n, *q2 = q + 2 * n, *q3 = q + 3 * n;
+    float s;
+    uint32_t i;
+
+    for (i = 0; i < n; i++) {
+        s = 1.0f / sqrtf(q0[i] * q0[i] + q1[i] * q1[i] + q2[i] * q2[i] + q3[i] * q3[i]);
+        q0[i] *= s;
+        q1[i] *= s;
+        q2[i] *= s;
+        q3[i] *= s;
+    }
+}
+
+#ifdef LIN_ALG_BATCH_TESTING
+#include "Lin_alg_float.h"
+#include "Board.h"
+#include "SerialM32.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_N 1003 // not a multiple of any vector width, so the tails run too
+
+static uint32_t lcg_state = 12345;
+static float a[QSZ][TEST_N];
+static float b[QSZ][TEST_N];
+static float out[QSZ][TEST_N];
+
+static float test_rand(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (int32_t) lcg_state / 2147483648.0f;
+}
+
+/* 1 if any component differs in any bit from the scalar result */
+static int test_compare(const char *name, int element, float scalar[], float batch[], int len) {
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (memcmp(&scalar[i], &batch[i], sizeof (float)) != 0) {
+            printf("%s: element %d row %d %.9g != %.9g\r\n", name, element, i,
+                    (double) scalar[i], (double) batch[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    float m[MSZ][MSZ];
+    float u[QSZ];
+    float v[QSZ];
+    float r[QSZ];
+    float s_out[QSZ];
+    float b_out[QSZ];
+    int failures = 0;
+    int errors;
+    int i;
+    int row;
+    int col;
+
+    Board_init();
+    Serial_init();
+    printf("Lin_alg_batch test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    for (row = 0; row < QSZ; row++) {
+        for (i = 0; i < TEST_N; i++) {
+            a[row][i] = 2.0f * test_rand();
+            b[row][i] = 2.0f * test_rand();
+        }
+    }
+    /* signed zeros, which the m_v_mult sum has to treat as the scalar does */
+    for (row = 0; row < QSZ; row++) {
+        a[row][0] = -0.0f;
+    }
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            m[row][col] = test_rand();
+        }
+    }
+
+    /* q_mult */
+    lin_alg_batch_q_mult(a[0], b[0], out[0], TEST_N);
+    errors = 0;
+    for (i = 0; i < TEST_N; i++) {
+        for (row = 0; row < QSZ; row++) {
+            u[row] = a[row][i];
+            v[row] = b[row][i];
+            b_out[row] = out[row][i];
+        }
+        lin_alg_q_mult(u, v, s_out);
+        errors += test_compare("q_mult", i, s_out, b_out, QSZ);
+    }
+    printf("q_mult: %d of %d differ\r\n", errors, TEST_N);
+    failures += errors > 0;
+
+    /* cross */
+    lin_alg_batch_cross(a[0], b[0], out[0], TEST_N);
+    errors = 0;
+    for (i = 0; i < TEST_N; i++) {
+        for (row = 0; row < MSZ; row++) {
+            u[row] = a[row][i];
+            v[row] = b[row][i];
+            b_out[row] = out[row][i];
+        }
+        lin_alg_cross(u, v, s_out);
+        errors += test_compare("cross", i, s_out, b_out, MSZ);
+    }
+    printf("cross: %d of %d differ\r\n", errors, TEST_N);
+    failures += errors > 0;
+
+    /* m_v_mult */
+    lin_alg_batch_m_v_mult(m, a[0], out[0], TEST_N);
+    errors = 0;
+    for (i = 0; i < TEST_N; i++) {
+        for (row = 0; row < MSZ; row++) {
+            u[row] = a[row][i];
+            b_out[row] = out[row][i];
+        }
+        lin_alg_m_v_mult(m, u, s_out);
+        errors += test_compare("m_v_mult", i, s_out, b_out, MSZ);
+    }
+    printf("m_v_mult: %d of %d differ\r\n", errors, TEST_N);
+    failures += errors > 0;
+
+    /* normalizations, skipping the zero vector */
+    a[0][0] = 1.0f;
+    memcpy(out, a, sizeof (out));
+    lin_alg_batch_v_normalize(out[0], TEST_N);
+    errors = 0;
+    for (i = 0; i < TEST_N; i++) {
+        for (row = 0; row < MSZ; row++) {
+            u[row] = a[row][i];
+            b_out[row] = out[row][i];
+        }
+        lin_alg_s_v_mult(1.0 / lin_alg_v_norm(u), u, s_out);
+        errors += test_compare("v_normalize", i, s_out, b_out, MSZ);
+    }
+    printf("v_normalize: %d of %d differ\r\n", errors, TEST_N);
+    failures += errors > 0;
+
+    memcpy(out, a, sizeof (out));
+    lin_alg_batch_q_normalize(out[0], TEST_N);
+    errors = 0;
+    for (i = 0; i < TEST_N; i++) {
+        for (row = 0; row < QSZ; row++) {
+            r[row] = a[row][i];
+            b_out[row] = out[row][i];
+        }
+        lin_alg_scale_q(1.0 / lin_alg_q_norm(r), r);
+        errors += test_compare("q_normalize", i, r, b_out, QSZ);
+    }
+    printf("q_normalize: %d of %d differ\r\n", errors, TEST_N);
+    failures += errors > 0;
+
+    printf("%s\r\n", failures == 0 ? "Lin_alg_batch tests passed" : "Lin_alg_batch tests FAILED");
+    return 0;
+}
+#endif //LIN_ALG_BATCH_TESTING
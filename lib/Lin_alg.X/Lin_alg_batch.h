@@ -0,0 +1,88 @@
+/*
+ * File:   Lin_alg_batch.h
+ * Author: Aaron Hunter
+ * Brief: Structure of arrays versions of the Lin_alg_float kernels that the
+ * offline tools run over whole logs: calibration fitting, replay and gain
+ * sweeps.  A batch of n vectors is one block of MSZ * n floats, component
+ * major, i.e. float v[MSZ][n] with v[row][i] the row of element i, and a batch
+ * of quaternions float q[QSZ][n].  Each kernel is one loop over i with no
+ * branches or calls, which gcc -O3 vectorizes for SSE or AVX on the host; on
+ * the PIC32 they are plain loops.  The normalizations need -fno-math-errno to
+ * vectorize, otherwise sqrtf() keeps its errno branch.
+ *
+ * Every kernel does the arithmetic of its Lin_alg_float counterpart in the
+ * same order, so the results agree bit for bit with calling that function on
+ * each element, see LIN_ALG_BATCH_TESTING.  That holds as long as the compiler
+ * contracts a * b + c into FMAs the same way in both, so build without
+ * -ffast-math, and with -ffp-contract=off to be sure when FMA is enabled
+ * (-march=native).
+ *
+ * Batches may not overlap, restrict, and the normalizations work in place.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_BATCH_H
+#define	LIN_ALG_BATCH_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * #DEFINES
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+#define QSZ 4
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_batch_q_mult()
+ * r = q p for n pairs, lin_alg_q_mult()
+ * @param q, p batches of quaternions, float [QSZ][n]
+ * @param r_out the products, float [QSZ][n]
+ * @param n batch size
+ */
+void lin_alg_batch_q_mult(float *restrict q, float *restrict p, float *restrict r_out, uint32_t n);
+
+/**
+ * @function lin_alg_batch_cross()
+ * w = u x v for n pairs, lin_alg_cross()
+ * @param u, v batches of vectors, float [MSZ][n]
+ * @param w_out the cross products, float [MSZ][n]
+ * @param n batch size
+ */
+void lin_alg_batch_cross(float *restrict u, float *restrict v, float *restrict w_out, uint32_t n);
+
+/**
+ * @function lin_alg_batch_m_v_mult()
+ * v_out = m v for one matrix and n vectors, lin_alg_m_v_mult(), e.g. a
+ * calibration applied to a log
+ * @param m the matrix
+ * @param v a batch of vectors, float [MSZ][n]
+ * @param v_out the products, float [MSZ][n]
+ * @param n batch size
+ */
+void lin_alg_batch_m_v_mult(float m[MSZ][MSZ], float *restrict v, float *restrict v_out, uint32_t n);
+
+/**
+ * @function lin_alg_batch_v_normalize()
+ * v = v / |v| for n vectors, as lin_alg_s_v_mult(1.0 / lin_alg_v_norm(v), v, v)
+ * @param v a batch of vectors, float [MSZ][n], normalized in place
+ * @param n batch size
+ */
+void lin_alg_batch_v_normalize(float *restrict v, uint32_t n);
+
+/**
+ * @function lin_alg_batch_q_normalize()
+ * q = q / |q| for n quaternions, as lin_alg_scale_q(1.0 / lin_alg_q_norm(q), q)
+ * @param q a batch of quaternions, float [QSZ][n], normalized in place
+ * @param n batch size
+ */
+void lin_alg_batch_q_normalize(float *restrict q, uint32_t n);
+
+#endif	/* LIN_ALG_BATCH_H */
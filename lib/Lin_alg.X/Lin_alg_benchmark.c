@@ -0,0 +1,588 @@
+/*
+ * File:   Lin_alg_benchmark.c
+ * Author: Aaron Hunter
+ * Brief: Execution time of the Lin_alg_float kernels used in the AHRS and
+ * control loops and of their Lin_alg_fix counterparts, in ns per call on the
+ * host and CPU cycles per call on the PIC32.  Kernels with the same name in the
+ * lin_alg_float and lin_alg_fix suites do the same work, as do those in the
+ * lin_alg_loop and lin_alg_batch suites, which process BATCH_N elements per
+ * call, the first with the scalar kernels over arrays of vectors and the
+ * second with the Lin_alg_batch kernels.  The lin_alg_mat6 and lin_alg_mat9
+ * suites time Lin_alg_mat at the sizes of a 6 and a 9 state filter.  Build
+ * with LIN_ALG_BENCHMARK defined.  On the host:
+ *     gcc -O3 -fno-math-errno -DHAL_SIM -DLIN_ALG_BENCHMARK -Ilib/HAL.X/linux
+ *         -Ilib/HAL.X -Ilib/Board.X -Ilib/Serial.X -Ilib/System_timer.X
+ *         -Ilib/Lin_alg.X -Ilib/Benchmark.X lib/Lin_alg.X/Lin_alg_float.c
+ *         lib/Lin_alg.X/Lin_alg_fix.c lib/Lin_alg.X/Lin_alg_batch.c
+ *         lib/Lin_alg.X/Lin_alg_mat.c lib/Lin_alg.X/Lin_alg_benchmark.c
+ *         lib/Benchmark.X/Benchmark.c lib/HAL.X/HAL_linux.c lib/Board.X/Board.c
+ *         lib/Serial.X/SerialM32.c lib/System_timer.X/System_timer.c -lm
+ * On the target add this file, Lin_alg_fix.c, Lin_alg_batch.c,
+ * Lin_alg_mat.c, Benchmark.c and HAL_pic32.c to
+ * the project and capture the serial port.  Lines starting with # are comments; the rest is
+ * the CSV described in Benchmark.h.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifdef LIN_ALG_BENCHMARK
+
+/*******************************************************************************
+ * #INCLUDES                                                                   *
+ ******************************************************************************/
+
+#include "Lin_alg_float.h"
+#include "Lin_alg_fix.h"
+#include "Lin_alg_batch.h"
+#include "Lin_alg_mat.h"
+#include "Benchmark.h"
+#include "Board.h"
+#include "SerialM32.h"
+#include <stdio.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES                                                            *
+ ******************************************************************************/
+#define SUITE "lin_alg_float"
+#define FIX_SUITE "lin_alg_fix"
+#define LOOP_SUITE "lin_alg_loop"
+#define BATCH_SUITE "lin_alg_batch"
+#define BATCH_N 64 // elements per batch, a block of a replayed log
+#define MAT6_SUITE "lin_alg_mat6"
+#define MAT9_SUITE "lin_alg_mat9"
+
+/*******************************************************************************
+ * PRIVATE TYPEDEFS                                                            *
+ ******************************************************************************/
+typedef struct {
+    float m1[MSZ][MSZ];
+    float m2[MSZ][MSZ];
+    float m_out[MSZ][MSZ];
+    float u[MSZ];
+    float v[MSZ];
+    float v_out[MSZ];
+    float w_out[MSZ];
+    float p[QSZ];
+    float q[QSZ];
+    float q_out[QSZ];
+    float psi;
+    float theta;
+    float phi;
+    float s;
+    char status;
+} operands_t;
+
+/* the same operands in Q2.30, with raw counts for the calibration */
+typedef struct {
+    q30_t u[MSZ];
+    q30_t v[MSZ];
+    q30_t v_out[MSZ];
+    q30_t w_out[MSZ];
+    q30_t p[QSZ];
+    q30_t q[QSZ];
+    q30_t q_out[QSZ];
+    int16_t counts[MSZ];
+    lin_alg_fix_cal_t cal;
+    char status;
+} fix_operands_t;
+
+/* BATCH_N operands, as arrays of vectors for the scalar kernels and as
+ * component major blocks for the batch kernels */
+typedef struct {
+    float m[MSZ][MSZ];
+    float u[BATCH_N][MSZ];
+    float v[BATCH_N][MSZ];
+    float w_out[BATCH_N][MSZ];
+    float p[BATCH_N][QSZ];
+    float q[BATCH_N][QSZ];
+    float q_out[BATCH_N][QSZ];
+    float u_soa[MSZ][BATCH_N];
+    float v_soa[MSZ][BATCH_N];
+    float w_out_soa[MSZ][BATCH_N];
+    float p_soa[QSZ][BATCH_N];
+    float q_soa[QSZ][BATCH_N];
+    float q_out_soa[QSZ][BATCH_N];
+} batch_operands_t;
+
+/* an n state filter: a transition a, a covariance p and n x 1 right hand sides */
+typedef struct {
+    lin_alg_mat_t a;
+    lin_alg_mat_t p;
+    lin_alg_mat_t b;
+    lin_alg_mat_t c;
+    lin_alg_mat_t d;
+    lin_alg_mat_t l;
+    lin_alg_mat_t lu;
+    lin_alg_mat_t x;
+    uint8_t perm[LIN_ALG_MAT_MAX];
+    char status;
+} mat_operands_t;
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES                                                *
+ ******************************************************************************/
+static void bench_q_mult(void *ctx);
+static void bench_cross(void *ctx);
+static void bench_m_m_mult(void *ctx);
+static void bench_extract_angles(void *ctx);
+static void bench_m_v_mult(void *ctx);
+static void bench_m_transpose(void *ctx);
+static void bench_m_det(void *ctx);
+static void bench_dot(void *ctx);
+static void bench_v_norm(void *ctx);
+static void bench_q_norm(void *ctx);
+static void bench_q2dcm(void *ctx);
+static void bench_q2euler_abs(void *ctx);
+static void bench_set_q(void *ctx);
+static void bench_gen_dcm(void *ctx);
+static void bench_q_rot_v_q_sandwich(void *ctx);
+static void bench_q_rot_v_q(void *ctx);
+static void bench_q_rot_v_q_pair(void *ctx);
+static void bench_v_normalize(void *ctx);
+static void bench_cal_apply(void *ctx);
+static void bench_fix_q_mult(void *ctx);
+static void bench_fix_cross(void *ctx);
+static void bench_fix_v_normalize(void *ctx);
+static void bench_fix_q_rot_v_q_pair(void *ctx);
+static void bench_fix_cal_apply(void *ctx);
+static void bench_loop_q_mult(void *ctx);
+static void bench_loop_cross(void *ctx);
+static void bench_loop_m_v_mult(void *ctx);
+static void bench_loop_v_normalize(void *ctx);
+static void bench_loop_q_normalize(void *ctx);
+static void bench_batch_q_mult(void *ctx);
+static void bench_batch_cross(void *ctx);
+static void bench_batch_m_v_mult(void *ctx);
+static void bench_batch_v_normalize(void *ctx);
+static void bench_batch_q_normalize(void *ctx);
+static void bench_mat_mult(void *ctx);
+static void bench_mat_mult_t(void *ctx);
+static void bench_mat_abat(void *ctx);
+static void bench_mat_sym_abat(void *ctx);
+static void bench_mat_cholesky(void *ctx);
+static void bench_mat_cholesky_solve(void *ctx);
+static void bench_mat_lu(void *ctx);
+static void bench_mat_lu_solve(void *ctx);
+static void mat_operands_init(mat_operands_t *o, uint8_t n);
+
+/*******************************************************************************
+ * PRIVATE VARIABLES                                                           *
+ ******************************************************************************/
+static const benchmark_t kernels[] = {
+    {"q_mult", bench_q_mult},
+    {"cross", bench_cross},
+    {"m_m_mult", bench_m_m_mult},
+    {"extract_angles", bench_extract_angles},
+    {"m_v_mult", bench_m_v_mult},
+    {"m_transpose", bench_m_transpose},
+    {"m_det", bench_m_det},
+    {"dot", bench_dot},
+    {"v_norm", bench_v_norm},
+    {"q_norm", bench_q_norm},
+    {"q2dcm", bench_q2dcm},
+    {"q2euler_abs", bench_q2euler_abs},
+    {"set_q", bench_set_q},
+    {"gen_dcm", bench_gen_dcm},
+    {"q_rot_v_q_sandwich", bench_q_rot_v_q_sandwich},
+    {"q_rot_v_q", bench_q_rot_v_q},
+    {"q_rot_v_q_pair", bench_q_rot_v_q_pair},
+    {"v_normalize", bench_v_normalize},
+    {"cal_apply", bench_cal_apply},
+};
+
+static const benchmark_t fix_kernels[] = {
+    {"q_mult", bench_fix_q_mult},
+    {"cross", bench_fix_cross},
+    {"v_normalize", bench_fix_v_normalize},
+    {"q_rot_v_q_pair", bench_fix_q_rot_v_q_pair},
+    {"cal_apply", bench_fix_cal_apply},
+};
+
+static const benchmark_t loop_kernels[] = {
+    {"q_mult", bench_loop_q_mult},
+    {"cross", bench_loop_cross},
+    {"m_v_mult", bench_loop_m_v_mult},
+    {"v_normalize", bench_loop_v_normalize},
+    {"q_normalize", bench_loop_q_normalize},
+};
+
+static const benchmark_t batch_kernels[] = {
+    {"q_mult", bench_batch_q_mult},
+    {"cross", bench_batch_cross},
+    {"m_v_mult", bench_batch_m_v_mult},
+    {"v_normalize", bench_batch_v_normalize},
+    {"q_normalize", bench_batch_q_normalize},
+};
+
+static const benchmark_t mat_kernels[] = {
+    {"mult", bench_mat_mult},
+    {"mult_t", bench_mat_mult_t},
+    {"abat", bench_mat_abat},
+    {"sym_abat", bench_mat_sym_abat},
+    {"cholesky", bench_mat_cholesky},
+    {"cholesky_solve", bench_mat_cholesky_solve},
+    {"lu", bench_mat_lu},
+    {"lu_solve", bench_mat_lu_solve},
+};
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS                                            *
+ ******************************************************************************/
+
+static void bench_q_mult(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_q_mult(o->p, o->q, o->q_out);
+}
+
+static void bench_cross(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_cross(o->u, o->v, o->v_out);
+}
+
+static void bench_m_m_mult(void *ctx) {
+    operands_t *o = ctx;
+    o->status = lin_alg_m_m_mult(o->m1, o->m2, o->m_out);
+}
+
+static void bench_extract_angles(void *ctx) {
+    operands_t *o = ctx;
+    o->status = lin_alg_extract_angles(o->m1, &o->psi, &o->theta, &o->phi);
+}
+
+static void bench_m_v_mult(void *ctx) {
+    operands_t *o = ctx;
+    o->status = lin_alg_m_v_mult(o->m1, o->u, o->v_out);
+}
+
+static void bench_m_transpose(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_m_transpose(o->m1, o->m_out);
+}
+
+static void bench_m_det(void *ctx) {
+    operands_t *o = ctx;
+    o->s = lin_alg_m_det(o->m2);
+}
+
+static void bench_dot(void *ctx) {
+    operands_t *o = ctx;
+    o->s = lin_alg_dot(o->u, o->v);
+}
+
+static void bench_v_norm(void *ctx) {
+    operands_t *o = ctx;
+    o->s = lin_alg_v_norm(o->u);
+}
+
+static void bench_q_norm(void *ctx) {
+    operands_t *o = ctx;
+    o->s = lin_alg_q_norm(o->q);
+}
+
+static void bench_q2dcm(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_q2dcm(o->q, o->m_out);
+}
+
+static void bench_q2euler_abs(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_q2euler_abs(o->q, &o->psi, &o->theta, &o->phi);
+}
+
+static void bench_set_q(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_set_q(0.3, -0.2, 0.1, o->q_out);
+}
+
+static void bench_gen_dcm(void *ctx) {
+    operands_t *o = ctx;
+    o->status = lin_alg_gen_dcm(0.25, o->u, o->m_out);
+}
+
+/**
+ * @function bench_q_rot_v_q_sandwich(void *ctx)
+ * @brief the q* v q rotation with two lin_alg_q_mult() calls that
+ * lin_alg_q_rot_v_q() replaced, kept as the reference
+ */
+static void bench_q_rot_v_q_sandwich(void *ctx) {
+    operands_t *o = ctx;
+    float q_conj[QSZ];
+    float q_temp[QSZ];
+    float q_b[QSZ];
+    float q_i[QSZ] = {0, o->u[0], o->u[1], o->u[2]};
+
+    lin_alg_q_inv(o->q, q_conj);
+    lin_alg_q_mult(q_i, o->q, q_temp);
+    lin_alg_q_mult(q_conj, q_temp, q_b);
+    o->v_out[0] = q_b[1];
+    o->v_out[1] = q_b[2];
+    o->v_out[2] = q_b[3];
+}
+
+static void bench_q_rot_v_q(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_q_rot_v_q(o->u, o->q, o->v_out);
+}
+
+static void bench_q_rot_v_q_pair(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_q_rot_v_q_pair(o->u, o->v, o->q, o->v_out, o->w_out);
+}
+
+/**
+ * @function bench_v_normalize(void *ctx)
+ * @brief the normalization at the top of AHRS_update()
+ */
+static void bench_v_normalize(void *ctx) {
+    operands_t *o = ctx;
+    lin_alg_s_v_mult(1.0 / lin_alg_v_norm(o->u), o->u, o->v_out);
+}
+
+/**
+ * @function bench_cal_apply(void *ctx)
+ * @brief the Dorveaux correction in IMU_normalize_data(), A v + b
+ */
+static void bench_cal_apply(void *ctx) {
+    operands_t *o = ctx;
+    o->status = lin_alg_m_v_mult(o->m2, o->v, o->v_out);
+    lin_alg_v_v_add(o->v_out, o->u, o->v_out);
+}
+
+static void bench_fix_q_mult(void *ctx) {
+    fix_operands_t *o = ctx;
+    lin_alg_fix_q_mult(o->p, o->q, o->q_out);
+}
+
+static void bench_fix_cross(void *ctx) {
+    fix_operands_t *o = ctx;
+    lin_alg_fix_cross(o->u, o->v, o->v_out);
+}
+
+static void bench_fix_v_normalize(void *ctx) {
+    fix_operands_t *o = ctx;
+    o->status = lin_alg_fix_v_normalize(o->u, MSZ, o->v_out);
+}
+
+static void bench_fix_q_rot_v_q_pair(void *ctx) {
+    fix_operands_t *o = ctx;
+    lin_alg_fix_q_rot_v_q_pair(o->u, o->v, o->q, o->v_out, o->w_out);
+}
+
+static void bench_fix_cal_apply(void *ctx) {
+    fix_operands_t *o = ctx;
+    lin_alg_fix_cal_apply(&o->cal, o->counts, o->v_out);
+}
+
+static void bench_loop_q_mult(void *ctx) {
+    batch_operands_t *o = ctx;
+    int i;
+
+    for (i = 0; i < BATCH_N; i++) {
+        lin_alg_q_mult(o->p[i], o->q[i], o->q_out[i]);
+    }
+}
+
+static void bench_loop_cross(void *ctx) {
+    batch_operands_t *o = ctx;
+    int i;
+
+    for (i = 0; i < BATCH_N; i++) {
+        lin_alg_cross(o->u[i], o->v[i], o->w_out[i]);
+    }
+}
+
+static void bench_loop_m_v_mult(void *ctx) {
+    batch_operands_t *o = ctx;
+    int i;
+
+    for (i = 0; i < BATCH_N; i++) {
+        lin_alg_m_v_mult(o->m, o->u[i], o->w_out[i]);
+    }
+}
+
+static void bench_loop_v_normalize(void *ctx) {
+    batch_operands_t *o = ctx;
+    int i;
+
+    for (i = 0; i < BATCH_N; i++) {
+        lin_alg_s_v_mult(1.0 / lin_alg_v_norm(o->u[i]), o->u[i], o->u[i]);
+    }
+}
+
+static void bench_loop_q_normalize(void *ctx) {
+    batch_operands_t *o = ctx;
+    int i;
+
+    for (i = 0; i < BATCH_N; i++) {
+        lin_alg_scale_q(1.0 / lin_alg_q_norm(o->q[i]), o->q[i]);
+    }
+}
+
+static void bench_batch_q_mult(void *ctx) {
+    batch_operands_t *o = ctx;
+    lin_alg_batch_q_mult(o->p_soa[0], o->q_soa[0], o->q_out_soa[0], BATCH_N);
+}
+
+static void bench_batch_cross(void *ctx) {
+    batch_operands_t *o = ctx;
+    lin_alg_batch_cross(o->u_soa[0], o->v_soa[0], o->w_out_soa[0], BATCH_N);
+}
+
+static void bench_batch_m_v_mult(void *ctx) {
+    batch_operands_t *o = ctx;
+    lin_alg_batch_m_v_mult(o->m, o->u_soa[0], o->w_out_soa[0], BATCH_N);
+}
+
+static void bench_batch_v_normalize(void *ctx) {
+    batch_operands_t *o = ctx;
+    lin_alg_batch_v_normalize(o->u_soa[0], BATCH_N);
+}
+
+static void bench_batch_q_normalize(void *ctx) {
+    batch_operands_t *o = ctx;
+    lin_alg_batch_q_normalize(o->q_soa[0], BATCH_N);
+}
+
+static void bench_mat_mult(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_mult(&o->a, &o->p, &o->c);
+}
+
+static void bench_mat_mult_t(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_mult_t(&o->a, &o->p, &o->c);
+}
+
+/**
+ * @function bench_mat_abat(void *ctx)
+ * @brief a p a' with two general products, the reference for sym_abat
+ */
+static void bench_mat_abat(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_mult(&o->a, &o->p, &o->c);
+    o->status |= lin_alg_mat_mult_t(&o->c, &o->a, &o->d);
+}
+
+static void bench_mat_sym_abat(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_sym_abat(&o->a, &o->p, &o->d);
+}
+
+static void bench_mat_cholesky(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_cholesky(&o->p, &o->l);
+}
+
+static void bench_mat_cholesky_solve(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_cholesky_solve(&o->l, &o->b, &o->x);
+}
+
+static void bench_mat_lu(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_lu(&o->a, &o->lu, o->perm);
+}
+
+static void bench_mat_lu_solve(void *ctx) {
+    mat_operands_t *o = ctx;
+    o->status = lin_alg_mat_lu_solve(&o->lu, o->perm, &o->b, &o->x);
+}
+
+/**
+ * @function mat_operands_init(mat_operands_t *o, uint8_t n)
+ * @brief a transition matrix close to the identity, as for a short time step,
+ * the covariance p = a a' + I and the factors the solves start from
+ */
+static void mat_operands_init(mat_operands_t *o, uint8_t n) {
+    uint8_t row;
+    uint8_t col;
+
+    lin_alg_mat_identity(&o->a, n);
+    lin_alg_mat_zeros(&o->b, n, 1);
+    for (row = 0; row < n; row++) {
+        for (col = 0; col < n; col++) {
+            o->a.m[row][col] += 0.01 * (float) ((row * 7 + col * 3) % 11) - 0.05;
+        }
+        o->b.m[row][0] = 0.1 * row - 0.3;
+    }
+    lin_alg_mat_mult_t(&o->a, &o->a, &o->p);
+    lin_alg_mat_identity(&o->c, n);
+    lin_alg_mat_add(&o->p, &o->c, &o->p);
+    o->status = lin_alg_mat_cholesky(&o->p, &o->l);
+    o->status |= lin_alg_mat_lu(&o->a, &o->lu, o->perm);
+}
+
+/*******************************************************************************
+ * BENCHMARK MAIN                                                              *
+ ******************************************************************************/
+
+int main(void) {
+    operands_t operands;
+    fix_operands_t fix_operands;
+    static batch_operands_t batch_operands;
+    static mat_operands_t mat_operands;
+    float cal_b[MSZ] = {0.01, -0.02, 0.03};
+    uint8_t i;
+    uint8_t j;
+
+    Board_init();
+    Serial_init();
+    printf("# Lin_alg_float benchmark %s, %s\r\n", __DATE__, __TIME__);
+
+    /* a representative attitude: the DCM and quaternion of 0.3, -0.2, 0.1 rad */
+    lin_alg_gen_dcm_with_angles(0.3, -0.2, 0.1, operands.m1);
+    lin_alg_set_q(0.3, -0.2, 0.1, operands.q);
+    lin_alg_set_q(-0.05, 0.02, 0.01, operands.p);
+    lin_alg_set_m(1.02, 0.01, -0.03,
+            0.02, 0.97, 0.04,
+            -0.01, 0.03, 1.05, operands.m2);
+    lin_alg_set_v(0.12, -0.98, 0.21, operands.u);
+    lin_alg_set_v(0.45, 0.07, -0.89, operands.v);
+
+    Benchmark_header();
+    Benchmark_run_table(SUITE, kernels, sizeof (kernels) / sizeof (kernels[0]), &operands);
+
+    /* a typical accelerometer calibration, unit gain over 16384 counts */
+    for (i = 0; i < MSZ; i++) {
+        fix_operands.u[i] = FLOAT_TO_Q30(operands.u[i]);
+        fix_operands.v[i] = FLOAT_TO_Q30(operands.v[i]);
+        fix_operands.counts[i] = (int16_t) (operands.v[i] * 16384);
+    }
+    for (i = 0; i < QSZ; i++) {
+        fix_operands.p[i] = FLOAT_TO_Q30(operands.p[i]);
+        fix_operands.q[i] = FLOAT_TO_Q30(operands.q[i]);
+    }
+    lin_alg_m_scale(1.0 / 16384, operands.m2);
+    fix_operands.status = lin_alg_fix_cal_set(operands.m2, cal_b, &fix_operands.cal);
+    Benchmark_run_table(FIX_SUITE, fix_kernels, sizeof (fix_kernels) / sizeof (fix_kernels[0]), &fix_operands);
+
+    /* a slowly turning attitude and rotating vectors, the same in both layouts */
+    lin_alg_set_m(1.02, 0.01, -0.03,
+            0.02, 0.97, 0.04,
+            -0.01, 0.03, 1.05, batch_operands.m);
+    for (j = 0; j < BATCH_N; j++) {
+        lin_alg_set_q(0.3 + 0.01 * j, -0.2, 0.1, batch_operands.q[j]);
+        lin_alg_set_q(-0.05, 0.02 * j, 0.01, batch_operands.p[j]);
+        lin_alg_q_rot_v_q(operands.u, batch_operands.q[j], batch_operands.u[j]);
+        lin_alg_q_rot_v_q(operands.v, batch_operands.p[j], batch_operands.v[j]);
+        for (i = 0; i < MSZ; i++) {
+            batch_operands.u_soa[i][j] = batch_operands.u[j][i];
+            batch_operands.v_soa[i][j] = batch_operands.v[j][i];
+        }
+        for (i = 0; i < QSZ; i++) {
+            batch_operands.p_soa[i][j] = batch_operands.p[j][i];
+            batch_operands.q_soa[i][j] = batch_operands.q[j][i];
+        }
+    }
+    Benchmark_run_table(LOOP_SUITE, loop_kernels, sizeof (loop_kernels) / sizeof (loop_kernels[0]), &batch_operands);
+    Benchmark_run_table(BATCH_SUITE, batch_kernels, sizeof (batch_kernels) / sizeof (batch_kernels[0]), &batch_operands);
+
+    mat_operands_init(&mat_operands, 6);
+    Benchmark_run_table(MAT6_SUITE, mat_kernels, sizeof (mat_kernels) / sizeof (mat_kernels[0]), &mat_operands);
+    mat_operands_init(&mat_operands, 9);
+    Benchmark_run_table(MAT9_SUITE, mat_kernels, sizeof (mat_kernels) / sizeof (mat_kernels[0]), &mat_operands);
+    printf("# done\r\n");
+    return 0;
+}
+
+#endif //LIN_ALG_BENCHMARK
@@ -0,0 +1,387 @@
+/*
+ * File:   Lin_alg_fix.c
+ * Author: Aaron Hunter
+ * Brief: Fixed point linear algebra for the attitude pipeline
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES
+ ******************************************************************************/
+#include "Lin_alg_fix.h"
+#define LIN_ALG_INLINE_IMPLEMENTATION
+#include "Lin_alg_inline.h"
+#include "Board.h"
+
+#include <math.h>
+#include <stdio.h>
+
+/*******************************************************************************
+ * PRIVATE #DEFINES
+ ******************************************************************************/
+/* chords of 1/sqrt(M) through M = 1/4, 1/2 and 1, Q2.30 */
+#define RSQRT_A_LOW 2776467046u
+#define RSQRT_B_LOW 2515933592u
+#define RSQRT_A_HIGH 1963258676u
+#define RSQRT_B_HIGH 889516852u
+#define RSQRT_ITERATIONS 3 // the chords are within 3%, three steps reach 1e-11
+#define CAL_SHIFT_MIN -14
+#define CAL_SHIFT_MAX 30
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS PROTOTYPES
+ ******************************************************************************/
+static uint32_t rsqrt_mantissa(uint32_t m);
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_fix_v_normalize()
+ * Scale a vector of any fixed point format to unit length.  With the sum of
+ * squares written as M * 2^(64 - z), M in [1/4, 1) and z even, the inverse
+ * norm is 1/sqrt(M) * 2^(z/2 - 32) and only 1/sqrt(M) needs iterating
+ * @param v A vector with n components, all in the same format
+ * @param n Number of components, MSZ or QSZ
+ * @param v_out The unit vector in Q2.30, may be v
+ * @return SUCCESS, or ERROR for a zero vector which is left unchanged
+ */
+char lin_alg_fix_v_normalize(int32_t v[], uint8_t n, q30_t v_out[]) {
+    uint64_t sum = 0;
+    uint32_t y;
+    uint8_t z;
+    uint8_t shift;
+    uint8_t i;
+
+    for (i = 0; i < n; i++) {
+        sum += (uint64_t) ((int64_t) v[i] * v[i]);
+    }
+    if (sum == 0) {
+        return ERROR;
+    }
+    z = __builtin_clzll(sum) & ~1;
+    y = rsqrt_mantissa((uint32_t) ((sum << z) >> 32));
+    shift = 32 - z / 2;
+    for (i = 0; i < n; i++) {
+        v_out[i] = (q30_t) (((int64_t) v[i] * y) >> shift);
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_fix_cross()
+ * @param u A Q2.30 vector
+ * @param v A Q2.30 vector
+ * @param w_out The cross product u x v, Q2.30
+ */
+void lin_alg_fix_cross(q30_t u[MSZ], q30_t v[MSZ], q30_t w_out[MSZ]) {
+    lin_alg_fix_cross_inline(u, v, w_out);
+}
+
+/**
+ * @function lin_alg_fix_q_mult()
+ * Multiply two quaternions together, same order as lin_alg_q_mult()
+ * @param q A Q2.30 quaternion
+ * @param p A Q2.30 quaternion
+ * @param r The resulting quaternion, must not be q or p
+ */
+void lin_alg_fix_q_mult(q30_t q[QSZ], q30_t p[QSZ], q30_t r[QSZ]) {
+    lin_alg_fix_q_mult_inline(q, p, r);
+}
+
+/**
+ * @function lin_alg_fix_q_rot_v_q_pair()
+ * Rotate two vectors from the inertial frame to the body frame, v_b = q* v_i q,
+ * through the DCM as lin_alg_q_rot_v_q_pair() does.  Twice the quaternion
+ * products reach 2.0, so the DCM is formed in 64 bits
+ * @param v1_i A Q2.30 vector in the inertial frame
+ * @param v2_i A Q2.30 vector in the inertial frame
+ * @param q A unit attitude quaternion, Q2.30
+ * @param v1_b v1_i in the body frame
+ * @param v2_b v2_i in the body frame
+ */
+void lin_alg_fix_q_rot_v_q_pair(q30_t v1_i[MSZ], q30_t v2_i[MSZ], q30_t q[QSZ],
+        q30_t v1_b[MSZ], q30_t v2_b[MSZ]) {
+    const int64_t one = Q30_ONE;
+    int64_t xx = ((int64_t) q[1] * q[1]) >> 29;
+    int64_t yy = ((int64_t) q[2] * q[2]) >> 29;
+    int64_t zz = ((int64_t) q[3] * q[3]) >> 29;
+    int64_t xy = ((int64_t) q[1] * q[2]) >> 29;
+    int64_t xz = ((int64_t) q[1] * q[3]) >> 29;
+    int64_t yz = ((int64_t) q[2] * q[3]) >> 29;
+    int64_t wx = ((int64_t) q[0] * q[1]) >> 29;
+    int64_t wy = ((int64_t) q[0] * q[2]) >> 29;
+    int64_t wz = ((int64_t) q[0] * q[3]) >> 29;
+    q30_t dcm[MSZ][MSZ];
+    int64_t v0;
+    int64_t v1;
+    int64_t v2;
+
+    /* lin_alg_q2dcm() for a unit quaternion */
+    dcm[0][0] = (q30_t) (one - yy - zz);
+    dcm[0][1] = (q30_t) (xy + wz);
+    dcm[0][2] = (q30_t) (xz - wy);
+    dcm[1][0] = (q30_t) (xy - wz);
+    dcm[1][1] = (q30_t) (one - xx - zz);
+    dcm[1][2] = (q30_t) (yz + wx);
+    dcm[2][0] = (q30_t) (xz + wy);
+    dcm[2][1] = (q30_t) (yz - wx);
+    dcm[2][2] = (q30_t) (one - xx - yy);
+
+    v0 = v1_i[0];
+    v1 = v1_i[1];
+    v2 = v1_i[2];
+    v1_b[0] = (q30_t) ((dcm[0][0] * v0 + dcm[0][1] * v1 + dcm[0][2] * v2) >> 30);
+    v1_b[1] = (q30_t) ((dcm[1][0] * v0 + dcm[1][1] * v1 + dcm[1][2] * v2) >> 30);
+    v1_b[2] = (q30_t) ((dcm[2][0] * v0 + dcm[2][1] * v1 + dcm[2][2] * v2) >> 30);
+    v0 = v2_i[0];
+    v1 = v2_i[1];
+    v2 = v2_i[2];
+    v2_b[0] = (q30_t) ((dcm[0][0] * v0 + dcm[0][1] * v1 + dcm[0][2] * v2) >> 30);
+    v2_b[1] = (q30_t) ((dcm[1][0] * v0 + dcm[1][1] * v1 + dcm[1][2] * v2) >> 30);
+    v2_b[2] = (q30_t) ((dcm[2][0] * v0 + dcm[2][1] * v1 + dcm[2][2] * v2) >> 30);
+}
+
+/**
+ * @function lin_alg_fix_cal_set()
+ * Convert a float calibration to fixed point, done once when it is loaded
+ * @param A Scale factor matrix from the tumble test
+ * @param b Offset vector from the tumble test
+ * @param cal The fixed point calibration
+ * @return SUCCESS, or ERROR if A or b does not fit
+ */
+char lin_alg_fix_cal_set(float A[MSZ][MSZ], float b[MSZ], lin_alg_fix_cal_t *cal) {
+    double a_max = 0;
+    int8_t shift = 0;
+    int row;
+    int col;
+
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            if (fabs(A[row][col]) > a_max) {
+                a_max = fabs(A[row][col]);
+            }
+        }
+        if (fabs(b[row]) >= 32767.0) {
+            return ERROR;
+        }
+    }
+    if (a_max == 0) {
+        return ERROR;
+    }
+    /* largest shift that keeps the biggest entry below 2.0 in Q2.30 */
+    while (a_max * ldexp(1.0, shift) >= 1.999 && shift > CAL_SHIFT_MIN) {
+        shift--;
+    }
+    while (a_max * ldexp(1.0, shift + 1) < 1.999 && shift < CAL_SHIFT_MAX) {
+        shift++;
+    }
+    if (a_max * ldexp(1.0, shift) >= 1.999) {
+        return ERROR;
+    }
+    for (row = 0; row < MSZ; row++) {
+        for (col = 0; col < MSZ; col++) {
+            cal->A[row][col] = (int32_t) lround(ldexp(A[row][col], 30 + shift));
+        }
+        cal->b[row] = (q16_t) lround(ldexp(b[row], 16));
+    }
+    cal->shift = shift;
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_fix_cal_apply()
+ * Correct a raw measurement, v_cal = A raw + b
+ * @param cal The fixed point calibration
+ * @param raw The raw sensor counts
+ * @param v_cal The corrected measurement in Q16.16
+ */
+void lin_alg_fix_cal_apply(const lin_alg_fix_cal_t *cal, const int16_t raw[MSZ],
+        q16_t v_cal[MSZ]) {
+    lin_alg_fix_cal_apply_inline(cal, raw, v_cal);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * @function rsqrt_mantissa()
+ * @param m M in [1/4, 1) as Q0.32
+ * @return 1/sqrt(M) in Q2.30, by Newton's method y = y (3 - M y^2) / 2 from
+ * a chord of the curve
+ */
+static uint32_t rsqrt_mantissa(uint32_t m) {
+    uint64_t y;
+    uint64_t t;
+    uint8_t i;
+
+    if (m < 0x80000000u) {
+        y = RSQRT_A_LOW - (((uint64_t) RSQRT_B_LOW * m) >> 32);
+    } else {
+        y = RSQRT_A_HIGH - (((uint64_t) RSQRT_B_HIGH * m) >> 32);
+    }
+    for (i = 0; i < RSQRT_ITERATIONS; i++) {
+        t = (y * y) >> 30;
+        t = (t * m) >> 32;
+        y = (y * ((3ull << 30) - t)) >> 31;
+    }
+    return (uint32_t) y;
+}
+
+/*******************************************************************************
+ * MODULE UNIT TESTS
+ ******************************************************************************/
+#ifdef LIN_ALG_FIX_TESTING
+#include "SerialM32.h"
+#include "Lin_alg_float.h"
+
+#define TEST_VECTORS 1000
+#define UNIT_TOL 1e-6 // the float reference carries 24 bits
+#define CAL_TOL 1e-4 // Q16.16 LSB plus float rounding of the reference
+
+static uint32_t lcg_state = 12345;
+
+static float test_rand(float scale) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return scale * ((int32_t) lcg_state / 2147483648.0f);
+}
+
+static double max_error(q30_t v[], float ref[], uint8_t n, double scale) {
+    double e = 0;
+    uint8_t i;
+    for (i = 0; i < n; i++) {
+        if (fabs(v[i] / scale - ref[i]) > e) {
+            e = fabs(v[i] / scale - ref[i]);
+        }
+    }
+    return e;
+}
+
+int main(void) {
+    float A_acc[MSZ][MSZ] = {
+        {6.01180201773358e-05, -6.28352073406424e-07, -3.91326747595870e-07},
+        {-1.18653342135860e-06, 6.01268083773005e-05, -2.97010157797952e-07},
+        {-3.19011230800348e-07, -3.62174516629958e-08, 6.04564465269327e-05}
+    };
+    float b_acc[MSZ] = {-0.0156750747576770, -0.0118720194488050, -0.0240128301624044};
+    float A_id[MSZ][MSZ] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    float b_zero[MSZ] = {0, 0, 0};
+    lin_alg_fix_cal_t cal;
+    lin_alg_fix_cal_t cal_id;
+    double err_norm = 0;
+    double err_quat = 0;
+    double err_rot = 0;
+    double err_cal = 0;
+    double e;
+    int failures = 0;
+    int i;
+    int j;
+
+    Board_init();
+    Serial_init();
+    printf("Lin_alg_fix test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    if (lin_alg_fix_cal_set(A_acc, b_acc, &cal) != SUCCESS
+            || lin_alg_fix_cal_set(A_id, b_zero, &cal_id) != SUCCESS) {
+        printf("lin_alg_fix_cal_set() failed\r\n");
+        failures++;
+    }
+    for (i = 0; i < TEST_VECTORS; i++) {
+        float v[MSZ];
+        float u[MSZ];
+        float q[QSZ];
+        float p[QSZ];
+        float r[QSZ];
+        float v_b[MSZ];
+        float u_b[MSZ];
+        float w[MSZ];
+        float norm;
+        q16_t v_fix[MSZ];
+        q30_t v_unit[MSZ];
+        q30_t u_unit[MSZ];
+        q30_t q_fix[QSZ];
+        q30_t p_fix[QSZ];
+        q30_t r_fix[QSZ];
+        q30_t v_b_fix[MSZ];
+        q30_t u_b_fix[MSZ];
+        q30_t w_fix[MSZ];
+        int16_t raw[MSZ];
+        q16_t cal_fix[MSZ];
+        float cal_ref[MSZ];
+
+        /* magnitudes from 1/64 to 4096, like calibrated mags and accels */
+        for (j = 0; j < MSZ; j++) {
+            v[j] = test_rand(ldexp(1.0, i % 19 - 6));
+            v_fix[j] = FLOAT_TO_Q16(v[j]);
+            v[j] = Q16_TO_FLOAT(v_fix[j]);
+            u[j] = test_rand(1.0);
+        }
+        if (lin_alg_fix_v_normalize(v_fix, MSZ, v_unit) == SUCCESS) {
+            norm = lin_alg_v_norm(v);
+            lin_alg_v_scale(1.0 / norm, v);
+            e = max_error(v_unit, v, MSZ, Q30_ONE);
+            err_norm = e > err_norm ? e : err_norm;
+        }
+
+        /* quaternion products and rotations of unit vectors */
+        lin_alg_set_q(test_rand(M_PI), test_rand(M_PI / 2), test_rand(M_PI), q);
+        lin_alg_set_q(test_rand(M_PI), test_rand(M_PI / 2), test_rand(M_PI), p);
+        for (j = 0; j < QSZ; j++) {
+            q_fix[j] = FLOAT_TO_Q30(q[j]);
+            p_fix[j] = FLOAT_TO_Q30(p[j]);
+        }
+        lin_alg_q_mult(q, p, r);
+        lin_alg_fix_q_mult(q_fix, p_fix, r_fix);
+        e = max_error(r_fix, r, QSZ, Q30_ONE);
+        err_quat = e > err_quat ? e : err_quat;
+
+        lin_alg_fix_v_normalize((int32_t *) v_unit, MSZ, v_unit);
+        for (j = 0; j < MSZ; j++) {
+            v[j] = Q30_TO_FLOAT(v_unit[j]);
+            u_unit[j] = FLOAT_TO_Q30(u[j] * 0.5);
+            u[j] = Q30_TO_FLOAT(u_unit[j]);
+        }
+        lin_alg_q_rot_v_q_pair(v, u, q, v_b, u_b);
+        lin_alg_fix_q_rot_v_q_pair(v_unit, u_unit, q_fix, v_b_fix, u_b_fix);
+        e = max_error(v_b_fix, v_b, MSZ, Q30_ONE);
+        err_rot = e > err_rot ? e : err_rot;
+        e = max_error(u_b_fix, u_b, MSZ, Q30_ONE);
+        err_rot = e > err_rot ? e : err_rot;
+        lin_alg_cross(v, u, w);
+        lin_alg_fix_cross(v_unit, u_unit, w_fix);
+        e = max_error(w_fix, w, MSZ, Q30_ONE);
+        err_rot = e > err_rot ? e : err_rot;
+
+        /* calibration of full scale raw counts */
+        for (j = 0; j < MSZ; j++) {
+            raw[j] = (int16_t) test_rand(32767.0);
+        }
+        lin_alg_fix_cal_apply(&cal, raw, cal_fix);
+        for (j = 0; j < MSZ; j++) {
+            cal_ref[j] = A_acc[j][0] * raw[0] + A_acc[j][1] * raw[1] + A_acc[j][2] * raw[2] + b_acc[j];
+        }
+        e = max_error(cal_fix, cal_ref, MSZ, Q16_ONE);
+        err_cal = e > err_cal ? e : err_cal;
+        lin_alg_fix_cal_apply(&cal_id, raw, cal_fix);
+        for (j = 0; j < MSZ; j++) {
+            if (cal_fix[j] != (q16_t) raw[j] * Q16_ONE) {
+                err_cal = 1;
+            }
+        }
+    }
+    if (lin_alg_fix_v_normalize((int32_t[]) {0, 0, 0}, MSZ, (q30_t[MSZ]) {0}) != ERROR) {
+        printf("zero vector normalized\r\n");
+        failures++;
+    }
+    printf("normalize max error %.3e\r\n", err_norm);
+    printf("q_mult max error %.3e\r\n", err_quat);
+    printf("rotation and cross max error %.3e\r\n", err_rot);
+    printf("calibration max error %.3e, shift %d\r\n", err_cal, cal.shift);
+    failures += err_norm > UNIT_TOL || err_quat > UNIT_TOL || err_rot > UNIT_TOL || err_cal > CAL_TOL;
+    printf("%s\r\n", failures == 0 ? "Lin_alg_fix tests passed" : "Lin_alg_fix tests FAILED");
+    return 0;
+}
+#endif //LIN_ALG_FIX_TESTING
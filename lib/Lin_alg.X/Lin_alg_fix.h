@@ -0,0 +1,122 @@
+/*
+ * File:   Lin_alg_fix.h
+ * Author: Aaron Hunter
+ * Brief: Fixed point counterparts of the Lin_alg_float kernels used by the
+ * attitude pipeline.  The PIC32MX795 has no FPU and no DSP extension, so
+ * every float operation is a library call while a 32x32 -> 64 bit multiply is
+ * a single instruction.  Two formats are used, both in plain int32_t:
+ *     q30_t, Q2.30, for quaternions, unit vectors and DCM entries.  Two
+ *            integer bits hold +/-1.0 exactly, so nothing needs saturation.
+ *     q16_t, Q16.16, for rates in rad/sec, biases, gains and calibrated
+ *            sensor values that are not yet normalized.
+ * Products are formed in 64 bits and shifted back, truncating toward minus
+ * infinity.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_FIX_H
+#define	LIN_ALG_FIX_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * #DEFINES
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+#define QSZ 4
+
+#define Q30_ONE (1L << 30)
+#define Q16_ONE (1L << 16)
+
+/* conversions, for initialization and telemetry, not for the inner loop */
+#define FLOAT_TO_Q30(x) ((q30_t) ((x) * (float) Q30_ONE))
+#define FLOAT_TO_Q16(x) ((q16_t) ((x) * (float) Q16_ONE))
+#define Q30_TO_FLOAT(x) ((float) (x) * (1.0f / Q30_ONE))
+#define Q16_TO_FLOAT(x) ((float) (x) * (1.0f / Q16_ONE))
+
+/* products: a Q2.30 by a Q2.30 or Q16.16 keeps the format of b */
+#define Q30_MULT(a, b) ((int32_t) (((int64_t) (a) * (b)) >> 30))
+#define Q16_MULT(a, b) ((int32_t) (((int64_t) (a) * (b)) >> 16))
+
+/*******************************************************************************
+ * PUBLIC DATATYPES
+ ******************************************************************************/
+typedef int32_t q30_t;
+typedef int32_t q16_t;
+
+/* a calibration matrix scaled by 2^(30 + shift) so its largest entry uses all
+ * 32 bits, the Dorveaux matrices are ~1e-4 and would keep only 16 bits as Q2.30 */
+typedef struct {
+    int32_t A[MSZ][MSZ];
+    int8_t shift;
+    q16_t b[MSZ];
+} lin_alg_fix_cal_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_fix_v_normalize()
+ * Scale a vector of any fixed point format to unit length
+ * @param v A vector with n components, all in the same format
+ * @param n Number of components, MSZ or QSZ
+ * @param v_out The unit vector in Q2.30, may be v
+ * @return SUCCESS, or ERROR for a zero vector which is left unchanged
+ */
+char lin_alg_fix_v_normalize(int32_t v[], uint8_t n, q30_t v_out[]);
+
+/**
+ * @function lin_alg_fix_cross()
+ * @param u A Q2.30 vector
+ * @param v A Q2.30 vector
+ * @param w_out The cross product u x v, Q2.30
+ */
+void lin_alg_fix_cross(q30_t u[MSZ], q30_t v[MSZ], q30_t w_out[MSZ]);
+
+/**
+ * @function lin_alg_fix_q_mult()
+ * Multiply two quaternions together, same order as lin_alg_q_mult()
+ * @param q A Q2.30 quaternion
+ * @param p A Q2.30 quaternion
+ * @param r The resulting quaternion
+ */
+void lin_alg_fix_q_mult(q30_t q[QSZ], q30_t p[QSZ], q30_t r[QSZ]);
+
+/**
+ * @function lin_alg_fix_q_rot_v_q_pair()
+ * Rotate two vectors from the inertial frame to the body frame, v_b = q* v_i q
+ * @param v1_i A Q2.30 vector in the inertial frame
+ * @param v2_i A Q2.30 vector in the inertial frame
+ * @param q A unit attitude quaternion, Q2.30
+ * @param v1_b v1_i in the body frame
+ * @param v2_b v2_i in the body frame
+ */
+void lin_alg_fix_q_rot_v_q_pair(q30_t v1_i[MSZ], q30_t v2_i[MSZ], q30_t q[QSZ],
+        q30_t v1_b[MSZ], q30_t v2_b[MSZ]);
+
+/**
+ * @function lin_alg_fix_cal_set()
+ * Convert a float calibration to fixed point, done once when it is loaded
+ * @param A Scale factor matrix from the tumble test
+ * @param b Offset vector from the tumble test
+ * @param cal The fixed point calibration
+ * @return SUCCESS, or ERROR if b does not fit in Q16.16
+ */
+char lin_alg_fix_cal_set(float A[MSZ][MSZ], float b[MSZ], lin_alg_fix_cal_t *cal);
+
+/**
+ * @function lin_alg_fix_cal_apply()
+ * Correct a raw measurement, v_cal = A raw + b
+ * @param cal The fixed point calibration
+ * @param raw The raw sensor counts
+ * @param v_cal The corrected measurement in Q16.16
+ */
+void lin_alg_fix_cal_apply(const lin_alg_fix_cal_t *cal, const int16_t raw[MSZ],
+        q16_t v_cal[MSZ]);
+
+#endif	/* LIN_ALG_FIX_H */
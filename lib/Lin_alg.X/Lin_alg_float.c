@@ -11,6 +11,8 @@
  * #INCLUDES
  ******************************************************************************/
 #include "Lin_alg_float.h"
+#define LIN_ALG_INLINE_IMPLEMENTATION
+#include "Lin_alg_inline.h"
 #include "Board.h"
 
 
@@ -218,11 +220,7 @@ void lin_alg_m_scale(float s, float m[MSZ][MSZ]) {
  * @param v_out
  */
 void lin_alg_s_v_mult(float s, float v[MSZ], float v_out[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = s * v[row];
-    }
+    lin_alg_s_v_mult_inline(s, v, v_out);
 }
 
 /**
@@ -232,11 +230,7 @@ void lin_alg_s_v_mult(float s, float v[MSZ], float v_out[MSZ]) {
  * @param v Vector to be scaled
  */
 void lin_alg_v_scale(float s, float v[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v[row] *= s;
-    }
+    lin_alg_v_scale_inline(s, v);
 }
 
 /**
@@ -320,11 +314,7 @@ void lin_alg_m_m_sub(float m1[MSZ][MSZ], float m2[MSZ][MSZ],
  * @param v_out Vector as sum of two vectors
  */
 void lin_alg_v_v_add(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = v1[row] + v2[row];
-    }
+    lin_alg_v_v_add_inline(v1, v2, v_out);
 }
 
 /**
@@ -335,11 +325,7 @@ void lin_alg_v_v_add(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
  * @param v_out Vector as difference of two vectors
  */
 void lin_alg_v_v_sub(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
-    int row;
-
-    for (row = 0; row < MSZ; row++) {
-        v_out[row] = v1[row] - v2[row];
-    }
+    lin_alg_v_v_sub_inline(v1, v2, v_out);
 }
 
 /**
@@ -443,7 +429,7 @@ void lin_alg_vex(float m[MSZ][MSZ], float v_out[MSZ]) {
  * @return The norm of v
  */
 float lin_alg_v_norm(float v[MSZ]) {
-    return ((float) sqrt((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2])));
+    return lin_alg_v_norm_inline(v);
 }
 
 /**
@@ -453,7 +439,7 @@ float lin_alg_v_norm(float v[MSZ]) {
  * @return The dot product (sometimes called the inner product) of u and v
  */
 float lin_alg_dot(float u[MSZ], float v[MSZ]) {
-    return (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]);
+    return lin_alg_dot_inline(u, v);
 }
 
 /**
@@ -463,9 +449,7 @@ float lin_alg_dot(float u[MSZ], float v[MSZ]) {
  * @return The cross product (sometimes called the outter product) of u and v
  */
 void lin_alg_cross(float u[MSZ], float v[MSZ], float w_out[MSZ]) {
-    w_out[0] = u[1] * v[2] - u[2] * v[1];
-    w_out[1] = u[2] * v[0] - u[0] * v[2];
-    w_out[2] = u[0] * v[1] - u[1] * v[0];
+    lin_alg_cross_inline(u, v, w_out);
 }
 
 /**
@@ -606,10 +590,7 @@ void lin_alg_q_inv(float q_in[QSZ], float q_out[QSZ]) {
  * @param q A quaternion
  */
 void lin_alg_scale_q(float s, float q[QSZ]) {
-    q[0] *= s;
-    q[1] *= s;
-    q[2] *= s;
-    q[3] *= s;
+    lin_alg_scale_q_inline(s, q);
 }
 
 /**
@@ -618,7 +599,7 @@ void lin_alg_scale_q(float s, float q[QSZ]) {
  * @return The magnitude of the quaternion, q
  */
 float lin_alg_q_norm(float q[QSZ]) {
-    return ((float) sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]));
+    return lin_alg_q_norm_inline(q);
 }
 
 /**
@@ -629,10 +610,87 @@ float lin_alg_q_norm(float q[QSZ]) {
  * @param r The resulting quaternion
  */
 void lin_alg_q_mult(float q[QSZ], float p[QSZ], float r[QSZ]) {
-    r[0] = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
-    r[1] = p[1] * q[0] + p[0] * q[1] + p[3] * q[2] - p[2] * q[3];
-    r[2] = p[2] * q[0] - p[3] * q[1] + p[0] * q[2] + p[1] * q[3];
-    r[3] = p[3] * q[0] + p[2] * q[1] - p[1] * q[2] + p[0] * q[3];
+    lin_alg_q_mult_inline(q, p, r);
+}
+
+/**
+ * @function lin_alg_q_rot_v_q()
+ * Rotate a vector from the inertial frame to the body frame, v_b = q* v_i q,
+ * without the two quaternion products: with u the vector part of q,
+ * t = 2 v_i x u and v_b = v_i + q0 t + t x u, 18 multiplies instead of 32
+ * @param v_i A vector in the inertial frame
+ * @param q A unit attitude quaternion
+ * @param v_b The vector in the body frame, may be v_i
+ */
+void lin_alg_q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]) {
+    float v0 = v_i[0];
+    float v1 = v_i[1];
+    float v2 = v_i[2];
+    float t0 = v1 * q[3] - v2 * q[2];
+    float t1 = v2 * q[1] - v0 * q[3];
+    float t2 = v0 * q[2] - v1 * q[1];
+
+    t0 += t0;
+    t1 += t1;
+    t2 += t2;
+    v_b[0] = v0 + q[0] * t0 + t1 * q[3] - t2 * q[2];
+    v_b[1] = v1 + q[0] * t1 + t2 * q[1] - t0 * q[3];
+    v_b[2] = v2 + q[0] * t2 + t0 * q[2] - t1 * q[1];
+}
+
+/**
+ * @function lin_alg_q_rot_v_q_pair()
+ * Rotate two vectors from the inertial frame to the body frame with one
+ * quaternion.  The DCM is formed once from 9 products and applied to both
+ * vectors, 27 multiplies against 36 for two lin_alg_q_rot_v_q() calls
+ * @param v1_i A vector in the inertial frame
+ * @param v2_i A vector in the inertial frame
+ * @param q A unit attitude quaternion
+ * @param v1_b v1_i in the body frame
+ * @param v2_b v2_i in the body frame
+ */
+void lin_alg_q_rot_v_q_pair(float v1_i[MSZ], float v2_i[MSZ], float q[QSZ],
+        float v1_b[MSZ], float v2_b[MSZ]) {
+    float x2 = q[1] + q[1];
+    float y2 = q[2] + q[2];
+    float z2 = q[3] + q[3];
+    float xx = q[1] * x2;
+    float yy = q[2] * y2;
+    float zz = q[3] * z2;
+    float xy = q[1] * y2;
+    float xz = q[1] * z2;
+    float yz = q[2] * z2;
+    float wx = q[0] * x2;
+    float wy = q[0] * y2;
+    float wz = q[0] * z2;
+    float dcm[MSZ][MSZ];
+    float v0;
+    float v1;
+    float v2;
+
+    /* lin_alg_q2dcm() for a unit quaternion */
+    dcm[0][0] = 1 - yy - zz;
+    dcm[0][1] = xy + wz;
+    dcm[0][2] = xz - wy;
+    dcm[1][0] = xy - wz;
+    dcm[1][1] = 1 - xx - zz;
+    dcm[1][2] = yz + wx;
+    dcm[2][0] = xz + wy;
+    dcm[2][1] = yz - wx;
+    dcm[2][2] = 1 - xx - yy;
+
+    v0 = v1_i[0];
+    v1 = v1_i[1];
+    v2 = v1_i[2];
+    v1_b[0] = dcm[0][0] * v0 + dcm[0][1] * v1 + dcm[0][2] * v2;
+    v1_b[1] = dcm[1][0] * v0 + dcm[1][1] * v1 + dcm[1][2] * v2;
+    v1_b[2] = dcm[2][0] * v0 + dcm[2][1] * v1 + dcm[2][2] * v2;
+    v0 = v2_i[0];
+    v1 = v2_i[1];
+    v2 = v2_i[2];
+    v2_b[0] = dcm[0][0] * v0 + dcm[0][1] * v1 + dcm[0][2] * v2;
+    v2_b[1] = dcm[1][0] * v0 + dcm[1][1] * v1 + dcm[1][2] * v2;
+    v2_b[2] = dcm[2][0] * v0 + dcm[2][1] * v1 + dcm[2][2] * v2;
 }
 
 /**
@@ -703,24 +761,10 @@ void lin_alg_q2euler_abs(float q[QSZ], float *psi, float *theta, float *phi) {
  */
 void lin_alg_rot_v_q(float v[MSZ], float psi, float theta, float phi,
         float v_new[MSZ]) {
-    float v_pure[QSZ];
-    float v_temp[MSZ];
-    float q[MSZ];
-    float q_conj[MSZ];
-
-    v_pure[0] = 0.0;
-    v_pure[1] = v[0];
-    v_pure[2] = v[1];
-    v_pure[3] = v[2];
+    float q[QSZ];
 
     lin_alg_set_q(psi, theta, phi, q);
-    lin_alg_q_inv(q, q_conj);
-    lin_alg_q_mult(q_conj, v_pure, v_temp);
-    lin_alg_q_mult(v_temp, q, v_pure);
-
-    v_new[0] = v_pure[1];
-    v_new[1] = v_pure[2];
-    v_new[2] = v_pure[3];
+    lin_alg_q_rot_v_q(v, q, v_new);
 }
 
 /**
@@ -798,6 +842,7 @@ int main(void) {
     int count_lin_alg_gen_dcm = 0;
     int count_lin_alg_q2euler = 0;
     int count_lin_alg_gen_dcm_with_angles = 0;
+    int count_lin_alg_q_rot_v_q = 0;
 
     int pass_lin_alg_is_m_equal = 0;
     int pass_lin_alg_m_m_mult = 0;
@@ -817,6 +862,7 @@ int main(void) {
     int pass_lin_alg_gen_dcm = 0;
     int pass_lin_alg_q2euler = 0;
     int pass_lin_alg_gen_dcm_with_angles = 0;
+    int pass_lin_alg_q_rot_v_q = 0;
 
     int total = 0;
     char correct_answer;
@@ -1523,6 +1569,46 @@ int main(void) {
     
     
 
+    for (i = 0; i < PAUSE; i++);
+    /***************************************************************************
+     * TEST: lin_alg_q_rot_v_q() and lin_alg_q_rot_v_q_pair() against q* v q
+     **************************************************************************/
+    count_lin_alg_q_rot_v_q++;
+    total++;
+    float q_rot[QSZ];
+    float q_conj[QSZ];
+    float q_v[QSZ] = {0.0, 0.110012, 0.478220, -0.871323};
+    float q_temp[QSZ];
+    float v_i[MSZ] = {0.110012, 0.478220, -0.871323};
+    float g_i[MSZ] = {0.0, 0.0, 1.0};
+    float v_b_answer[MSZ];
+    float v_b[MSZ];
+    float g_b[MSZ];
+    float v_pair[MSZ];
+
+    lin_alg_set_q(psi, theta, phi, q_rot);
+    lin_alg_q_inv(q_rot, q_conj);
+    lin_alg_q_mult(q_v, q_rot, q_temp);
+    lin_alg_q_mult(q_conj, q_temp, q_v);
+    lin_alg_set_v(q_v[1], q_v[2], q_v[3], v_b_answer);
+    lin_alg_q_rot_v_q(v_i, q_rot, v_b);
+    lin_alg_q_rot_v_q_pair(g_i, v_i, q_rot, g_b, v_pair);
+    if (lin_alg_is_v_equal(v_b, v_b_answer) == TRUE
+            && lin_alg_is_v_equal(v_pair, v_b_answer) == TRUE
+            && fabs(g_b[0] + sin(theta)) < RES) {
+        pass_lin_alg_q_rot_v_q++;
+        printf("\r\nSUCCESS: Test %d lin_alg_q_rot_v_q() correctly passes", total);
+    } else {
+        printf("\r\nFAIL:    Test %d lin_alg_q_rot_v_q() correctly passes", total);
+    }
+
+    printf("\r\n    Expected Answer:");
+    lin_alg_v_print(v_b_answer);
+    printf("\r\n    Result:");
+    lin_alg_v_print(v_b);
+    printf("\r\n    Result of pair:");
+    lin_alg_v_print(v_pair);
+
     for (i = 0; i < PAUSE; i++);
 
     /***************************************************************************
@@ -1578,6 +1664,8 @@ int main(void) {
     printf("%d / %d Passed: lin_alg_q2euler", pass_lin_alg_q2euler, count_lin_alg_q2euler);
     i += test_num_print(i, pass_lin_alg_gen_dcm_with_angles);
     printf("%d / %d Passed: lin_alg_gen_dcm_with_angles", pass_lin_alg_gen_dcm_with_angles, count_lin_alg_gen_dcm_with_angles);
+    i += test_num_print(i, pass_lin_alg_q_rot_v_q);
+    printf("%d / %d Passed: lin_alg_q_rot_v_q", pass_lin_alg_q_rot_v_q, count_lin_alg_q_rot_v_q);
 
     pass_count = (pass_lin_alg_is_m_equal +
             pass_lin_alg_m_m_mult +
@@ -1596,7 +1684,8 @@ int main(void) {
             pass_lin_alg_v_norm +
             pass_lin_alg_gen_dcm +
             pass_lin_alg_q2euler +
-            pass_lin_alg_gen_dcm_with_angles);
+            pass_lin_alg_gen_dcm_with_angles +
+            pass_lin_alg_q_rot_v_q);
 
     printf("\r\n\r\n%d / %d Tests passed\r\n", pass_count, total);
 
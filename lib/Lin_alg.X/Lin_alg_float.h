@@ -348,6 +348,28 @@ float lin_alg_q_norm(float q[QSZ]);
  */
 void lin_alg_q_mult(float p[QSZ], float q[QSZ], float r[QSZ]);
 
+/**
+ * @function lin_alg_q_rot_v_q()
+ * Rotate a vector from the inertial frame to the body frame, v_b = q* v_i q
+ * @param v_i A vector in the inertial frame
+ * @param q A unit attitude quaternion
+ * @param v_b The vector in the body frame, may be v_i
+ */
+void lin_alg_q_rot_v_q(float v_i[MSZ], float q[QSZ], float v_b[MSZ]);
+
+/**
+ * @function lin_alg_q_rot_v_q_pair()
+ * Rotate two vectors from the inertial frame to the body frame with one
+ * quaternion, cheaper than two lin_alg_q_rot_v_q() calls
+ * @param v1_i A vector in the inertial frame
+ * @param v2_i A vector in the inertial frame
+ * @param q A unit attitude quaternion
+ * @param v1_b v1_i in the body frame
+ * @param v2_b v2_i in the body frame
+ */
+void lin_alg_q_rot_v_q_pair(float v1_i[MSZ], float v2_i[MSZ], float q[QSZ],
+        float v1_b[MSZ], float v2_b[MSZ]);
+
 /**
  * @function lin_alg_q2dcm()
  * Form a DCM from a quaternion
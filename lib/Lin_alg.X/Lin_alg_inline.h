@@ -0,0 +1,205 @@
+/*
+ * File:   Lin_alg_inline.h
+ * Author: Aaron Hunter
+ * Brief: static inline versions of the small Lin_alg_float and Lin_alg_fix
+ * kernels that the per-sample paths call, for modules that opt in by
+ * including this header and calling the _inline names.  A call into
+ * Lin_alg_float.c costs a jump and return, spills the caller's live registers
+ * and hides the 3 or 4 element loop from the optimizer; inlined, XC32 keeps the
+ * operands in registers and schedules them with the caller's code.
+ *
+ * These are the implementations: the out-of-line lin_alg_cross() etc. call
+ * them, so both give the same result to the bit and existing callers are
+ * unchanged.  Build with LIN_ALG_NO_INLINE defined to turn the _inline names
+ * back into calls of the out-of-line functions, which is how the before and
+ * after cycle counts of AHRS_benchmark.c are compared.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_INLINE_H
+#define	LIN_ALG_INLINE_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES
+ ******************************************************************************/
+#include <stdint.h>
+#include <math.h>
+#include "Lin_alg_fix.h"
+
+/*******************************************************************************
+ * #DEFINES
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+#define QSZ 4
+
+#if defined(LIN_ALG_NO_INLINE) && !defined(LIN_ALG_INLINE_IMPLEMENTATION)
+#include "Lin_alg_float.h"
+#define lin_alg_cross_inline lin_alg_cross
+#define lin_alg_dot_inline lin_alg_dot
+#define lin_alg_v_norm_inline lin_alg_v_norm
+#define lin_alg_v_scale_inline lin_alg_v_scale
+#define lin_alg_s_v_mult_inline lin_alg_s_v_mult
+#define lin_alg_v_v_add_inline lin_alg_v_v_add
+#define lin_alg_v_v_sub_inline lin_alg_v_v_sub
+#define lin_alg_q_mult_inline lin_alg_q_mult
+#define lin_alg_q_norm_inline lin_alg_q_norm
+#define lin_alg_scale_q_inline lin_alg_scale_q
+#define lin_alg_fix_cross_inline lin_alg_fix_cross
+#define lin_alg_fix_q_mult_inline lin_alg_fix_q_mult
+#define lin_alg_fix_cal_apply_inline lin_alg_fix_cal_apply
+#else
+
+/*******************************************************************************
+ * FLOAT KERNELS, see Lin_alg_float.h
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_cross_inline()
+ * w_out = u x v, w_out must not be u or v
+ */
+static inline void lin_alg_cross_inline(float u[MSZ], float v[MSZ], float w_out[MSZ]) {
+    w_out[0] = u[1] * v[2] - u[2] * v[1];
+    w_out[1] = u[2] * v[0] - u[0] * v[2];
+    w_out[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+/**
+ * @function lin_alg_dot_inline()
+ * @return u . v
+ */
+static inline float lin_alg_dot_inline(float u[MSZ], float v[MSZ]) {
+    return (u[0] * v[0] + u[1] * v[1] + u[2] * v[2]);
+}
+
+/**
+ * @function lin_alg_v_norm_inline()
+ * @return |v|, with sqrtf(), which rounds the same as the float cast of
+ * sqrt() without the double precision library call
+ */
+static inline float lin_alg_v_norm_inline(float v[MSZ]) {
+    return sqrtf((v[0] * v[0]) + (v[1] * v[1]) + (v[2] * v[2]));
+}
+
+/**
+ * @function lin_alg_v_scale_inline()
+ * v = s v
+ */
+static inline void lin_alg_v_scale_inline(float s, float v[MSZ]) {
+    v[0] *= s;
+    v[1] *= s;
+    v[2] *= s;
+}
+
+/**
+ * @function lin_alg_s_v_mult_inline()
+ * v_out = s v
+ */
+static inline void lin_alg_s_v_mult_inline(float s, float v[MSZ], float v_out[MSZ]) {
+    v_out[0] = s * v[0];
+    v_out[1] = s * v[1];
+    v_out[2] = s * v[2];
+}
+
+/**
+ * @function lin_alg_v_v_add_inline()
+ * v_out = v1 + v2
+ */
+static inline void lin_alg_v_v_add_inline(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
+    v_out[0] = v1[0] + v2[0];
+    v_out[1] = v1[1] + v2[1];
+    v_out[2] = v1[2] + v2[2];
+}
+
+/**
+ * @function lin_alg_v_v_sub_inline()
+ * v_out = v1 - v2
+ */
+static inline void lin_alg_v_v_sub_inline(float v1[MSZ], float v2[MSZ], float v_out[MSZ]) {
+    v_out[0] = v1[0] - v2[0];
+    v_out[1] = v1[1] - v2[1];
+    v_out[2] = v1[2] - v2[2];
+}
+
+/**
+ * @function lin_alg_q_mult_inline()
+ * r = q p, r must not be q or p
+ */
+static inline void lin_alg_q_mult_inline(float q[QSZ], float p[QSZ], float r[QSZ]) {
+    r[0] = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
+    r[1] = p[1] * q[0] + p[0] * q[1] + p[3] * q[2] - p[2] * q[3];
+    r[2] = p[2] * q[0] - p[3] * q[1] + p[0] * q[2] + p[1] * q[3];
+    r[3] = p[3] * q[0] + p[2] * q[1] - p[1] * q[2] + p[0] * q[3];
+}
+
+/**
+ * @function lin_alg_q_norm_inline()
+ * @return |q|
+ */
+static inline float lin_alg_q_norm_inline(float q[QSZ]) {
+    return sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+}
+
+/**
+ * @function lin_alg_scale_q_inline()
+ * q = s q
+ */
+static inline void lin_alg_scale_q_inline(float s, float q[QSZ]) {
+    q[0] *= s;
+    q[1] *= s;
+    q[2] *= s;
+    q[3] *= s;
+}
+
+/*******************************************************************************
+ * FIXED POINT KERNELS, see Lin_alg_fix.h
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_fix_cross_inline()
+ * w_out = u x v in Q2.30, w_out may be u or v
+ */
+static inline void lin_alg_fix_cross_inline(q30_t u[MSZ], q30_t v[MSZ], q30_t w_out[MSZ]) {
+    q30_t w0 = (q30_t) (((int64_t) u[1] * v[2] - (int64_t) u[2] * v[1]) >> 30);
+    q30_t w1 = (q30_t) (((int64_t) u[2] * v[0] - (int64_t) u[0] * v[2]) >> 30);
+    q30_t w2 = (q30_t) (((int64_t) u[0] * v[1] - (int64_t) u[1] * v[0]) >> 30);
+    w_out[0] = w0;
+    w_out[1] = w1;
+    w_out[2] = w2;
+}
+
+/**
+ * @function lin_alg_fix_q_mult_inline()
+ * r = q p in Q2.30, r must not be q or p
+ */
+static inline void lin_alg_fix_q_mult_inline(q30_t q[QSZ], q30_t p[QSZ], q30_t r[QSZ]) {
+    r[0] = (q30_t) (((int64_t) p[0] * q[0] - (int64_t) p[1] * q[1]
+            - (int64_t) p[2] * q[2] - (int64_t) p[3] * q[3]) >> 30);
+    r[1] = (q30_t) (((int64_t) p[1] * q[0] + (int64_t) p[0] * q[1]
+            + (int64_t) p[3] * q[2] - (int64_t) p[2] * q[3]) >> 30);
+    r[2] = (q30_t) (((int64_t) p[2] * q[0] - (int64_t) p[3] * q[1]
+            + (int64_t) p[0] * q[2] + (int64_t) p[1] * q[3]) >> 30);
+    r[3] = (q30_t) (((int64_t) p[3] * q[0] + (int64_t) p[2] * q[1]
+            - (int64_t) p[1] * q[2] + (int64_t) p[0] * q[3]) >> 30);
+}
+
+/**
+ * @function lin_alg_fix_cal_apply_inline()
+ * v_cal = A raw + b in Q16.16
+ */
+static inline void lin_alg_fix_cal_apply_inline(const lin_alg_fix_cal_t *cal, const int16_t raw[MSZ],
+        q16_t v_cal[MSZ]) {
+    int8_t shift = 14 + cal->shift; // Q(30 + shift) to Q16
+    int64_t sum;
+    int row;
+
+    for (row = 0; row < MSZ; row++) {
+        sum = (int64_t) cal->A[row][0] * raw[0] + (int64_t) cal->A[row][1] * raw[1]
+                + (int64_t) cal->A[row][2] * raw[2];
+        v_cal[row] = (q16_t) (shift >= 0 ? sum >> shift : sum << -shift) + cal->b[row];
+    }
+}
+
+#endif //LIN_ALG_NO_INLINE
+
+#endif	/* LIN_ALG_INLINE_H */
@@ -0,0 +1,720 @@
+/*
+ * File:   Lin_alg_mat.c
+ * Author: Aaron Hunter
+ * Brief: Fixed capacity matrices, see Lin_alg_mat.h.  The loops run over the
+ * dimensions in use, not the capacity, so a 6x6 multiply costs 216 multiply
+ * adds whatever LIN_ALG_MAT_MAX is.  Intermediate products that the routines
+ * need, e.g. a p in lin_alg_mat_sym_abat(), are lin_alg_mat_t locals, so stack
+ * use is a few hundred bytes at the default capacity.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+/*******************************************************************************
+ * #INCLUDES
+ ******************************************************************************/
+#include "Lin_alg_mat.h"
+#include "Board.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_mat_zeros()
+ * @param a The matrix, set to rows x cols zeros
+ * @param rows, cols The dimensions
+ * @return SUCCESS or ERROR if over LIN_ALG_MAT_MAX
+ */
+char lin_alg_mat_zeros(lin_alg_mat_t *a, uint8_t rows, uint8_t cols) {
+    int row;
+    int col;
+
+    if (rows > LIN_ALG_MAT_MAX || cols > LIN_ALG_MAT_MAX) {
+        return ERROR;
+    }
+    a->rows = rows;
+    a->cols = cols;
+    for (row = 0; row < rows; row++) {
+        for (col = 0; col < cols; col++) {
+            a->m[row][col] = 0;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_identity()
+ * @param a The matrix, set to the n x n identity
+ * @param n The dimension
+ * @return SUCCESS or ERROR if over LIN_ALG_MAT_MAX
+ */
+char lin_alg_mat_identity(lin_alg_mat_t *a, uint8_t n) {
+    int row;
+
+    if (lin_alg_mat_zeros(a, n, n) == ERROR) {
+        return ERROR;
+    }
+    for (row = 0; row < n; row++) {
+        a->m[row][row] = 1.0;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_set_block()
+ * Copies a 3x3 matrix into a, e.g. a block of a covariance
+ * @return SUCCESS or ERROR if the block does not fit in a
+ */
+char lin_alg_mat_set_block(lin_alg_mat_t *a, uint8_t row, uint8_t col, float block[MSZ][MSZ]) {
+    int i;
+    int j;
+
+    if (row + MSZ > a->rows || col + MSZ > a->cols) {
+        return ERROR;
+    }
+    for (i = 0; i < MSZ; i++) {
+        for (j = 0; j < MSZ; j++) {
+            a->m[row + i][col + j] = block[i][j];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_get_block()
+ * Copies a 3x3 block of a out
+ * @return SUCCESS or ERROR if the block does not fit in a
+ */
+char lin_alg_mat_get_block(lin_alg_mat_t *a, uint8_t row, uint8_t col, float block[MSZ][MSZ]) {
+    int i;
+    int j;
+
+    if (row + MSZ > a->rows || col + MSZ > a->cols) {
+        return ERROR;
+    }
+    for (i = 0; i < MSZ; i++) {
+        for (j = 0; j < MSZ; j++) {
+            block[i][j] = a->m[row + i][col + j];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_add()
+ * c = a + b, c may be a or b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_add(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c) {
+    int row;
+    int col;
+
+    if (a->rows != b->rows || a->cols != b->cols) {
+        return ERROR;
+    }
+    c->rows = a->rows;
+    c->cols = a->cols;
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < a->cols; col++) {
+            c->m[row][col] = a->m[row][col] + b->m[row][col];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_sub()
+ * c = a - b, c may be a or b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_sub(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c) {
+    int row;
+    int col;
+
+    if (a->rows != b->rows || a->cols != b->cols) {
+        return ERROR;
+    }
+    c->rows = a->rows;
+    c->cols = a->cols;
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < a->cols; col++) {
+            c->m[row][col] = a->m[row][col] - b->m[row][col];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_scale()
+ * a = s a
+ */
+void lin_alg_mat_scale(float s, lin_alg_mat_t *a) {
+    int row;
+    int col;
+
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < a->cols; col++) {
+            a->m[row][col] *= s;
+        }
+    }
+}
+
+/**
+ * @function lin_alg_mat_transpose()
+ * b = a'
+ * @return SUCCESS or ERROR if b is a
+ */
+char lin_alg_mat_transpose(lin_alg_mat_t *a, lin_alg_mat_t *b) {
+    int row;
+    int col;
+
+    if (a == b) {
+        return ERROR;
+    }
+    b->rows = a->cols;
+    b->cols = a->rows;
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < a->cols; col++) {
+            b->m[col][row] = a->m[row][col];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_mult()
+ * c = a b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_mult(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c) {
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+
+    if (a->cols != b->rows || c == a || c == b) {
+        return ERROR;
+    }
+    c->rows = a->rows;
+    c->cols = b->cols;
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < b->cols; col++) {
+            sum = 0;
+            for (i_sum = 0; i_sum < a->cols; i_sum++) {
+                sum += a->m[row][i_sum] * b->m[i_sum][col];
+            }
+            c->m[row][col] = sum;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_mult_t()
+ * c = a b'
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_mult_t(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c) {
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+
+    if (a->cols != b->cols || c == a || c == b) {
+        return ERROR;
+    }
+    c->rows = a->rows;
+    c->cols = b->rows;
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < b->rows; col++) {
+            sum = 0;
+            for (i_sum = 0; i_sum < a->cols; i_sum++) {
+                sum += a->m[row][i_sum] * b->m[col][i_sum];
+            }
+            c->m[row][col] = sum;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_v_mult()
+ * v_out = a v
+ * @return SUCCESS or ERROR if v_out is v
+ */
+char lin_alg_mat_v_mult(lin_alg_mat_t *a, float v[], float v_out[]) {
+    int row;
+    int col;
+    float sum;
+
+    if (v == v_out) {
+        return ERROR;
+    }
+    for (row = 0; row < a->rows; row++) {
+        sum = 0;
+        for (col = 0; col < a->cols; col++) {
+            sum += a->m[row][col] * v[col];
+        }
+        v_out[row] = sum;
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_sym_abat()
+ * c = a p a' for symmetric p, upper triangle computed and mirrored
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_sym_abat(lin_alg_mat_t *a, lin_alg_mat_t *p, lin_alg_mat_t *c) {
+    lin_alg_mat_t ap;
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+
+    if (p->rows != p->cols || c == a || c == p) {
+        return ERROR;
+    }
+    if (lin_alg_mat_mult(a, p, &ap) == ERROR) {
+        return ERROR;
+    }
+    c->rows = a->rows;
+    c->cols = a->rows;
+    for (row = 0; row < a->rows; row++) {
+        for (col = row; col < a->rows; col++) {
+            sum = 0;
+            for (i_sum = 0; i_sum < a->cols; i_sum++) {
+                sum += ap.m[row][i_sum] * a->m[col][i_sum];
+            }
+            c->m[row][col] = sum;
+            c->m[col][row] = sum;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_symmetrize()
+ * a = (a + a') / 2
+ * @return SUCCESS or ERROR if a is not square
+ */
+char lin_alg_mat_symmetrize(lin_alg_mat_t *a) {
+    int row;
+    int col;
+    float mean;
+
+    if (a->rows != a->cols) {
+        return ERROR;
+    }
+    for (row = 0; row < a->rows; row++) {
+        for (col = row + 1; col < a->cols; col++) {
+            mean = 0.5 * (a->m[row][col] + a->m[col][row]);
+            a->m[row][col] = mean;
+            a->m[col][row] = mean;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_cholesky()
+ * Factors a = l l', column by column.  Entry (row, col) of a is read before
+ * l overwrites it, so l may be a.
+ * @return SUCCESS or ERROR if a is not square or not positive definite
+ */
+char lin_alg_mat_cholesky(lin_alg_mat_t *a, lin_alg_mat_t *l) {
+    int n = a->rows;
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+    float diag;
+
+    if (a->rows != a->cols) {
+        return ERROR;
+    }
+    l->rows = n;
+    l->cols = n;
+    for (col = 0; col < n; col++) {
+        sum = a->m[col][col];
+        for (i_sum = 0; i_sum < col; i_sum++) {
+            sum -= l->m[col][i_sum] * l->m[col][i_sum];
+        }
+        if (!(sum > 0)) { // also catches NaN
+            return ERROR;
+        }
+        diag = sqrtf(sum);
+        l->m[col][col] = diag;
+        diag = 1.0f / diag;
+        for (row = col + 1; row < n; row++) {
+            sum = a->m[row][col];
+            for (i_sum = 0; i_sum < col; i_sum++) {
+                sum -= l->m[row][i_sum] * l->m[col][i_sum];
+            }
+            l->m[row][col] = sum * diag;
+        }
+    }
+    for (row = 0; row < n; row++) {
+        for (col = row + 1; col < n; col++) {
+            l->m[row][col] = 0;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_cholesky_solve()
+ * Solves l y = b by forward and l' x = y by back substitution, one column at
+ * a time and in place, so x may be b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_cholesky_solve(lin_alg_mat_t *l, lin_alg_mat_t *b, lin_alg_mat_t *x) {
+    int n = l->rows;
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+
+    if (l->rows != l->cols || b->rows != n) {
+        return ERROR;
+    }
+    x->rows = b->rows;
+    x->cols = b->cols;
+    for (col = 0; col < b->cols; col++) {
+        for (row = 0; row < n; row++) {
+            sum = b->m[row][col];
+            for (i_sum = 0; i_sum < row; i_sum++) {
+                sum -= l->m[row][i_sum] * x->m[i_sum][col];
+            }
+            x->m[row][col] = sum / l->m[row][row];
+        }
+        for (row = n - 1; row >= 0; row--) {
+            sum = x->m[row][col];
+            for (i_sum = row + 1; i_sum < n; i_sum++) {
+                sum -= l->m[i_sum][row] * x->m[i_sum][col];
+            }
+            x->m[row][col] = sum / l->m[row][row];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_lu()
+ * Gaussian elimination with partial pivoting in place in lu.  A pivot under
+ * n FLT_EPSILON times the largest entry of a means a is singular to working
+ * precision.
+ * @return SUCCESS or ERROR if a is not square or is singular
+ */
+char lin_alg_mat_lu(lin_alg_mat_t *a, lin_alg_mat_t *lu, uint8_t perm[LIN_ALG_MAT_MAX]) {
+    int n = a->rows;
+    int row;
+    int col;
+    int k;
+    int pivot_row;
+    float pivot;
+    float a_max = 0;
+    float tol;
+    float temp;
+    uint8_t temp_index;
+
+    if (a->rows != a->cols) {
+        return ERROR;
+    }
+    lu->rows = n;
+    lu->cols = n;
+    for (row = 0; row < n; row++) {
+        perm[row] = row;
+        for (col = 0; col < n; col++) {
+            lu->m[row][col] = a->m[row][col];
+            if (fabsf(lu->m[row][col]) > a_max) {
+                a_max = fabsf(lu->m[row][col]);
+            }
+        }
+    }
+    tol = n * FLT_EPSILON * a_max;
+
+    for (k = 0; k < n; k++) {
+        pivot_row = k;
+        for (row = k + 1; row < n; row++) {
+            if (fabsf(lu->m[row][k]) > fabsf(lu->m[pivot_row][k])) {
+                pivot_row = row;
+            }
+        }
+        if (!(fabsf(lu->m[pivot_row][k]) > tol)) {
+            return ERROR;
+        }
+        if (pivot_row != k) {
+            for (col = 0; col < n; col++) {
+                temp = lu->m[k][col];
+                lu->m[k][col] = lu->m[pivot_row][col];
+                lu->m[pivot_row][col] = temp;
+            }
+            temp_index = perm[k];
+            perm[k] = perm[pivot_row];
+            perm[pivot_row] = temp_index;
+        }
+        pivot = 1.0f / lu->m[k][k];
+        for (row = k + 1; row < n; row++) {
+            lu->m[row][k] *= pivot;
+            for (col = k + 1; col < n; col++) {
+                lu->m[row][col] -= lu->m[row][k] * lu->m[k][col];
+            }
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_lu_solve()
+ * Solves l u x = p b by forward and back substitution, through a permuted
+ * copy of b so x may be b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_lu_solve(lin_alg_mat_t *lu, uint8_t perm[LIN_ALG_MAT_MAX], lin_alg_mat_t *b,
+        lin_alg_mat_t *x) {
+    lin_alg_mat_t pb;
+    int n = lu->rows;
+    int row;
+    int col;
+    int i_sum;
+    float sum;
+
+    if (lu->rows != lu->cols || b->rows != n) {
+        return ERROR;
+    }
+    for (row = 0; row < n; row++) {
+        for (col = 0; col < b->cols; col++) {
+            pb.m[row][col] = b->m[perm[row]][col];
+        }
+    }
+    x->rows = b->rows;
+    x->cols = b->cols;
+    for (col = 0; col < b->cols; col++) {
+        for (row = 0; row < n; row++) {
+            sum = pb.m[row][col];
+            for (i_sum = 0; i_sum < row; i_sum++) {
+                sum -= lu->m[row][i_sum] * x->m[i_sum][col];
+            }
+            x->m[row][col] = sum;
+        }
+        for (row = n - 1; row >= 0; row--) {
+            sum = x->m[row][col];
+            for (i_sum = row + 1; i_sum < n; i_sum++) {
+                sum -= lu->m[row][i_sum] * x->m[i_sum][col];
+            }
+            x->m[row][col] = sum / lu->m[row][row];
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * @function lin_alg_mat_print()
+ * Print a matrix
+ * @param a A matrix to print out
+ */
+void lin_alg_mat_print(lin_alg_mat_t *a) {
+    int row;
+    int col;
+
+    printf("\r\n");
+    for (row = 0; row < a->rows; row++) {
+        printf("\r\n");
+        for (col = 0; col < a->cols; col++) {
+            printf("    % -9.4f", (double) a->m[row][col]);
+        }
+    }
+    printf("\r\n");
+}
+
+#ifdef LIN_ALG_MAT_TESTING
+#include "SerialM32.h"
+
+#define TEST_N 9 // a 9 state filter
+#define TEST_M 6 // measurements
+#define TEST_TOL 1e-4
+
+static uint32_t lcg_state = 12345;
+
+static float test_rand(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (int32_t) lcg_state / 2147483648.0f;
+}
+
+static void test_fill(lin_alg_mat_t *a, uint8_t rows, uint8_t cols) {
+    int row;
+    int col;
+
+    lin_alg_mat_zeros(a, rows, cols);
+    for (row = 0; row < rows; row++) {
+        for (col = 0; col < cols; col++) {
+            a->m[row][col] = test_rand();
+        }
+    }
+}
+
+/* largest entry of |a - b|, or a large number if the dimensions differ */
+static float test_diff(lin_alg_mat_t *a, lin_alg_mat_t *b) {
+    float diff = 0;
+    int row;
+    int col;
+
+    if (a->rows != b->rows || a->cols != b->cols) {
+        return 1e9;
+    }
+    for (row = 0; row < a->rows; row++) {
+        for (col = 0; col < a->cols; col++) {
+            if (fabsf(a->m[row][col] - b->m[row][col]) > diff) {
+                diff = fabsf(a->m[row][col] - b->m[row][col]);
+            }
+        }
+    }
+    return diff;
+}
+
+static int test_check(const char *name, int pass) {
+    printf("%s: %s\r\n", name, pass ? "pass" : "FAIL");
+    return pass ? 0 : 1;
+}
+
+int main(void) {
+    lin_alg_mat_t a;
+    lin_alg_mat_t b;
+    lin_alg_mat_t c;
+    lin_alg_mat_t d;
+    lin_alg_mat_t p;
+    lin_alg_mat_t l;
+    lin_alg_mat_t x;
+    uint8_t perm[LIN_ALG_MAT_MAX];
+    float block[MSZ][MSZ] = {
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9}
+    };
+    float block_out[MSZ][MSZ];
+    int failures = 0;
+    int row;
+    int col;
+    int is_symmetric;
+
+    Board_init();
+    Serial_init();
+    printf("Lin_alg_mat test harness %s, %s\r\n", __DATE__, __TIME__);
+
+    failures += test_check("capacity",
+            lin_alg_mat_zeros(&a, LIN_ALG_MAT_MAX + 1, 1) == ERROR
+            && lin_alg_mat_identity(&a, LIN_ALG_MAT_MAX) == SUCCESS);
+
+    /* [1 2 3; 4 5 6] [1 0; 0 1; 1 1] = [4 5; 10 11] */
+    lin_alg_mat_zeros(&a, 2, 3);
+    lin_alg_mat_zeros(&b, 3, 2);
+    lin_alg_mat_zeros(&d, 2, 2);
+    for (col = 0; col < 3; col++) {
+        a.m[0][col] = col + 1;
+        a.m[1][col] = col + 4;
+    }
+    b.m[0][0] = 1;
+    b.m[1][1] = 1;
+    b.m[2][0] = 1;
+    b.m[2][1] = 1;
+    d.m[0][0] = 4;
+    d.m[0][1] = 5;
+    d.m[1][0] = 10;
+    d.m[1][1] = 11;
+    failures += test_check("mult",
+            lin_alg_mat_mult(&a, &b, &c) == SUCCESS && test_diff(&c, &d) == 0);
+    failures += test_check("dimension and alias checks",
+            lin_alg_mat_mult(&a, &a, &c) == ERROR
+            && lin_alg_mat_mult(&a, &b, &a) == ERROR
+            && lin_alg_mat_add(&a, &b, &c) == ERROR
+            && lin_alg_mat_cholesky(&a, &c) == ERROR);
+
+    /* a b' against a (b')' */
+    test_fill(&a, TEST_M, TEST_N);
+    test_fill(&b, TEST_M, TEST_N);
+    lin_alg_mat_transpose(&b, &c);
+    lin_alg_mat_mult(&a, &c, &d);
+    failures += test_check("mult_t",
+            lin_alg_mat_mult_t(&a, &b, &c) == SUCCESS && test_diff(&c, &d) == 0);
+
+    /* a covariance, b b' + I */
+    test_fill(&b, TEST_N, TEST_N);
+    lin_alg_mat_mult_t(&b, &b, &p);
+    lin_alg_mat_identity(&c, TEST_N);
+    lin_alg_mat_add(&p, &c, &p);
+
+    /* a p a' against the two general products */
+    lin_alg_mat_mult(&a, &p, &b);
+    lin_alg_mat_mult_t(&b, &a, &d);
+    lin_alg_mat_sym_abat(&a, &p, &c);
+    is_symmetric = TRUE;
+    for (row = 0; row < c.rows; row++) {
+        for (col = 0; col < c.cols; col++) {
+            if (c.m[row][col] != c.m[col][row]) {
+                is_symmetric = FALSE;
+            }
+        }
+    }
+    failures += test_check("sym_abat",
+            c.rows == TEST_M && test_diff(&c, &d) < TEST_TOL && is_symmetric);
+
+    /* p = l l' and p x = b */
+    failures += test_check("cholesky", lin_alg_mat_cholesky(&p, &l) == SUCCESS
+            && lin_alg_mat_mult_t(&l, &l, &c) == SUCCESS && test_diff(&c, &p) < TEST_TOL);
+    test_fill(&b, TEST_N, 3);
+    lin_alg_mat_cholesky_solve(&l, &b, &x);
+    lin_alg_mat_mult(&p, &x, &c);
+    failures += test_check("cholesky_solve", test_diff(&c, &b) < TEST_TOL);
+    d = p;
+    x = b;
+    lin_alg_mat_cholesky(&d, &d);
+    lin_alg_mat_cholesky_solve(&d, &x, &x);
+    lin_alg_mat_mult(&p, &x, &c);
+    failures += test_check("cholesky in place", test_diff(&d, &l) == 0 && test_diff(&c, &b) < TEST_TOL);
+
+    /* [1 2; 2 1] is indefinite */
+    lin_alg_mat_identity(&a, 2);
+    a.m[0][1] = 2;
+    a.m[1][0] = 2;
+    failures += test_check("cholesky not positive definite", lin_alg_mat_cholesky(&a, &l) == ERROR);
+
+    /* a general matrix */
+    test_fill(&a, TEST_N, TEST_N);
+    test_fill(&b, TEST_N, 3);
+    failures += test_check("lu", lin_alg_mat_lu(&a, &l, perm) == SUCCESS);
+    lin_alg_mat_lu_solve(&l, perm, &b, &x);
+    lin_alg_mat_mult(&a, &x, &c);
+    failures += test_check("lu_solve", test_diff(&c, &b) < TEST_TOL);
+    x = b;
+    lin_alg_mat_lu_solve(&l, perm, &x, &x);
+    lin_alg_mat_mult(&a, &x, &c);
+    failures += test_check("lu_solve in place", test_diff(&c, &b) < TEST_TOL);
+
+    /* [0 1; 1 0] needs the pivot, [1 2; 2 4] is singular */
+    lin_alg_mat_zeros(&a, 2, 2);
+    a.m[0][1] = 1;
+    a.m[1][0] = 1;
+    failures += test_check("lu pivot", lin_alg_mat_lu(&a, &l, perm) == SUCCESS
+            && perm[0] == 1 && perm[1] == 0);
+    a.m[0][0] = 1;
+    a.m[0][1] = 2;
+    a.m[1][0] = 2;
+    a.m[1][1] = 4;
+    failures += test_check("lu singular", lin_alg_mat_lu(&a, &l, perm) == ERROR);
+
+    /* a 3x3 block in and out of a 6x6 */
+    lin_alg_mat_zeros(&a, 6, 6);
+    failures += test_check("blocks", lin_alg_mat_set_block(&a, 3, 3, block) == SUCCESS
+            && lin_alg_mat_get_block(&a, 3, 3, block_out) == SUCCESS
+            && block_out[2][1] == 8 && a.m[5][4] == 8
+            && lin_alg_mat_set_block(&a, 4, 0, block) == ERROR);
+
+    printf("%s\r\n", failures == 0 ? "Lin_alg_mat tests passed" : "Lin_alg_mat tests FAILED");
+    return 0;
+}
+#endif //LIN_ALG_MAT_TESTING
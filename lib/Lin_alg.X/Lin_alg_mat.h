@@ -0,0 +1,215 @@
+/*
+ * File:   Lin_alg_mat.h
+ * Author: Aaron Hunter
+ * Brief: Matrices of any size up to LIN_ALG_MAT_MAX x LIN_ALG_MAT_MAX for
+ * filters with more states than the 3x3 Lin_alg_float routines cover, e.g. a
+ * 6 or 9 state Kalman filter.  A lin_alg_mat_t carries its dimensions with a
+ * fixed capacity array, so matrices live on the stack or in static storage,
+ * never on the heap, and the memory a filter uses is known at compile time.
+ * The capacity is a build option; raise it for larger filters at a cost of
+ * 4 * LIN_ALG_MAT_MAX^2 bytes per matrix.
+ *
+ * Every routine checks the dimensions of its operands and returns ERROR
+ * without touching the output when they do not agree.  Outputs may not be an
+ * input unless the function says otherwise.
+ *
+ * Solves use factorizations rather than inverses: lin_alg_mat_cholesky() for
+ * the symmetric positive definite matrices of a Kalman filter, e.g. the
+ * innovation covariance S in K = P H' S^-1, which is solved as S K' = H P, and
+ * lin_alg_mat_lu() with partial pivoting for general square matrices.
+ * lin_alg_mat_sym_abat() forms A P A' for symmetric P, the covariance
+ * propagation, with half the multiplies of the second product and an exactly
+ * symmetric result.
+ * Created on Oct 16, 2026
+ * Modified on
+ */
+
+#ifndef LIN_ALG_MAT_H
+#define	LIN_ALG_MAT_H
+
+/*******************************************************************************
+ * PUBLIC #INCLUDES
+ ******************************************************************************/
+#include <stdint.h>
+
+/*******************************************************************************
+ * #DEFINES
+ ******************************************************************************/
+#define MSZ 3 // Maximum size of statically allocated arrays
+
+#ifndef LIN_ALG_MAT_MAX
+#define LIN_ALG_MAT_MAX 9 // rows and columns of the largest matrix
+#endif
+
+/*******************************************************************************
+ * PUBLIC DATATYPES
+ ******************************************************************************/
+typedef struct {
+    uint8_t rows;
+    uint8_t cols;
+    float m[LIN_ALG_MAT_MAX][LIN_ALG_MAT_MAX]; // m[row][col], unused entries undefined
+} lin_alg_mat_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES
+ ******************************************************************************/
+
+/**
+ * @function lin_alg_mat_zeros()
+ * @param a The matrix, set to rows x cols zeros
+ * @param rows, cols The dimensions
+ * @return SUCCESS or ERROR if over LIN_ALG_MAT_MAX
+ */
+char lin_alg_mat_zeros(lin_alg_mat_t *a, uint8_t rows, uint8_t cols);
+
+/**
+ * @function lin_alg_mat_identity()
+ * @param a The matrix, set to the n x n identity
+ * @param n The dimension
+ * @return SUCCESS or ERROR if over LIN_ALG_MAT_MAX
+ */
+char lin_alg_mat_identity(lin_alg_mat_t *a, uint8_t n);
+
+/**
+ * @function lin_alg_mat_set_block()
+ * Copies a 3x3 matrix into a, e.g. a block of a covariance
+ * @param a The matrix
+ * @param row, col The top left entry of the block
+ * @param block The 3x3 matrix
+ * @return SUCCESS or ERROR if the block does not fit in a
+ */
+char lin_alg_mat_set_block(lin_alg_mat_t *a, uint8_t row, uint8_t col, float block[MSZ][MSZ]);
+
+/**
+ * @function lin_alg_mat_get_block()
+ * Copies a 3x3 block of a out
+ * @param a The matrix
+ * @param row, col The top left entry of the block
+ * @param block The 3x3 matrix
+ * @return SUCCESS or ERROR if the block does not fit in a
+ */
+char lin_alg_mat_get_block(lin_alg_mat_t *a, uint8_t row, uint8_t col, float block[MSZ][MSZ]);
+
+/**
+ * @function lin_alg_mat_add()
+ * c = a + b, c may be a or b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_add(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c);
+
+/**
+ * @function lin_alg_mat_sub()
+ * c = a - b, c may be a or b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_sub(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c);
+
+/**
+ * @function lin_alg_mat_scale()
+ * a = s a
+ * @param s The scalar
+ * @param a The matrix
+ */
+void lin_alg_mat_scale(float s, lin_alg_mat_t *a);
+
+/**
+ * @function lin_alg_mat_transpose()
+ * b = a'
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_transpose(lin_alg_mat_t *a, lin_alg_mat_t *b);
+
+/**
+ * @function lin_alg_mat_mult()
+ * c = a b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_mult(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c);
+
+/**
+ * @function lin_alg_mat_mult_t()
+ * c = a b', without forming b', e.g. P H'
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_mult_t(lin_alg_mat_t *a, lin_alg_mat_t *b, lin_alg_mat_t *c);
+
+/**
+ * @function lin_alg_mat_v_mult()
+ * v_out = a v
+ * @param a The matrix
+ * @param v A vector of a->cols entries
+ * @param v_out A vector of a->rows entries
+ * @return SUCCESS or ERROR if v_out is v
+ */
+char lin_alg_mat_v_mult(lin_alg_mat_t *a, float v[], float v_out[]);
+
+/**
+ * @function lin_alg_mat_sym_abat()
+ * c = a p a' for symmetric p.  Only the upper triangle of c is computed and
+ * mirrored, so c is symmetric to the bit and rounding cannot make a
+ * covariance drift asymmetric.
+ * @param a An m x n matrix
+ * @param p An n x n symmetric matrix
+ * @param c The m x m result
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_sym_abat(lin_alg_mat_t *a, lin_alg_mat_t *p, lin_alg_mat_t *c);
+
+/**
+ * @function lin_alg_mat_symmetrize()
+ * a = (a + a') / 2
+ * @return SUCCESS or ERROR if a is not square
+ */
+char lin_alg_mat_symmetrize(lin_alg_mat_t *a);
+
+/**
+ * @function lin_alg_mat_cholesky()
+ * Factors a symmetric positive definite a = l l' with l lower triangular.
+ * Only the lower triangle of a is read.
+ * @param a The matrix
+ * @param l The factor, may be a
+ * @return SUCCESS or ERROR if a is not square or not positive definite
+ */
+char lin_alg_mat_cholesky(lin_alg_mat_t *a, lin_alg_mat_t *l);
+
+/**
+ * @function lin_alg_mat_cholesky_solve()
+ * Solves l l' x = b for every column of b
+ * @param l The factor from lin_alg_mat_cholesky()
+ * @param b The right hand sides
+ * @param x The solutions, may be b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_cholesky_solve(lin_alg_mat_t *l, lin_alg_mat_t *b, lin_alg_mat_t *x);
+
+/**
+ * @function lin_alg_mat_lu()
+ * Factors p a = l u with partial pivoting, l unit lower and u upper
+ * triangular, both held in lu
+ * @param a The square matrix
+ * @param lu The factors, may be a
+ * @param perm The row permutation p, row i of p a is row perm[i] of a
+ * @return SUCCESS or ERROR if a is not square or is singular to working
+ * precision
+ */
+char lin_alg_mat_lu(lin_alg_mat_t *a, lin_alg_mat_t *lu, uint8_t perm[LIN_ALG_MAT_MAX]);
+
+/**
+ * @function lin_alg_mat_lu_solve()
+ * Solves a x = b for every column of b
+ * @param lu, perm The factors from lin_alg_mat_lu()
+ * @param b The right hand sides
+ * @param x The solutions, may be b
+ * @return SUCCESS or ERROR
+ */
+char lin_alg_mat_lu_solve(lin_alg_mat_t *lu, uint8_t perm[LIN_ALG_MAT_MAX], lin_alg_mat_t *b,
+        lin_alg_mat_t *x);
+
+/**
+ * @function lin_alg_mat_print()
+ * Print a matrix
+ * @param a A matrix to print out
+ */
+void lin_alg_mat_print(lin_alg_mat_t *a);
+
+#endif	/* LIN_ALG_MAT_H */
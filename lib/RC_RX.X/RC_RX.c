@@ -13,7 +13,7 @@
 
 #include "RC_RX.h" // The header file for this source file. 
 #include "SerialM32.h" // The header file for this source file. 
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
 #include <xc.h>
 #include <stdio.h>
 #include <sys/attribs.h>  //for ISR definitions
@@ -417,7 +417,7 @@ static void RCRX_run_RX_state_machine(uint8_t curr_byte) {
     static RCRX_state_t current_state = GET_START;
     static uint8_t prev_byte = START_BYTE; //initialize the previous byte to something other than END_BYTE
     static uint8_t byte_counter = 0;
-    RCRX_state_t next_state;
+    RCRX_state_t next_state = current_state;
     switch (current_state) {
         case WAIT_SYNC:
             /* data stream shows STATUS BYTE = 0x00 = END_BYTE so we look for 
@@ -12,7 +12,7 @@
 
 #include "Radio_serial.h" // The header file for this source file. 
 #include "SerialM32.h" //debug serial
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
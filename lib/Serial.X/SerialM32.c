@@ -11,7 +11,7 @@
  ******************************************************************************/
 
 #include "SerialM32.h" // The header file for this source file. 
-#include "Board.H"   //Max32 setup      
+#include "Board.h"   //Max32 setup      
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
@@ -17,6 +17,9 @@
 #include <stdio.h>
 #include <sys/attribs.h>  //for ISR definitions
 #include <proc/p32mx795f512l.h>
+#ifdef HAL_SIM
+#include "HAL_sim.h" // host build, time only moves when the firmware looks at it
+#endif
 
 /*******************************************************************************
  * PRIVATE #DEFINES                                                            *
@@ -66,6 +69,9 @@ void Sys_timer_init(void) {
  * @return the current millisecond counter value
  */
 uint32_t Sys_timer_get_msec(void) {
+#ifdef HAL_SIM
+    HAL_sim_poll();
+#endif
     return msec_counter;
 }
 
@@ -80,6 +86,9 @@ uint32_t Sys_timer_get_usec(void) {
     // divide by scalar to convert to usecs 
     // Add to usec_counter
     // return sum
+#ifdef HAL_SIM
+    HAL_sim_poll();
+#endif
     return (TMR5 / TICKS_PER_USEC + usec_counter);
 }
 